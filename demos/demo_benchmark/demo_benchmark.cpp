@@ -0,0 +1,387 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#define LOG_TAG "demo_benchmark"
+
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
+
+#include <sakit/HttpResponse.h>
+#include <sakit/OutgoingDatagram.h>
+#include <sakit/sakit.h>
+#include <sakit/TcpServer.h>
+#include <sakit/TcpServerDelegate.h>
+#include <sakit/TcpSocket.h>
+#include <sakit/TcpSocketDelegate.h>
+#include <sakit/UdpSocket.h>
+#include <sakit/UdpSocketDelegate.h>
+
+#define TCP_PORT_LATENCY 52000
+#define TCP_PORT_RACING 52001
+#define UDP_PORT_SEND 52100
+#define UDP_PORT_SEND_CLIENT 52101
+#define LATENCY_ROUND_TRIPS 1000
+#define LATENCY_SLEEPING_ROUND_TRIPS 100
+#define UDP_DATAGRAM_COUNT 100000
+#define UDP_DATAGRAM_SIZE 64
+#define UDP_BATCH_SIZE 64
+#define RACING_CONNECTS 100
+#define RESOLVER_CALLS 2000
+#define RESOLVER_MAX_THREADS 8
+#define PARSER_BODY_SIZE 1048576
+#define PARSER_ITERATIONS 50
+#define PARSER_SEGMENT_SIZE 1460
+
+sakit::TcpServerDelegate tcpServerDelegate;
+sakit::TcpSocketDelegate tcpSocketDelegate;
+sakit::UdpSocketDelegate udpSocketDelegate;
+
+sakit::TcpSocket* echoSocket = NULL;
+
+void _echo(hthread* thread)
+{
+	unsigned char data = 0;
+	hstream stream;
+	// ends when the client disconnects or stops sending
+	while (echoSocket->receive(&data, 1) == 1)
+	{
+		stream.clear();
+		stream.writeRaw(&data, 1);
+		stream.rewind();
+		echoSocket->send(&stream);
+	}
+}
+
+/// @param[in] sleeping Whether to wait for the echo like receiving used to, by trying again after sleeping the retry frequency.
+/// @return Time in microseconds per round trip.
+float _measureRoundTrips(sakit::TcpSocket* client, int count, bool sleeping)
+{
+	float timeout = sakit::getGlobalTimeout();
+	float retryFrequency = sakit::getGlobalRetryFrequency();
+	hstream stream;
+	unsigned char data = 0;
+	int received = 0;
+	int read = 0;
+	float time = 0.0f;
+	// the sleeping is done here, receiving only takes what has arrived already then
+	client->setTimeout(sleeping ? 0.0f : timeout, retryFrequency);
+	int64_t start = htickCount();
+	for_iter (i, 0, count)
+	{
+		data = (unsigned char)i;
+		stream.clear();
+		stream.writeRaw(&data, 1);
+		stream.rewind();
+		client->send(&stream);
+		read = client->receive(&data, 1);
+		time = 0.0f;
+		while (sleeping && read == 0 && time < timeout)
+		{
+			hthread::sleep(retryFrequency * 1000.0f);
+			time += retryFrequency;
+			read = client->receive(&data, 1);
+		}
+		received += read;
+	}
+	float result = (htickCount() - start) * 1000.0f / count;
+	client->setTimeout(timeout, retryFrequency);
+	hlog::writef(LOG_TAG, "%s: %d of %d round trips, %.1f us per round trip", sleeping ? hsprintf("sleeping %.1f ms between attempts",
+		retryFrequency * 1000.0f).cStr() : "waiting in poll()", received, count, result);
+	return result;
+}
+
+void _benchmarkReceiveLatency()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting benchmark: blocking receive latency");
+	hlog::debug(LOG_TAG, "");
+	sakit::TcpServer* server = new sakit::TcpServer(&tcpServerDelegate, &tcpSocketDelegate);
+	server->setTimeout(0.1f);
+	if (server->bind(sakit::Host::Localhost, TCP_PORT_LATENCY))
+	{
+		server->accept(); // starts listening
+		sakit::TcpSocket* client = new sakit::TcpSocket(&tcpSocketDelegate);
+		if (client->connect(sakit::Host::Localhost, TCP_PORT_LATENCY))
+		{
+			while (echoSocket == NULL)
+			{
+				echoSocket = server->accept();
+			}
+			hthread echoThread(&_echo, "echo");
+			echoThread.start();
+			// the old way of receiving as the baseline, fewer round trips since each one takes about a retry frequency
+			float sleepingTime = _measureRoundTrips(client, LATENCY_SLEEPING_ROUND_TRIPS, true);
+			float waitingTime = _measureRoundTrips(client, LATENCY_ROUND_TRIPS, false);
+			if (waitingTime < sleepingTime)
+			{
+				hlog::writef(LOG_TAG, "waiting is %.1f times as fast", sleepingTime / hmax(waitingTime, 0.001f));
+			}
+			else
+			{
+				hlog::error(LOG_TAG, "waiting is not faster!");
+			}
+			client->disconnect();
+			echoThread.join();
+			echoSocket->disconnect();
+			echoSocket = NULL;
+		}
+		delete client;
+		server->unbind();
+	}
+	delete server;
+}
+
+void _printRate(chstr name, int count, int64_t time)
+{
+	hlog::writef(LOG_TAG, "%s: %d datagrams in %d ms, %.0f datagrams per second", name.cStr(), count, (int)time, count * 1000.0f / hmax(time, (int64_t)1));
+}
+
+void _benchmarkUdpSend()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting benchmark: UDP datagrams per second");
+	hlog::debug(LOG_TAG, "");
+	sakit::UdpSocket* receiver = new sakit::UdpSocket(&udpSocketDelegate);
+	sakit::UdpSocket* sender = new sakit::UdpSocket(&udpSocketDelegate);
+	// the receiver doesn't read anything, it only makes sure the datagrams have a destination
+	if (receiver->bind(sakit::Host::Localhost, UDP_PORT_SEND) && sender->bind(sakit::Host::Localhost, UDP_PORT_SEND_CLIENT) &&
+		sender->setDestination(sakit::Host::Localhost, UDP_PORT_SEND))
+	{
+		unsigned char data[UDP_DATAGRAM_SIZE * UDP_BATCH_SIZE] = {0};
+		hstream stream;
+		stream.writeRaw(data, UDP_DATAGRAM_SIZE);
+		int sent = 0;
+		int64_t start = htickCount();
+		for_iter (i, 0, UDP_DATAGRAM_COUNT)
+		{
+			stream.rewind();
+			if (sender->send(&stream) > 0)
+			{
+				++sent;
+			}
+		}
+		_printRate("send()", sent, htickCount() - start);
+		harray<sakit::OutgoingDatagram> datagrams;
+		for_iter (i, 0, UDP_BATCH_SIZE)
+		{
+			datagrams += sakit::OutgoingDatagram(sakit::Host::Localhost, UDP_PORT_SEND, data, UDP_DATAGRAM_SIZE);
+		}
+		sent = 0;
+		start = htickCount();
+		for_iter (i, 0, UDP_DATAGRAM_COUNT / UDP_BATCH_SIZE)
+		{
+			sent += sender->sendBatch(datagrams);
+		}
+		_printRate("sendBatch()", sent, htickCount() - start);
+		sent = 0;
+		start = htickCount();
+		for_iter (i, 0, UDP_DATAGRAM_COUNT / UDP_BATCH_SIZE)
+		{
+			sent += sender->sendSegmented(data, UDP_DATAGRAM_SIZE * UDP_BATCH_SIZE, UDP_DATAGRAM_SIZE) / UDP_DATAGRAM_SIZE;
+		}
+		_printRate("sendSegmented()", sent, htickCount() - start);
+	}
+	sender->unbind();
+	receiver->unbind();
+	delete sender;
+	delete receiver;
+}
+
+void _benchmarkConnectRacing()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting benchmark: connecting to localhost with a server on only one address family");
+	hlog::debug(LOG_TAG, "");
+	harray<sakit::Host> ips = sakit::resolveHosts(sakit::Host::Localhost);
+	harray<hstr> addresses;
+	foreach (sakit::Host, it, ips)
+	{
+		addresses += (*it).toString();
+	}
+	// the attempts are only raced if localhost has both an IPv4 and an IPv6 address, e.g. in /etc/hosts
+	hlog::write(LOG_TAG, "localhost resolves to: " + addresses.joined(", "));
+	harray<sakit::Host> serverHosts;
+	serverHosts += sakit::Host(127, 0, 0, 1);
+	serverHosts += sakit::Host::LocalhostIpv6;
+	sakit::TcpServer* server = NULL;
+	sakit::TcpSocket* client = NULL;
+	int connected = 0;
+	int64_t start = 0;
+	int64_t time = 0;
+	foreach (sakit::Host, it, serverHosts)
+	{
+		server = new sakit::TcpServer(&tcpServerDelegate, &tcpSocketDelegate);
+		server->setTimeout(0.0f);
+		if (server->bind((*it), TCP_PORT_RACING))
+		{
+			server->accept(); // starts listening, the connections are completed by the system without accepting them
+			connected = 0;
+			start = htickCount();
+			for_iter (i, 0, RACING_CONNECTS)
+			{
+				client = new sakit::TcpSocket(&tcpSocketDelegate);
+				if (client->connect(sakit::Host::Localhost, TCP_PORT_RACING))
+				{
+					++connected;
+					client->disconnect();
+				}
+				delete client;
+			}
+			time = htickCount() - start;
+			hlog::writef(LOG_TAG, "server on %s: %d of %d connected, %.2f ms per connect", (*it).toString().cStr(), connected, RACING_CONNECTS, (float)time / RACING_CONNECTS);
+			server->unbind();
+		}
+		delete server;
+	}
+}
+
+void _resolve(hthread* thread)
+{
+	for_iter (i, 0, RESOLVER_CALLS)
+	{
+		sakit::resolveHosts("localhost");
+		sakit::resolveIp(sakit::Host(127, 0, 0, 1));
+	}
+}
+
+void _benchmarkResolverContention()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting benchmark: resolver calls from multiple threads");
+	hlog::debug(LOG_TAG, "");
+	float ttl = sakit::getDnsCacheTtl();
+	float negativeTtl = sakit::getDnsCacheNegativeTtl();
+	sakit::setDnsCacheTtl(0.0f, 0.0f); // every call has to go to the system resolver
+	sakit::clearDnsCache();
+	harray<hthread*> threads;
+	int64_t start = 0;
+	int64_t time = 0;
+	for (int count = 1; count <= RESOLVER_MAX_THREADS; count *= 2)
+	{
+		for_iter (i, 0, count)
+		{
+			threads += new hthread(&_resolve, "resolver");
+		}
+		start = htickCount();
+		foreach (hthread*, it, threads)
+		{
+			(*it)->start();
+		}
+		foreach (hthread*, it, threads)
+		{
+			(*it)->join();
+			delete (*it);
+		}
+		time = hmax(htickCount() - start, (int64_t)1);
+		threads.clear();
+		// with a global lock around the resolver, more threads can't do more calls per second
+		hlog::writef(LOG_TAG, "%d threads: %d calls in %d ms, %.0f calls per second", count, count * RESOLVER_CALLS * 2, (int)time,
+			count * RESOLVER_CALLS * 2 * 1000.0f / time);
+	}
+	sakit::setDnsCacheTtl(ttl, negativeTtl);
+}
+
+hstr _makeResponse(int chunkSize)
+{
+	hstr result = "HTTP/1.1 200 OK\r\nServer: demo_benchmark\r\nContent-Type: application/octet-stream\r\nCache-Control: no-cache\r\n";
+	hstr chunk;
+	if (chunkSize <= 0)
+	{
+		return (result + hsprintf("Content-Length: %d\r\n\r\n", PARSER_BODY_SIZE) + hstr('x', PARSER_BODY_SIZE));
+	}
+	result += "Transfer-Encoding: chunked\r\n\r\n";
+	chunk = hsprintf("%x\r\n", chunkSize) + hstr('x', chunkSize) + "\r\n";
+	for_iter (i, 0, PARSER_BODY_SIZE / chunkSize)
+	{
+		result += chunk;
+	}
+	return (result + "0\r\n\r\n");
+}
+
+/// @param[in] segmentSize The data is appended in pieces of this size like it would be received, 0 appends everything at once.
+bool _parseResponse(sakit::HttpResponse* response, chstr data, int segmentSize)
+{
+	int size = 0;
+	response->clear();
+	if (segmentSize <= 0)
+	{
+		segmentSize = data.size();
+	}
+	for (int offset = 0; offset < data.size(); offset += size)
+	{
+		size = hmin(segmentSize, data.size() - offset);
+		response->raw.seek(0, hstream::END);
+		response->raw.writeRaw(&data.cStr()[offset], size);
+		response->parseFromRaw();
+	}
+	return (response->headersComplete && response->bodyComplete && response->body.size() == PARSER_BODY_SIZE);
+}
+
+void _benchmarkHttpParser()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting benchmark: HTTP response parser");
+	hlog::debug(LOG_TAG, "");
+	harray<int> chunkSizes;
+	chunkSizes += 0;
+	chunkSizes += 65536;
+	chunkSizes += 256;
+	harray<int> segmentSizes;
+	segmentSizes += 0;
+	segmentSizes += PARSER_SEGMENT_SIZE;
+	sakit::HttpResponse response;
+	hstr data;
+	int parsed = 0;
+	int64_t start = 0;
+	int64_t time = 0;
+	foreach (int, it, chunkSizes)
+	{
+		data = _makeResponse(*it);
+		foreach (int, it2, segmentSizes)
+		{
+			parsed = 0;
+			start = htickCount();
+			for_iter (i, 0, PARSER_ITERATIONS)
+			{
+				if (_parseResponse(&response, data, (*it2)))
+				{
+					++parsed;
+				}
+			}
+			time = hmax(htickCount() - start, (int64_t)1);
+			hlog::writef(LOG_TAG, "%s, %s: %d of %d parsed in %d ms, %.1f MB/s", (*it) > 0 ? hsprintf("%d byte chunks", (*it)).cStr() : "Content-Length",
+				(*it2) > 0 ? hsprintf("%d byte segments", (*it2)).cStr() : "at once", parsed, PARSER_ITERATIONS, (int)time,
+				(float)data.size() * parsed * 1000.0f / (time * 1048576.0f));
+		}
+	}
+}
+
+#ifndef _WINRT
+int main(int argc, char **argv)
+#else
+[Platform::MTAThread]
+int main(Platform::Array<Platform::String^>^ args)
+#endif
+{
+	hlog::setLevelDebug(true); // for the nice colors
+	sakit::init();
+	_benchmarkReceiveLatency();
+	_benchmarkUdpSend();
+	_benchmarkConnectRacing();
+	_benchmarkResolverContention();
+	_benchmarkHttpParser();
+	hlog::debug(LOG_TAG, "Done.");
+	sakit::destroy();
+#if defined(_WIN32) && !defined(_WINRT)
+	system("pause");
+#endif
+	return 0;
+}
@@ -0,0 +1,156 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#define LOG_TAG "demo_byte_scanner"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+// the scanner is internal to the library so its source is compiled into this demo
+#include "../../src/ByteScanner.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CYCLE_COUNTER
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#define CORPUS_SIZE 1048576
+#define SCAN_ITERATIONS 100
+
+typedef int64_t (*FindFunction)(const char*, int64_t, char);
+
+/// @note Counts reference cycles of the time stamp counter which can differ from core cycles when the clock is scaled.
+uint64_t _readCycles()
+{
+#ifdef CYCLE_COUNTER
+	return (uint64_t)__rdtsc();
+#else
+	return 0;
+#endif
+}
+
+int64_t _findMemchr(const char* data, int64_t size, char value)
+{
+	const char* result = (const char*)memchr(data, value, (size_t)size);
+	return (result != NULL ? (int64_t)(result - data) : -1);
+}
+
+int64_t _findLoop(const char* data, int64_t size, char value)
+{
+	for_iter (i, 0, size)
+	{
+		if (data[i] == value)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/// @brief Repeats the pattern until the corpus has its size.
+hstr _makeCorpus(chstr pattern)
+{
+	hstr result;
+	while (result.size() + pattern.size() <= CORPUS_SIZE)
+	{
+		result += pattern;
+	}
+	return result;
+}
+
+/// @brief Finds all line ends in the corpus the way the HTTP parser does.
+/// @return Number of found line ends.
+int _scanCorpus(FindFunction function, chstr corpus)
+{
+	const char* data = corpus.cStr();
+	int64_t size = corpus.size();
+	int64_t offset = 0;
+	int64_t index = 0;
+	int lines = 0;
+	while (offset < size)
+	{
+		index = (*function)(&data[offset], size - offset, '\n');
+		if (index < 0)
+		{
+			break;
+		}
+		offset += index + 1;
+		++lines;
+	}
+	return lines;
+}
+
+void _benchmarkCorpus(chstr name, chstr corpus)
+{
+	harray<hstr> functionNames;
+	harray<FindFunction> functions;
+	functionNames += sakit::_getByteScannerName();
+	functions += &sakit::_findByte;
+	functionNames += "memchr";
+	functions += &_findMemchr;
+	functionNames += "loop";
+	functions += &_findLoop;
+	int lines = 0;
+	uint64_t cycles = 0;
+	int64_t start = 0;
+	int64_t time = 0;
+	double bytes = (double)corpus.size() * SCAN_ITERATIONS;
+	for_iter (i, 0, functions.size())
+	{
+		lines = 0;
+		start = htickCount();
+		cycles = _readCycles();
+		for_iter (j, 0, SCAN_ITERATIONS)
+		{
+			lines += _scanCorpus(functions[i], corpus);
+		}
+		cycles = _readCycles() - cycles;
+		time = hmax(htickCount() - start, (int64_t)1);
+		if (cycles > 0)
+		{
+			hlog::writef(LOG_TAG, "%s, %s: %d line ends, %.2f bytes per cycle, %.0f MB/s", name.cStr(), functionNames[i].cStr(), lines / SCAN_ITERATIONS,
+				bytes / cycles, bytes * 1000.0 / (time * 1048576.0));
+		}
+		else
+		{
+			hlog::writef(LOG_TAG, "%s, %s: %d line ends, %.0f MB/s", name.cStr(), functionNames[i].cStr(), lines / SCAN_ITERATIONS, bytes * 1000.0 / (time * 1048576.0));
+		}
+	}
+}
+
+#ifndef _WINRT
+int main(int argc, char **argv)
+#else
+[Platform::MTAThread]
+int main(Platform::Array<Platform::String^>^ args)
+#endif
+{
+	hlog::setLevelDebug(true); // for the nice colors
+	hlog::write(LOG_TAG, "scanning with: " + sakit::_getByteScannerName());
+	// short header lines, one line end every few dozen bytes
+	_benchmarkCorpus("headers", _makeCorpus("HTTP/1.1 200 OK\r\nServer: demo_byte_scanner\r\nContent-Type: text/html; charset=utf-8\r\n"
+		"Cache-Control: no-cache\r\nTransfer-Encoding: chunked\r\nConnection: keep-alive\r\n\r\n"));
+	// size lines between chunks of a chunked body
+	_benchmarkCorpus("256 byte chunks", _makeCorpus("100\r\n" + hstr('x', 256) + "\r\n"));
+	// a body without any line ends is scanned in one go
+	_benchmarkCorpus("body", hstr('x', CORPUS_SIZE));
+	hlog::debug(LOG_TAG, "Done.");
+#if defined(_WIN32) && !defined(_WINRT)
+	system("pause");
+#endif
+	return 0;
+}
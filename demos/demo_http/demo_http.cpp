@@ -0,0 +1,720 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#define LOG_TAG "demo_http"
+
+#include <hltypes/harray.h>
+#include <hltypes/hfile.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
+
+#include <sakit/HttpBodySink.h>
+#include <sakit/HttpClient.h>
+#include <sakit/HttpClientDelegate.h>
+#include <sakit/HttpDownloadSink.h>
+#include <sakit/HttpResponse.h>
+#include <sakit/HttpSegmentedDownload.h>
+#include <sakit/HttpSegmentedDownloadDelegate.h>
+#include <sakit/HttpSocket.h>
+#include <sakit/HttpSocketDelegate.h>
+#include <sakit/sakit.h>
+#include <sakit/TcpServer.h>
+#include <sakit/TcpServerDelegate.h>
+#include <sakit/TcpSocket.h>
+#include <sakit/TcpSocketDelegate.h>
+#include <sakit/Url.h>
+
+#define HTTP_PORT 53000
+#define HTTP_URL "http://127.0.0.1:53000"
+#define SEND_CHUNK_SIZE 65536
+#define POOL_REQUESTS 200
+#define PIPELINE_REQUESTS 200
+#define PIPELINE_CLOSE_AFTER 16
+#define PIPELINE_DEPTH 16
+#define SLOW_SINK_SIZE 1048576
+#define SLOW_SINK_TIMEOUT 0.5f
+#define RESUME_SIZE 4194304
+#define RESUME_FILENAME "demo_http_resume.bin"
+#define SEGMENTED_SIZE 67108864
+#define SEGMENTED_SEND_RATE 16777216
+#define SEGMENTED_FILENAME "demo_http_segmented.bin"
+
+sakit::TcpServerDelegate tcpServerDelegate;
+sakit::TcpSocketDelegate tcpSocketDelegate;
+
+class HttpSocketDelegate : public sakit::HttpSocketDelegate
+{
+public:
+	int completed;
+	int failed;
+
+	HttpSocketDelegate() : sakit::HttpSocketDelegate(), completed(0), failed(0)
+	{
+	}
+
+	void onExecuteCompleted(sakit::HttpSocket* socket, sakit::HttpResponse* response, sakit::Url url)
+	{
+		++this->completed;
+	}
+
+	void onExecuteFailed(sakit::HttpSocket* socket, sakit::HttpResponse* response, sakit::Url url)
+	{
+		++this->failed;
+	}
+
+} httpSocketDelegate;
+
+/// @brief A minimal HTTP/1.1 server with persistent connections for testing the clients locally.
+/// @note "/data/<size>" responds with <size> bytes of data and supports ranges, everything else with a short text.
+class HttpServer : public hthread
+{
+public:
+	HttpServer() : hthread(&process, "HTTP server"), server(NULL), connectionCount(0), requestCount(0), closeAfter(0), sendRate(0), interruptNext(false)
+	{
+	}
+
+	~HttpServer()
+	{
+		this->unbind();
+	}
+
+	int getConnectionCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->connectionCount;
+	}
+
+	int getRequestCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->requestCount;
+	}
+
+	/// @brief Connections are closed after this many responses without announcing it, 0 keeps them open.
+	void setCloseAfter(int value)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->closeAfter = value;
+	}
+
+	/// @brief Limits how many bytes per second are sent over each connection, 0 doesn't limit it.
+	void setSendRate(int64_t value)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->sendRate = value;
+	}
+
+	/// @brief The connection of the next data response is closed after half of the body was sent.
+	void interruptNextData()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->interruptNext = true;
+	}
+
+	bool bind(unsigned short port)
+	{
+		this->server = new sakit::TcpServer(&tcpServerDelegate, &tcpSocketDelegate);
+		this->server->setTimeout(0.1f);
+		if (!this->server->bind(sakit::Host(127, 0, 0, 1), port))
+		{
+			delete this->server;
+			this->server = NULL;
+			return false;
+		}
+		this->server->accept(); // starts listening so clients can connect right away
+		this->start();
+		return true;
+	}
+
+	void unbind()
+	{
+		if (this->server == NULL)
+		{
+			return;
+		}
+		this->executing = false;
+		this->join();
+		foreach (Connection*, it, this->connections)
+		{
+			(*it)->stop();
+			delete (*it);
+		}
+		this->connections.clear();
+		this->server->unbind();
+		delete this->server;
+		this->server = NULL;
+	}
+
+	static unsigned char getData(int64_t offset)
+	{
+		return (unsigned char)(offset % 251);
+	}
+
+protected:
+	class Connection : public hthread
+	{
+	public:
+		Connection(HttpServer* server, sakit::TcpSocket* socket) : hthread(&process, "HTTP server connection"), server(server), socket(socket)
+		{
+			// like most servers, idle connections are closed after a while
+			this->socket->setTimeout(1.0f);
+		}
+
+		void stop()
+		{
+			this->executing = false;
+			this->join();
+		}
+
+	protected:
+		HttpServer* server;
+		/// @note Accepted sockets belong to the TcpServer which deletes them once they are disconnected.
+		sakit::TcpSocket* socket;
+
+		static void process(hthread* thread)
+		{
+			Connection* connection = (Connection*)thread;
+			hstr buffer;
+			hstr received;
+			int index = 0;
+			int responses = 0;
+			while (connection->executing && connection->socket->isConnected())
+			{
+				received = connection->socket->receive();
+				if (received == "") // the client has closed the connection or it was idle for too long
+				{
+					break;
+				}
+				buffer += received;
+				// pipelined requests can arrive together
+				for (index = buffer.indexOf("\r\n\r\n"); index >= 0; index = buffer.indexOf("\r\n\r\n"))
+				{
+					++responses;
+					if (!connection->server->_respond(connection->socket, buffer(0, index), responses))
+					{
+						connection->socket->disconnect();
+						return;
+					}
+					buffer = buffer(index + 4, -1);
+				}
+			}
+			connection->socket->disconnect();
+		}
+
+	};
+
+	sakit::TcpServer* server;
+	harray<Connection*> connections;
+	hmutex mutex;
+	int connectionCount;
+	int requestCount;
+	int closeAfter;
+	int64_t sendRate;
+	bool interruptNext;
+
+	/// @return False if the connection has to be closed.
+	bool _respond(sakit::TcpSocket* socket, chstr request, int responses)
+	{
+		harray<hstr> lines = request.split("\r\n");
+		harray<hstr> requestLine = lines.first().split(' ');
+		hmap<hstr, hstr> headers;
+		int index = 0;
+		for_iter (i, 1, lines.size())
+		{
+			index = lines[i].indexOf(':');
+			if (index > 0)
+			{
+				headers[lines[i](0, index).trimmed().lowered()] = lines[i](index + 1, -1).trimmed();
+			}
+		}
+		if (requestLine.size() < 3)
+		{
+			return false;
+		}
+		hstr method = requestLine[0];
+		hstr path = requestLine[1];
+		hmutex::ScopeLock lock(&this->mutex);
+		++this->requestCount;
+		bool keepAlive = (headers.tryGet("connection", "") != "close");
+		bool closing = (this->closeAfter > 0 && responses >= this->closeAfter);
+		bool interrupt = false;
+		int64_t sendRate = this->sendRate;
+		if (path.startsWith("/data/"))
+		{
+			interrupt = this->interruptNext;
+			this->interruptNext = false;
+		}
+		lock.release();
+		hstr status = "200 OK";
+		hstr extraHeaders;
+		int64_t size = 6;
+		int64_t first = 0;
+		int64_t last = 5;
+		if (path.startsWith("/data/"))
+		{
+			size = (int)path(6, -1);
+			first = 0;
+			last = size - 1;
+			hstr eTag = "\"data-" + hstr(size) + "\"";
+			extraHeaders = "ETag: " + eTag + "\r\nAccept-Ranges: bytes\r\n";
+			hstr range = headers.tryGet("range", "");
+			// the whole file is sent if it has changed since the range was requested
+			if (range.startsWith("bytes=") && range.indexOf('-') > 0 && headers.tryGet("if-range", eTag) == eTag)
+			{
+				harray<hstr> limits = range(6, -1).split('-', 1);
+				first = hclamp((int64_t)(int)limits[0], (int64_t)0, size - 1);
+				last = (limits[1].trimmed() != "" ? hclamp((int64_t)(int)limits[1], first, size - 1) : size - 1);
+				status = "206 Partial Content";
+				extraHeaders += hsprintf("Content-Range: bytes %lld-%lld/%lld\r\n", (long long)first, (long long)last, (long long)size);
+			}
+		}
+		hstream stream;
+		stream.write("HTTP/1.1 " + status + "\r\n" + hsprintf("Content-Length: %lld\r\n", (long long)(last - first + 1)) + extraHeaders +
+			(keepAlive && !interrupt ? "" : "Connection: close\r\n") + "\r\n");
+		int64_t end = (interrupt ? first + (last - first + 1) / 2 : last + 1);
+		if (method == "HEAD")
+		{
+			end = first;
+		}
+		int64_t offset = first;
+		unsigned char data[SEND_CHUNK_SIZE];
+		int chunkSize = 0;
+		int64_t start = htickCount();
+		int64_t delay = 0;
+		do
+		{
+			chunkSize = (int)hmin(end - offset, (int64_t)SEND_CHUNK_SIZE);
+			if (!path.startsWith("/data/"))
+			{
+				stream.write(hstr("Hello.")(0, chunkSize));
+			}
+			else
+			{
+				for_iter (i, 0, chunkSize)
+				{
+					data[i] = HttpServer::getData(offset + i);
+				}
+				stream.writeRaw(data, chunkSize);
+			}
+			offset += chunkSize;
+			stream.rewind();
+			if (socket->send(&stream) < stream.size())
+			{
+				return false;
+			}
+			stream.clear();
+			if (sendRate > 0)
+			{
+				// like a link where each connection only gets part of the bandwidth
+				delay = (offset - first) * 1000 / sendRate - (htickCount() - start);
+				if (delay > 0)
+				{
+					hthread::sleep((float)delay);
+				}
+			}
+		} while (offset < end);
+		return (keepAlive && !interrupt && !closing);
+	}
+
+	static void process(hthread* thread)
+	{
+		HttpServer* server = (HttpServer*)thread;
+		sakit::TcpSocket* socket = NULL;
+		Connection* connection = NULL;
+		while (server->executing)
+		{
+			socket = server->server->accept();
+			if (socket != NULL)
+			{
+				connection = new Connection(server, socket);
+				hmutex::ScopeLock lock(&server->mutex);
+				++server->connectionCount;
+				lock.release();
+				server->connections += connection;
+				connection->start();
+			}
+		}
+	}
+
+};
+
+HttpServer httpServer;
+
+class HttpClientDelegate : public sakit::HttpClientDelegate
+{
+public:
+	int completed;
+	int failed;
+
+	HttpClientDelegate() : sakit::HttpClientDelegate(), completed(0), failed(0)
+	{
+	}
+
+	void onExecuteCompleted(sakit::HttpClient* client, sakit::HttpResponse* response, sakit::Url url)
+	{
+		++this->completed;
+	}
+
+	void onExecuteFailed(sakit::HttpClient* client, sakit::HttpResponse* response, sakit::Url url)
+	{
+		++this->failed;
+	}
+
+} httpClientDelegate;
+
+/// @param[out] reused Number of requests that were sent over an already opened connection.
+/// @return Time in milliseconds it took until all requests were completed.
+int64_t _executeRequests(bool pooled, int& reused)
+{
+	sakit::Url url(HTTP_URL "/hello");
+	int connections = httpServer.getConnectionCount();
+	httpClientDelegate.completed = 0;
+	httpClientDelegate.failed = 0;
+	sakit::HttpClient* client = new sakit::HttpClient(&httpClientDelegate);
+	client->setMaxConnectionsPerHost(4);
+	if (!pooled)
+	{
+		// without idle connections every request has to open a new one
+		client->setMaxIdleConnections(0);
+	}
+	int64_t start = htickCount();
+	for_iter (i, 0, POOL_REQUESTS)
+	{
+		client->executeGetAsync(url);
+	}
+	while (httpClientDelegate.completed + httpClientDelegate.failed < POOL_REQUESTS)
+	{
+		// queued requests are only started when completions are delivered in update(), a long sleep would hide the time a new connection takes
+		sakit::update();
+		hthread::sleep(0.1f);
+	}
+	int64_t time = htickCount() - start;
+	reused = (int)client->getReusedConnectionCount();
+	hlog::writef(LOG_TAG, "pooling %s: %d of %d completed, %d failed in %d ms over %d connections (%d opened, %d reused)", pooled ? "on" : "off",
+		httpClientDelegate.completed, POOL_REQUESTS, httpClientDelegate.failed, (int)time, httpServer.getConnectionCount() - connections,
+		(int)client->getOpenedConnectionCount(), reused);
+	delete client;
+	return time;
+}
+
+void _testClientPool()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting test: HTTP client connection pool");
+	hlog::debug(LOG_TAG, "");
+	int unpooledReused = 0;
+	int pooledReused = 0;
+	int64_t unpooledTime = _executeRequests(false, unpooledReused);
+	int64_t pooledTime = _executeRequests(true, pooledReused);
+	if (pooledReused <= unpooledReused)
+	{
+		hlog::error(LOG_TAG, "pooled connections were not reused!");
+	}
+	if (pooledTime < unpooledTime)
+	{
+		hlog::writef(LOG_TAG, "pooling is %.1f times as fast", (double)unpooledTime / hmax(pooledTime, (int64_t)1));
+	}
+	else
+	{
+		hlog::error(LOG_TAG, "pooling is not faster!");
+	}
+}
+
+/// @return Time in milliseconds it took until all requests were completed.
+int64_t _executeBurst(bool pipelining, int closeAfter)
+{
+	sakit::Url url(HTTP_URL "/hello");
+	int connections = httpServer.getConnectionCount();
+	httpServer.setCloseAfter(closeAfter);
+	httpClientDelegate.completed = 0;
+	httpClientDelegate.failed = 0;
+	sakit::HttpClient* client = new sakit::HttpClient(&httpClientDelegate);
+	client->setMaxConnectionsPerHost(1);
+	client->setPipelining(pipelining);
+	client->setMaxPipelinedRequests(PIPELINE_DEPTH);
+	int64_t start = htickCount();
+	for_iter (i, 0, PIPELINE_REQUESTS)
+	{
+		client->executeGetAsync(url);
+	}
+	while (httpClientDelegate.completed + httpClientDelegate.failed < PIPELINE_REQUESTS)
+	{
+		sakit::update();
+		hthread::sleep(1.0f);
+	}
+	int64_t time = htickCount() - start;
+	hlog::writef(LOG_TAG, "pipelining %s, server closes %s: %d of %d completed, %d failed in %d ms over %d connections (%d pipelined)", pipelining ? "on" : "off",
+		closeAfter > 0 ? hsprintf("after %d responses", closeAfter).cStr() : "never", httpClientDelegate.completed, PIPELINE_REQUESTS, httpClientDelegate.failed,
+		(int)time, httpServer.getConnectionCount() - connections, (int)client->getPipelinedRequestCount());
+	delete client;
+	httpServer.setCloseAfter(0);
+	return time;
+}
+
+void _testPipelining()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting test: HTTP pipelining of a burst of requests");
+	hlog::debug(LOG_TAG, "");
+	int64_t sequentialTime = _executeBurst(false, 0);
+	int64_t pipelinedTime = _executeBurst(true, 0);
+	if (pipelinedTime < sequentialTime)
+	{
+		hlog::writef(LOG_TAG, "pipelining is %.1f times as fast", (double)sequentialTime / hmax(pipelinedTime, (int64_t)1));
+	}
+	else
+	{
+		hlog::error(LOG_TAG, "pipelining is not faster!");
+	}
+	// the requests that were still unanswered when the server closed the connection are sent again on a new one
+	_executeBurst(true, PIPELINE_CLOSE_AFTER);
+}
+
+/// @brief Doesn't accept anything until the application has caught up and checks the data afterwards.
+class SlowBodySink : public sakit::HttpBodySink
+{
+public:
+	int64_t blockedUntil;
+	int64_t received;
+	bool valid;
+
+	SlowBodySink(int64_t blockedUntil) : sakit::HttpBodySink(), blockedUntil(blockedUntil), received(0), valid(true)
+	{
+	}
+
+	int write(const unsigned char* data, int size)
+	{
+		if (htickCount() < this->blockedUntil)
+		{
+			return 0;
+		}
+		for_iter (i, 0, size)
+		{
+			if (data[i] != HttpServer::getData(this->received + i))
+			{
+				this->valid = false;
+			}
+		}
+		this->received += size;
+		return size;
+	}
+
+};
+
+void _executeSlowBodySink(bool async)
+{
+	sakit::Url url(HTTP_URL "/data/" + hstr(SLOW_SINK_SIZE));
+	sakit::HttpSocket* socket = new sakit::HttpSocket(&httpSocketDelegate);
+	sakit::HttpResponse response;
+	// the sink blocks for longer than the timeout, but the server isn't the one who is late
+	SlowBodySink sink(htickCount() + (int64_t)(SLOW_SINK_TIMEOUT * 4000));
+	socket->setTimeout(SLOW_SINK_TIMEOUT);
+	socket->setBodySink(&sink);
+	bool success = false;
+	int64_t start = htickCount();
+	if (async)
+	{
+		httpSocketDelegate.completed = 0;
+		httpSocketDelegate.failed = 0;
+		if (socket->executeGetAsync(url))
+		{
+			while (httpSocketDelegate.completed + httpSocketDelegate.failed == 0)
+			{
+				sakit::update();
+				hthread::sleep(1.0f);
+			}
+			success = (httpSocketDelegate.completed > 0);
+		}
+	}
+	else
+	{
+		success = socket->executeGet(&response, url);
+	}
+	hlog::writef(LOG_TAG, "%s: %s after %d ms, %d of %d bytes in the sink, data %s", async ? "async" : "sync", success ? "completed" : "failed",
+		(int)(htickCount() - start), (int)sink.received, SLOW_SINK_SIZE, sink.valid ? "valid" : "invalid");
+	delete socket;
+}
+
+void _testSlowBodySink()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting test: body sink that blocks for longer than the timeout");
+	hlog::debug(LOG_TAG, "");
+	_executeSlowBodySink(false);
+	_executeSlowBodySink(true);
+}
+
+/// @return True if the file contains exactly the data that the server sends.
+bool _checkDownloadedFile(chstr filename, int64_t size)
+{
+	hfile file;
+	file.open(filename);
+	if (file.size() != size)
+	{
+		return false;
+	}
+	unsigned char data[SEND_CHUNK_SIZE];
+	int64_t offset = 0;
+	int count = 0;
+	while (offset < size)
+	{
+		count = file.readRaw(data, SEND_CHUNK_SIZE);
+		if (count <= 0)
+		{
+			return false;
+		}
+		for_iter (i, 0, count)
+		{
+			if (data[i] != HttpServer::getData(offset + i))
+			{
+				return false;
+			}
+		}
+		offset += count;
+	}
+	return true;
+}
+
+void _testResumeDownload()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting test: resuming an interrupted download");
+	hlog::debug(LOG_TAG, "");
+	sakit::Url url(HTTP_URL "/data/" + hstr(RESUME_SIZE));
+	// leftovers of an earlier run would be resumed as well
+	hfile::remove(RESUME_FILENAME);
+	hfile::remove(RESUME_FILENAME ".resume");
+	sakit::HttpSocket* socket = new sakit::HttpSocket(&httpSocketDelegate);
+	sakit::HttpDownloadSink* sink = new sakit::HttpDownloadSink();
+	sakit::HttpResponse response;
+	// the server closes the connection after half of the file
+	httpServer.interruptNextData();
+	sink->open(RESUME_FILENAME);
+	bool success = socket->executeDownload(&response, url, sink);
+	hlog::writef(LOG_TAG, "interrupted: %s with status %d, %d of %d bytes downloaded", success ? "completed" : "failed", (int)response.statusCode,
+		(int)sink->getDownloadedSize(), RESUME_SIZE);
+	sink->close();
+	delete sink;
+	// a new sink continues from the state that was kept next to the file
+	sink = new sakit::HttpDownloadSink();
+	sink->open(RESUME_FILENAME);
+	int64_t resumedFrom = sink->getDownloadedSize();
+	response.clear();
+	success = socket->executeDownload(&response, url, sink);
+	hlog::writef(LOG_TAG, "resumed from %d: %s with status %d, %d of %d bytes downloaded, file %s", (int)resumedFrom, success ? "completed" : "failed",
+		(int)response.statusCode, (int)sink->getDownloadedSize(), RESUME_SIZE, sink->isComplete() ? "complete" : "incomplete");
+	sink->close();
+	delete sink;
+	delete socket;
+	hlog::writef(LOG_TAG, "resumed download: partial response %s, data %s, state file %s", response.statusCode == sakit::HttpResponse::PARTIAL_CONTENT ? "yes" : "no",
+		_checkDownloadedFile(RESUME_FILENAME, RESUME_SIZE) ? "valid" : "invalid", hfile::exists(RESUME_FILENAME ".resume") ? "kept" : "removed");
+	hfile::remove(RESUME_FILENAME);
+}
+
+class HttpSegmentedDownloadDelegate : public sakit::HttpSegmentedDownloadDelegate
+{
+public:
+	int completed;
+	int failed;
+
+	HttpSegmentedDownloadDelegate() : sakit::HttpSegmentedDownloadDelegate(), completed(0), failed(0)
+	{
+	}
+
+	void onDownloadCompleted(sakit::HttpSegmentedDownload* download)
+	{
+		++this->completed;
+	}
+
+	void onDownloadFailed(sakit::HttpSegmentedDownload* download)
+	{
+		++this->failed;
+	}
+
+} httpSegmentedDownloadDelegate;
+
+void _executeSegmentedDownload(int connectionCount)
+{
+	sakit::Url url(HTTP_URL "/data/" + hstr(SEGMENTED_SIZE));
+	hfile::remove(SEGMENTED_FILENAME);
+	hfile::remove(SEGMENTED_FILENAME ".resume");
+	httpSegmentedDownloadDelegate.completed = 0;
+	httpSegmentedDownloadDelegate.failed = 0;
+	int connections = httpServer.getConnectionCount();
+	sakit::HttpSegmentedDownload* download = new sakit::HttpSegmentedDownload(&httpSegmentedDownloadDelegate, connectionCount);
+	int64_t start = htickCount();
+	int64_t time = 0;
+	if (download->start(url, SEGMENTED_FILENAME))
+	{
+		while (httpSegmentedDownloadDelegate.completed + httpSegmentedDownloadDelegate.failed == 0)
+		{
+			sakit::update();
+			hthread::sleep(1.0f);
+		}
+	}
+	time = hmax(htickCount() - start, (int64_t)1);
+	hlog::writef(LOG_TAG, "%d parallel: %s in %d ms, %.0f MB/s, %d connections opened, %d splits, data %s", connectionCount,
+		httpSegmentedDownloadDelegate.completed > 0 ? "completed" : "failed", (int)time, SEGMENTED_SIZE * 1000.0 / (time * 1048576.0),
+		httpServer.getConnectionCount() - connections, download->getSplitCount(), _checkDownloadedFile(SEGMENTED_FILENAME, SEGMENTED_SIZE) ? "valid" : "invalid");
+	delete download;
+	hfile::remove(SEGMENTED_FILENAME);
+}
+
+void _benchmarkSegmentedDownload()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting benchmark: segmented download over several connections");
+	hlog::debug(LOG_TAG, "");
+	hlog::write(LOG_TAG, "unlimited connections:");
+	_executeSegmentedDownload(1);
+	_executeSegmentedDownload(2);
+	_executeSegmentedDownload(4);
+	_executeSegmentedDownload(8);
+	hlog::writef(LOG_TAG, "connections limited to %d MB/s:", SEGMENTED_SEND_RATE / 1048576);
+	httpServer.setSendRate(SEGMENTED_SEND_RATE);
+	_executeSegmentedDownload(1);
+	_executeSegmentedDownload(2);
+	_executeSegmentedDownload(4);
+	_executeSegmentedDownload(8);
+	httpServer.setSendRate(0);
+}
+
+#ifndef _WINRT
+int main(int argc, char **argv)
+#else
+[Platform::MTAThread]
+int main(Platform::Array<Platform::String^>^ args)
+#endif
+{
+	hlog::setLevelDebug(true); // for the nice colors
+	sakit::init();
+	if (httpServer.bind(HTTP_PORT))
+	{
+		_testClientPool();
+		_testPipelining();
+		_testSlowBodySink();
+		_testResumeDownload();
+		_benchmarkSegmentedDownload();
+		httpServer.unbind();
+	}
+	else
+	{
+		hlog::error(LOG_TAG, "Could not bind HTTP server!");
+	}
+	hlog::debug(LOG_TAG, "Done.");
+	sakit::destroy();
+#if defined(_WIN32) && !defined(_WINRT)
+	system("pause");
+#endif
+	return 0;
+}
@@ -14,6 +14,8 @@
 #include <hltypes/hstring.h>
 #include <hltypes/hthread.h>
 
+#include <sakit/OutgoingDatagram.h>
+#include <sakit/ResolverDelegate.h>
 #include <sakit/sakit.h>
 #include <sakit/Socket.h>
 #include <sakit/TcpServer.h>
@@ -38,6 +40,8 @@
 #define UDP_PORT_ASYNC_CLIENT 50201
 #define UDP_PORT_MULTICAST_CLIENT_1 50300
 #define UDP_PORT_MULTICAST_CLIENT_2 50301
+#define UDP_PORT_DNS_SERVER 50400
+#define UDP_PORT_DNS_SPOOFER 50401
 #define UDP_PORT_BROADCAST 51000
 #define UDP_MULTICAST_HOST_ADDRESS "192.168.1.109" // this needs changing depending on the machine
 #define UDP_MULTICAST_ADDRESS "226.2.3.4"
@@ -300,6 +304,101 @@ public:
 
 } httpSocketDelegate;
 
+class ResolverDelegate : public sakit::ResolverDelegate
+{
+public:
+	int count;
+
+	ResolverDelegate() : sakit::ResolverDelegate(), count(0)
+	{
+	}
+
+	void onResolved(sakit::Host domain, const harray<sakit::Host>& ips)
+	{
+		++this->count;
+		harray<hstr> addresses;
+		foreachc (sakit::Host, it, ips)
+		{
+			addresses += (*it).toString();
+		}
+		hlog::writef(LOG_TAG, "- RESOLVER resolved '%s': %s", domain.toString().cStr(), addresses.joined(", ").cStr());
+	}
+
+	void onResolveFailed(sakit::Host domain)
+	{
+		++this->count;
+		hlog::writef(LOG_TAG, "- RESOLVER failed to resolve '%s'", domain.toString().cStr());
+	}
+
+} resolverDelegate;
+
+sakit::UdpSocket* dnsServer = NULL;
+sakit::UdpSocket* dnsSpoofer = NULL;
+bool dnsServerRunning = false;
+
+// answers A queries for "stub.test" with 10.0.0.1, "large.test" with a truncated response, "missing.test" with NXDOMAIN and ignores everything else
+void _runStubDns(hthread* thread)
+{
+	hstream stream;
+	sakit::Host remoteHost;
+	unsigned short remotePort = 0;
+	unsigned char data[512];
+	unsigned char answer[16] = {0xC0, 0x0C, 0, 1, 0, 1, 0, 0, 0, 60, 0, 4, 10, 0, 0, 1}; // name pointer, A, IN, TTL, size, address
+	int size = 0;
+	int offset = 0;
+	hstr name;
+	harray<sakit::OutgoingDatagram> datagrams;
+	while (dnsServerRunning)
+	{
+		stream.clear();
+		size = dnsServer->receive(&stream, remoteHost, remotePort);
+		if (size < 17 || size > 496)
+		{
+			continue;
+		}
+		stream.rewind();
+		stream.readRaw(data, size);
+		name = "";
+		for (offset = 12; offset < size && data[offset] != 0; offset += data[offset] + 1)
+		{
+			name += (name != "" ? "." : "") + hstr((char*)&data[offset + 1], data[offset]);
+		}
+		if (offset + 5 > size)
+		{
+			continue;
+		}
+		hlog::writef(LOG_TAG, "- DNS SERVER received query for '%s' (type %d)", name.cStr(), data[offset + 2]);
+		if (name != "stub.test" && name != "large.test" && name != "missing.test")
+		{
+			continue;
+		}
+		size = offset + 5; // the answer directly follows the question
+		data[2] = 0x81; // response, recursion desired
+		data[3] = (name == "missing.test" ? 0x83 : 0x80); // recursion available, NXDOMAIN
+		if (name == "large.test")
+		{
+			data[2] |= 0x02; // truncated
+		}
+		else if (name == "stub.test" && data[offset + 2] == 1)
+		{
+			data[7] = 1; // one answer
+			memcpy(&data[size], answer, 16);
+			size += 16;
+			// a forged response with the right ID from a different port has to be ignored
+			answer[15] = 66;
+			memcpy(&data[size - 16], answer, 16);
+			datagrams.clear();
+			datagrams += sakit::OutgoingDatagram(remoteHost, remotePort, data, size);
+			dnsSpoofer->sendBatch(datagrams);
+			answer[15] = 1;
+			memcpy(&data[size - 16], answer, 16);
+		}
+		datagrams.clear();
+		datagrams += sakit::OutgoingDatagram(remoteHost, remotePort, data, size);
+		dnsServer->sendBatch(datagrams);
+	}
+}
+
 void _testAsyncTcpServer()
 {
 	hlog::debug(LOG_TAG, "");
@@ -595,6 +694,56 @@ void _testAsyncUdpClient()
 	delete server;
 }
 
+void _testAsyncResolver()
+{
+	hlog::debug(LOG_TAG, "");
+	hlog::debug(LOG_TAG, "starting test: async resolver with a local DNS server");
+	hlog::debug(LOG_TAG, "");
+	sakit::Host localhost(127, 0, 0, 1);
+	harray<sakit::Host> servers;
+	servers += localhost;
+	dnsServer = new sakit::UdpSocket(&udpClientDelegate);
+	dnsSpoofer = new sakit::UdpSocket(&udpClientDelegate);
+	dnsServer->setTimeout(0.1f);
+	if (dnsServer->bind(localhost, UDP_PORT_DNS_SERVER) && dnsSpoofer->bind(localhost, UDP_PORT_DNS_SPOOFER))
+	{
+		hthread thread(&_runStubDns, "stub DNS server");
+		dnsServerRunning = true;
+		thread.start();
+		sakit::setDnsServers(servers, UDP_PORT_DNS_SERVER);
+		sakit::resolveHostAsync("stub.test", &resolverDelegate);
+		sakit::resolveHostAsync("large.test", &resolverDelegate);
+		sakit::resolveHostAsync("missing.test", &resolverDelegate);
+		sakit::resolveHostAsync("silent.test", &resolverDelegate);
+		// the unanswered query takes a few retries until it times out
+		while (resolverDelegate.count < 4)
+		{
+			sakit::update();
+			hthread::sleep(100.0f);
+		}
+		hlog::write(LOG_TAG, "Resolving again, only the failure of 'missing.test' is cached, the server is queried for 'silent.test' again.");
+		sakit::resolveHostAsync("missing.test", &resolverDelegate);
+		sakit::resolveHostAsync("silent.test", &resolverDelegate);
+		for_iter (i, 0, 5)
+		{
+			sakit::update();
+			hthread::sleep(100.0f);
+		}
+		sakit::cancelResolveHostAsync(&resolverDelegate);
+		sakit::setDnsServers(harray<sakit::Host>());
+		dnsServerRunning = false;
+		thread.join();
+	}
+	else
+	{
+		hlog::error(LOG_TAG, "Could not bind UDP socket!");
+	}
+	dnsSpoofer->unbind();
+	dnsServer->unbind();
+	delete dnsSpoofer;
+	delete dnsServer;
+}
+
 void _testUdpBroadcast()
 {
 	hlog::debug(LOG_TAG, "");
@@ -745,6 +894,7 @@ int main(Platform::Array<Platform::String^>^ args)
 	// UDP tests
 	_testAsyncUdpServer();
 	_testAsyncUdpClient();
+	_testAsyncResolver();
 	_testUdpBroadcast();
 #ifndef _WINRT // because loopbacks are disabled on WinRT, multicast messages will not arrive and render this test basically useless
 	_testUdpMulticast();
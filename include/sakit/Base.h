@@ -13,6 +13,7 @@
 #ifndef SAKIT_BASE_H
 #define SAKIT_BASE_H
 
+#include <hltypes/harray.h>
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
@@ -20,15 +21,21 @@
 
 #include "Host.h"
 #include "sakitExport.h"
+#include "Span.h"
 #include "State.h"
 
 namespace sakit
 {
+	class Endpoint;
+	class FileTransfer;
 	class PlatformSocket;
 
 	class sakitExport Base
 	{
 	public:
+		friend void _internalUpdate(float timeDelta);
+		friend void _queueUpdate(Base* connection);
+
 		virtual ~Base();
 
 		HL_DEFINE_GET(Host, localHost, LocalHost);
@@ -36,6 +43,7 @@ namespace sakit
 		HL_DEFINE_GET(float, timeout, Timeout);
 		HL_DEFINE_GET(float, retryFrequency, RetryFrequency);
 
+		/// @note A timeout of 0 makes receiving only take what has been received already.
 		void setTimeout(float timeout, float retryFrequency = 0.01f);
 
 		virtual void update(float timeDelta = 0.0f) = 0;
@@ -48,12 +56,22 @@ namespace sakit
 		unsigned short localPort;
 		float timeout;
 		float retryFrequency;
+		/// @note Used to avoid queueing the same connection for an update multiple times.
+		bool updateQueued;
+		/// @note Connections are only queued for an update while they are registered.
+		bool updateRegistered;
 
 		Base();
 
 		int _sendDirect(hstream* stream, int count);
+		int _sendDirect(harray<Span> spans);
+		int64_t _sendDirect(FileTransfer* transfer);
 		int _receiveDirect(hstream* stream, int maxBytes);
-		int _receiveFromDirect(hstream* stream, Host& remoteHost, unsigned short& remotePort);
+		int _receiveDirect(unsigned char* data, int size);
+		int _receiveFromDirect(hstream* stream, Endpoint& remoteEndpoint);
+		/// @brief Blocks in the socket until something can be received or the remaining timeout has passed.
+		/// @param[in,out] ready Whether the previous wait ended because something could be received.
+		void _waitReceive(bool& ready, float timeout);
 
 		void __register();
 		void __unregister();
@@ -0,0 +1,75 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a reference counted batch of datagrams that were received with a single system call.
+
+#ifndef SAKIT_DATAGRAM_BATCH_H
+#define SAKIT_DATAGRAM_BATCH_H
+
+#include <hltypes/hltypesUtil.h>
+
+#include "Endpoint.h"
+#include "Host.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class PlatformSocket;
+
+	/// @note All datagrams are stored in one block of memory that is taken from the same buffer pool as the socket receive buffers.
+	class sakitExport DatagramBatch
+	{
+	public:
+		friend class PlatformSocket;
+
+		/// @note The created batch has a reference count of 1.
+		DatagramBatch(int capacity, int datagramSize);
+
+		HL_DEFINE_GET(int, capacity, Capacity);
+		HL_DEFINE_GET(int, datagramSize, DatagramSize);
+		/// @return Number of datagrams in the batch.
+		int size() const;
+
+		const unsigned char* getData(int index) const;
+		int getSize(int index) const;
+		/// @return True if the datagram was larger than the datagram size of the batch and was cut off.
+		bool isTruncated(int index) const;
+		/// @note The address is only converted when this is called.
+		void getRemoteAddress(int index, Host& remoteHost, unsigned short& remotePort) const;
+		Endpoint getRemoteEndpoint(int index) const;
+
+		/// @brief Keeps the batch alive after the delegate call that provided it has returned.
+		void retain();
+		/// @brief Destroys the batch when the last reference is released.
+		void release();
+
+	protected:
+		int capacity;
+		int datagramSize;
+		int count;
+		/// @note Datagram i starts at i * datagramSize.
+		unsigned char* data;
+		int* sizes;
+		bool* truncated;
+		/// @note Raw socket addresses of the senders.
+		unsigned char* addresses;
+		int* addressSizes;
+		volatile int references;
+
+		/// @note Only destroyed through release().
+		~DatagramBatch();
+
+	private:
+		DatagramBatch(const DatagramBatch& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -0,0 +1,62 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a remote or local endpoint as a binary socket address.
+
+#ifndef SAKIT_ENDPOINT_H
+#define SAKIT_ENDPOINT_H
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "Host.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	/// @note Unlike Host this is never formatted as text unless getHost() or toString() is called.
+	class sakitExport Endpoint
+	{
+	public:
+		Endpoint();
+		/// @param[in] address A raw socket address as received from the system.
+		Endpoint(const void* address, int size);
+		/// @note Only IP addresses can be converted, domains are not resolved.
+		Endpoint(Host host, unsigned short port);
+		~Endpoint();
+
+		HL_DEFINE_GET(int, size, Size);
+		/// @return The raw socket address.
+		const void* getAddress() const;
+		bool isValid() const;
+
+		Host getHost() const;
+		unsigned short getPort() const;
+
+		/// @return The host and port, e.g. "127.0.0.1:80".
+		hstr toString() const;
+		unsigned int hash() const;
+
+		bool operator==(const Endpoint& other) const;
+		bool operator!=(const Endpoint& other) const;
+		/// @note Allows endpoints to be used as map keys.
+		bool operator<(const Endpoint& other) const;
+
+		/// @brief Large enough for every supported kind of socket address.
+		static const int MaxSize = 128;
+
+	protected:
+		unsigned char address[MaxSize];
+		int size;
+
+	};
+
+}
+#endif
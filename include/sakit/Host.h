@@ -30,15 +30,33 @@ namespace sakit
 		Host(unsigned char a, unsigned char b, unsigned char c, unsigned char d);
 		~Host();
 
+		/// @return True for IPv4 and IPv6 addresses.
 		bool isIp() const;
+		bool isIpv4() const;
+		/// @note A scope ID like "%eth0" is allowed at the end.
+		bool isIpv6() const;
+		/// @brief Gets the numeric parts of an IPv4 address without splitting the string.
+		/// @param[out] bytes Has to have room for 4 values.
+		/// @return False if this is not an IPv4 address.
+		bool getIpBytes(unsigned char* bytes) const;
+		/// @brief Gets the numeric parts of an IPv6 address in network byte order without the scope ID.
+		/// @param[out] bytes Has to have room for 16 values.
+		/// @return False if this is not an IPv6 address.
+		bool getIpv6Bytes(unsigned char* bytes) const;
 
 		hstr toString() const;
 
+		/// @brief Formats an IPv6 address in its shortest form, e.g. "::1".
+		/// @param[in] bytes The 16 bytes of the address in network byte order.
+		static Host fromIpv6Bytes(const unsigned char* bytes);
+
 		bool operator==(const Host& other) const;
 		bool operator!=(const Host& other) const;
 
 		static const Host Localhost;
 		static const Host Any;
+		static const Host LocalhostIpv6;
+		static const Host AnyIpv6;
 
 	protected:
 		hstr address;
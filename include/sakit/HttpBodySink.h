@@ -0,0 +1,45 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a receiver for HTTP response bodies that are streamed instead of being kept in memory.
+
+#ifndef SAKIT_HTTP_BODY_SINK_H
+#define SAKIT_HTTP_BODY_SINK_H
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class HttpResponse;
+
+	/// @brief Override write() to receive the decoded body while it's being received.
+	class sakitExport HttpBodySink
+	{
+	public:
+		HttpBodySink();
+		virtual ~HttpBodySink();
+
+		/// @brief Called from the socket's thread with the next part of the decoded body.
+		/// @param[in] data The body data.
+		/// @param[in] size Size of the data in bytes.
+		/// @return Number of bytes that were accepted or a negative value if the request has to fail.
+		/// @note When fewer bytes are accepted, the socket stops receiving and offers the rest again later.
+		virtual int write(const unsigned char* data, int size) = 0;
+		/// @brief Called from the socket's thread once all headers were received, before any of the body is written.
+		/// @param[in] response The response with its status and headers.
+		/// @return False if the request has to fail.
+		virtual bool start(HttpResponse* response);
+		/// @brief Called from the socket's thread once the whole body was written.
+		virtual void finish();
+
+	};
+
+}
+#endif
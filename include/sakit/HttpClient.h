@@ -0,0 +1,156 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a HTTP client that executes requests over a pool of persistent connections.
+
+#ifndef SAKIT_HTTP_CLIENT_H
+#define SAKIT_HTTP_CLIENT_H
+
+#include <stdint.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "HttpSocketDelegate.h"
+#include "sakitExport.h"
+#include "Url.h"
+
+namespace sakit
+{
+	class HttpClientDelegate;
+	class HttpProgress;
+	class HttpResponse;
+	class HttpSocket;
+
+	/// @note Requests are executed asynchronously on keep-alive connections that are reused for later requests to the same host and port.
+	/// @note Requests are queued while all connections to their host are busy and the delegate is called in sakit::update().
+	class sakitExport HttpClient
+	{
+	public:
+		HttpClient(HttpClientDelegate* clientDelegate);
+		~HttpClient();
+
+		HL_DEFINE_GET(float, timeout, Timeout);
+		HL_DEFINE_GET(float, retryFrequency, RetryFrequency);
+		HL_DEFINE_GETSET(int, maxConnectionsPerHost, MaxConnectionsPerHost);
+		/// @note Idle connections beyond this number are closed, the ones that were not used for the longest time first.
+		HL_DEFINE_GETSET(int, maxIdleConnections, MaxIdleConnections);
+		/// @note Time in seconds after which an unused connection is closed.
+		HL_DEFINE_GETSET(float, idleTimeout, IdleTimeout);
+		HL_DEFINE_ISSET(reportProgress, ReportProgress);
+		/// @note When all connections to a host are busy, idempotent requests are pipelined on them instead of waiting.
+		HL_DEFINE_ISSET(pipelining, Pipelining);
+		/// @note See HttpSocket::setMaxPipelinedRequests().
+		HL_DEFINE_GETSET(int, maxPipelinedRequests, MaxPipelinedRequests);
+		/// @return Number of connections that had to be established.
+		HL_DEFINE_GET(int64_t, openedConnectionCount, OpenedConnectionCount);
+		/// @return Number of requests that were sent over an already established connection.
+		HL_DEFINE_GET(int64_t, reusedConnectionCount, ReusedConnectionCount);
+		/// @return Number of requests that were sent while the connection was still waiting for earlier responses.
+		HL_DEFINE_GET(int64_t, pipelinedRequestCount, PipelinedRequestCount);
+		void setTimeout(float timeout, float retryFrequency = 0.01f);
+		/// @return Number of connections that are currently executing a request.
+		int getActiveConnectionCount();
+		/// @return Number of established connections that are waiting for the next request.
+		int getIdleConnectionCount();
+		/// @return Number of requests that are waiting for a free connection.
+		int getQueuedRequestCount();
+
+		bool executeOptionsAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeGetAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeHeadAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executePostAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executePutAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeDeleteAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeTraceAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		bool executeConnectAsync(Url url, chstr customBody = "", hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+
+		/// @brief Closes and destroys all connections that are not executing a request.
+		/// @note Must not be called from within a delegate call.
+		void closeIdleConnections();
+
+	protected:
+		/// @brief Forwards the results of the pooled sockets to the client.
+		class SocketDelegate : public HttpSocketDelegate
+		{
+		public:
+			SocketDelegate(HttpClient* client);
+
+			void onExecuteProgress(HttpSocket* socket, HttpResponse* response, Url url);
+			void onExecuteBodyProgress(HttpSocket* socket, HttpProgress* progress, Url url);
+			void onExecuteCompleted(HttpSocket* socket, HttpResponse* response, Url url);
+			void onExecuteFailed(HttpSocket* socket, HttpResponse* response, Url url);
+
+		protected:
+			HttpClient* client;
+
+		};
+
+		struct Connection
+		{
+			HttpSocket* socket;
+			/// @brief The host and port of the current connection.
+			hstr key;
+			bool leased;
+			int64_t idleSince;
+		};
+
+		struct Request
+		{
+			hstr method;
+			Url url;
+			hstr customBody;
+			hmap<hstr, hstr> customHeaders;
+		};
+
+		HttpClientDelegate* clientDelegate;
+		SocketDelegate socketDelegate;
+		hmutex mutex;
+		harray<Connection> connections;
+		harray<Request> requests;
+		float timeout;
+		float retryFrequency;
+		int maxConnectionsPerHost;
+		int maxIdleConnections;
+		float idleTimeout;
+		bool reportProgress;
+		bool pipelining;
+		int maxPipelinedRequests;
+		int64_t openedConnectionCount;
+		int64_t reusedConnectionCount;
+		int64_t pipelinedRequestCount;
+
+		bool _executeAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders);
+		/// @brief Starts queued requests on connections that became available.
+		void _startQueuedRequests();
+		/// @brief Starts as many queued requests as there are free connections.
+		/// @return Requests that could not be started.
+		harray<Request> _dispatch();
+		/// @return The connection that executes the request or NULL if all connections to the host are busy.
+		Connection* _lease(chstr key);
+		/// @return True if the request was added to a busy connection to its host.
+		bool _pipeline(Request& request, chstr key);
+		void _closeExpiredConnections();
+		/// @brief Marks the connection of the socket as idle once it has no more requests to execute.
+		void _release(HttpSocket* socket);
+		void _failRequests(const harray<Request>& requests);
+
+		static hstr _makeKey(Url& url);
+
+	private:
+		HttpClient(const HttpClient& other); // prevents copying
+
+	};
+
+}
+#endif
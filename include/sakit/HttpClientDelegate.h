@@ -0,0 +1,47 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a HTTP client delegate.
+
+#ifndef SAKIT_HTTP_CLIENT_DELEGATE_H
+#define SAKIT_HTTP_CLIENT_DELEGATE_H
+
+#include "sakitExport.h"
+#include "Url.h"
+
+namespace sakit
+{
+	class HttpClient;
+	class HttpProgress;
+	class HttpResponse;
+
+	class sakitExport HttpClientDelegate
+	{
+	public:
+		friend class HttpClient;
+
+		HttpClientDelegate();
+		virtual ~HttpClientDelegate();
+
+		/// @note Receives a copy of the whole response on every call, onExecuteBodyProgress() is cheaper for large responses.
+		virtual void onExecuteProgress(HttpClient* client, HttpResponse* response, Url url);
+		/// @note Only the body data that was received since the previous call is available in progress.
+		virtual void onExecuteBodyProgress(HttpClient* client, HttpProgress* progress, Url url);
+		virtual void onExecuteCompleted(HttpClient* client, HttpResponse* response, Url url);
+		virtual void onExecuteFailed(HttpClient* client, HttpResponse* response, Url url);
+
+	protected:
+		/// @brief Whether onExecuteProgress() is overridden, the response is only copied for it if it is.
+		bool responseProgress;
+
+	};
+
+}
+#endif
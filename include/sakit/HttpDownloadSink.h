@@ -0,0 +1,82 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a body sink that downloads HTTP response bodies into a preallocated file and can resume interrupted downloads.
+
+#ifndef SAKIT_HTTP_DOWNLOAD_SINK_H
+#define SAKIT_HTTP_DOWNLOAD_SINK_H
+
+#include <stdint.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstring.h>
+
+#include "HttpBodySink.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class DownloadFile;
+	class HttpResponse;
+
+	/// @brief Use with HttpSocket::executeDownload() or HttpSocket::executeDownloadAsync().
+	/// @note The state of an incomplete download is kept in a file next to the downloaded file until the download is complete.
+	class sakitExport HttpDownloadSink : public HttpBodySink
+	{
+	public:
+		friend class HttpSegmentedDownload;
+
+		HttpDownloadSink();
+		~HttpDownloadSink();
+
+		/// @note Maps the file into memory instead of writing to it, where supported. Has to be set before the file is opened.
+		HL_DEFINE_ISSET(mapped, Mapped);
+		hstr getFilename();
+		/// @return Size of the whole file or -1 if it isn't known yet.
+		int64_t getSize();
+		/// @return Number of bytes that were downloaded, including those of earlier interrupted downloads.
+		int64_t getDownloadedSize();
+		bool isOpen();
+		bool isComplete();
+
+		/// @brief Opens the file, an earlier interrupted download of the same file is continued.
+		bool open(chstr filename);
+		/// @note An incomplete download can be continued later by opening the same file again.
+		void close();
+		/// @return The Range and If-Range headers that request only the part of the file that is still missing.
+		hmap<hstr, hstr> makeRequestHeaders();
+
+		bool start(HttpResponse* response);
+		int write(const unsigned char* data, int size);
+		void finish();
+
+	protected:
+		bool mapped;
+		DownloadFile* file;
+		/// @brief Index of the file's segment that is written.
+		int segment;
+		/// @brief Whether the file belongs to a segmented download where other sinks write the other segments.
+		bool shared;
+		/// @brief Whether the server responded with only the requested part of the file.
+		bool partial;
+
+		HttpDownloadSink(DownloadFile* file, int segment);
+
+		/// @return The ETag or Last-Modified value that identifies the version of the file.
+		static hstr _getValidator(HttpResponse* response);
+
+	private:
+		HttpDownloadSink(const HttpDownloadSink& other); // prevents copying
+
+	};
+
+}
+#endif
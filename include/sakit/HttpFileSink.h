@@ -0,0 +1,55 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a body sink that writes HTTP response bodies to a file.
+
+#ifndef SAKIT_HTTP_FILE_SINK_H
+#define SAKIT_HTTP_FILE_SINK_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "HttpBodySink.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class sakitExport HttpFileSink : public HttpBodySink
+	{
+	public:
+		HttpFileSink();
+		~HttpFileSink();
+
+		HL_DEFINE_GET(hstr, filename, Filename);
+		/// @return Number of bytes written since the file was opened.
+		HL_DEFINE_GET(int64_t, writtenSize, WrittenSize);
+		bool isOpen();
+
+		/// @param[in] append Whether the data is appended to an existing file instead of replacing it.
+		bool open(chstr filename, bool append = false);
+		void close();
+
+		int write(const unsigned char* data, int size);
+
+	protected:
+		hstr filename;
+		int64_t writtenSize;
+		FILE* file;
+
+	private:
+		HttpFileSink(const HttpFileSink& other); // prevents copying
+
+	};
+
+}
+#endif
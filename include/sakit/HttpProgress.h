@@ -0,0 +1,53 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines the progress of receiving an HTTP response.
+
+#ifndef SAKIT_HTTP_PROGRESS_H
+#define SAKIT_HTTP_PROGRESS_H
+
+#include <stdint.h>
+
+#include <hltypes/hstream.h>
+
+#include "HttpResponse.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	/// @brief Contains only the body data that was decoded since the previous progress report, not the whole response.
+	class sakitExport HttpProgress
+	{
+	public:
+		HttpResponse::Code statusCode;
+		bool headersComplete;
+		bool bodyComplete;
+		/// @brief The newly decoded body data.
+		/// @note Stays empty when the body is written to a body sink.
+		hstream data;
+		/// @brief Offset of the newly decoded data within the body.
+		int64_t offset;
+		/// @brief Number of newly decoded bytes.
+		/// @note Also set when the body is written to a body sink.
+		int size;
+		/// @brief Number of body bytes decoded so far.
+		int64_t bodySize;
+		/// @brief Size of the whole body or -1 if it isn't known yet.
+		int64_t expectedBodySize;
+		/// @brief Number of bytes received so far, including the status line and headers.
+		int64_t receivedSize;
+
+		HttpProgress();
+		~HttpProgress();
+
+	};
+
+}
+#endif
@@ -64,9 +64,15 @@
 
 namespace sakit
 {
+	class HttpBodySink;
+	class HttpProgress;
+
 	class sakitExport HttpResponse
 	{
 	public:
+		friend class HttpSocket;
+		friend class HttpSocketThread;
+
 		enum Code
 		{
 			UNDEFINED = 0, // server did not respond
@@ -116,7 +122,9 @@ namespace sakit
 		Code statusCode;
 		hstr statusMessage;
 		hmap<hstr, hstr> headers;
+		/// @note Stays empty when the body is written to a body sink.
 		hstream body;
+		/// @note Only contains the headers when the body is written to a body sink.
 		hstream raw;
 		bool headersComplete;
 		bool bodyComplete;
@@ -125,6 +133,8 @@ namespace sakit
 		~HttpResponse();
 
 		void clear();
+		/// @brief Continues parsing where the previous call stopped, so it can be called again whenever new data was appended to raw.
+		/// @note Afterwards the position of raw is at the end of the parsed data.
 		void parseFromRaw();
 		bool hasNewData();
 		int consumeNewData();
@@ -132,13 +142,53 @@ namespace sakit
 		HttpResponse* clone() const;
 
 	protected:
-		int chunkSize;
-		int chunkRead;
+		/// @brief What parseFromRaw() expects next in raw.
+		enum ParserState
+		{
+			PARSER_STATUS_LINE,
+			PARSER_HEADERS,
+			PARSER_BODY,
+			PARSER_CHUNK_SIZE,
+			PARSER_CHUNK_DATA,
+			PARSER_CHUNK_END,
+			PARSER_TRAILERS,
+			PARSER_DONE,
+			PARSER_FAILED
+		};
+
+		/// @note Negative if the body has no predefined length and ends with the connection.
+		int64_t chunkSize;
+		int64_t chunkRead;
 		int newDataSize;
+		/// @brief Number of body bytes that were decoded so far, including the ones written to the body sink.
+		int64_t decodedSize;
+		/// @brief Set for responses to HEAD requests which never have a body.
+		bool bodyless;
+		ParserState parserState;
+		/// @brief Offset in raw up to which the data has been parsed.
+		int64_t parserOffset;
+		/// @brief Offset in raw up to which the current line has been searched for its end.
+		int64_t scanOffset;
+		/// @brief Receives the body instead of it being stored in body.
+		HttpBodySink* bodySink;
+		/// @brief Whether the body sink didn't accept all available data.
+		bool bodySinkBlocked;
+		/// @brief Size of the status line and the headers in raw.
+		int64_t headersSize;
+		/// @brief Number of bytes that were removed from raw after they were written to the body sink.
+		int64_t discardedSize;
 
-		void _getRawData(hstr& data, int& size);
-		void _readHeaders();
-		void _readBody();
+		/// @return Offset of the line feed that ends the current line or -1 if the line hasn't been received completely.
+		int64_t _findLineEnd(const char* data, int64_t size);
+		void _parseStatusLine(const char* line, int size);
+		void _parseHeaderLine(const char* line, int size);
+		/// @brief Determines how the body is transferred once all headers were received.
+		void _startBody();
+		void _finishBody();
+		/// @return A value that increases whenever data was received or parsed.
+		int64_t _getProgress();
+		/// @brief Copies only the body data that was decoded since the previous call into progress and consumes it.
+		void _consumeProgress(HttpProgress* progress);
 
 	};
 
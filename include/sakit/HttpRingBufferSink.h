@@ -0,0 +1,54 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a body sink that keeps HTTP response bodies in a fixed-size ring buffer.
+
+#ifndef SAKIT_HTTP_RING_BUFFER_SINK_H
+#define SAKIT_HTTP_RING_BUFFER_SINK_H
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+
+#include "HttpBodySink.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	/// @note The socket stops receiving while the buffer is full, so the data has to be read regularly, e.g. in onExecuteBodyProgress().
+	class sakitExport HttpRingBufferSink : public HttpBodySink
+	{
+	public:
+		HttpRingBufferSink(int capacity);
+		~HttpRingBufferSink();
+
+		HL_DEFINE_GET(int, capacity, Capacity);
+		/// @return Number of bytes that can be read.
+		int getAvailableSize();
+
+		/// @return Number of bytes that were read.
+		int read(unsigned char* data, int size);
+		void clear();
+
+		int write(const unsigned char* data, int size);
+
+	protected:
+		unsigned char* buffer;
+		int capacity;
+		int start;
+		int size;
+		hmutex mutex;
+
+	private:
+		HttpRingBufferSink(const HttpRingBufferSink& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -0,0 +1,149 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a download that receives parts of a file over several HTTP connections at the same time.
+
+#ifndef SAKIT_HTTP_SEGMENTED_DOWNLOAD_H
+#define SAKIT_HTTP_SEGMENTED_DOWNLOAD_H
+
+#include <stdint.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "HttpSocketDelegate.h"
+#include "sakitExport.h"
+#include "Url.h"
+
+namespace sakit
+{
+	class DownloadFile;
+	class HttpDownloadSink;
+	class HttpProgress;
+	class HttpResponse;
+	class HttpSegmentedDownloadDelegate;
+	class HttpSocket;
+
+	/// @brief Requests different ranges of the file over separate connections and writes them at their offsets into one preallocated file.
+	/// @note The first request finds out the size of the file and whether the server supports ranges, otherwise the file is downloaded over one connection.
+	/// @note A connection that has finished its part takes over half of the largest remaining part of another connection, so slow connections don't hold up the download.
+	/// @note Interrupted downloads are continued like with HttpDownloadSink and the delegate is called in sakit::update().
+	class sakitExport HttpSegmentedDownload
+	{
+	public:
+		HttpSegmentedDownload(HttpSegmentedDownloadDelegate* downloadDelegate, int connectionCount = 4);
+		~HttpSegmentedDownload();
+
+		HL_DEFINE_GET(int, connectionCount, ConnectionCount);
+		HL_DEFINE_GET(float, timeout, Timeout);
+		HL_DEFINE_GET(float, retryFrequency, RetryFrequency);
+		/// @note Parts that would be smaller than this aren't split anymore.
+		HL_DEFINE_GETSET(int64_t, minSegmentSize, MinSegmentSize);
+		/// @note How often parts that failed are requested again before the download fails.
+		HL_DEFINE_GETSET(int, maxRetries, MaxRetries);
+		/// @note Maps the file into memory instead of writing to it, where supported.
+		HL_DEFINE_ISSET(mapped, Mapped);
+		/// @return Number of times a part was split so another connection could take over half of it.
+		HL_DEFINE_GET(int, splitCount, SplitCount);
+		void setTimeout(float timeout, float retryFrequency = 0.01f);
+		Url getUrl();
+		hstr getFilename();
+		/// @return Size of the whole file or -1 if it isn't known yet.
+		int64_t getSize();
+		/// @return Number of bytes that were downloaded, including those of earlier interrupted downloads.
+		int64_t getDownloadedSize();
+		/// @return Number of connections that are currently receiving a part of the file.
+		int getActiveConnectionCount();
+		bool isRunning();
+
+		/// @brief Starts downloading the file, an earlier interrupted download of the same file is continued.
+		bool start(Url url, chstr filename);
+		/// @brief Aborts all connections, the download can be continued later by starting it again with the same file.
+		/// @note The delegate isn't called.
+		void stop();
+
+	protected:
+		/// @brief Forwards the results of the sockets to the download.
+		class SocketDelegate : public HttpSocketDelegate
+		{
+		public:
+			SocketDelegate(HttpSegmentedDownload* download);
+
+			void onExecuteBodyProgress(HttpSocket* socket, HttpProgress* progress, Url url);
+			void onExecuteCompleted(HttpSocket* socket, HttpResponse* response, Url url);
+			void onExecuteFailed(HttpSocket* socket, HttpResponse* response, Url url);
+
+		protected:
+			HttpSegmentedDownload* download;
+
+		};
+
+		struct Connection
+		{
+			HttpSocket* socket;
+			/// @note NULL while the connection is idle.
+			HttpDownloadSink* sink;
+		};
+
+		/// @brief What happens once all connections have finished.
+		enum Ending
+		{
+			ENDING_NONE,
+			ENDING_STOP,
+			ENDING_FAIL,
+			/// @brief The file has changed since the interrupted download so it's downloaded again from the beginning.
+			ENDING_RESTART
+		};
+
+		HttpSegmentedDownloadDelegate* downloadDelegate;
+		SocketDelegate socketDelegate;
+		hmutex mutex;
+		DownloadFile* file;
+		harray<Connection> connections;
+		Url url;
+		int connectionCount;
+		float timeout;
+		float retryFrequency;
+		int64_t minSegmentSize;
+		int maxRetries;
+		bool mapped;
+		int splitCount;
+		bool running;
+		/// @brief Whether the first request is still waiting for the size of the file.
+		bool probing;
+		bool rangesSupported;
+		bool restarted;
+		int retries;
+		Ending ending;
+
+		/// @brief Checks whether the first response revealed the size of the file and whether the server supports ranges.
+		void _checkProbe(Connection* connection);
+		/// @brief Gives idle connections a part of the file that is still missing.
+		void _dispatch();
+		bool _startSegment(Connection* connection, int segment);
+		/// @return Index of a part that is missing and not being received or -1 if there is none.
+		int _findMissingSegment();
+		/// @brief Splits the part with the most remaining data that is being received.
+		/// @return Index of the new part or -1 if no part can be split anymore.
+		int _splitSlowestSegment();
+		void _finishSegment(HttpSocket* socket, HttpResponse* response, bool completed);
+		void _abortConnections();
+		int _getActiveConnectionCount();
+		Connection* _findConnection(HttpSocket* socket);
+
+	private:
+		HttpSegmentedDownload(const HttpSegmentedDownload& other); // prevents copying
+
+	};
+
+}
+#endif
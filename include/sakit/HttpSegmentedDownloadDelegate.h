@@ -0,0 +1,35 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a HTTP segmented download delegate.
+
+#ifndef SAKIT_HTTP_SEGMENTED_DOWNLOAD_DELEGATE_H
+#define SAKIT_HTTP_SEGMENTED_DOWNLOAD_DELEGATE_H
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class HttpSegmentedDownload;
+
+	class sakitExport HttpSegmentedDownloadDelegate
+	{
+	public:
+		HttpSegmentedDownloadDelegate();
+		virtual ~HttpSegmentedDownloadDelegate();
+
+		virtual void onDownloadCompleted(HttpSegmentedDownload* download);
+		/// @note The download can be continued later by starting it again with the same file.
+		virtual void onDownloadFailed(HttpSegmentedDownload* download);
+
+	};
+
+}
+#endif
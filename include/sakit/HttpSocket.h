@@ -59,6 +59,8 @@
 
 namespace sakit
 {
+	class HttpBodySink;
+	class HttpDownloadSink;
 	class HttpResponse;
 	class HttpSocketDelegate;
 	class HttpSocketThread;
@@ -68,6 +70,8 @@ namespace sakit
 	class sakitExport HttpSocket : public SocketBase
 	{
 	public:
+		friend class HttpClient;
+
 		enum Protocol
 		{
 			HTTP11
@@ -78,11 +82,22 @@ namespace sakit
 
 		HL_DEFINE_ISSET(keepAlive, KeepAlive);
 		HL_DEFINE_ISSET(reportProgress, ReportProgress);
+		/// @note Allows async requests to the same host to be sent while earlier ones are still waiting for their responses. Requires keepAlive.
+		/// @note Only idempotent requests are pipelined, the delegate receives the responses in the order the requests were executed.
+		/// @note If the server closes the connection before answering all of them, the unanswered requests are sent again on a new connection.
+		HL_DEFINE_ISSET(pipelining, Pipelining);
+		/// @note Number of requests that are sent before their responses have arrived. As many further requests wait on the connection and are sent as soon as responses arrive.
+		HL_DEFINE_GETSET(int, maxPipelinedRequests, MaxPipelinedRequests);
+		/// @note When set, response bodies of the following requests are written to the sink instead of HttpResponse::body and requests aren't pipelined.
+		/// @note The sink is called from the socket's thread and has to exist until the request has finished.
+		HL_DEFINE_GETSET(HttpBodySink*, bodySink, BodySink);
 		HL_DEFINE_GETSET(Protocol, protocol, Protocol);
 		HL_DEFINE_SET(unsigned short, remotePort, RemotePort);
 		/// @note This is due to keepAlive which has to be set beforehand
 		bool isConnected();
 		bool isExecuting();
+		/// @return Number of executed requests that are still waiting for their responses.
+		int getPendingRequestCount();
 
 		void update(float timeDelta = 0.0f);
 
@@ -123,6 +138,12 @@ namespace sakit
 		bool executeTraceAsync(chstr customBody, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
 		bool executeConnectAsync(chstr customBody, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
 
+		/// @brief Downloads the body directly into the file of the download sink, continuing where an earlier download of the file was interrupted.
+		/// @note The download sink has to be opened beforehand and is used instead of the body sink for this request.
+		bool executeDownload(HttpResponse* response, Url url, HttpDownloadSink* downloadSink, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+		/// @note The download sink has to exist until the request has finished.
+		bool executeDownloadAsync(Url url, HttpDownloadSink* downloadSink, hmap<hstr, hstr> customHeaders = hmap<hstr, hstr>());
+
 		bool abort();
 
 		static unsigned short DefaultPort;
@@ -133,6 +154,9 @@ namespace sakit
 		Protocol protocol;
 		bool keepAlive;
 		bool reportProgress;
+		bool pipelining;
+		int maxPipelinedRequests;
+		HttpBodySink* bodySink;
 		Url url;
 
 		bool _executeMethod(HttpResponse* response, chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders);
@@ -142,10 +166,25 @@ namespace sakit
 		bool _executeMethodAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders);
 		bool _executeMethodAsync(chstr method, chstr customBody, hmap<hstr, hstr>& customHeaders);
 		bool _executeMethodInternalAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders);
+		/// @brief Adds the request to the running pipelined requests on the same connection.
+		/// @return False if the request can't be pipelined.
+		bool _pipelineMethodAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders);
+
+		void _deliverResponse(State result, HttpResponse* response, Url& url);
+		/// @brief Adds the headers that request only the missing part of the download.
+		/// @return False if there is nothing to download.
+		bool _prepareDownload(HttpDownloadSink* downloadSink, hmap<hstr, hstr>& customHeaders);
 
 		int _send(hstream* stream, int count);
 		bool _sendAsync(hstream* stream, int count);
 		void _terminateConnection();
+		/// @return Whether the persistent connection goes to the same host and port as the URL.
+		bool _isSameConnection(Url& url);
+		/// @brief Closes the persistent connection if the server has closed it in the meantime.
+		/// @return Whether the persistent connection can still be used.
+		bool _checkIdleConnection();
+		/// @brief Closes the persistent connection unless a request is being executed.
+		void _closeIdleConnection();
 
 		int _receiveHttpDirect(HttpResponse* response);
 
@@ -21,19 +21,29 @@
 
 namespace sakit
 {
+	class HttpProgress;
 	class HttpResponse;
 	class HttpSocket;
 
 	class sakitExport HttpSocketDelegate
 	{
 	public:
+		friend class HttpSocket;
+
 		HttpSocketDelegate();
 		virtual ~HttpSocketDelegate();
 
+		/// @note Receives a copy of the whole response on every call, onExecuteBodyProgress() is cheaper for large responses.
 		virtual void onExecuteProgress(HttpSocket* socket, HttpResponse* response, Url url);
+		/// @note Only the body data that was received since the previous call is available in progress.
+		virtual void onExecuteBodyProgress(HttpSocket* socket, HttpProgress* progress, Url url);
 		virtual void onExecuteCompleted(HttpSocket* socket, HttpResponse* response, Url url);
 		virtual void onExecuteFailed(HttpSocket* socket, HttpResponse* response, Url url);
 
+	protected:
+		/// @brief Whether onExecuteProgress() is overridden, the response is only copied for it if it is.
+		bool responseProgress;
+
 	};
 
 }
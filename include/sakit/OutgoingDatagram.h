@@ -0,0 +1,49 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a datagram that is sent as part of a batch.
+
+#ifndef SAKIT_OUTGOING_DATAGRAM_H
+#define SAKIT_OUTGOING_DATAGRAM_H
+
+#include <hltypes/hltypesUtil.h>
+
+#include "Host.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	/// @note The payload is not copied so it has to stay valid until sending has finished.
+	class sakitExport OutgoingDatagram
+	{
+	public:
+		OutgoingDatagram();
+		/// @note Sent to the destination of the socket.
+		OutgoingDatagram(const void* data, int size);
+		OutgoingDatagram(Host remoteHost, unsigned short remotePort, const void* data, int size);
+		~OutgoingDatagram();
+
+		HL_DEFINE_GET(Host, remoteHost, RemoteHost);
+		HL_DEFINE_GET(unsigned short, remotePort, RemotePort);
+		HL_DEFINE_GET(const unsigned char*, data, Data);
+		HL_DEFINE_GET(int, size, Size);
+		/// @return False if the datagram is sent to the destination of the socket.
+		bool hasRemoteHost() const;
+
+	protected:
+		Host remoteHost;
+		unsigned short remotePort;
+		const unsigned char* data;
+		int size;
+
+	};
+
+}
+#endif
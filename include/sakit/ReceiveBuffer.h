@@ -0,0 +1,65 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a reference counted buffer that data is received into directly.
+
+#ifndef SAKIT_RECEIVE_BUFFER_H
+#define SAKIT_RECEIVE_BUFFER_H
+
+#include <hltypes/hltypesUtil.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class TcpReceiverThread;
+	class TcpSocket;
+
+	/// @note The memory is taken from the same buffer pool as the socket receive buffers.
+	/// @note A buffer can be a view into a part of a larger buffer that other views share, the larger buffer is released with its last view.
+	class sakitExport ReceiveBuffer
+	{
+	public:
+		friend class TcpReceiverThread;
+		friend class TcpSocket;
+
+		/// @note The created buffer has a reference count of 1.
+		ReceiveBuffer(int capacity);
+
+		HL_DEFINE_GET(unsigned char*, data, Data);
+		/// @return Number of received bytes in the buffer.
+		HL_DEFINE_GET(int, size, Size);
+		HL_DEFINE_GET(int, capacity, Capacity);
+
+		/// @brief Keeps the buffer alive after the delegate call that provided it has returned.
+		void retain();
+		/// @brief Destroys the buffer when the last reference is released.
+		void release();
+
+	protected:
+		unsigned char* data;
+		int size;
+		int capacity;
+		volatile int references;
+		/// @brief The buffer that owns the memory of a view, NULL if the memory is owned by this buffer.
+		ReceiveBuffer* block;
+
+		/// @brief Creates a view into a part of the block and retains the block.
+		ReceiveBuffer(ReceiveBuffer* block, int offset, int capacity);
+		/// @note Only destroyed through release().
+		~ReceiveBuffer();
+
+	private:
+		ReceiveBuffer(const ReceiveBuffer& other); // prevents copying
+
+	};
+
+}
+#endif
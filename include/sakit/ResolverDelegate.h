@@ -0,0 +1,38 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a delegate for asynchronous domain resolving.
+
+#ifndef SAKIT_RESOLVER_DELEGATE_H
+#define SAKIT_RESOLVER_DELEGATE_H
+
+#include <hltypes/harray.h>
+
+#include "Host.h"
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class sakitExport ResolverDelegate
+	{
+	public:
+		ResolverDelegate();
+		virtual ~ResolverDelegate();
+
+		virtual void onResolved(Host domain, Host ip);
+		/// @brief Provides all IPv4 and IPv6 addresses of the domain, the preferred family first.
+		/// @note The default implementation calls onResolved() with the first address.
+		virtual void onResolved(Host domain, const harray<Host>& ips);
+		virtual void onResolveFailed(Host domain);
+
+	};
+
+}
+#endif
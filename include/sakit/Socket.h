@@ -13,6 +13,7 @@
 #ifndef SAKIT_SOCKET_H
 #define SAKIT_SOCKET_H
 
+#include <hltypes/harray.h>
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
@@ -21,6 +22,7 @@
 
 #include "sakitExport.h"
 #include "SocketBase.h"
+#include "Span.h"
 #include "State.h"
 
 namespace sakit
@@ -41,9 +43,13 @@ namespace sakit
 
 		int send(hstream* stream, int count = INT_MAX);
 		int send(chstr data);
+		/// @brief Sends all spans as one continuous block of data without joining them first.
+		int send(harray<Span> spans);
 
 		bool sendAsync(hstream* stream, int count = INT_MAX);
 		bool sendAsync(chstr data);
+		/// @note The memory of the spans is not copied so it has to stay valid until sending has finished or failed.
+		bool sendAsync(harray<Span> spans);
 		bool stopReceive();
 		bool stopReceiveAsync();
 
@@ -56,7 +62,11 @@ namespace sakit
 		Socket(SocketDelegate* socketDelegate, State idleState);
 
 		int _send(hstream* stream, int count);
+		int64_t _sendFile(chstr filename, int64_t offset, int64_t length);
+		bool _sendFileAsync(chstr filename, int64_t offset, int64_t length);
 		bool _prepareReceive(hstream* stream);
+		bool _prepareReceive(unsigned char* data, int size);
+		bool _prepareReceive();
 		int _finishReceive(int result);
 		bool _startReceiveAsync(int maxValue);
 
@@ -69,7 +79,9 @@ namespace sakit
 		bool _canReceive(State state);
 		bool _canStopReceive(State state);
 		bool _checkSendParameters(hstream* stream, int count);
+		bool _checkSendParameters(harray<Span>& spans);
 		bool _checkReceiveParameters(hstream* stream);
+		bool _checkReceiveParameters(unsigned char* data, int size);
 
 	private:
 		Socket(const Socket& other); // prevents copying
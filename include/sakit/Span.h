@@ -0,0 +1,44 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a reference to a block of memory that is sent as part of a scatter/gather send.
+
+#ifndef SAKIT_SPAN_H
+#define SAKIT_SPAN_H
+
+#include <hltypes/hltypesUtil.h>
+
+#include "sakitExport.h"
+
+namespace sakit
+{
+	class PlatformSocket;
+
+	/// @note The memory is not copied so it has to stay valid until sending has finished.
+	class sakitExport Span
+	{
+	public:
+		friend class PlatformSocket;
+
+		Span();
+		Span(const void* data, int size);
+		~Span();
+
+		HL_DEFINE_GET(const unsigned char*, data, Data);
+		HL_DEFINE_GET(int, size, Size);
+
+	protected:
+		const unsigned char* data;
+		int size;
+
+	};
+
+}
+#endif
@@ -13,6 +13,7 @@
 #ifndef SAKIT_TCP_SOCKET_H
 #define SAKIT_TCP_SOCKET_H
 
+#include <hltypes/harray.h>
 #include <hltypes/hstream.h>
 
 #include "Connector.h"
@@ -24,12 +25,16 @@
 namespace sakit
 {
 	class ConnectorThread;
+	class ReceiveBuffer;
 	class TcpReceiverThread;
+	class TcpServer;
 	class TcpSocketDelegate;
 
 	class sakitExport TcpSocket : public Socket, public Connector
 	{
 	public:
+		friend class TcpServer;
+
 		TcpSocket(TcpSocketDelegate* socketDelegate);
 		~TcpSocket();
 
@@ -40,13 +45,28 @@ namespace sakit
 		/// @note Keep in mind that only all queued stream data is received at once.
 		int receive(hstream* stream, int maxBytes = 0);
 		hstr receive(int maxBytes = 0);
+		/// @brief Receives directly into the given memory without any intermediate copies.
+		/// @return Number of received bytes.
+		/// @note Returns as soon as data was received and no more is available, the memory doesn't have to be filled completely.
+		int receive(unsigned char* data, int size);
 		bool startReceiveAsync(int maxBytes = 0);
 
+		/// @brief Sends a part of a file without loading it into memory.
+		/// @param[in] length Negative to send everything until the end of the file.
+		/// @return Number of sent bytes.
+		int64_t sendFile(chstr filename, int64_t offset = 0, int64_t length = -1);
+		/// @note Progress is reported through SocketDelegate::onSent().
+		bool sendFileAsync(chstr filename, int64_t offset = 0, int64_t length = -1);
+
 	protected:
 		TcpSocketDelegate* tcpSocketDelegate;
 		TcpReceiverThread* tcpReceiver;
+		/// @brief The server that accepted this socket, it removes the socket in its update once it has been disconnected.
+		TcpServer* server;
 
 		void _updateReceiving();
+		void _takeReceivedBuffers(harray<ReceiveBuffer*>& buffers);
+		void _deliverReceivedBuffers(harray<ReceiveBuffer*>& buffers);
 
 		void _activateConnection(Host remoteHost, unsigned short remotePort, Host localHost, unsigned short localPort);
 
@@ -13,6 +13,7 @@
 #ifndef SAKIT_TCP_SOCKET_DELEGATE_H
 #define SAKIT_TCP_SOCKET_DELEGATE_H
 
+#include <hltypes/harray.h>
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 
@@ -23,6 +24,7 @@
 
 namespace sakit
 {
+	class ReceiveBuffer;
 	class TcpSocket;
 
 	class sakitExport TcpSocketDelegate : public SocketDelegate, public ConnectorDelegate
@@ -32,6 +34,10 @@ namespace sakit
 		~TcpSocketDelegate();
 
 		virtual void onReceived(TcpSocket* socket, hstream* stream);
+		/// @brief Provides the received data in the buffers it was received into.
+		/// @note The default implementation copies all buffers into one stream and calls onReceived().
+		/// @note The buffers are released after this call, use ReceiveBuffer::retain() to keep them.
+		virtual void onReceivedBuffers(TcpSocket* socket, harray<ReceiveBuffer*> buffers);
 		virtual void onReceiveFailed(TcpSocket* socket);
 
 	};
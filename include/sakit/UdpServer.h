@@ -13,6 +13,7 @@
 #ifndef SAKIT_UDP_SERVER_H
 #define SAKIT_UDP_SERVER_H
 
+#include "Endpoint.h"
 #include "sakitExport.h"
 #include "Server.h"
 #include "Socket.h"
@@ -32,10 +33,18 @@ namespace sakit
 		void update(float timeDelta = 0.0f);
 
 		bool receive(hstream* stream, Host& remoteHost, unsigned short& remotePort);
+		bool receive(hstream* stream, Endpoint& remoteEndpoint);
+		HL_DEFINE_GET(int, receiveBatchSize, ReceiveBatchSize);
+		/// @brief Enables receiving multiple datagrams with a single system call.
+		/// @param[in] count Maximum number of datagrams per batch, 0 disables batched receiving.
+		/// @param[in] datagramSize Larger datagrams are cut off.
+		/// @note Batches are delivered through UdpServerDelegate::onReceivedBatch().
+		bool setReceiveBatchSize(int count, int datagramSize = 2048);
 
 	protected:
 		UdpServerThread* udpServerThread;
 		UdpServerDelegate* udpServerDelegate;
+		int receiveBatchSize;
 
 	private:
 		UdpServer(const UdpServer& other); // prevents copying
@@ -20,6 +20,8 @@
 
 namespace sakit
 {
+	class DatagramBatch;
+	class Endpoint;
 	class UdpServer;
 	class UdpSocket;
 
@@ -30,6 +32,13 @@ namespace sakit
 		~UdpServerDelegate();
 
 		virtual void onReceived(UdpServer* server, Host remoteHost, unsigned short remotePort, hstream* stream);
+		/// @brief Provides the sender as a binary endpoint without formatting it as text first.
+		/// @note The default implementation calls onReceived() with the host and port of the endpoint.
+		virtual void onReceived(UdpServer* server, const Endpoint& remoteEndpoint, hstream* stream);
+		/// @brief Provides received datagrams when batched receiving is enabled.
+		/// @note The default implementation calls onReceived() for every datagram.
+		/// @note The batch is released after this call, use DatagramBatch::retain() to keep it.
+		virtual void onReceivedBatch(UdpServer* server, DatagramBatch* batch);
 
 	};
 
@@ -16,14 +16,18 @@
 #include <hltypes/hstream.h>
 
 #include "Binder.h"
+#include "Endpoint.h"
 #include "Host.h"
 #include "NetworkAdapter.h"
+#include "OutgoingDatagram.h"
 #include "sakitExport.h"
 #include "Socket.h"
 
 namespace sakit
 {
 	class BroadcasterThread;
+	class Datagram;
+	class DatagramBatch;
 	class UdpReceiverThread;
 	class UdpSocketDelegate;
 
@@ -44,10 +48,27 @@ namespace sakit
 
 		bool setDestination(Host remoteHost, unsigned short remotePort);
 
+		/// @brief Sends all datagrams with as few system calls as possible.
+		/// @return Number of datagrams that were sent.
+		/// @note Datagrams without a remote host are sent to the destination of the socket.
+		int sendBatch(harray<OutgoingDatagram> datagrams);
+		/// @brief Sends the data to the destination as datagrams of segmentSize bytes, the last one being shorter if necessary.
+		/// @return Number of bytes that were sent.
+		/// @note Where the kernel supports UDP segmentation offloading, multiple datagrams are passed to it at once.
+		int sendSegmented(const void* data, int size, int segmentSize);
+
 		/// @note Keep in mind that only one datagram is received at the time.
 		int receive(hstream* stream, Host& remoteHost, unsigned short& remotePort);
+		/// @note Keep in mind that only one datagram is received at the time.
+		int receive(hstream* stream, Endpoint& remoteEndpoint);
 		hstr receive(Host& remoteHost, unsigned short& remotePort);
 		bool startReceiveAsync(int maxPackages = 0);
+		HL_DEFINE_GET(int, receiveBatchSize, ReceiveBatchSize);
+		/// @brief Enables receiving multiple datagrams with a single system call.
+		/// @param[in] count Maximum number of datagrams per batch, 0 disables batched receiving.
+		/// @param[in] datagramSize Larger datagrams are cut off.
+		/// @note Batches are delivered through UdpSocketDelegate::onReceivedBatch().
+		bool setReceiveBatchSize(int count, int datagramSize = 2048);
 
 		bool broadcast(harray<NetworkAdapter> adapters, unsigned short remotePort, hstream* stream, int count = INT_MAX);
 		bool broadcast(unsigned short remotePort, hstream* stream, int count = INT_MAX);
@@ -66,12 +87,15 @@ namespace sakit
 		UdpReceiverThread* udpReceiver;
 		BroadcasterThread* broadcaster;
 		harray<std::pair<Host, Host> > multicastHosts;
+		int receiveBatchSize;
 
 		void _updateReceiving();
+		void _deliverReceived(harray<Datagram>& datagrams, harray<DatagramBatch*>& batches);
 		void _clear();
 		void _activateConnection(Host remoteHost, unsigned short remotePort, Host localHost, unsigned short localPort);
 
 		bool _canSetDestination(State state);
+		bool _checkBatchParameters(harray<OutgoingDatagram>& datagrams);
 		bool _canJoinMulticastGroup(State state);
 		bool _canLeaveMulticastGroup(State state);
 
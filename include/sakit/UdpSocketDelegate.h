@@ -17,12 +17,14 @@
 #include <hltypes/hstring.h>
 
 #include "BinderDelegate.h"
+#include "Endpoint.h"
 #include "Host.h"
 #include "sakitExport.h"
 #include "SocketDelegate.h"
 
 namespace sakit
 {
+	class DatagramBatch;
 	class UdpSocket;
 
 	class sakitExport UdpSocketDelegate : public SocketDelegate, public BinderDelegate
@@ -32,6 +34,13 @@ namespace sakit
 		virtual ~UdpSocketDelegate();
 
 		virtual void onReceived(UdpSocket* socket, Host remoteHost, unsigned short remotePort, hstream* stream);
+		/// @brief Provides the sender as a binary endpoint without formatting it as text first.
+		/// @note The default implementation calls onReceived() with the host and port of the endpoint.
+		virtual void onReceived(UdpSocket* socket, const Endpoint& remoteEndpoint, hstream* stream);
+		/// @brief Provides received datagrams when batched receiving is enabled.
+		/// @note The default implementation calls onReceived() for every datagram.
+		/// @note The batch is released after this call, use DatagramBatch::retain() to keep it.
+		virtual void onReceivedBatch(UdpSocket* socket, DatagramBatch* batch);
 
 		virtual void onBroadcastFinished(UdpSocket* socket);
 		virtual void onBroadcastFailed(UdpSocket* socket);
@@ -31,6 +31,7 @@ namespace sakit
 		~Url();
 
 		HL_DEFINE_IS(valid, Valid);
+		/// @note IPv6 addresses are returned without brackets.
 		HL_DEFINE_GET(hstr, host, Host);
 		HL_DEFINE_GET(unsigned short, port, Port);
 		HL_DEFINE_GET(hstr, path, Path);
@@ -63,6 +64,8 @@ namespace sakit
 		void _checkValues(chstr query);
 
 		static bool _checkCharset(chstr string, chstr allowed);
+		/// @note IPv6 addresses are put into brackets.
+		static hstr _encodeHost(chstr host);
 		static hstr _encodeWwwFormComponent(chstr string, chstr allowed);
 		static hstr _decodeWwwFormComponent(chstr string);
 
@@ -13,6 +13,8 @@
 #ifndef SAKIT_H
 #define SAKIT_H
 
+#include <stdint.h>
+
 #include <hltypes/harray.h>
 #include <hltypes/hstring.h>
 
@@ -22,22 +24,75 @@
 
 namespace sakit
 {
+	class ResolverDelegate;
+
 	sakitExport extern hstr logTag;
 
-	sakitFnExport void init(bool threadedUpdate = false);
+	/// @brief Defines how the underlying socket operations are performed.
+	enum IoBackend
+	{
+		/// @brief Plain socket system calls.
+		IO_BACKEND_SOCKETS,
+		/// @brief Batched submissions through io_uring with multishot receiving and accepting where the kernel supports it.
+		/// @note Only supported on Linux (not Android), otherwise plain sockets are used.
+		IO_BACKEND_IO_URING
+	};
+
+	/// @param[in] reactorCount Number of event loops that drive receiving and accepting through readiness notifications instead of a polling thread per socket.
+	/// @param[in] backend The I/O backend used for receiving, accepting and connecting.
+	/// @param[in] poolThreadCount Number of shared threads that execute async operations. Negative values use one thread per processor core, 0 uses one thread per operation.
+	/// @note Reactors are only supported on Linux and Android, otherwise polling threads are always used.
+	/// @note Connecting blocks a pool thread until the connection has been established so the pool should have enough threads for concurrent connects.
+	sakitFnExport void init(bool threadedUpdate = false, int reactorCount = 0, IoBackend backend = IO_BACKEND_SOCKETS, int poolThreadCount = 0);
 	sakitFnExport bool isInitialized();
 	sakitFnExport void destroy();
 	sakitFnExport hstr getHostName();
 	/// @brief A call to this function will trigger delegate callbacks.
 	sakitFnExport void update(float timeDelta = 0.0f);
+	sakitFnExport int getReactorCount();
+	sakitFnExport IoBackend getIoBackend();
+	sakitFnExport int getPoolThreadCount();
 	sakitFnExport int getBufferSize();
 	sakitFnExport void setBufferSize(int value);
+	/// @return Number of pooled receive buffers that are currently used by sockets.
+	/// @note Sockets only use a receive buffer while they are receiving.
+	sakitFnExport int getUsedBufferCount();
+	/// @return Number of pooled receive buffers that are kept for reuse.
+	sakitFnExport int getFreeBufferCount();
+	/// @return Size in bytes of all pooled receive buffers, used and free.
+	sakitFnExport int64_t getAllocatedBufferSize();
 	sakitFnExport float getGlobalTimeout();
 	sakitFnExport float getGlobalRetryFrequency();
 	sakitFnExport void setGlobalTimeout(float globalTimeout, float globalRetryFrequency = 0.01f);
 	sakitFnExport harray<NetworkAdapter> getNetworkAdapters();
+	sakitFnExport float getDnsCacheTtl();
+	sakitFnExport float getDnsCacheNegativeTtl();
+	/// @brief Sets how long resolved domains are cached.
+	/// @param[in] ttl Time in seconds that resolved domains are kept, 0 disables caching.
+	/// @param[in] negativeTtl Time in seconds that failed lookups are kept, 0 disables caching of failures.
+	sakitFnExport void setDnsCacheTtl(float ttl, float negativeTtl = 5.0f);
+	sakitFnExport int getDnsCacheMaxSize();
+	/// @note Domains that were not used for the longest time are removed first when the cache is full.
+	sakitFnExport void setDnsCacheMaxSize(int value);
+	/// @return Number of cached domains, including failed lookups.
+	sakitFnExport int getDnsCacheSize();
+	sakitFnExport int64_t getDnsCacheHitCount();
+	sakitFnExport int64_t getDnsCacheMissCount();
+	sakitFnExport void clearDnsCache();
 	/// @return The IP of the domain/host.
+	/// @note Results are cached, see setDnsCacheTtl().
 	sakitFnExport Host resolveHost(Host domain);
+	/// @return All IPv4 and IPv6 addresses of the domain/host in the order the system prefers them.
+	/// @note Results are cached, see setDnsCacheTtl().
+	sakitFnExport harray<Host> resolveHosts(Host domain);
+	/// @brief Resolves the domain without blocking, the result is delivered to the delegate in update().
+	/// @note Uses its own DNS client with the name servers from /etc/resolv.conf and the entries from /etc/hosts where available.
+	sakitFnExport bool resolveHostAsync(Host domain, ResolverDelegate* resolverDelegate);
+	/// @brief Discards all results that haven't been delivered to the delegate yet.
+	/// @note Has to be called before a delegate with pending queries is destroyed.
+	sakitFnExport void cancelResolveHostAsync(ResolverDelegate* resolverDelegate);
+	/// @brief Sets the name servers used by asynchronous resolving, an empty array uses the ones from /etc/resolv.conf.
+	sakitFnExport void setDnsServers(const harray<Host>& servers, unsigned short port = 53);
 	/// @return The domain/host associated with this IP address.
 	sakitFnExport Host resolveIp(Host ip);
 	/// @return The port for the given service name.
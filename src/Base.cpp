@@ -7,11 +7,14 @@
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
 #include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
 #include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 
 #include "Base.h"
+#include "Endpoint.h"
+#include "FileTransfer.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 
@@ -20,11 +23,17 @@ namespace sakit
 	extern harray<Base*> connections;
 	extern hmutex connectionsMutex;
 	extern hmutex updateMutex;
+	extern harray<Base*> queuedConnections;
+	extern harray<Base*> updatingConnections;
+	extern hmutex queuedConnectionsMutex;
 
 	void Base::__register()
 	{
 		hmutex::ScopeLock lock(&connectionsMutex);
 		connections += this;
+		lock.release();
+		lock.acquire(&queuedConnectionsMutex);
+		this->updateRegistered = true;
 	}
 
 	void Base::__unregister()
@@ -36,11 +45,26 @@ namespace sakit
 		{
 			connections.removeAt(index);
 		}
+		lock.release();
+		lock.acquire(&queuedConnectionsMutex);
+		this->updateRegistered = false;
+		if (this->updateQueued)
+		{
+			this->updateQueued = false;
+			queuedConnections -= this;
+		}
+		// the update thread itself could be in the middle of dispatching queued connections
+		index = updatingConnections.indexOf(this);
+		if (index >= 0)
+		{
+			updatingConnections[index] = NULL;
+		}
 	}
 
-	Base::Base() : state(IDLE), localPort(0)
+	Base::Base() : state(IDLE), localPort(0), updateQueued(false), updateRegistered(false)
 	{
 		this->socket = new PlatformSocket();
+		this->socket->setOwner(this);
 		this->timeout = sakit::getGlobalTimeout();
 		this->retryFrequency = sakit::getGlobalRetryFrequency();
 	}
@@ -76,10 +100,46 @@ namespace sakit
 		return sent;
 	}
 	
+	int Base::_sendDirect(harray<Span> spans)
+	{
+		int sent = 0;
+		while (spans.size() > 0)
+		{
+			if (!this->socket->send(spans, sent))
+			{
+				break;
+			}
+			if (spans.size() == 0)
+			{
+				break;
+			}
+			hthread::sleep(this->retryFrequency * 1000.0f);
+		}
+		return sent;
+	}
+
+	int64_t Base::_sendDirect(FileTransfer* transfer)
+	{
+		int64_t sent = 0;
+		int count = 0;
+		while (transfer->getRemaining() > 0)
+		{
+			count = 0;
+			if (!this->socket->sendFile(transfer, count))
+			{
+				break;
+			}
+			sent += count;
+		}
+		return sent;
+	}
+
 	int Base::_receiveDirect(hstream* stream, int maxBytes)
 	{
 		hmutex mutex;
+		int64_t start = htickCount();
 		float time = 0.0f;
+		bool ready = false;
 		int remaining = maxBytes;
 		int64_t position = stream->position();
 		int64_t lastPosition = position;
@@ -96,46 +156,106 @@ namespace sakit
 			if (lastPosition != stream->position())
 			{
 				lastPosition = stream->position();
-				// retry attempts are reset after a successful read
+				// the timeout is reset after a successful read
+				start = htickCount();
 				time = 0.0f;
+				ready = false;
 				continue;
 			}
 			if (remaining != maxBytes || lastPosition != position)
 			{
 				break;
 			}
-			time += this->retryFrequency;
+			time = (htickCount() - start) * 0.001f;
 			if (time >= this->timeout)
 			{
 				break;
 			}
-			hthread::sleep(this->retryFrequency * 1000.0f);
+			this->_waitReceive(ready, this->timeout - time);
 		}
+		this->socket->releaseBuffer();
 		lastPosition = stream->position();
-		if (time >= this->timeout)
+		// a timeout of 0 only takes what has been received already, which isn't a timeout
+		if (time >= this->timeout && this->timeout > 0.0f)
 		{
 			hlog::warn(logTag, "Timed out while waiting for data.");
 		}
 		return (int)(lastPosition - position);
 	}
 
-	int Base::_receiveFromDirect(hstream* stream, Host& host, unsigned short& port)
+	int Base::_receiveDirect(unsigned char* data, int size)
 	{
+		int64_t start = htickCount();
 		float time = 0.0f;
+		bool ready = false;
+		int received = 0;
+		int read = 0;
+		while (received < size)
+		{
+			if (!this->socket->receive(data + received, size - received, read))
+			{
+				break;
+			}
+			if (read > 0)
+			{
+				received += read;
+				// the timeout is reset after a successful read
+				start = htickCount();
+				time = 0.0f;
+				ready = false;
+				continue;
+			}
+			if (received > 0)
+			{
+				break;
+			}
+			time = (htickCount() - start) * 0.001f;
+			if (time >= this->timeout)
+			{
+				if (this->timeout > 0.0f)
+				{
+					hlog::warn(logTag, "Timed out while waiting for data.");
+				}
+				break;
+			}
+			this->_waitReceive(ready, this->timeout - time);
+		}
+		this->socket->releaseBuffer();
+		return received;
+	}
+
+	int Base::_receiveFromDirect(hstream* stream, Endpoint& remoteEndpoint)
+	{
+		int64_t start = htickCount();
+		float time = 0.0f;
+		bool ready = false;
+		int64_t size = stream->size();
 		while (true)
 		{
-			if (this->socket->receiveFrom(stream, host, port))
+			// waits for the first datagram the same way as connection based receiving waits for the first data
+			if (this->socket->receiveFrom(stream, remoteEndpoint) && stream->size() != size)
 			{
 				break;
 			}
-			time += this->retryFrequency;
+			time = (htickCount() - start) * 0.001f;
 			if (time >= this->timeout)
 			{
 				break;
 			}
-			hthread::sleep(this->retryFrequency * 1000.0f);
+			this->_waitReceive(ready, this->timeout - time);
 		}
+		this->socket->releaseBuffer();
 		return (int)stream->size();
 	}
 
+	void Base::_waitReceive(bool& ready, float timeout)
+	{
+		// being ready without anything received (e.g. a closed connection) would turn blocking into a busy loop
+		if (ready)
+		{
+			hthread::sleep(hmin(this->retryFrequency, timeout) * 1000.0f);
+		}
+		ready = this->socket->waitReceive(timeout);
+	}
+
 }
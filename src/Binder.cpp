@@ -34,7 +34,7 @@ namespace sakit
 	{
 		if (this->_thread != NULL)
 		{
-			this->_thread->join();
+			this->_thread->joinWork();
 			delete this->_thread;
 		}
 	}
@@ -210,7 +210,7 @@ namespace sakit
 		this->_thread->result = RUNNING;
 		this->_thread->host = localHost;
 		this->_thread->port = localPort;
-		this->_thread->start();
+		this->_thread->startWork();
 		return true;
 	}
 	
@@ -229,7 +229,7 @@ namespace sakit
 		*this->_state = UNBINDING;
 		this->_thread->state = UNBINDING;
 		this->_thread->result = RUNNING;
-		this->_thread->start();
+		this->_thread->startWork();
 		return true;
 	}
 
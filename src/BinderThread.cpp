@@ -30,14 +30,14 @@ namespace sakit
 	{
 		bool result = this->socket->bind(this->host, this->port);
 		hmutex::ScopeLock lock(&this->mutex);
-		this->result = (result ? FINISHED : FAILED);
+		this->_setResult(result ? FINISHED : FAILED);
 	}
 
 	void BinderThread::_updateUnbinding()
 	{
 		bool result = this->socket->disconnect();
 		hmutex::ScopeLock lock(&this->mutex);
-		this->result = (result ? FINISHED : FAILED);
+		this->_setResult(result ? FINISHED : FAILED);
 	}
 
 	void BinderThread::_updateProcess()
@@ -32,7 +32,7 @@ namespace sakit
 	{
 		bool result = this->socket->broadcast(this->adapters, this->remotePort, this->stream, (int)this->stream->size());
 		hmutex::ScopeLock lock(&this->mutex);
-		this->result = (result ? FINISHED : FAILED);
+		this->_setResult(result ? FINISHED : FAILED);
 		this->stream->clear();
 	}
 
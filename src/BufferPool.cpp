@@ -0,0 +1,98 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+
+#include "BufferPool.h"
+
+#define MIN_SIZE_CLASS 4096
+// more free buffers than this are deleted so idle sockets don't keep the memory allocated
+#define MAX_FREE_BUFFERS 64
+
+namespace sakit
+{
+	BufferPool::BufferPool() : usedCount(0), freeCount(0), allocatedSize(0)
+	{
+	}
+
+	BufferPool::~BufferPool()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		foreach_map (int, harray<char*>, it, this->freeBuffers)
+		{
+			foreach (char*, it2, it->second)
+			{
+				delete [] (*it2);
+			}
+		}
+		this->freeBuffers.clear();
+	}
+
+	int BufferPool::getUsedCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->usedCount;
+	}
+
+	int BufferPool::getFreeCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->freeCount;
+	}
+
+	int64_t BufferPool::getAllocatedSize()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->allocatedSize;
+	}
+
+	char* BufferPool::acquire(int size)
+	{
+		int sizeClass = BufferPool::_getSizeClass(size);
+		hmutex::ScopeLock lock(&this->mutex);
+		++this->usedCount;
+		if (this->freeBuffers.hasKey(sizeClass) && this->freeBuffers[sizeClass].size() > 0)
+		{
+			--this->freeCount;
+			return this->freeBuffers[sizeClass].removeLast();
+		}
+		this->allocatedSize += sizeClass;
+		lock.release();
+		return new char[sizeClass];
+	}
+
+	void BufferPool::release(char* buffer, int size)
+	{
+		int sizeClass = BufferPool::_getSizeClass(size);
+		hmutex::ScopeLock lock(&this->mutex);
+		--this->usedCount;
+		harray<char*>& buffers = this->freeBuffers[sizeClass];
+		if (buffers.size() < MAX_FREE_BUFFERS)
+		{
+			buffers += buffer;
+			++this->freeCount;
+			return;
+		}
+		this->allocatedSize -= sizeClass;
+		lock.release();
+		delete [] buffer;
+	}
+
+	int BufferPool::_getSizeClass(int size)
+	{
+		int result = MIN_SIZE_CLASS;
+		while (result < size)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+
+}
@@ -0,0 +1,56 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a pool of receive buffers that are shared between all sockets.
+
+#ifndef SAKIT_BUFFER_POOL_H
+#define SAKIT_BUFFER_POOL_H
+
+#include <stdint.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+
+namespace sakit
+{
+	class BufferPool
+	{
+	public:
+		BufferPool();
+		~BufferPool();
+
+		int getUsedCount();
+		int getFreeCount();
+		/// @return Size in bytes of all buffers that are used or kept for reuse.
+		int64_t getAllocatedSize();
+
+		/// @note The returned buffer is at least as large as the given size.
+		char* acquire(int size);
+		/// @note The size has to be the same one that was used for acquiring the buffer.
+		void release(char* buffer, int size);
+
+	protected:
+		hmutex mutex;
+		/// @note Free buffers per size class.
+		hmap<int, harray<char*> > freeBuffers;
+		int usedCount;
+		int freeCount;
+		int64_t allocatedSize;
+
+		static int _getSizeClass(int size);
+
+	private:
+		BufferPool(const BufferPool& other); // prevents copying
+
+	};
+
+}
+#endif
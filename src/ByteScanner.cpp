@@ -0,0 +1,210 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hstring.h>
+
+#include "ByteScanner.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define _SAKIT_SCAN_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define _SAKIT_SCAN_NEON
+#include <arm_neon.h>
+#endif
+
+// vector code is compiled per function so the rest of the library doesn't require these instruction sets
+#if defined(__GNUC__) || defined(__clang__)
+#define SCAN_TARGET(name) __attribute__((target(name)))
+#else
+#define SCAN_TARGET(name)
+#endif
+
+namespace sakit
+{
+	typedef int64_t (*ScanFunction)(const char*, int64_t, char);
+
+	static int64_t _findByteScalar(const char* data, int64_t size, char value)
+	{
+		for_iter (i, 0, size)
+		{
+			if (data[i] == value)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	static inline int _findLowestBit(uint64_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index = 0;
+#if defined(_M_X64) || defined(_M_ARM64)
+		_BitScanForward64(&index, mask);
+#else
+		if (!_BitScanForward(&index, (unsigned long)mask))
+		{
+			_BitScanForward(&index, (unsigned long)(mask >> 32));
+			index += 32;
+		}
+#endif
+		return (int)index;
+#else
+		return __builtin_ctzll(mask);
+#endif
+	}
+
+#ifdef _SAKIT_SCAN_X86
+	SCAN_TARGET("sse2")
+	static int64_t _findByteSse2(const char* data, int64_t size, char value)
+	{
+		__m128i pattern = _mm_set1_epi8(value);
+		int mask = 0;
+		int64_t i = 0;
+		for (; i + 16 <= size; i += 16)
+		{
+			mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&data[i]), pattern));
+			if (mask != 0)
+			{
+				return (i + _findLowestBit((uint64_t)(unsigned int)mask));
+			}
+		}
+		int64_t result = _findByteScalar(&data[i], size - i, value);
+		return (result >= 0 ? i + result : -1);
+	}
+
+	SCAN_TARGET("avx2")
+	static int64_t _findByteAvx2(const char* data, int64_t size, char value)
+	{
+		__m256i pattern = _mm256_set1_epi8(value);
+		unsigned int mask = 0;
+		int64_t i = 0;
+		for (; i + 32 <= size; i += 32)
+		{
+			mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&data[i]), pattern));
+			if (mask != 0)
+			{
+				return (i + _findLowestBit((uint64_t)mask));
+			}
+		}
+		int64_t result = _findByteSse2(&data[i], size - i, value);
+		return (result >= 0 ? i + result : -1);
+	}
+
+	static bool _hasCpuFeature(int leaf, int registerIndex, int bit)
+	{
+		int registers[4] = {0, 0, 0, 0};
+#ifdef _MSC_VER
+		__cpuid(registers, 0);
+		if (registers[0] < leaf)
+		{
+			return false;
+		}
+		__cpuidex(registers, leaf, 0);
+#else
+		if ((int)__get_cpuid_max(0, NULL) < leaf)
+		{
+			return false;
+		}
+		unsigned int eax = 0;
+		unsigned int ebx = 0;
+		unsigned int ecx = 0;
+		unsigned int edx = 0;
+		__cpuid_count(leaf, 0, eax, ebx, ecx, edx);
+		registers[0] = (int)eax;
+		registers[1] = (int)ebx;
+		registers[2] = (int)ecx;
+		registers[3] = (int)edx;
+#endif
+		return ((registers[registerIndex] >> bit) & 1) != 0;
+	}
+
+	static bool _isAvx2Supported()
+	{
+		// the OS has to save the YMM registers as well
+		if (!_hasCpuFeature(1, 2, 27) || !_hasCpuFeature(1, 2, 28)) // OSXSAVE and AVX
+		{
+			return false;
+		}
+#ifdef _MSC_VER
+		unsigned long long xcr0 = _xgetbv(0);
+#else
+		unsigned int xcr0Low = 0;
+		unsigned int xcr0High = 0;
+		__asm__ __volatile__ ("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+		unsigned long long xcr0 = xcr0Low;
+#endif
+		return ((xcr0 & 0x6) == 0x6 && _hasCpuFeature(7, 1, 5)); // XMM and YMM state, AVX2
+	}
+#endif
+
+#ifdef _SAKIT_SCAN_NEON
+	static int64_t _findByteNeon(const char* data, int64_t size, char value)
+	{
+		uint8x16_t pattern = vdupq_n_u8((uint8_t)value);
+		uint64_t mask = 0;
+		int64_t i = 0;
+		for (; i + 16 <= size; i += 16)
+		{
+			// narrowing leaves 4 bits per compared byte since NEON has no movemask
+			uint8x16_t matches = vceqq_u8(vld1q_u8((const uint8_t*)&data[i]), pattern);
+			mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+			if (mask != 0)
+			{
+				return (i + (_findLowestBit(mask) >> 2));
+			}
+		}
+		int64_t result = _findByteScalar(&data[i], size - i, value);
+		return (result >= 0 ? i + result : -1);
+	}
+#endif
+
+	static ScanFunction _selectScanFunction(hstr& name)
+	{
+#ifdef _SAKIT_SCAN_X86
+		if (_isAvx2Supported())
+		{
+			name = "AVX2";
+			return &_findByteAvx2;
+		}
+		if (_hasCpuFeature(1, 3, 26))
+		{
+			name = "SSE2";
+			return &_findByteSse2;
+		}
+#endif
+#ifdef _SAKIT_SCAN_NEON
+		name = "NEON";
+		return &_findByteNeon;
+#else
+		name = "scalar";
+		return &_findByteScalar;
+#endif
+	}
+
+	static hstr scanFunctionName;
+	static ScanFunction scanFunction = _selectScanFunction(scanFunctionName);
+
+	int64_t _findByte(const char* data, int64_t size, char value)
+	{
+		return (size > 0 ? (*scanFunction)(data, size, value) : -1);
+	}
+
+	hstr _getByteScannerName()
+	{
+		return scanFunctionName;
+	}
+
+}
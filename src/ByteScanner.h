@@ -0,0 +1,29 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines vectorized searching for delimiters in received data.
+
+#ifndef SAKIT_BYTE_SCANNER_H
+#define SAKIT_BYTE_SCANNER_H
+
+#include <stdint.h>
+
+#include <hltypes/hstring.h>
+
+namespace sakit
+{
+	/// @return Offset of the first occurrence of value in data or -1 if there is none.
+	/// @note Uses AVX2, SSE2 or NEON, whichever is the best the CPU supports.
+	int64_t _findByte(const char* data, int64_t size, char value);
+	/// @return Name of the instruction set used by _findByte().
+	hstr _getByteScannerName();
+
+}
+#endif
@@ -20,6 +20,8 @@
 
 namespace sakit
 {
+	void _queueUpdate(Base* connection);
+
 	Connector::Connector(PlatformSocket* socket, ConnectorDelegate* connectorDelegate)
 	{
 		this->_socket = socket;
@@ -39,7 +41,7 @@ namespace sakit
 	{
 		if (this->_thread != NULL)
 		{
-			this->_thread->join();
+			this->_thread->joinWork();
 			delete this->_thread;
 		}
 	}
@@ -206,6 +208,11 @@ namespace sakit
 			*this->_localHost = Host();
 			*this->_localPort = 0;
 			*this->_state = IDLE;
+			// a disconnect on the caller's thread isn't a worker result, the update still has to run so e.g. a server can remove an accepted socket
+			if (this->_socket->getOwner() != NULL)
+			{
+				_queueUpdate(this->_socket->getOwner());
+			}
 		}
 		else
 		{
@@ -226,7 +233,7 @@ namespace sakit
 		this->_thread->result = RUNNING;
 		this->_thread->host = remoteHost;
 		this->_thread->port = remotePort;
-		this->_thread->start();
+		this->_thread->startWork();
 		return true;
 	}
 	
@@ -240,7 +247,7 @@ namespace sakit
 		*this->_state = DISCONNECTING;
 		this->_thread->state = DISCONNECTING;
 		this->_thread->result = RUNNING;
-		this->_thread->start();
+		this->_thread->startWork();
 		return true;
 	}
 
@@ -10,6 +10,7 @@
 #include <hltypes/hthread.h>
 
 #include "ConnectorThread.h"
+#include "DnsResolver.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "Socket.h"
@@ -18,30 +19,45 @@
 
 namespace sakit
 {
-	ConnectorThread::ConnectorThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : TimedThread(socket, timeout, retryFrequency), localPort(0)
+	extern DnsResolver* dnsResolver;
+
+	ConnectorThread::ConnectorThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : TimedThread(socket, timeout, retryFrequency), localPort(0), resolveHandle(0)
 	{
 		this->name = "SAKit connector";
 	}
 
 	ConnectorThread::~ConnectorThread()
 	{
+		if (this->resolveHandle != 0 && dnsResolver != NULL)
+		{
+			dnsResolver->cancel(this->resolveHandle);
+		}
 	}
 
 	void ConnectorThread::_updateConnecting()
 	{
 		Host localHost;
 		unsigned short localPort = 0;
-		bool result = this->socket->connect(this->host, this->port, localHost, localPort, *this->timeout, *this->retryFrequency);
+		bool result = false;
+		if (this->remoteIps.size() > 0)
+		{
+			result = this->socket->connect(this->remoteIps, this->port, localHost, localPort, *this->timeout, *this->retryFrequency);
+			this->remoteIps.clear();
+		}
+		else
+		{
+			result = this->socket->connect(this->host, this->port, localHost, localPort, *this->timeout, *this->retryFrequency);
+		}
 		hmutex::ScopeLock lock(&this->mutex);
 		if (result)
 		{
-			this->result = FINISHED;
+			this->_setResult(FINISHED);
 			this->localHost = localHost;
 			this->localPort = localPort;
 		}
 		else
 		{
-			this->result = FAILED;
+			this->_setResult(FAILED);
 		}
 	}
 
@@ -49,7 +65,41 @@ namespace sakit
 	{
 		bool result = this->socket->disconnect();
 		hmutex::ScopeLock lock(&this->mutex);
-		this->result = (result ? FINISHED : FAILED);
+		this->_setResult(result ? FINISHED : FAILED);
+	}
+
+	float ConnectorThread::_updatePooled()
+	{
+		if (this->state == CONNECTING && !this->host.isIp() && dnsResolver != NULL)
+		{
+			if (this->resolveHandle == 0)
+			{
+				this->resolveHandle = dnsResolver->query(this->host);
+			}
+			if (!this->executing)
+			{
+				dnsResolver->cancel(this->resolveHandle);
+				this->resolveHandle = 0;
+				hmutex::ScopeLock lock(&this->mutex);
+				this->_setResult(FAILED);
+				return -1.0f;
+			}
+			harray<Host> ips;
+			bool success = false;
+			if (!dnsResolver->poll(this->resolveHandle, ips, success))
+			{
+				return (*this->retryFrequency * 1000.0f);
+			}
+			this->resolveHandle = 0;
+			if (!success)
+			{
+				hmutex::ScopeLock lock(&this->mutex);
+				this->_setResult(FAILED);
+				return -1.0f;
+			}
+			this->remoteIps = ips;
+		}
+		return TimedThread::_updatePooled();
 	}
 
 	void ConnectorThread::_updateProcess()
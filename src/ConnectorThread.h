@@ -13,6 +13,7 @@
 #ifndef SAKIT_CONNECTOR_THREAD_H
 #define SAKIT_CONNECTOR_THREAD_H
 
+#include <hltypes/harray.h>
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
@@ -38,10 +39,15 @@ namespace sakit
 		State state;
 		Host localHost;
 		unsigned short localPort;
+		/// @note Set when the domain has been resolved without blocking before connecting.
+		harray<Host> remoteIps;
+		int resolveHandle;
 
 		void _updateConnecting();
 		void _updateDisconnecting();
 		void _updateProcess();
+		/// @note Resolves the domain asynchronously so the pool thread isn't blocked while waiting for the DNS response.
+		float _updatePooled();
 
 	};
 
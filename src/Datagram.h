@@ -0,0 +1,34 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a received datagram that is handed from a worker to update().
+
+#ifndef SAKIT_DATAGRAM_H
+#define SAKIT_DATAGRAM_H
+
+#include <hltypes/hstream.h>
+
+#include "Endpoint.h"
+
+namespace sakit
+{
+	class Datagram
+	{
+	public:
+		Endpoint endpoint;
+		hstream* stream;
+
+		Datagram() : stream(NULL) { }
+		Datagram(const Endpoint& endpoint, hstream* stream) : endpoint(endpoint), stream(stream) { }
+
+	};
+
+}
+#endif
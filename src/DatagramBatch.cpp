@@ -0,0 +1,97 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "BufferPool.h"
+#include "DatagramBatch.h"
+#include "Endpoint.h"
+#include "PlatformSocket.h"
+
+namespace sakit
+{
+	extern BufferPool bufferPool;
+
+	DatagramBatch::DatagramBatch(int capacity, int datagramSize) : capacity(capacity), datagramSize(datagramSize), count(0), references(1)
+	{
+		this->data = (unsigned char*)bufferPool.acquire(capacity * datagramSize);
+		this->sizes = new int[capacity];
+		this->truncated = new bool[capacity];
+		this->addresses = new unsigned char[capacity * PlatformSocket::AddressSize];
+		this->addressSizes = new int[capacity];
+	}
+
+	DatagramBatch::~DatagramBatch()
+	{
+		bufferPool.release((char*)this->data, this->capacity * this->datagramSize);
+		delete [] this->sizes;
+		delete [] this->truncated;
+		delete [] this->addresses;
+		delete [] this->addressSizes;
+	}
+
+	int DatagramBatch::size() const
+	{
+		return this->count;
+	}
+
+	const unsigned char* DatagramBatch::getData(int index) const
+	{
+		return &this->data[index * this->datagramSize];
+	}
+
+	int DatagramBatch::getSize(int index) const
+	{
+		return this->sizes[index];
+	}
+
+	bool DatagramBatch::isTruncated(int index) const
+	{
+		return this->truncated[index];
+	}
+
+	void DatagramBatch::getRemoteAddress(int index, Host& remoteHost, unsigned short& remotePort) const
+	{
+		PlatformSocket::getAddressHostPort(&this->addresses[index * PlatformSocket::AddressSize], this->addressSizes[index], remoteHost, remotePort);
+	}
+
+	Endpoint DatagramBatch::getRemoteEndpoint(int index) const
+	{
+		return Endpoint(&this->addresses[index * PlatformSocket::AddressSize], this->addressSizes[index]);
+	}
+
+	void DatagramBatch::retain()
+	{
+#if defined(__ATOMIC_ACQ_REL)
+		__atomic_add_fetch(&this->references, 1, __ATOMIC_ACQ_REL);
+#elif defined(_MSC_VER)
+		_InterlockedIncrement((volatile long*)&this->references);
+#else
+		__sync_add_and_fetch(&this->references, 1);
+#endif
+	}
+
+	void DatagramBatch::release()
+	{
+		int references = 0;
+#if defined(__ATOMIC_ACQ_REL)
+		references = __atomic_sub_fetch(&this->references, 1, __ATOMIC_ACQ_REL);
+#elif defined(_MSC_VER)
+		references = (int)_InterlockedDecrement((volatile long*)&this->references);
+#else
+		references = __sync_sub_and_fetch(&this->references, 1);
+#endif
+		if (references == 0)
+		{
+			delete this;
+		}
+	}
+
+}
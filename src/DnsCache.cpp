@@ -0,0 +1,199 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "DnsCache.h"
+#include "Host.h"
+
+#define DEFAULT_TTL 60.0f
+#define DEFAULT_NEGATIVE_TTL 5.0f
+#define DEFAULT_MAX_SIZE 256
+
+namespace sakit
+{
+	DnsCache::DnsCache() : ttl(DEFAULT_TTL), negativeTtl(DEFAULT_NEGATIVE_TTL), maxSize(DEFAULT_MAX_SIZE), hitCount(0), missCount(0)
+	{
+	}
+
+	DnsCache::~DnsCache()
+	{
+	}
+
+	float DnsCache::getTtl()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->ttl;
+	}
+
+	float DnsCache::getNegativeTtl()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->negativeTtl;
+	}
+
+	void DnsCache::setTtl(float ttl, float negativeTtl)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->ttl = hmax(ttl, 0.0f);
+		this->negativeTtl = hmax(negativeTtl, 0.0f);
+		// already cached entries keep their old expiration time
+	}
+
+	int DnsCache::getMaxSize()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->maxSize;
+	}
+
+	void DnsCache::setMaxSize(int value)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->maxSize = hmax(value, 0);
+		int64_t time = htickCount();
+		while (this->entries.size() > this->maxSize)
+		{
+			this->_removeOldest(time);
+		}
+	}
+
+	int DnsCache::getSize()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->entries.size();
+	}
+
+	int64_t DnsCache::getHitCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->hitCount;
+	}
+
+	int64_t DnsCache::getMissCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->missCount;
+	}
+
+	DnsCache::Result DnsCache::get(const Host& domain, Host& ip)
+	{
+		harray<Host> ips;
+		Result result = this->get(domain, ips);
+		if (result == FOUND)
+		{
+			ip = ips.first();
+		}
+		return result;
+	}
+
+	DnsCache::Result DnsCache::get(const Host& domain, harray<Host>& ips)
+	{
+		hstr key = domain.toString().lowered();
+		hmutex::ScopeLock lock(&this->mutex);
+		hmap<hstr, Entry>::iterator it = this->entries.find(key);
+		if (it == this->entries.end())
+		{
+			++this->missCount;
+			return MISSING;
+		}
+		int64_t time = htickCount();
+		if (time >= it->second.expiration)
+		{
+			this->entries.erase(it);
+			++this->missCount;
+			return MISSING;
+		}
+		++this->hitCount;
+		it->second.lastUsed = time;
+		if (it->second.failed)
+		{
+			return FAILED;
+		}
+		ips = it->second.ips;
+		return FOUND;
+	}
+
+	void DnsCache::add(const Host& domain, const Host& ip, float ttl)
+	{
+		harray<Host> ips;
+		ips += ip;
+		this->add(domain, ips, ttl);
+	}
+
+	void DnsCache::add(const Host& domain, const harray<Host>& ips, float ttl)
+	{
+		if (ips.size() == 0)
+		{
+			return;
+		}
+		hmutex::ScopeLock lock(&this->mutex);
+		this->_add(domain, ips, false, (ttl >= 0.0f ? hmin(ttl, this->ttl) : this->ttl));
+	}
+
+	void DnsCache::addFailed(const Host& domain)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->_add(domain, harray<Host>(), true, this->negativeTtl);
+	}
+
+	void DnsCache::clear()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->entries.clear();
+	}
+
+	void DnsCache::_add(const Host& domain, const harray<Host>& ips, bool failed, float ttl)
+	{
+		if (ttl <= 0.0f || this->maxSize == 0)
+		{
+			return;
+		}
+		hstr key = domain.toString().lowered();
+		int64_t time = htickCount();
+		if (!this->entries.hasKey(key))
+		{
+			while (this->entries.size() >= this->maxSize)
+			{
+				this->_removeOldest(time);
+			}
+		}
+		Entry entry;
+		entry.ips = ips;
+		entry.failed = failed;
+		entry.expiration = time + (int64_t)(ttl * 1000.0f);
+		entry.lastUsed = time;
+		this->entries[key] = entry;
+	}
+
+	void DnsCache::_removeOldest(int64_t time)
+	{
+		hmap<hstr, Entry>::iterator oldest = this->entries.end();
+		for (hmap<hstr, Entry>::iterator it = this->entries.begin(); it != this->entries.end(); ++it)
+		{
+			// expired entries are removed first
+			if (time >= it->second.expiration)
+			{
+				oldest = it;
+				break;
+			}
+			if (oldest == this->entries.end() || it->second.lastUsed < oldest->second.lastUsed)
+			{
+				oldest = it;
+			}
+		}
+		if (oldest != this->entries.end())
+		{
+			this->entries.erase(oldest);
+		}
+	}
+
+}
@@ -0,0 +1,92 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a cache of resolved domains that is shared between all sockets.
+
+#ifndef SAKIT_DNS_CACHE_H
+#define SAKIT_DNS_CACHE_H
+
+#include <stdint.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "Host.h"
+
+namespace sakit
+{
+	class DnsCache
+	{
+	public:
+		enum Result
+		{
+			/// @brief The domain has not been resolved yet or its entry has expired.
+			MISSING,
+			/// @brief The domain was resolved successfully.
+			FOUND,
+			/// @brief Resolving the domain has failed recently.
+			FAILED
+		};
+
+		DnsCache();
+		~DnsCache();
+
+		float getTtl();
+		float getNegativeTtl();
+		/// @param[in] ttl Time in seconds that resolved domains are kept, 0 disables caching.
+		/// @param[in] negativeTtl Time in seconds that failed lookups are kept, 0 disables caching of failures.
+		void setTtl(float ttl, float negativeTtl);
+		int getMaxSize();
+		/// @note Entries that were not used for the longest time are removed first when the cache is full.
+		void setMaxSize(int value);
+		int getSize();
+		int64_t getHitCount();
+		int64_t getMissCount();
+
+		/// @param[out] ip The first of the cached addresses.
+		Result get(const Host& domain, Host& ip);
+		/// @param[out] ips All cached addresses in the order they were resolved.
+		Result get(const Host& domain, harray<Host>& ips);
+		/// @param[in] ttl Time in seconds from the DNS record, the configured TTL is used if it is shorter or if this is negative.
+		void add(const Host& domain, const Host& ip, float ttl = -1.0f);
+		/// @note Used when a domain has multiple addresses, e.g. IPv4 and IPv6 ones.
+		void add(const Host& domain, const harray<Host>& ips, float ttl = -1.0f);
+		void addFailed(const Host& domain);
+		void clear();
+
+	protected:
+		struct Entry
+		{
+			harray<Host> ips;
+			bool failed;
+			int64_t expiration;
+			int64_t lastUsed;
+		};
+
+		hmutex mutex;
+		hmap<hstr, Entry> entries;
+		float ttl;
+		float negativeTtl;
+		int maxSize;
+		int64_t hitCount;
+		int64_t missCount;
+
+		void _add(const Host& domain, const harray<Host>& ips, bool failed, float ttl);
+		void _removeOldest(int64_t time);
+
+	private:
+		DnsCache(const DnsCache& other); // prevents copying
+
+	};
+
+}
+#endif
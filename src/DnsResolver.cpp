@@ -0,0 +1,805 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#ifdef _WIN32
+#include <windows.h>
+#include <bcrypt.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <hltypes/harray.h>
+#include <hltypes/hfile.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
+
+#include "DnsCache.h"
+#include "DnsResolver.h"
+#include "Endpoint.h"
+#include "NetworkAdapter.h"
+#include "OutgoingDatagram.h"
+#include "PlatformSocket.h"
+#include "ResolverDelegate.h"
+#include "sakit.h"
+#include "Semaphore.h"
+
+#define DNS_PORT 53
+// UDP responses without EDNS are never larger than this
+#define MAX_PACKET_SIZE 512
+#define MAX_NAME_SIZE 253
+#define MAX_LABEL_SIZE 63
+#define HEADER_SIZE 12
+#define FLAG_TRUNCATED 0x02
+#define TYPE_A 1
+#define TYPE_AAAA 28
+#define CLASS_IN 1
+#define RCODE_NXDOMAIN 3
+// a query is sent again to the next server if there was no response
+#define RETRY_TIMEOUT 1000
+#define MAX_ATTEMPTS 4
+// how long the thread waits for responses before checking for new queries and timeouts, in seconds
+#define RESPONSE_WAIT_TIMEOUT 0.01f
+// how long the thread sleeps when there are no queries, in milliseconds
+#define IDLE_WAIT_TIMEOUT 100.0f
+
+namespace sakit
+{
+	extern DnsCache dnsCache;
+
+	void _wakeUpdate();
+
+	/// @note Reads a possibly compressed name and returns the offset after it in the packet.
+	static int _readName(const unsigned char* data, int size, int offset, hstr* name)
+	{
+		int end = -1;
+		int jumps = 0;
+		harray<hstr> labels;
+		while (offset < size)
+		{
+			unsigned char length = data[offset];
+			if (length == 0)
+			{
+				if (name != NULL)
+				{
+					*name = labels.joined('.').lowered();
+				}
+				return (end >= 0 ? end : offset + 1);
+			}
+			if ((length & 0xC0) == 0xC0)
+			{
+				// pointers can't loop forever
+				if (offset + 1 >= size || jumps >= MAX_PACKET_SIZE)
+				{
+					return -1;
+				}
+				if (end < 0)
+				{
+					end = offset + 2;
+				}
+				offset = ((length & 0x3F) << 8) | data[offset + 1];
+				++jumps;
+				continue;
+			}
+			if (length > MAX_LABEL_SIZE || offset + 1 + length > size)
+			{
+				return -1;
+			}
+			if (name != NULL)
+			{
+				labels += hstr((const char*)&data[offset + 1], length);
+			}
+			offset += 1 + length;
+		}
+		return -1;
+	}
+
+	DnsResolver::DnsResolver() : hthread(&process, "SAKit DNS resolver"), nextHandle(1), serverPort(DNS_PORT), ipv6Preferred(false)
+	{
+		this->_loadConfiguration();
+	}
+
+	DnsResolver::~DnsResolver()
+	{
+		foreach_map (int, PlatformSocket*, it, this->sockets)
+		{
+			it->second->disconnect();
+			delete it->second;
+		}
+	}
+
+	void DnsResolver::setServers(const harray<Host>& servers, unsigned short port)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (servers.size() > 0)
+		{
+			this->servers = servers;
+			this->serverPort = port;
+		}
+		else
+		{
+			this->_loadConfiguration();
+		}
+	}
+
+	int DnsResolver::query(Host domain, ResolverDelegate* resolverDelegate)
+	{
+		Query query;
+		query.domain = domain;
+		query.resolverDelegate = resolverDelegate;
+		query.result = RUNNING;
+		query.ipv4Answered = false;
+		query.ipv6Answered = false;
+		query.ttl = 0.0f;
+		query.id = 0;
+		query.attempts = 0;
+		query.sendTime = 0;
+		query.systemResolver = false;
+		harray<Host> ips;
+		// known domains don't need to go through the thread
+		DnsCache::Result cached = (domain.isIp() ? DnsCache::FOUND : dnsCache.get(domain, ips));
+		if (domain.isIp())
+		{
+			ips += domain;
+		}
+		hmutex::ScopeLock lock(&this->mutex);
+		query.handle = this->nextHandle;
+		++this->nextHandle;
+		if (this->nextHandle <= 0)
+		{
+			this->nextHandle = 1;
+		}
+		if (cached == DnsCache::MISSING)
+		{
+			hstr name = domain.toString().lowered();
+			if (this->hosts.hasKey(name))
+			{
+				cached = DnsCache::FOUND;
+				ips = this->_sortIps(this->hosts[name]);
+			}
+		}
+		if (cached != DnsCache::MISSING)
+		{
+			query.result = (cached == DnsCache::FOUND ? FINISHED : FAILED);
+			query.ips = ips;
+		}
+		this->queries += query;
+		lock.release();
+		if (query.result == RUNNING)
+		{
+			this->semaphore.post();
+		}
+		else if (resolverDelegate != NULL)
+		{
+			_wakeUpdate();
+		}
+		return query.handle;
+	}
+
+	bool DnsResolver::poll(int handle, harray<Host>& ips, bool& success)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		for_iter (i, 0, this->queries.size())
+		{
+			if (this->queries[i].handle == handle)
+			{
+				if (this->queries[i].result == RUNNING)
+				{
+					return false;
+				}
+				success = (this->queries[i].result == FINISHED);
+				ips = this->queries[i].ips;
+				this->queries.removeAt(i);
+				return true;
+			}
+		}
+		// an unknown handle is treated as a failed query so callers don't wait forever
+		success = false;
+		return true;
+	}
+
+	void DnsResolver::cancel(int handle)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		for_iter (i, 0, this->queries.size())
+		{
+			if (this->queries[i].handle == handle)
+			{
+				this->queries.removeAt(i);
+				break;
+			}
+		}
+	}
+
+	void DnsResolver::cancel(ResolverDelegate* resolverDelegate)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		for_iter (i, 0, this->queries.size())
+		{
+			if (this->queries[i].resolverDelegate == resolverDelegate)
+			{
+				this->queries.removeAt(i);
+				--i;
+			}
+		}
+	}
+
+	void DnsResolver::shutdown()
+	{
+		this->executing = false;
+		this->semaphore.post();
+		this->join();
+	}
+
+	void DnsResolver::update()
+	{
+		harray<Query> finished;
+		hmutex::ScopeLock lock(&this->mutex);
+		for_iter (i, 0, this->queries.size())
+		{
+			if (this->queries[i].resolverDelegate != NULL && this->queries[i].result != RUNNING)
+			{
+				finished += this->queries.removeAt(i);
+				--i;
+			}
+		}
+		lock.release();
+		foreach (Query, it, finished)
+		{
+			if ((*it).result == FINISHED)
+			{
+				(*it).resolverDelegate->onResolved((*it).domain, (*it).ips);
+			}
+			else
+			{
+				(*it).resolverDelegate->onResolveFailed((*it).domain);
+			}
+		}
+	}
+
+	void DnsResolver::_loadConfiguration()
+	{
+		this->servers.clear();
+		this->serverPort = DNS_PORT;
+		this->hosts.clear();
+		hfile file;
+		harray<hstr> lines;
+		harray<hstr> fields;
+		if (hfile::exists("/etc/resolv.conf"))
+		{
+			file.open("/etc/resolv.conf");
+			lines = file.read().split('\n', -1, true);
+			file.close();
+			foreach (hstr, it, lines)
+			{
+				fields = DnsResolver::_splitLine(*it);
+				// the socket only uses IPv4
+				if (fields.size() >= 2 && fields[0] == "nameserver" && Host(fields[1]).isIpv4())
+				{
+					this->servers += Host(fields[1]);
+				}
+			}
+		}
+		if (hfile::exists("/etc/hosts"))
+		{
+			file.open("/etc/hosts");
+			lines = file.read().split('\n', -1, true);
+			file.close();
+			Host ip;
+			foreach (hstr, it, lines)
+			{
+				fields = DnsResolver::_splitLine(*it);
+				// e.g. "localhost" usually has both an IPv4 and an IPv6 entry
+				if (fields.size() >= 2 && Host(fields[0]).isIp())
+				{
+					ip = Host(fields[0]);
+					for_iter (i, 1, fields.size())
+					{
+						if (!this->hosts[fields[i].lowered()].has(ip))
+						{
+							this->hosts[fields[i].lowered()] += ip;
+						}
+					}
+				}
+			}
+		}
+		this->_loadPreferredFamily();
+	}
+
+	void DnsResolver::_loadPreferredFamily()
+	{
+		this->ipv6Preferred = false;
+		harray<NetworkAdapter> adapters = PlatformSocket::getNetworkAdapters();
+		hstr address;
+		foreach (NetworkAdapter, it, adapters)
+		{
+			// loopback and link-local addresses don't make IPv6 reachable
+			address = (*it).getAddress().toString().lowered();
+			if ((*it).getAddress().isIpv6() && address != "::1" && !address.startsWith("fe80:"))
+			{
+				this->ipv6Preferred = true;
+				break;
+			}
+		}
+	}
+
+	PlatformSocket* DnsResolver::_createSocket(int handle)
+	{
+		PlatformSocket* socket = new PlatformSocket();
+		socket->setConnectionLess(true);
+		// the system picks a random port so responses can't be forged without seeing the query
+		unsigned short localPort = 0;
+		if (!socket->bind(Host::Any, localPort))
+		{
+			hlog::warn(logTag, "Could not create DNS resolver socket, using the system resolver instead.");
+			delete socket;
+			return NULL;
+		}
+		this->sockets[handle] = socket;
+		return socket;
+	}
+
+	void DnsResolver::_destroySockets()
+	{
+		harray<int> handles = this->sockets.keys();
+		foreach (Query, it, this->queries)
+		{
+			if ((*it).result == RUNNING)
+			{
+				handles.tryRemove((*it).handle);
+			}
+		}
+		foreach (int, it, handles)
+		{
+			this->sockets[*it]->disconnect();
+			delete this->sockets[*it];
+			this->sockets.removeKey(*it);
+		}
+	}
+
+	void DnsResolver::_updateQueries()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->_destroySockets();
+		bool useServers = (this->servers.size() > 0);
+		int64_t time = htickCount();
+		// both questions have to stay valid until the batch is sent
+		unsigned char packet[2][MAX_PACKET_SIZE];
+		hstream stream;
+		Query* query = NULL;
+		Host domain;
+		harray<Host> ips;
+		bool temporaryFailure = false;
+		harray<OutgoingDatagram> datagrams;
+		PlatformSocket* socket = NULL;
+		Host server;
+		int sent = 0;
+		for_iter (i, 0, this->queries.size())
+		{
+			query = &this->queries[i];
+			if (query->result != RUNNING)
+			{
+				continue;
+			}
+			if (!useServers || query->systemResolver)
+			{
+				// the system resolver blocks so the lock is released while it runs
+				domain = query->domain;
+				int handle = query->handle;
+				lock.release();
+				PlatformSocket::_resolveHosts(domain, ips, temporaryFailure);
+				lock.acquire(&this->mutex);
+				for_iter (j, 0, this->queries.size())
+				{
+					if (this->queries[j].handle == handle)
+					{
+						this->queries[j].ips = ips;
+						this->queries[j].ttl = dnsCache.getTtl();
+						this->_finish(this->queries[j], (ips.size() > 0), !temporaryFailure);
+						break;
+					}
+				}
+				// the queries might have changed in the meantime
+				return;
+			}
+			if (query->attempts > 0 && time - query->sendTime < RETRY_TIMEOUT)
+			{
+				continue;
+			}
+			if (query->attempts >= MAX_ATTEMPTS)
+			{
+				hlog::warn(logTag, "DNS query timed out for: " + query->domain.toString());
+				// one of the families might have been answered already, but the domain might exist so a failure is not cached
+				this->_finish(*query, (query->ips.size() > 0), false);
+				continue;
+			}
+			if (query->attempts == 0)
+			{
+				socket = (DnsResolver::_makeId(query->id) ? this->_createSocket(query->handle) : NULL);
+				if (socket == NULL)
+				{
+					query->systemResolver = true;
+					--i;
+					continue;
+				}
+			}
+			else
+			{
+				socket = this->sockets[query->handle];
+			}
+			// every attempt goes to the next server
+			server = this->servers[query->attempts % this->servers.size()];
+			datagrams.clear();
+			for_iter (j, 0, 2)
+			{
+				if (j == 0 ? query->ipv4Answered : query->ipv6Answered)
+				{
+					continue;
+				}
+				stream.clear();
+				if (!this->_writeQuery(*query, (j == 0 ? TYPE_A : TYPE_AAAA), stream))
+				{
+					break;
+				}
+				int size = (int)stream.size();
+				stream.rewind();
+				stream.readRaw(&packet[j][0], size);
+				datagrams += OutgoingDatagram(server, this->serverPort, &packet[j][0], size);
+			}
+			if (datagrams.size() == 0)
+			{
+				hlog::warn(logTag, "Cannot resolve invalid domain: " + query->domain.toString());
+				this->_finish(*query, false, true);
+				continue;
+			}
+			if (!query->servers.has(server))
+			{
+				query->servers += server;
+			}
+			sent = 0;
+			socket->sendBatch(datagrams, sent);
+			++query->attempts;
+			query->sendTime = time;
+		}
+	}
+
+	void DnsResolver::_updateResponses()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		bool running = false;
+		harray<int> handles;
+		harray<PlatformSocket*> sockets;
+		foreach (Query, it, this->queries)
+		{
+			if ((*it).result == RUNNING)
+			{
+				running = true;
+				if (this->sockets.hasKey((*it).handle))
+				{
+					handles += (*it).handle;
+					sockets += this->sockets[(*it).handle];
+				}
+			}
+		}
+		lock.release();
+		if (sockets.size() == 0)
+		{
+			this->semaphore.wait(running ? RESPONSE_WAIT_TIMEOUT * 1000.0f : IDLE_WAIT_TIMEOUT);
+			return;
+		}
+		if (!PlatformSocket::waitReceive(sockets, RESPONSE_WAIT_TIMEOUT))
+		{
+			return;
+		}
+		Endpoint remoteEndpoint;
+		unsigned short id = 0;
+		hstr domain;
+		int type = 0;
+		bool truncated = false;
+		bool success = false;
+		harray<Host> ips;
+		float ttl = 0.0f;
+		Query* query = NULL;
+		for_iter (i, 0, sockets.size())
+		{
+			while (true)
+			{
+				this->stream.clear();
+				if (!sockets[i]->receiveFrom(&this->stream, remoteEndpoint) || this->stream.size() == 0)
+				{
+					break;
+				}
+				this->stream.rewind();
+				if (!this->_readResponse(this->stream, id, domain, type, truncated, success, ips, ttl))
+				{
+					continue;
+				}
+				lock.acquire(&this->mutex);
+				query = NULL;
+				for_iter (j, 0, this->queries.size())
+				{
+					if (this->queries[j].handle == handles[i])
+					{
+						query = &this->queries[j];
+						break;
+					}
+				}
+				// the sender and the name have to match as well so a guessed ID is not enough to spoof a response
+				if (query == NULL || query->result != RUNNING || query->systemResolver || query->id != id || query->domain.toString().lowered() != domain ||
+					remoteEndpoint.getPort() != this->serverPort || !query->servers.has(remoteEndpoint.getHost()) ||
+					(type == TYPE_A ? query->ipv4Answered : query->ipv6Answered))
+				{
+					lock.release();
+					continue;
+				}
+				if (truncated)
+				{
+					// the system resolver can use TCP for large responses
+					query->systemResolver = true;
+				}
+				else if (!success) // the domain doesn't exist at all
+				{
+					this->_finish(*query, false, true);
+				}
+				else
+				{
+					if (ips.size() > 0)
+					{
+						query->ttl = (query->ips.size() > 0 ? hmin(query->ttl, ttl) : ttl);
+						query->ips += ips;
+					}
+					if (type == TYPE_A)
+					{
+						query->ipv4Answered = true;
+					}
+					else
+					{
+						query->ipv6Answered = true;
+					}
+					// if neither family has an address, the domain has no usable records
+					if (query->ipv4Answered && query->ipv6Answered)
+					{
+						this->_finish(*query, (query->ips.size() > 0), true);
+					}
+				}
+				lock.release();
+			}
+			sockets[i]->releaseBuffer();
+		}
+	}
+
+	void DnsResolver::_finish(Query& query, bool success, bool cache)
+	{
+		query.result = (success ? FINISHED : FAILED);
+		if (success)
+		{
+			query.ips = this->_sortIps(query.ips);
+			dnsCache.add(query.domain, query.ips, query.ttl);
+		}
+		else
+		{
+			query.ips.clear();
+			if (cache)
+			{
+				dnsCache.addFailed(query.domain);
+			}
+		}
+		if (query.resolverDelegate != NULL)
+		{
+			_wakeUpdate();
+		}
+	}
+
+	harray<Host> DnsResolver::_sortIps(const harray<Host>& ips)
+	{
+		harray<Host> result;
+		harray<Host> other;
+		for_iter (i, 0, ips.size())
+		{
+			if (ips[i].isIpv6() == this->ipv6Preferred)
+			{
+				result += ips[i];
+			}
+			else
+			{
+				other += ips[i];
+			}
+		}
+		result += other;
+		return result;
+	}
+
+	bool DnsResolver::_writeQuery(const Query& query, int type, hstream& stream)
+	{
+		hstr name = query.domain.toString();
+		if (name.endsWith("."))
+		{
+			name = name(0, name.size() - 1);
+		}
+		if (name.size() == 0 || name.size() > MAX_NAME_SIZE)
+		{
+			return false;
+		}
+		harray<hstr> labels = name.split('.');
+		unsigned char header[HEADER_SIZE] = {0};
+		header[0] = (unsigned char)(query.id >> 8);
+		header[1] = (unsigned char)(query.id & 0xFF);
+		header[2] = 0x01; // recursion desired
+		header[5] = 1; // one question
+		stream.writeRaw(header, HEADER_SIZE);
+		unsigned char length = 0;
+		foreach (hstr, it, labels)
+		{
+			if ((*it).size() == 0 || (*it).size() > MAX_LABEL_SIZE)
+			{
+				return false;
+			}
+			length = (unsigned char)(*it).size();
+			stream.writeRaw(&length, 1);
+			stream.writeRaw((unsigned char*)(*it).cStr(), (*it).size());
+		}
+		unsigned char question[5] = {0, 0, (unsigned char)type, 0, CLASS_IN}; // root label, type, class
+		stream.writeRaw(question, 5);
+		return true;
+	}
+
+	bool DnsResolver::_readResponse(hstream& stream, unsigned short& id, hstr& domain, int& type, bool& truncated, bool& success, harray<Host>& ips, float& ttl)
+	{
+		unsigned char data[MAX_PACKET_SIZE];
+		int size = hmin((int)stream.size(), MAX_PACKET_SIZE);
+		if (size < HEADER_SIZE)
+		{
+			return false;
+		}
+		stream.readRaw(data, size);
+		if ((data[2] & 0x80) == 0) // not a response
+		{
+			return false;
+		}
+		id = (unsigned short)((data[0] << 8) | data[1]);
+		truncated = ((data[2] & FLAG_TRUNCATED) != 0);
+		int questionCount = (data[4] << 8) | data[5];
+		int answerCount = (data[6] << 8) | data[7];
+		int responseCode = (data[3] & 0x0F);
+		if (questionCount != 1)
+		{
+			return false;
+		}
+		int offset = _readName(data, size, HEADER_SIZE, &domain);
+		if (offset < 0 || offset + 4 > size)
+		{
+			return false;
+		}
+		type = (data[offset] << 8) | data[offset + 1];
+		if (type != TYPE_A && type != TYPE_AAAA)
+		{
+			return false;
+		}
+		offset += 4;
+		success = false;
+		ips.clear();
+		ttl = 0.0f;
+		if (truncated) // the answers can't be trusted to be complete
+		{
+			return true;
+		}
+		if (responseCode != 0)
+		{
+			if (responseCode != RCODE_NXDOMAIN)
+			{
+				// e.g. a server failure, another attempt might succeed
+				return false;
+			}
+			return true;
+		}
+		int recordType = 0;
+		int dataClass = 0;
+		int dataSize = 0;
+		unsigned int recordTtl = 0;
+		// NODATA responses are successful, there just isn't an address of this family
+		success = true;
+		for_iter (i, 0, answerCount)
+		{
+			offset = _readName(data, size, offset, NULL);
+			if (offset < 0 || offset + 10 > size)
+			{
+				return false;
+			}
+			recordType = (data[offset] << 8) | data[offset + 1];
+			dataClass = (data[offset + 2] << 8) | data[offset + 3];
+			recordTtl = ((unsigned int)data[offset + 4] << 24) | ((unsigned int)data[offset + 5] << 16) | ((unsigned int)data[offset + 6] << 8) | (unsigned int)data[offset + 7];
+			dataSize = (data[offset + 8] << 8) | data[offset + 9];
+			offset += 10;
+			if (offset + dataSize > size)
+			{
+				return false;
+			}
+			// aliases (CNAME) are followed by the server and come before the actual addresses
+			if (recordType == type && dataClass == CLASS_IN)
+			{
+				if (type == TYPE_A && dataSize == 4)
+				{
+					ips += Host(data[offset], data[offset + 1], data[offset + 2], data[offset + 3]);
+				}
+				else if (type == TYPE_AAAA && dataSize == 16)
+				{
+					ips += Host::fromIpv6Bytes(&data[offset]);
+				}
+				// the shortest TTL of all records is used
+				recordTtl = hmin(recordTtl, (unsigned int)0x7FFFFFFF);
+				ttl = (ips.size() == 1 ? (float)recordTtl : hmin(ttl, (float)recordTtl));
+			}
+			offset += dataSize;
+		}
+		return true;
+	}
+
+	harray<hstr> DnsResolver::_splitLine(chstr line)
+	{
+		int index = line.indexOf('#');
+		hstr result = (index >= 0 ? line(0, index) : line);
+		return result.replaced("\t", " ").replaced("\r", "").split(' ', -1, true);
+	}
+
+	bool DnsResolver::_makeId(unsigned short& id)
+	{
+		unsigned char bytes[2] = {0};
+#ifdef _WIN32
+		if (!BCRYPT_SUCCESS(BCryptGenRandom(NULL, bytes, 2, BCRYPT_USE_SYSTEM_PREFERRED_RNG)))
+		{
+			return false;
+		}
+#else
+		int file = open("/dev/urandom", O_RDONLY);
+		if (file < 0)
+		{
+			hlog::error(logTag, "Cannot open /dev/urandom for DNS query IDs.");
+			return false;
+		}
+		int count = 0;
+		int result = 0;
+		while (count < 2)
+		{
+			result = (int)read(file, &bytes[count], 2 - count);
+			if (result < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (result <= 0)
+			{
+				break;
+			}
+			count += result;
+		}
+		close(file);
+		if (count < 2)
+		{
+			return false;
+		}
+#endif
+		id = (unsigned short)((bytes[0] << 8) | bytes[1]);
+		return true;
+	}
+
+	void DnsResolver::process(hthread* thread)
+	{
+		DnsResolver* resolver = (DnsResolver*)thread;
+		while (resolver->isRunning() && resolver->executing)
+		{
+			resolver->_updateQueries();
+			resolver->_updateResponses();
+		}
+	}
+
+}
@@ -0,0 +1,125 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a thread that resolves domains asynchronously with its own DNS client.
+
+#ifndef SAKIT_DNS_RESOLVER_H
+#define SAKIT_DNS_RESOLVER_H
+
+#include <stdint.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
+
+#include "Host.h"
+#include "Semaphore.h"
+#include "State.h"
+
+namespace sakit
+{
+	class PlatformSocket;
+	class ResolverDelegate;
+
+	/// @note Queries are sent over UDP to the name servers from /etc/resolv.conf. If there are none, a socket can't be created or a response is truncated, the system resolver is called on this thread instead.
+	class DnsResolver : public hthread
+	{
+	public:
+		DnsResolver();
+		~DnsResolver();
+
+		/// @brief Sets the name servers that are queried, an empty array loads them from /etc/resolv.conf again.
+		/// @note Mostly useful for testing against a local DNS server.
+		void setServers(const harray<Host>& servers, unsigned short port);
+		/// @brief Starts resolving a domain.
+		/// @param[in] resolverDelegate Receives the result in update(), if NULL the result has to be taken with poll().
+		/// @return A handle for poll() and cancel().
+		int query(Host domain, ResolverDelegate* resolverDelegate = NULL);
+		/// @param[out] ips All IPv4 and IPv6 addresses of the domain, the preferred family first.
+		/// @return False while the domain is still being resolved.
+		/// @note The query is removed once a result has been returned.
+		bool poll(int handle, harray<Host>& ips, bool& success);
+		void cancel(int handle);
+		/// @brief Removes all queries that would report to the given delegate.
+		void cancel(ResolverDelegate* resolverDelegate);
+		void shutdown();
+		/// @brief Calls the delegates of all finished queries.
+		void update();
+
+	protected:
+		struct Query
+		{
+			int handle;
+			Host domain;
+			ResolverDelegate* resolverDelegate;
+			State result;
+			harray<Host> ips;
+			/// @note A and AAAA records are queried separately with the same ID.
+			bool ipv4Answered;
+			bool ipv6Answered;
+			float ttl;
+			unsigned short id;
+			int attempts;
+			int64_t sendTime;
+			/// @brief The name servers the query was sent to, responses from anywhere else are ignored.
+			harray<Host> servers;
+			/// @brief Set when the response didn't fit into a UDP packet or the query has no socket, the system resolver is used instead.
+			bool systemResolver;
+		};
+
+		hmutex mutex;
+		/// @brief Wakes the thread when new queries are added.
+		Semaphore semaphore;
+		harray<Query> queries;
+		int nextHandle;
+		/// @note Every query has its own socket so the source port can't be predicted, only used on the resolver thread.
+		hmap<int, PlatformSocket*> sockets;
+		harray<Host> servers;
+		unsigned short serverPort;
+		/// @note Lowered domain names from /etc/hosts.
+		hmap<hstr, harray<Host> > hosts;
+		/// @brief Whether IPv6 addresses come first, only if there is a network adapter with a global IPv6 address.
+		bool ipv6Preferred;
+		hstream stream;
+
+		void _loadConfiguration();
+		void _loadPreferredFamily();
+		PlatformSocket* _createSocket(int handle);
+		/// @brief Closes the sockets of queries that aren't running anymore.
+		void _destroySockets();
+		void _updateQueries();
+		void _updateResponses();
+		/// @param[in] cache Whether a failure is cached, only when the domain or the address family doesn't exist and not when the servers didn't answer.
+		void _finish(Query& query, bool success, bool cache);
+		/// @brief Puts the addresses of the preferred family first.
+		harray<Host> _sortIps(const harray<Host>& ips);
+		bool _writeQuery(const Query& query, int type, hstream& stream);
+		/// @param[out] type The record type of the question.
+		/// @param[out] truncated Whether the response didn't fit into the packet, nothing else but the question is read then.
+		bool _readResponse(hstream& stream, unsigned short& id, hstr& domain, int& type, bool& truncated, bool& success, harray<Host>& ips, float& ttl);
+
+		/// @brief Splits a line of a configuration file into fields without the comment.
+		static harray<hstr> _splitLine(chstr line);
+		/// @brief Creates an unpredictable query ID with the random number generator of the system.
+		static bool _makeId(unsigned short& id);
+
+		static void process(hthread* thread);
+
+	private:
+		DnsResolver(const DnsResolver& other); // prevents copying
+
+	};
+
+}
+#endif
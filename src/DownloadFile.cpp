@@ -0,0 +1,559 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "DownloadFile.h"
+
+#include <string.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <hltypes/harray.h>
+#include <hltypes/hfile.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+
+#include "sakit.h"
+#include "sakitUtil.h"
+
+#define SAVE_INTERVAL 67108864 // bytes that are written before the state is saved again
+
+namespace sakit
+{
+	hstr DownloadFile::StateExtension = ".resume";
+
+	DownloadFile::Segment::Segment() : start(0), end(-1), received(0)
+	{
+	}
+
+	DownloadFile::Segment::Segment(int64_t start, int64_t end) : received(0)
+	{
+		this->start = start;
+		this->end = end;
+	}
+
+	int64_t DownloadFile::Segment::getOffset() const
+	{
+		return (this->start + this->received);
+	}
+
+	int64_t DownloadFile::Segment::getRemaining() const
+	{
+		return (this->end >= 0 ? this->end - this->start - this->received : -1);
+	}
+
+	DownloadFile::DownloadFile() : size(-1), unsavedSize(0)
+	{
+#ifndef _WIN32
+		this->descriptor = -1;
+		this->mapping = NULL;
+		this->mappingSize = 0;
+		this->mappingRequested = false;
+#endif
+	}
+
+	DownloadFile::~DownloadFile()
+	{
+		this->close();
+	}
+
+	hstr DownloadFile::getFilename()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->filename;
+	}
+
+	int64_t DownloadFile::getSize()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->size;
+	}
+
+	hstr DownloadFile::getValidator()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->validator;
+	}
+
+	int64_t DownloadFile::getReceivedSize()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		int64_t result = 0;
+		foreach (Segment, it, this->segments)
+		{
+			result += (*it).received;
+		}
+		return result;
+	}
+
+	harray<DownloadFile::Segment> DownloadFile::getSegments()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->segments;
+	}
+
+	bool DownloadFile::isOpen()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->_isOpen();
+	}
+
+	bool DownloadFile::isMapped()
+	{
+#ifndef _WIN32
+		hmutex::ScopeLock lock(&this->mutex);
+		return (this->mapping != NULL);
+#else
+		return false;
+#endif
+	}
+
+	bool DownloadFile::isComplete()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->_isComplete();
+	}
+
+	bool DownloadFile::open(chstr filename, bool mapped)
+	{
+		this->close();
+		hmutex::ScopeLock lock(&this->mutex);
+#ifndef _WIN32
+		this->descriptor = ::open(filename.cStr(), O_RDWR | O_CREAT, 0644);
+		if (this->descriptor < 0)
+		{
+			hlog::errorf(logTag, "Could not open file '%s': %s", filename.cStr(), strerror(errno));
+			return false;
+		}
+		this->mappingRequested = mapped;
+#else
+		hmutex::ScopeLock lockFile(&this->fileMutex);
+		// existing data is kept since it could be resumed
+		this->file.open(filename, (hfile::exists(filename) ? hfile::READ_WRITE : hfile::READ_WRITE_CREATE));
+		lockFile.release();
+#endif
+		this->filename = filename;
+		this->unsavedSize = 0;
+		if (!this->_loadState())
+		{
+			this->size = -1;
+			this->validator = "";
+			this->segments.clear();
+			return true;
+		}
+		// the file is already allocated, but it might have to be mapped again
+		if (!this->_allocate())
+		{
+			this->_closeFile();
+			return false;
+		}
+		return true;
+	}
+
+	void DownloadFile::close()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (!this->_isOpen())
+		{
+			return;
+		}
+		if (this->segments.size() > 0)
+		{
+			if (this->_isComplete())
+			{
+				this->_flush();
+				this->_removeState();
+			}
+			else
+			{
+				this->_saveState();
+			}
+		}
+		this->_closeFile();
+	}
+
+	bool DownloadFile::reset(int64_t size, chstr validator)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (!this->_isOpen())
+		{
+			hlog::error(logTag, "Cannot reset download, file is not open!");
+			return false;
+		}
+		this->size = size;
+		this->validator = validator;
+		this->segments.clear();
+		this->segments += Segment(0, size);
+		this->unsavedSize = 0;
+		// old data is discarded so nothing of it remains beyond the new size
+#ifndef _WIN32
+		this->_unmap();
+		if (ftruncate(this->descriptor, 0) != 0)
+		{
+			hlog::errorf(logTag, "Could not truncate file '%s': %s", this->filename.cStr(), strerror(errno));
+			return false;
+		}
+#else
+		hmutex::ScopeLock lockFile(&this->fileMutex);
+		this->file.close();
+		this->file.open(this->filename, hfile::READ_WRITE_CREATE);
+		lockFile.release();
+#endif
+		if (!this->_allocate())
+		{
+			return false;
+		}
+		return this->_saveState();
+	}
+
+	int DownloadFile::split(int index, int64_t minSize)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (index < 0 || index >= this->segments.size())
+		{
+			return -1;
+		}
+		int64_t remaining = this->segments[index].getRemaining();
+		// both halves need to be worth a request of their own
+		if (remaining < hmax(minSize, (int64_t)1) * 2)
+		{
+			return -1;
+		}
+		int64_t middle = this->segments[index].getOffset() + remaining / 2;
+		this->segments += Segment(middle, this->segments[index].end);
+		this->segments[index].end = middle;
+		return (this->segments.size() - 1);
+	}
+
+	int DownloadFile::write(int index, const unsigned char* data, int size)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (index < 0 || index >= this->segments.size())
+		{
+			hlog::error(logTag, "Cannot write download, segment does not exist!");
+			return -1;
+		}
+		int64_t offset = this->segments[index].getOffset();
+		int64_t remaining = this->segments[index].getRemaining();
+		int count = (remaining >= 0 ? (int)hmin((int64_t)size, remaining) : size);
+		if (count <= 0)
+		{
+			return 0;
+		}
+#ifndef _WIN32
+		unsigned char* mapping = this->mapping;
+#endif
+		// segments don't overlap so they can be written in parallel
+		lock.release();
+#ifndef _WIN32
+		if (mapping != NULL)
+		{
+			memcpy(&mapping[offset], data, count);
+		}
+		else
+#endif
+		if (!this->_writeAt(offset, data, count))
+		{
+			return -1;
+		}
+		lock.acquire(&this->mutex);
+		this->segments[index].received += count;
+		this->unsavedSize += count;
+		if (this->unsavedSize >= SAVE_INTERVAL)
+		{
+			this->_saveState();
+		}
+		return count;
+	}
+
+	void DownloadFile::finishSegment(int index)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (index >= 0 && index < this->segments.size() && this->segments[index].end < 0)
+		{
+			this->segments[index].end = this->segments[index].getOffset();
+			if (this->segments.size() == 1)
+			{
+				this->size = this->segments[index].end;
+			}
+		}
+	}
+
+	bool DownloadFile::saveState()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->_saveState();
+	}
+
+	bool DownloadFile::_isOpen()
+	{
+#ifndef _WIN32
+		return (this->descriptor >= 0);
+#else
+		return this->file.isOpen();
+#endif
+	}
+
+	bool DownloadFile::_isComplete()
+	{
+		if (this->size < 0 || this->segments.size() == 0)
+		{
+			return false;
+		}
+		foreach (Segment, it, this->segments)
+		{
+			if ((*it).getRemaining() != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	hstr DownloadFile::_getStateFilename()
+	{
+		return (this->filename + DownloadFile::StateExtension);
+	}
+
+	bool DownloadFile::_loadState()
+	{
+		hstr stateFilename = this->_getStateFilename();
+		if (!hfile::exists(stateFilename))
+		{
+			return false;
+		}
+		// first line is the size, second line the validator, then one line per segment with start, end and received size
+		harray<hstr> lines = hfile::hread(stateFilename).split('\n');
+		int64_t size = 0;
+		if (lines.size() < 3 || !_parseSize(lines[0], size) || size == 0)
+		{
+			hlog::warnf(logTag, "Ignoring invalid download state '%s'!", stateFilename.cStr());
+			return false;
+		}
+		harray<Segment> segments;
+		harray<hstr> values;
+		Segment segment;
+		for_iter (i, 2, lines.size())
+		{
+			if (lines[i] == "")
+			{
+				continue;
+			}
+			values = lines[i].split(' ', -1, true);
+			if (values.size() != 3 || !_parseSize(values[0], segment.start) || !_parseSize(values[1], segment.end) || !_parseSize(values[2], segment.received) ||
+				segment.start > segment.end || segment.end > size || segment.received > segment.end - segment.start)
+			{
+				hlog::warnf(logTag, "Ignoring invalid download state '%s'!", stateFilename.cStr());
+				return false;
+			}
+			segments += segment;
+		}
+		// the received data has to be still there
+		int64_t fileSize = 0;
+#ifndef _WIN32
+		struct stat info;
+		if (fstat(this->descriptor, &info) == 0)
+		{
+			fileSize = (int64_t)info.st_size;
+		}
+#else
+		hmutex::ScopeLock lockFile(&this->fileMutex);
+		fileSize = this->file.size();
+		lockFile.release();
+#endif
+		if (segments.size() == 0 || fileSize < size)
+		{
+			hlog::warnf(logTag, "Ignoring download state '%s', it does not match the file!", stateFilename.cStr());
+			return false;
+		}
+		this->size = size;
+		this->validator = lines[1];
+		this->segments = segments;
+		return true;
+	}
+
+	bool DownloadFile::_saveState()
+	{
+		this->unsavedSize = 0;
+		// downloads of unknown size can't be resumed
+		if (this->size < 0)
+		{
+			this->_removeState();
+			return true;
+		}
+		// the data has to be on the disk before the state claims it was received
+		if (!this->_flush())
+		{
+			return false;
+		}
+		hstr state = hstr(this->size) + "\n" + this->validator + "\n";
+		foreach (Segment, it, this->segments)
+		{
+			state += hsprintf("%lld %lld %lld\n", (long long)(*it).start, (long long)(*it).end, (long long)(*it).received);
+		}
+		hfile::hwrite(this->_getStateFilename(), state);
+		return true;
+	}
+
+	void DownloadFile::_removeState()
+	{
+		hstr stateFilename = this->_getStateFilename();
+		if (hfile::exists(stateFilename))
+		{
+			hfile::remove(stateFilename);
+		}
+	}
+
+	bool DownloadFile::_allocate()
+	{
+		if (this->size <= 0)
+		{
+			return true;
+		}
+#ifndef _WIN32
+#ifdef _SAKIT_FALLOCATE
+		// reserves the disk space up front so the download can't run out of space halfway and the file isn't fragmented
+		int error = posix_fallocate(this->descriptor, 0, (off_t)this->size);
+		if (error != 0 && error != EINVAL && error != EOPNOTSUPP)
+		{
+			hlog::errorf(logTag, "Could not allocate %lld bytes for file '%s': %s", (long long)this->size, this->filename.cStr(), strerror(error));
+			return false;
+		}
+#endif
+		// file systems without support for allocation only get the file resized
+		struct stat info;
+		if (fstat(this->descriptor, &info) != 0 || (int64_t)info.st_size < this->size)
+		{
+			if (ftruncate(this->descriptor, (off_t)this->size) != 0)
+			{
+				hlog::errorf(logTag, "Could not resize file '%s': %s", this->filename.cStr(), strerror(errno));
+				return false;
+			}
+		}
+		if (this->mappingRequested && this->mapping == NULL && (uint64_t)this->size <= (uint64_t)((size_t)-1))
+		{
+			void* mapping = mmap(NULL, (size_t)this->size, PROT_READ | PROT_WRITE, MAP_SHARED, this->descriptor, 0);
+			if (mapping != MAP_FAILED)
+			{
+				this->mapping = (unsigned char*)mapping;
+				this->mappingSize = (size_t)this->size;
+			}
+			else
+			{
+				hlog::warnf(logTag, "Could not map file '%s', it will be written instead: %s", this->filename.cStr(), strerror(errno));
+			}
+		}
+#else
+		hmutex::ScopeLock lockFile(&this->fileMutex);
+		if (this->file.size() < this->size)
+		{
+			unsigned char zero = 0;
+			this->file.seek(this->size - 1, hfile::START);
+			this->file.writeRaw(&zero, 1);
+		}
+#endif
+		return true;
+	}
+
+	void DownloadFile::_closeFile()
+	{
+#ifndef _WIN32
+		this->_unmap();
+		if (this->descriptor >= 0)
+		{
+			::close(this->descriptor);
+			this->descriptor = -1;
+		}
+		this->mappingRequested = false;
+#else
+		hmutex::ScopeLock lockFile(&this->fileMutex);
+		if (this->file.isOpen())
+		{
+			this->file.close();
+		}
+		lockFile.release();
+#endif
+		this->filename = "";
+		this->size = -1;
+		this->validator = "";
+		this->segments.clear();
+		this->unsavedSize = 0;
+	}
+
+#ifndef _WIN32
+	void DownloadFile::_unmap()
+	{
+		if (this->mapping != NULL)
+		{
+			munmap(this->mapping, this->mappingSize);
+			this->mapping = NULL;
+			this->mappingSize = 0;
+		}
+	}
+#endif
+
+	bool DownloadFile::_writeAt(int64_t offset, const unsigned char* data, int size)
+	{
+#ifndef _WIN32
+		ssize_t written = 0;
+		while (size > 0)
+		{
+			written = pwrite(this->descriptor, data, (size_t)size, (off_t)offset);
+			if (written < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				hlog::errorf(logTag, "Could not write to file '%s': %s", this->filename.cStr(), strerror(errno));
+				return false;
+			}
+			data += written;
+			size -= (int)written;
+			offset += written;
+		}
+#else
+		hmutex::ScopeLock lockFile(&this->fileMutex);
+		this->file.seek(offset, hfile::START);
+		if (this->file.writeRaw(data, size) < size)
+		{
+			hlog::errorf(logTag, "Could not write to file '%s'!", this->filename.cStr());
+			return false;
+		}
+#endif
+		return true;
+	}
+
+	bool DownloadFile::_flush()
+	{
+#ifndef _WIN32
+		if (this->mapping != NULL && msync(this->mapping, this->mappingSize, MS_SYNC) != 0)
+		{
+			hlog::errorf(logTag, "Could not write mapped file '%s': %s", this->filename.cStr(), strerror(errno));
+			return false;
+		}
+#ifdef __APPLE__
+		if (fsync(this->descriptor) != 0)
+#else
+		if (fdatasync(this->descriptor) != 0)
+#endif
+		{
+			hlog::errorf(logTag, "Could not write file '%s': %s", this->filename.cStr(), strerror(errno));
+			return false;
+		}
+#endif
+		return true;
+	}
+
+}
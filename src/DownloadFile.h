@@ -0,0 +1,135 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a preallocated file that downloaded data is written to at its offsets.
+
+#ifndef SAKIT_DOWNLOAD_FILE_H
+#define SAKIT_DOWNLOAD_FILE_H
+
+#if defined(__linux__) || defined(_ANDROID)
+#define _SAKIT_FALLOCATE
+#endif
+
+#include <stdint.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstring.h>
+#ifdef _WIN32
+#include <hltypes/hfile.h>
+#endif
+
+namespace sakit
+{
+	/// @brief Keeps track of which parts of the file were received in a state file next to it, so interrupted downloads can be resumed.
+	/// @note Uses fallocate() on Linux and can map the file into memory on Unix systems, on Windows the file is written in chunks.
+	class DownloadFile
+	{
+	public:
+		/// @brief A part of the file that is received in one piece.
+		struct Segment
+		{
+			int64_t start;
+			/// @note Negative while the size of the file isn't known.
+			int64_t end;
+			/// @brief Number of bytes that were received after start.
+			int64_t received;
+
+			Segment();
+			Segment(int64_t start, int64_t end);
+
+			/// @return Offset where the next received data is written.
+			int64_t getOffset() const;
+			/// @return Number of bytes that are still missing or a negative value if it isn't known.
+			int64_t getRemaining() const;
+
+		};
+
+		/// @brief Extension of the file that stores the state of an incomplete download.
+		static hstr StateExtension;
+
+		DownloadFile();
+		~DownloadFile();
+
+		hstr getFilename();
+		/// @return Size of the whole file or a negative value if it isn't known yet.
+		int64_t getSize();
+		/// @return The ETag or Last-Modified value of the downloaded file or an empty string if there is none.
+		hstr getValidator();
+		int64_t getReceivedSize();
+		harray<Segment> getSegments();
+		bool isOpen();
+		bool isMapped();
+		bool isComplete();
+
+		/// @brief Opens the file and restores the state of an earlier interrupted download of it.
+		/// @param[in] mapped Whether the file is mapped into memory instead of data being written to it, when its size is known.
+		bool open(chstr filename, bool mapped = false);
+		/// @brief Saves the state so the download can be resumed, or removes it if the download is complete.
+		void close();
+		/// @brief Discards everything that was received and preallocates the file.
+		/// @param[in] size Size of the whole file, negative if it isn't known so the file grows while it's written.
+		/// @param[in] validator The ETag or Last-Modified value that identifies this version of the file.
+		bool reset(int64_t size, chstr validator);
+		/// @brief Splits the remaining part of a segment in two.
+		/// @return Index of the new segment that continues where the split segment ends now or -1 if the segment can't be split.
+		/// @note The new segment is always added at the end so the indices of existing segments stay the same.
+		int split(int index, int64_t minSize);
+		/// @brief Writes the data at the current offset of the segment.
+		/// @return Number of bytes that were written, fewer if the segment ends before, or -1 if writing failed.
+		/// @note Different segments can be written from different threads at the same time, but not while the file is reset or closed.
+		int write(int index, const unsigned char* data, int size);
+		/// @brief Sets the size of a segment with an unknown end to what was received.
+		void finishSegment(int index);
+		/// @brief Writes all data to the disk and saves the state.
+		bool saveState();
+
+	protected:
+		hstr filename;
+		int64_t size;
+		hstr validator;
+		harray<Segment> segments;
+		/// @brief Number of bytes that were written since the state was saved.
+		int64_t unsavedSize;
+		hmutex mutex;
+#ifndef _WIN32
+		int descriptor;
+		unsigned char* mapping;
+		size_t mappingSize;
+		bool mappingRequested;
+#else
+		hfile file;
+		hmutex fileMutex;
+#endif
+
+		bool _isOpen();
+		bool _isComplete();
+		hstr _getStateFilename();
+		bool _loadState();
+		bool _saveState();
+		void _removeState();
+		bool _allocate();
+		/// @brief Closes the file without saving or removing the state.
+		void _closeFile();
+#ifndef _WIN32
+		void _unmap();
+#endif
+		bool _writeAt(int64_t offset, const unsigned char* data, int size);
+		/// @brief Makes sure that all written data is on the disk.
+		bool _flush();
+
+	private:
+		DownloadFile(const DownloadFile& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -0,0 +1,118 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+
+#include "Endpoint.h"
+#include "Host.h"
+#include "PlatformSocket.h"
+
+namespace sakit
+{
+	Endpoint::Endpoint() : size(0)
+	{
+		memset(this->address, 0, sizeof(this->address));
+	}
+
+	Endpoint::Endpoint(const void* address, int size) : size(0)
+	{
+		memset(this->address, 0, sizeof(this->address));
+		if (address != NULL && size > 0)
+		{
+			this->size = hmin(size, (int)sizeof(this->address));
+			memcpy(this->address, address, this->size);
+		}
+	}
+
+	Endpoint::Endpoint(Host host, unsigned short port) : size(0)
+	{
+		memset(this->address, 0, sizeof(this->address));
+		PlatformSocket::makeAddress(host, port, this->address, this->size);
+	}
+
+	Endpoint::~Endpoint()
+	{
+	}
+
+	const void* Endpoint::getAddress() const
+	{
+		return this->address;
+	}
+
+	bool Endpoint::isValid() const
+	{
+		return (this->size > 0);
+	}
+
+	Host Endpoint::getHost() const
+	{
+		Host host;
+		unsigned short port = 0;
+		if (this->size > 0)
+		{
+			PlatformSocket::getAddressHostPort(this->address, this->size, host, port);
+		}
+		return host;
+	}
+
+	unsigned short Endpoint::getPort() const
+	{
+		return (this->size > 0 ? PlatformSocket::getAddressPort(this->address, this->size) : 0);
+	}
+
+	hstr Endpoint::toString() const
+	{
+		if (this->size == 0)
+		{
+			return "";
+		}
+		Host host;
+		unsigned short port = 0;
+		PlatformSocket::getAddressHostPort(this->address, this->size, host, port);
+		hstr result = host.toString();
+		if (result.contains(":")) // IPv6 addresses need brackets to be told apart from the port
+		{
+			result = "[" + result + "]";
+		}
+		return result + ":" + hstr(port);
+	}
+
+	unsigned int Endpoint::hash() const
+	{
+		// FNV-1a
+		unsigned int result = 2166136261U;
+		for_iter (i, 0, this->size)
+		{
+			result = (result ^ this->address[i]) * 16777619U;
+		}
+		return result;
+	}
+
+	bool Endpoint::operator==(const Endpoint& other) const
+	{
+		return (this->size == other.size && memcmp(this->address, other.address, this->size) == 0);
+	}
+
+	bool Endpoint::operator!=(const Endpoint& other) const
+	{
+		return !(*this == other);
+	}
+
+	bool Endpoint::operator<(const Endpoint& other) const
+	{
+		if (this->size != other.size)
+		{
+			return (this->size < other.size);
+		}
+		return (memcmp(this->address, other.address, this->size) < 0);
+	}
+
+}
@@ -0,0 +1,158 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "FileTransfer.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef _SAKIT_MMAP_SEND
+#include <sys/mman.h>
+#endif
+#endif
+
+#include <hltypes/hlog.h>
+#include <hltypes/hstring.h>
+#ifdef _WIN32
+#include <hltypes/hfile.h>
+#endif
+
+#include "sakit.h"
+
+namespace sakit
+{
+	FileTransfer::FileTransfer() : offset(0), remaining(0)
+	{
+#ifndef _WIN32
+		this->descriptor = -1;
+#ifdef _SAKIT_MMAP_SEND
+		this->mapping = NULL;
+		this->mappingSize = 0;
+		this->data = NULL;
+#endif
+#endif
+	}
+
+	FileTransfer::~FileTransfer()
+	{
+		this->close();
+	}
+
+	bool FileTransfer::isOpen()
+	{
+#ifndef _WIN32
+		return (this->descriptor >= 0);
+#else
+		return this->file.isOpen();
+#endif
+	}
+
+	bool FileTransfer::open(chstr filename, int64_t offset, int64_t length)
+	{
+		this->close();
+		int64_t size = 0;
+#ifndef _WIN32
+		this->descriptor = ::open(filename.cStr(), O_RDONLY);
+		if (this->descriptor < 0)
+		{
+			hlog::errorf(logTag, "Could not open file '%s': %s", filename.cStr(), strerror(errno));
+			return false;
+		}
+		struct stat info;
+		if (fstat(this->descriptor, &info) != 0)
+		{
+			hlog::errorf(logTag, "Could not get size of file '%s': %s", filename.cStr(), strerror(errno));
+			this->close();
+			return false;
+		}
+		size = (int64_t)info.st_size;
+#else
+		if (!hfile::exists(filename))
+		{
+			hlog::errorf(logTag, "Could not open file '%s'!", filename.cStr());
+			return false;
+		}
+		this->file.open(filename);
+		size = this->file.size();
+#endif
+		if (offset < 0 || offset > size)
+		{
+			hlog::errorf(logTag, "Cannot send file '%s', offset %lld is outside of the file!", filename.cStr(), (long long)offset);
+			this->close();
+			return false;
+		}
+		this->offset = offset;
+		this->remaining = (length >= 0 ? hmin(length, size - offset) : size - offset);
+#ifdef _SAKIT_MMAP_SEND
+		if (this->remaining > 0)
+		{
+			// the mapping has to start at a page boundary
+			int64_t start = offset - offset % (int64_t)sysconf(_SC_PAGESIZE);
+			this->mappingSize = (size_t)(offset + this->remaining - start);
+			void* mapping = mmap(NULL, this->mappingSize, PROT_READ, MAP_PRIVATE, this->descriptor, (off_t)start);
+			if (mapping == MAP_FAILED)
+			{
+				hlog::errorf(logTag, "Could not map file '%s': %s", filename.cStr(), strerror(errno));
+				this->close();
+				return false;
+			}
+			this->mapping = (unsigned char*)mapping;
+			this->data = this->mapping + (offset - start);
+		}
+#endif
+		return true;
+	}
+
+	void FileTransfer::close()
+	{
+#ifndef _WIN32
+#ifdef _SAKIT_MMAP_SEND
+		if (this->mapping != NULL)
+		{
+			munmap(this->mapping, this->mappingSize);
+			this->mapping = NULL;
+			this->mappingSize = 0;
+			this->data = NULL;
+		}
+#endif
+		if (this->descriptor >= 0)
+		{
+			::close(this->descriptor);
+			this->descriptor = -1;
+		}
+#else
+		if (this->file.isOpen())
+		{
+			this->file.close();
+		}
+#endif
+		this->offset = 0;
+		this->remaining = 0;
+	}
+
+	void FileTransfer::advance(int count)
+	{
+		this->offset += count;
+		this->remaining -= count;
+#ifdef _SAKIT_MMAP_SEND
+		this->data += count;
+#endif
+	}
+
+#ifdef _WIN32
+	int FileTransfer::_read(unsigned char* data, int size)
+	{
+		this->file.seek(this->offset, hfile::START);
+		return this->file.readRaw(data, size);
+	}
+#endif
+
+}
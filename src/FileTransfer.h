@@ -0,0 +1,76 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a part of a file that is sent without loading it into memory.
+
+#ifndef SAKIT_FILE_TRANSFER_H
+#define SAKIT_FILE_TRANSFER_H
+
+#if defined(__linux__) || defined(_ANDROID)
+#define _SAKIT_SENDFILE
+#elif !defined(_WIN32)
+#define _SAKIT_MMAP_SEND
+#endif
+
+#include <stdint.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstring.h>
+#ifdef _WIN32
+#include <hltypes/hfile.h>
+#endif
+
+namespace sakit
+{
+	class PlatformSocket;
+
+	/// @note Uses sendfile() on Linux, maps the file into memory on other Unix systems and reads it in chunks on Windows.
+	class FileTransfer
+	{
+	public:
+		friend class PlatformSocket;
+
+		FileTransfer();
+		~FileTransfer();
+
+		HL_DEFINE_GET(int64_t, remaining, Remaining);
+		bool isOpen();
+
+		/// @param[in] length Negative to send everything until the end of the file.
+		bool open(chstr filename, int64_t offset, int64_t length);
+		void close();
+		/// @brief Moves forward after the given number of bytes has been sent.
+		void advance(int count);
+
+	protected:
+		int64_t offset;
+		int64_t remaining;
+#ifndef _WIN32
+		int descriptor;
+#ifdef _SAKIT_MMAP_SEND
+		unsigned char* mapping;
+		size_t mappingSize;
+		/// @note Points to the data at the current offset within the mapping.
+		unsigned char* data;
+#endif
+#else
+		hfile file;
+
+		/// @note Reads from the current offset.
+		int _read(unsigned char* data, int size);
+#endif
+
+	private:
+		FileTransfer(const FileTransfer& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -6,6 +6,8 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <string.h>
+
 #include <hltypes/harray.h>
 #include <hltypes/hlog.h>
 #include <hltypes/hstring.h>
@@ -18,6 +20,8 @@ namespace sakit
 {
 	const Host Host::Localhost("localhost");
 	const Host Host::Any("0.0.0.0");
+	const Host Host::LocalhostIpv6("::1");
+	const Host Host::AnyIpv6("::");
 
 	Host::Host()
 	{
@@ -45,17 +49,177 @@ namespace sakit
 
 	bool Host::isIp() const
 	{
-		harray<hstr> fragments = this->address.split('.');
-		if (fragments.size() != 4)
+		return (this->isIpv4() || this->isIpv6());
+	}
+
+	bool Host::isIpv4() const
+	{
+		unsigned char bytes[4];
+		return this->getIpBytes(bytes);
+	}
+
+	bool Host::isIpv6() const
+	{
+		unsigned char bytes[16];
+		return this->getIpv6Bytes(bytes);
+	}
+
+	bool Host::getIpBytes(unsigned char* bytes) const
+	{
+		const char* string = this->address.cStr();
+		int index = 0;
+		int value = 0;
+		int digits = 0;
+		while (true)
 		{
-			return false;
+			if (*string >= '0' && *string <= '9')
+			{
+				value = value * 10 + (*string - '0');
+				++digits;
+				if (digits > 3 || value >= 256)
+				{
+					return false;
+				}
+			}
+			else if (*string == '.' || *string == '\0')
+			{
+				if (digits == 0 || index >= 4)
+				{
+					return false;
+				}
+				bytes[index] = (unsigned char)value;
+				++index;
+				if (*string == '\0')
+				{
+					break;
+				}
+				value = 0;
+				digits = 0;
+			}
+			else
+			{
+				return false;
+			}
+			++string;
+		}
+		return (index == 4);
+	}
+
+	bool Host::getIpv6Bytes(unsigned char* bytes) const
+	{
+		hstr address = this->address;
+		int index = address.indexOf('%');
+		if (index >= 0)
+		{
+			if (index == address.size() - 1)
+			{
+				return false;
+			}
+			address = address(0, index);
 		}
-		foreach (hstr, it, fragments)
+		const char* string = address.cStr();
+		unsigned short groups[8];
+		int count = 0;
+		int gap = -1; // where "::" was found
+		if (string[0] == ':')
 		{
-			if (!(*it).isNumber() || (int)(*it) >= 256)
+			if (string[1] != ':')
 			{
 				return false;
 			}
+			gap = 0;
+			string += 2;
+		}
+		const char* start = NULL;
+		int value = 0;
+		int digits = 0;
+		while (*string != '\0')
+		{
+			start = string;
+			value = 0;
+			digits = 0;
+			while (true)
+			{
+				if (*string >= '0' && *string <= '9')
+				{
+					value = value * 16 + (*string - '0');
+				}
+				else if (*string >= 'a' && *string <= 'f')
+				{
+					value = value * 16 + (*string - 'a' + 10);
+				}
+				else if (*string >= 'A' && *string <= 'F')
+				{
+					value = value * 16 + (*string - 'A' + 10);
+				}
+				else
+				{
+					break;
+				}
+				++digits;
+				if (digits > 4)
+				{
+					return false;
+				}
+				++string;
+			}
+			if (*string == '.')
+			{
+				// an IPv4 address can make up the last 32 bits, e.g. "::ffff:127.0.0.1"
+				unsigned char ipv4Bytes[4];
+				if (count > 6 || !Host(start).getIpBytes(ipv4Bytes))
+				{
+					return false;
+				}
+				groups[count] = (unsigned short)((ipv4Bytes[0] << 8) | ipv4Bytes[1]);
+				groups[count + 1] = (unsigned short)((ipv4Bytes[2] << 8) | ipv4Bytes[3]);
+				count += 2;
+				break;
+			}
+			if (digits == 0 || count >= 8)
+			{
+				return false;
+			}
+			groups[count] = (unsigned short)value;
+			++count;
+			if (*string == '\0')
+			{
+				break;
+			}
+			if (*string != ':')
+			{
+				return false;
+			}
+			++string;
+			if (*string == ':')
+			{
+				if (gap >= 0)
+				{
+					return false;
+				}
+				gap = count;
+				++string;
+			}
+			else if (*string == '\0')
+			{
+				return false;
+			}
+		}
+		if (gap >= 0 ? count > 7 : count != 8)
+		{
+			return false;
+		}
+		memset(bytes, 0, 16);
+		// groups after the gap are moved to the end
+		int offset = 0;
+		for_iter (i, 0, count)
+		{
+			if (i == gap)
+			{
+				offset = 8 - count;
+			}
+			bytes[(i + offset) * 2] = (unsigned char)(groups[i] >> 8);
+			bytes[(i + offset) * 2 + 1] = (unsigned char)(groups[i] & 0xFF);
 		}
 		return true;
 	}
@@ -65,6 +229,44 @@ namespace sakit
 		return this->address;
 	}
 
+	Host Host::fromIpv6Bytes(const unsigned char* bytes)
+	{
+		unsigned short groups[8];
+		for_iter (i, 0, 8)
+		{
+			groups[i] = (unsigned short)((bytes[i * 2] << 8) | bytes[i * 2 + 1]);
+		}
+		// the longest run of at least 2 zero groups is shortened to "::" as described in RFC 5952
+		int gap = -1;
+		int gapSize = 1;
+		int size = 0;
+		for_iter (i, 0, 8)
+		{
+			size = (groups[i] == 0 ? size + 1 : 0);
+			if (size > gapSize)
+			{
+				gap = i - size + 1;
+				gapSize = size;
+			}
+		}
+		hstr result;
+		for_iter (i, 0, 8)
+		{
+			if (i == gap)
+			{
+				result += "::";
+				i += gapSize - 1;
+				continue;
+			}
+			if (result.size() > 0 && !result.endsWith(":"))
+			{
+				result += ":";
+			}
+			result += hsprintf("%x", groups[i]);
+		}
+		return Host(result);
+	}
+
 	bool Host::operator==(const Host& other) const
 	{
 		return (this->address == other.address);
@@ -0,0 +1,30 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "HttpBodySink.h"
+
+namespace sakit
+{
+	HttpBodySink::HttpBodySink()
+	{
+	}
+
+	HttpBodySink::~HttpBodySink()
+	{
+	}
+
+	bool HttpBodySink::start(HttpResponse* response)
+	{
+		return true;
+	}
+
+	void HttpBodySink::finish()
+	{
+	}
+
+}
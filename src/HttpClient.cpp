@@ -0,0 +1,379 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/hlog.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstring.h>
+
+#include "HttpClient.h"
+#include "HttpClientDelegate.h"
+#include "HttpResponse.h"
+#include "HttpSocket.h"
+#include "sakit.h"
+
+#define REQUEST_OPTIONS "OPTIONS"
+#define REQUEST_GET "GET"
+#define REQUEST_HEAD "HEAD"
+#define REQUEST_POST "POST"
+#define REQUEST_PUT "PUT"
+#define REQUEST_DELETE "DELETE"
+#define REQUEST_TRACE "TRACE"
+#define REQUEST_CONNECT "CONNECT"
+
+#define CLIENT_EXECUTE_ASYNC(name, constant) \
+	bool HttpClient::execute ## name ## Async(Url url, chstr customBody, hmap<hstr, hstr> customHeaders) \
+	{ \
+		return this->_executeAsync(REQUEST_ ## constant, url, customBody, customHeaders); \
+	}
+
+namespace sakit
+{
+	HttpClient::SocketDelegate::SocketDelegate(HttpClient* client) : HttpSocketDelegate()
+	{
+		this->client = client;
+	}
+
+	void HttpClient::SocketDelegate::onExecuteProgress(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		this->client->clientDelegate->onExecuteProgress(this->client, response, url);
+		this->responseProgress = this->client->clientDelegate->responseProgress;
+	}
+
+	void HttpClient::SocketDelegate::onExecuteBodyProgress(HttpSocket* socket, HttpProgress* progress, Url url)
+	{
+		this->client->clientDelegate->onExecuteBodyProgress(this->client, progress, url);
+	}
+
+	void HttpClient::SocketDelegate::onExecuteCompleted(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		// released before the delegate call so requests executed from within the delegate can reuse the connection
+		this->client->_release(socket);
+		this->client->clientDelegate->onExecuteCompleted(this->client, response, url);
+		this->client->_startQueuedRequests();
+	}
+
+	void HttpClient::SocketDelegate::onExecuteFailed(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		this->client->_release(socket);
+		this->client->clientDelegate->onExecuteFailed(this->client, response, url);
+		this->client->_startQueuedRequests();
+	}
+
+	HttpClient::HttpClient(HttpClientDelegate* clientDelegate) : socketDelegate(this), maxConnectionsPerHost(6), maxIdleConnections(16), idleTimeout(60.0f),
+		reportProgress(false), pipelining(false), maxPipelinedRequests(8), openedConnectionCount(0), reusedConnectionCount(0), pipelinedRequestCount(0)
+	{
+		this->clientDelegate = clientDelegate;
+		this->timeout = sakit::getGlobalTimeout();
+		this->retryFrequency = sakit::getGlobalRetryFrequency();
+	}
+
+	HttpClient::~HttpClient()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		foreach (Connection, it, this->connections)
+		{
+			delete (*it).socket;
+		}
+		this->connections.clear();
+		this->requests.clear();
+	}
+
+	void HttpClient::setTimeout(float timeout, float retryFrequency)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->timeout = timeout;
+		this->retryFrequency = retryFrequency;
+	}
+
+	int HttpClient::getActiveConnectionCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		int result = 0;
+		foreach (Connection, it, this->connections)
+		{
+			if ((*it).leased)
+			{
+				++result;
+			}
+		}
+		return result;
+	}
+
+	int HttpClient::getIdleConnectionCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		int result = 0;
+		foreach (Connection, it, this->connections)
+		{
+			if (!(*it).leased && (*it).socket->isConnected())
+			{
+				++result;
+			}
+		}
+		return result;
+	}
+
+	int HttpClient::getQueuedRequestCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->requests.size();
+	}
+
+	CLIENT_EXECUTE_ASYNC(Options, OPTIONS);
+	CLIENT_EXECUTE_ASYNC(Get, GET);
+	CLIENT_EXECUTE_ASYNC(Head, HEAD);
+	CLIENT_EXECUTE_ASYNC(Post, POST);
+	CLIENT_EXECUTE_ASYNC(Put, PUT);
+	CLIENT_EXECUTE_ASYNC(Delete, DELETE);
+	CLIENT_EXECUTE_ASYNC(Trace, TRACE);
+	CLIENT_EXECUTE_ASYNC(Connect, CONNECT);
+
+	void HttpClient::closeIdleConnections()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		harray<Connection> connections = this->connections;
+		this->connections.clear();
+		foreach (Connection, it, connections)
+		{
+			if ((*it).leased)
+			{
+				this->connections += (*it);
+			}
+			else
+			{
+				delete (*it).socket;
+			}
+		}
+	}
+
+	bool HttpClient::_executeAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders)
+	{
+		if (!url.isValid())
+		{
+			hlog::warn(logTag, "Cannot execute, URL is not valid!");
+			return false;
+		}
+		Request request;
+		request.method = method;
+		request.url = url;
+		request.customBody = customBody;
+		request.customHeaders = customHeaders;
+		hmutex::ScopeLock lock(&this->mutex);
+		this->requests += request;
+		lock.release();
+		this->_startQueuedRequests();
+		return true;
+	}
+
+	void HttpClient::_startQueuedRequests()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		harray<Request> failedRequests = this->_dispatch();
+		lock.release();
+		this->_failRequests(failedRequests);
+	}
+
+	harray<HttpClient::Request> HttpClient::_dispatch()
+	{
+		this->_closeExpiredConnections();
+		harray<Request> failedRequests;
+		Connection* connection = NULL;
+		hstr key;
+		int i = 0;
+		while (i < this->requests.size())
+		{
+			key = HttpClient::_makeKey(this->requests[i].url);
+			connection = this->_lease(key);
+			if (connection == NULL)
+			{
+				if (this->_pipeline(this->requests[i], key))
+				{
+					this->requests.removeAt(i);
+				}
+				else
+				{
+					++i; // the request has to wait until a connection to its host is available
+				}
+				continue;
+			}
+			Request request = this->requests.removeAt(i);
+			if (!connection->socket->_executeMethodAsync(request.method, request.url, request.customBody, request.customHeaders))
+			{
+				connection->leased = false;
+				connection->idleSince = htickCount();
+				failedRequests += request;
+			}
+		}
+		return failedRequests;
+	}
+
+	HttpClient::Connection* HttpClient::_lease(chstr key)
+	{
+		Connection* freeConnection = NULL;
+		int hostCount = 0;
+		foreach (Connection, it, this->connections)
+		{
+			if ((*it).leased)
+			{
+				if ((*it).key == key)
+				{
+					++hostCount;
+				}
+				continue;
+			}
+			if ((*it).key == key && (*it).socket->isConnected())
+			{
+				if ((*it).socket->_checkIdleConnection())
+				{
+					(*it).socket->setPipelining(this->pipelining);
+					(*it).socket->setMaxPipelinedRequests(this->maxPipelinedRequests);
+					(*it).leased = true;
+					++this->reusedConnectionCount;
+					return &(*it);
+				}
+				(*it).socket->_closeIdleConnection();
+			}
+			if (freeConnection == NULL && !(*it).socket->isConnected())
+			{
+				freeConnection = &(*it);
+			}
+		}
+		if (hostCount >= this->maxConnectionsPerHost)
+		{
+			return NULL;
+		}
+		if (freeConnection == NULL)
+		{
+			Connection connection;
+			connection.socket = new HttpSocket(&this->socketDelegate);
+			connection.socket->setKeepAlive(true);
+			this->connections += connection;
+			freeConnection = &this->connections.last();
+		}
+		freeConnection->socket->setTimeout(this->timeout, this->retryFrequency);
+		freeConnection->socket->setReportProgress(this->reportProgress);
+		freeConnection->socket->setPipelining(this->pipelining);
+		freeConnection->socket->setMaxPipelinedRequests(this->maxPipelinedRequests);
+		freeConnection->key = key;
+		freeConnection->leased = true;
+		freeConnection->idleSince = 0;
+		++this->openedConnectionCount;
+		return freeConnection;
+	}
+
+	bool HttpClient::_pipeline(Request& request, chstr key)
+	{
+		if (!this->pipelining)
+		{
+			return false;
+		}
+		harray<HttpSocket*> sockets;
+		int index = 0;
+		foreach (Connection, it, this->connections)
+		{
+			if ((*it).leased && (*it).key == key)
+			{
+				sockets += (*it).socket;
+			}
+		}
+		// the connection with the fewest waiting requests is used, unless it can't take any more requests
+		while (sockets.size() > 0)
+		{
+			index = 0;
+			for_iter (i, 1, sockets.size())
+			{
+				if (sockets[i]->getPendingRequestCount() < sockets[index]->getPendingRequestCount())
+				{
+					index = i;
+				}
+			}
+			if (sockets[index]->_pipelineMethodAsync(request.method, request.url, request.customBody, request.customHeaders))
+			{
+				break;
+			}
+			sockets.removeAt(index);
+		}
+		if (sockets.size() == 0)
+		{
+			return false;
+		}
+		++this->pipelinedRequestCount;
+		return true;
+	}
+
+	void HttpClient::_closeExpiredConnections()
+	{
+		int64_t now = htickCount();
+		int64_t idleTimeout = (int64_t)(this->idleTimeout * 1000);
+		int idleCount = 0;
+		foreach (Connection, it, this->connections)
+		{
+			if (!(*it).leased && (*it).socket->isConnected())
+			{
+				if (now - (*it).idleSince >= idleTimeout)
+				{
+					(*it).socket->_closeIdleConnection();
+				}
+				else
+				{
+					++idleCount;
+				}
+			}
+		}
+		// the sockets are kept since this can be called from within a socket's delegate call, closed ones are reused for new connections
+		Connection* oldest = NULL;
+		while (idleCount > this->maxIdleConnections)
+		{
+			oldest = NULL;
+			foreach (Connection, it, this->connections)
+			{
+				if (!(*it).leased && (*it).socket->isConnected() && (oldest == NULL || (*it).idleSince < oldest->idleSince))
+				{
+					oldest = &(*it);
+				}
+			}
+			oldest->socket->_closeIdleConnection();
+			--idleCount;
+		}
+	}
+
+	void HttpClient::_release(HttpSocket* socket)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		foreach (Connection, it, this->connections)
+		{
+			if ((*it).socket == socket)
+			{
+				// pipelined requests can still be waiting for their responses
+				(*it).leased = socket->isExecuting();
+				if (!(*it).leased)
+				{
+					(*it).idleSince = htickCount();
+				}
+				break;
+			}
+		}
+	}
+
+	void HttpClient::_failRequests(const harray<Request>& requests)
+	{
+		HttpResponse response;
+		foreachc (Request, it, requests)
+		{
+			hlog::warnf(logTag, "Could not execute %s request for: %s", (*it).method.cStr(), (*it).url.toString().cStr());
+			this->clientDelegate->onExecuteFailed(this, &response, (*it).url);
+		}
+	}
+
+	hstr HttpClient::_makeKey(Url& url)
+	{
+		unsigned short port = (url.getPort() == 0 ? HttpSocket::DefaultPort : url.getPort());
+		return url.getHost().lowered() + ":" + hstr(port);
+	}
+
+}
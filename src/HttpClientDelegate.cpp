@@ -0,0 +1,39 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "HttpClientDelegate.h"
+
+namespace sakit
+{
+	HttpClientDelegate::HttpClientDelegate() : responseProgress(true)
+	{
+	}
+
+	HttpClientDelegate::~HttpClientDelegate()
+	{
+	}
+
+	void HttpClientDelegate::onExecuteProgress(HttpClient* client, HttpResponse* response, Url url)
+	{
+		// not overridden so the response doesn't have to be copied anymore
+		this->responseProgress = false;
+	}
+
+	void HttpClientDelegate::onExecuteBodyProgress(HttpClient* client, HttpProgress* progress, Url url)
+	{
+	}
+
+	void HttpClientDelegate::onExecuteCompleted(HttpClient* client, HttpResponse* response, Url url)
+	{
+	}
+
+	void HttpClientDelegate::onExecuteFailed(HttpClient* client, HttpResponse* response, Url url)
+	{
+	}
+
+}
@@ -0,0 +1,234 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hstring.h>
+
+#include "DownloadFile.h"
+#include "HttpDownloadSink.h"
+#include "HttpResponse.h"
+#include "HttpSocket.h"
+#include "sakit.h"
+#include "sakitUtil.h"
+
+namespace sakit
+{
+	/// @note Parses e.g. "bytes 100-199/1000" where the total size can also be "*".
+	static bool _parseContentRange(chstr value, int64_t& first, int64_t& last, int64_t& total)
+	{
+		hstr unit;
+		hstr range;
+		hstr positions;
+		hstr length;
+		hstr firstText;
+		hstr lastText;
+		if (!value.trimmed().split(' ', unit, range) || unit.lowered() != "bytes" || !range.trimmed().split('/', positions, length) ||
+			!positions.split('-', firstText, lastText) || !_parseSize(firstText, first) || !_parseSize(lastText, last) || first > last)
+		{
+			return false;
+		}
+		total = -1;
+		if (length != "*" && !_parseSize(length, total))
+		{
+			return false;
+		}
+		return (total < 0 || last < total);
+	}
+
+	HttpDownloadSink::HttpDownloadSink() : HttpBodySink(), mapped(false), segment(0), shared(false), partial(false)
+	{
+		this->file = new DownloadFile();
+	}
+
+	HttpDownloadSink::HttpDownloadSink(DownloadFile* file, int segment) : HttpBodySink(), mapped(false), shared(true), partial(false)
+	{
+		this->file = file;
+		this->segment = segment;
+	}
+
+	HttpDownloadSink::~HttpDownloadSink()
+	{
+		if (!this->shared)
+		{
+			delete this->file;
+		}
+	}
+
+	hstr HttpDownloadSink::getFilename()
+	{
+		return this->file->getFilename();
+	}
+
+	int64_t HttpDownloadSink::getSize()
+	{
+		return this->file->getSize();
+	}
+
+	int64_t HttpDownloadSink::getDownloadedSize()
+	{
+		return this->file->getReceivedSize();
+	}
+
+	bool HttpDownloadSink::isOpen()
+	{
+		return this->file->isOpen();
+	}
+
+	bool HttpDownloadSink::isComplete()
+	{
+		return this->file->isComplete();
+	}
+
+	bool HttpDownloadSink::open(chstr filename)
+	{
+		return this->file->open(filename, this->mapped);
+	}
+
+	void HttpDownloadSink::close()
+	{
+		this->file->close();
+	}
+
+	hmap<hstr, hstr> HttpDownloadSink::makeRequestHeaders()
+	{
+		hmap<hstr, hstr> result;
+		harray<DownloadFile::Segment> segments = this->file->getSegments();
+		if (this->segment >= segments.size())
+		{
+			return result;
+		}
+		if (this->file->getSize() < 0)
+		{
+			// a segmented download finds out this way whether the server supports ranges at all
+			if (this->shared)
+			{
+				result[SAKIT_HTTP_REQUEST_HEADER_RANGE] = "bytes=0-";
+			}
+			return result;
+		}
+		hstr validator = this->file->getValidator();
+		// without a validator it's not certain that the rest belongs to the same version of the file so everything is downloaded again
+		if (validator == "" && !this->shared)
+		{
+			return result;
+		}
+		DownloadFile::Segment segment = segments[this->segment];
+		result[SAKIT_HTTP_REQUEST_HEADER_RANGE] = hsprintf("bytes=%lld-%lld", (long long)segment.getOffset(), (long long)(segment.end - 1));
+		// the server sends the whole file instead if it has changed
+		if (validator != "")
+		{
+			result[SAKIT_HTTP_REQUEST_HEADER_IF_RANGE] = validator;
+		}
+		return result;
+	}
+
+	bool HttpDownloadSink::start(HttpResponse* response)
+	{
+		if (!this->file->isOpen())
+		{
+			hlog::error(logTag, "Cannot download, file is not open!");
+			return false;
+		}
+		if (response->statusCode == HttpResponse::PARTIAL_CONTENT)
+		{
+			hstr contentRange = response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_RANGE, "");
+			int64_t first = 0;
+			int64_t last = 0;
+			int64_t total = 0;
+			if (!_parseContentRange(contentRange, first, last, total))
+			{
+				hlog::warnf(logTag, "Cannot download, invalid Content-Range: '%s'", contentRange.cStr());
+				return false;
+			}
+			int64_t length = 0;
+			if (response->headers.hasKey(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH) &&
+				(!_parseSize(response->headers[SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH].trimmed(), length) || length != last - first + 1))
+			{
+				hlog::warnf(logTag, "Cannot download, Content-Length does not match Content-Range '%s'!", contentRange.cStr());
+				return false;
+			}
+			harray<DownloadFile::Segment> segments = this->file->getSegments();
+			int64_t size = this->file->getSize();
+			if (this->shared && size < 0 && first == 0 && (total < 0 || last == total - 1))
+			{
+				// the size is set before the flag is read from another thread, the file's mutex makes sure the flag is visible then
+				this->partial = true;
+				return this->file->reset(total, HttpDownloadSink::_getValidator(response));
+			}
+			// a shared segment can be split while its request is on the way, the data beyond its new end is cut off while writing
+			if (this->segment >= segments.size() || first != segments[this->segment].getOffset() || last < segments[this->segment].end - 1 ||
+				(!this->shared && last != segments[this->segment].end - 1) || (total >= 0 && total != size))
+			{
+				hlog::warnf(logTag, "Cannot download, Content-Range '%s' does not match the requested range!", contentRange.cStr());
+				return false;
+			}
+			this->partial = true;
+			return true;
+		}
+		if (response->statusCode == HttpResponse::OK)
+		{
+			int64_t size = -1;
+			// Content-Length is ignored with chunked transfers
+			if (response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING, "identity").lowered().indexOf("chunked") < 0 &&
+				response->headers.hasKey(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH) &&
+				!_parseSize(response->headers[SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH].trimmed(), size))
+			{
+				hlog::warn(logTag, "Cannot download, invalid Content-Length!");
+				return false;
+			}
+			// the whole file is sent if it has changed since the interrupted download or the server doesn't support ranges
+			if (this->shared && this->file->getSize() >= 0)
+			{
+				hlog::warn(logTag, "Cannot download segment, server sent the whole file!");
+				return false;
+			}
+			if (this->file->getReceivedSize() > 0)
+			{
+				hlog::writef(logTag, "Download of '%s' cannot be resumed and starts over.", this->file->getFilename().cStr());
+			}
+			return this->file->reset(size, HttpDownloadSink::_getValidator(response));
+		}
+		hlog::warnf(logTag, "Cannot download, server responded with: %d %s", (int)response->statusCode, response->statusMessage.cStr());
+		return false;
+	}
+
+	int HttpDownloadSink::write(const unsigned char* data, int size)
+	{
+		int written = this->file->write(this->segment, data, size);
+		if (written >= 0 && written < size)
+		{
+			// the rest of a shared segment is downloaded by another connection since the segment was split
+			if (!this->shared)
+			{
+				hlog::warn(logTag, "Cannot download, received more data than expected!");
+			}
+			return -1;
+		}
+		return written;
+	}
+
+	void HttpDownloadSink::finish()
+	{
+		// the size of a file without Content-Length is only known now
+		this->file->finishSegment(this->segment);
+	}
+
+	hstr HttpDownloadSink::_getValidator(HttpResponse* response)
+	{
+		// weak ETags can't be used with If-Range
+		hstr eTag = response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_E_TAG, "").trimmed();
+		if (eTag != "" && !eTag.startsWith("W/"))
+		{
+			return eTag;
+		}
+		return response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_LAST_MODIFIED, "").trimmed();
+	}
+
+}
@@ -0,0 +1,80 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <hltypes/hlog.h>
+#include <hltypes/hstring.h>
+
+#include "HttpFileSink.h"
+#include "sakit.h"
+
+namespace sakit
+{
+	HttpFileSink::HttpFileSink() : HttpBodySink(), writtenSize(0), file(NULL)
+	{
+	}
+
+	HttpFileSink::~HttpFileSink()
+	{
+		this->close();
+	}
+
+	bool HttpFileSink::isOpen()
+	{
+		return (this->file != NULL);
+	}
+
+	bool HttpFileSink::open(chstr filename, bool append)
+	{
+		this->close();
+#ifdef _WIN32
+		this->file = _wfopen(filename.wStr().c_str(), (append ? L"ab" : L"wb"));
+#else
+		this->file = fopen(filename.cStr(), (append ? "ab" : "wb"));
+#endif
+		if (this->file == NULL)
+		{
+			hlog::errorf(logTag, "Could not open file '%s': %s", filename.cStr(), strerror(errno));
+			return false;
+		}
+		this->filename = filename;
+		this->writtenSize = 0;
+		return true;
+	}
+
+	void HttpFileSink::close()
+	{
+		if (this->file != NULL)
+		{
+			fclose(this->file);
+			this->file = NULL;
+		}
+		this->filename = "";
+	}
+
+	int HttpFileSink::write(const unsigned char* data, int size)
+	{
+		if (this->file == NULL)
+		{
+			hlog::error(logTag, "Cannot write body, file is not open!");
+			return -1;
+		}
+		int written = (int)fwrite(data, 1, size, this->file);
+		if (written < size)
+		{
+			hlog::errorf(logTag, "Could not write to file '%s': %s", this->filename.cStr(), strerror(errno));
+			return -1;
+		}
+		this->writtenSize += written;
+		return written;
+	}
+
+}
@@ -0,0 +1,23 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "HttpProgress.h"
+#include "HttpResponse.h"
+
+namespace sakit
+{
+	HttpProgress::HttpProgress() : statusCode(HttpResponse::UNDEFINED), headersComplete(false), bodyComplete(false), offset(0), size(0), bodySize(0),
+		expectedBodySize(-1), receivedSize(0)
+	{
+	}
+
+	HttpProgress::~HttpProgress()
+	{
+	}
+
+}
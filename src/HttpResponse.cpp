@@ -11,40 +11,54 @@
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 
+#include "ByteScanner.h"
+#include "HttpBodySink.h"
+#include "HttpProgress.h"
 #include "HttpResponse.h"
 #include "sakit.h"
 
-#define HTTP_DELIMITER "\r\n"
-
 namespace sakit
 {
-	static int _findSequence(hstream& stream, unsigned char* sequence, int sequenceLength)
+	/// @return False if the line doesn't start with a hex number or the number doesn't fit.
+	static bool _parseChunkSize(const char* line, int size, int64_t& result)
 	{
-		if (sequence != NULL && sequenceLength > 0)
+		int digits = 0;
+		int value = 0;
+		char c = '\0';
+		result = 0;
+		// anything after the hex digits are chunk extensions which are ignored
+		for_iter (i, 0, size)
 		{
-			int position = (int)stream.position();
-			int size = (int)stream.size();
-			int j = 0;
-			for_iter (i, position, size)
+			c = line[i];
+			if (c >= '0' && c <= '9')
 			{
-				if (stream[i] == sequence[j])
-				{
-					++j;
-				}
-				else
-				{
-					j = 0;
-				}
-				if (j == sequenceLength)
-				{
-					return i - position - 1;
-				}
+				value = c - '0';
+			}
+			else if (c >= 'a' && c <= 'f')
+			{
+				value = c - 'a' + 10;
 			}
+			else if (c >= 'A' && c <= 'F')
+			{
+				value = c - 'A' + 10;
+			}
+			else
+			{
+				break;
+			}
+			// another digit would shift bits into the sign
+			if ((result >> 59) != 0)
+			{
+				return false;
+			}
+			result = (result << 4) | value;
+			++digits;
 		}
-		return -1;
+		return (digits > 0);
 	}
 
-	HttpResponse::HttpResponse() : statusCode(UNDEFINED), headersComplete(false), bodyComplete(false), chunkSize(0), chunkRead(0), newDataSize(0)
+	HttpResponse::HttpResponse() : statusCode(UNDEFINED), headersComplete(false), bodyComplete(false), chunkSize(0), chunkRead(0), newDataSize(0), decodedSize(0),
+		bodyless(false), parserState(PARSER_STATUS_LINE), parserOffset(0), scanOffset(0), bodySink(NULL), bodySinkBlocked(false), headersSize(0), discardedSize(0)
 	{
 		this->clear();
 	}
@@ -66,18 +80,152 @@ namespace sakit
 		this->chunkSize = 0;
 		this->chunkRead = 0;
 		this->newDataSize = 0;
+		this->decodedSize = 0;
+		this->bodyless = false;
+		this->parserState = PARSER_STATUS_LINE;
+		this->parserOffset = 0;
+		this->scanOffset = 0;
+		this->bodySink = NULL;
+		this->bodySinkBlocked = false;
+		this->headersSize = 0;
+		this->discardedSize = 0;
 	}
 
 	void HttpResponse::parseFromRaw()
 	{
-		if (!this->headersComplete)
+		int64_t size = this->raw.size();
+		if (this->parserOffset < size)
 		{
-			this->_readHeaders();
-		}
-		if (this->headersComplete && !this->bodyComplete)
-		{
-			this->_readBody();
+			// raw isn't changed while parsing so the data is used in place
+			const char* data = (const char*)&this->raw[0];
+			const char* line = NULL;
+			int lineSize = 0;
+			int64_t lineEnd = 0;
+			int64_t count = 0;
+			int written = 0;
+			this->bodySinkBlocked = false;
+			while (this->parserState != PARSER_DONE && this->parserState != PARSER_FAILED && this->parserOffset < size && !this->bodySinkBlocked)
+			{
+				if (this->parserState == PARSER_BODY || this->parserState == PARSER_CHUNK_DATA)
+				{
+					count = size - this->parserOffset;
+					if (this->chunkSize >= 0)
+					{
+						count = hmin(count, this->chunkSize - this->chunkRead);
+					}
+					if (this->bodySink != NULL)
+					{
+						written = this->bodySink->write((const unsigned char*)&data[this->parserOffset], (int)count);
+						if (written < 0)
+						{
+							this->parserState = PARSER_FAILED;
+							break;
+						}
+						// the rest stays in raw and is offered again with the next call
+						this->bodySinkBlocked = (written < count);
+						count = written;
+					}
+					else
+					{
+						this->body.writeRaw(&data[this->parserOffset], (int)count);
+					}
+					this->parserOffset += count;
+					this->chunkRead += count;
+					this->newDataSize += (int)count;
+					this->decodedSize += count;
+					if (this->chunkSize >= 0 && this->chunkRead >= this->chunkSize)
+					{
+						if (this->parserState == PARSER_BODY)
+						{
+							this->_finishBody();
+						}
+						else
+						{
+							this->parserState = PARSER_CHUNK_END;
+						}
+					}
+					continue;
+				}
+				lineEnd = this->_findLineEnd(data, size);
+				if (lineEnd < 0)
+				{
+					break; // not enough bytes to read
+				}
+				line = &data[this->parserOffset];
+				lineSize = (int)(lineEnd - this->parserOffset);
+				if (lineSize > 0 && line[lineSize - 1] == '\r')
+				{
+					--lineSize;
+				}
+				this->parserOffset = lineEnd + 1;
+				this->scanOffset = this->parserOffset;
+				switch (this->parserState)
+				{
+				case PARSER_STATUS_LINE:
+					// empty lines before the status line are ignored
+					if (lineSize > 0)
+					{
+						this->_parseStatusLine(line, lineSize);
+						this->parserState = PARSER_HEADERS;
+					}
+					break;
+				case PARSER_HEADERS:
+					if (lineSize > 0)
+					{
+						this->_parseHeaderLine(line, lineSize);
+					}
+					else
+					{
+						this->headersComplete = true;
+						this->headersSize = this->parserOffset;
+						this->_startBody();
+					}
+					break;
+				case PARSER_CHUNK_SIZE:
+					if (!_parseChunkSize(line, lineSize, this->chunkSize))
+					{
+						this->parserState = PARSER_FAILED;
+						break;
+					}
+					this->chunkRead = 0;
+					// the last chunk is followed by optional trailer headers and an empty line
+					this->parserState = (this->chunkSize > 0 ? PARSER_CHUNK_DATA : PARSER_TRAILERS);
+					break;
+				case PARSER_CHUNK_END:
+					// chunk data has to be followed by a line break, anything else means the chunk size was wrong
+					this->parserState = (lineSize == 0 ? PARSER_CHUNK_SIZE : PARSER_FAILED);
+					break;
+				case PARSER_TRAILERS:
+					if (lineSize > 0)
+					{
+						this->_parseHeaderLine(line, lineSize);
+					}
+					else
+					{
+						this->_finishBody();
+					}
+					break;
+				default:
+					break;
+				}
+			}
+			// data that was written to the body sink isn't kept, only the headers and what hasn't been parsed yet
+			if (this->bodySink != NULL && this->headersComplete && this->parserOffset > this->headersSize)
+			{
+				hstream raw;
+				raw.writeRaw(data, (int)this->headersSize);
+				if (this->parserOffset < size)
+				{
+					raw.writeRaw(&data[this->parserOffset], (int)(size - this->parserOffset));
+				}
+				int64_t discarded = this->parserOffset - this->headersSize;
+				this->raw = raw;
+				this->discardedSize += discarded;
+				this->parserOffset = this->headersSize;
+				this->scanOffset = hmax(this->scanOffset - discarded, this->parserOffset);
+			}
 		}
+		this->raw.seek(this->parserOffset, hstream::START);
 	}
 
 	bool HttpResponse::hasNewData()
@@ -96,136 +244,143 @@ namespace sakit
 		return 0;
 	}
 
-	void HttpResponse::_readHeaders()
+	int64_t HttpResponse::_findLineEnd(const char* data, int64_t size)
 	{
-		hstr data;
-		int size = 0;
-		this->_getRawData(data, size);
-		int index = 0;
-		int read = 0;
-		hstr line;
-		harray<hstr> lineData;
-		while (true)
-		{
-			index = data.indexOf(HTTP_DELIMITER);
-			if (index < 0)
-			{
-				this->raw.seek(read - size, hstream::END);
-				break;
-			}
-			line = (index > 0 ? data(0, index) : "");
-			data = data(index + 2, -1); // +2 is HTTP_DELIMITER's size
-			read += index + 2;
-			if (line == "")
-			{
-				this->raw.seek(read - size, hstream::END);
-				this->headersComplete = true;
-				break;
-			}
-			if (this->statusCode == HttpResponse::UNDEFINED)
-			{
-				index = line.indexOf(' ');
-				if (index >= 0)
-				{
-					this->protocol = line(0, index);
-					line = line(index + 1, -1);
-					index = line.indexOf(' ');
-					if (index >= 0)
-					{
-						this->statusCode = (HttpResponse::Code)(int)line(0, index);
-						this->statusMessage = line(index + 1, -1);
-					}
-					else
-					{
-						this->statusMessage = line;
-					}
-				}
-			}
-			else
-			{
-				lineData = line.split(':', 1, true);
-				if (lineData.size() > 1)
-				{
-					this->headers[lineData[0]] = lineData[1](1, -1); // because there's that space character
-				}
-				else
-				{
-					this->headers[lineData[0]] = "";
-				}
-			}
+		// the search continues where the previous one stopped so partially received lines aren't scanned again
+		int64_t start = hmax(this->parserOffset, this->scanOffset);
+		int64_t result = _findByte(&data[start], size - start, '\n');
+		if (result < 0)
+		{
+			this->scanOffset = size;
+			return -1;
 		}
+		return (start + result);
 	}
 
-	void HttpResponse::_readBody()
+	void HttpResponse::_parseStatusLine(const char* line, int size)
 	{
-		if (this->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING, "identity") != "chunked")
+		hstr data(line, size);
+		int index = data.indexOf(' ');
+		if (index < 0)
 		{
-			this->chunkSize = (int)this->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH, "0");
-			int written = this->body.writeRaw(this->raw);
-			this->raw.seek(written);
-			this->chunkRead += written;
-			if (written > 0)
+			this->protocol = data;
+			return;
+		}
+		this->protocol = data(0, index);
+		data = data(index + 1, -1);
+		index = data.indexOf(' ');
+		if (index >= 0)
+		{
+			this->statusCode = (HttpResponse::Code)(int)data(0, index);
+			this->statusMessage = data(index + 1, -1);
+		}
+		else
+		{
+			this->statusCode = (HttpResponse::Code)(int)data;
+		}
+	}
+
+	void HttpResponse::_parseHeaderLine(const char* line, int size)
+	{
+		int nameSize = (int)_findByte(line, size, ':');
+		if (nameSize < 0)
+		{
+			this->headers[hstr(line, size)] = "";
+			return;
+		}
+		int start = nameSize + 1;
+		// optional whitespace around the value isn't part of it
+		while (start < size && (line[start] == ' ' || line[start] == '\t'))
+		{
+			++start;
+		}
+		while (size > start && (line[size - 1] == ' ' || line[size - 1] == '\t'))
+		{
+			--size;
+		}
+		this->headers[hstr(line, nameSize)] = hstr(&line[start], size - start);
+	}
+
+	void HttpResponse::_startBody()
+	{
+		this->chunkSize = 0;
+		this->chunkRead = 0;
+		if (this->bodySink != NULL && !this->bodySink->start(this))
+		{
+			this->parserState = PARSER_FAILED;
+			return;
+		}
+		// these never have a body, regardless of their headers
+		if (this->bodyless || this->statusCode == HttpResponse::NO_CONTENT || this->statusCode == HttpResponse::NOT_MODIFIED)
+		{
+			this->_finishBody();
+		}
+		else if (this->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING, "identity").lowered().indexOf("chunked") >= 0)
+		{
+			this->parserState = PARSER_CHUNK_SIZE;
+		}
+		else if (this->headers.hasKey(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH))
+		{
+			this->chunkSize = (int64_t)this->headers[SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH];
+			if (this->chunkSize > 0)
 			{
-				this->newDataSize += written;
+				this->parserState = PARSER_BODY;
 			}
-			if (this->chunkSize > 0 && this->chunkSize == this->chunkRead)
+			else
 			{
-				this->bodyComplete = true;
+				this->_finishBody();
 			}
 		}
 		else
 		{
-			int offset = 0;
-			int read = 0;
-			while (true)
-			{
-				if (this->chunkSize == 0)
-				{
-					offset = _findSequence(this->raw, (unsigned char*)HTTP_DELIMITER, strlen(HTTP_DELIMITER));
-					if (offset < 0)
-					{
-						break; // not enough bytes to read
-					}
-					this->chunkSize = (int)hstr(this->raw.read(offset)).unhex();
-					this->raw.seek(2);
-					if (this->chunkSize == 0)
-					{
-						this->body.writeRaw(this->raw);
-						this->raw.seek(0, hstream::END);
-						this->bodyComplete = true;
-						break;
-					}
-				}
-				if (this->chunkSize > 0)
-				{
-					read = this->chunkSize - this->chunkRead;
-					read = this->body.writeRaw(this->raw, read);
-					this->raw.seek(read);
-					this->chunkRead += read;
-					this->newDataSize += read;
-					if (this->chunkRead == this->chunkSize)
-					{
-						this->chunkSize = 0;
-						this->chunkRead = 0;
-						this->raw.seek(2);
-					}
-					if (this->raw.eof())
-					{
-						break;
-					}
-				}
-			}
+			this->chunkSize = -1;
+			this->parserState = PARSER_BODY;
 		}
 	}
 
-	void HttpResponse::_getRawData(hstr& data, int& size)
+	void HttpResponse::_finishBody()
 	{
-		size = (int)(this->raw.size() - this->raw.position());
-		char* buffer = new char[size + 1];
-		this->raw.readRaw(buffer, size);
-		buffer[size] = '\0'; // classic string terminating 0-character
-		data = hstr(buffer);
-		delete [] buffer;
+		this->parserState = PARSER_DONE;
+		this->bodyComplete = true;
+		if (this->bodySink != NULL)
+		{
+			this->bodySink->finish();
+		}
+	}
+
+	int64_t HttpResponse::_getProgress()
+	{
+		// both the received and the parsed size only grow, even though raw shrinks when a body sink is used
+		return (this->discardedSize * 2 + this->raw.size() + this->parserOffset);
+	}
+
+	void HttpResponse::_consumeProgress(HttpProgress* progress)
+	{
+		int64_t offset = 0;
+		progress->statusCode = this->statusCode;
+		progress->headersComplete = this->headersComplete;
+		progress->bodyComplete = this->bodyComplete;
+		progress->size = this->consumeNewData();
+		progress->bodySize = this->decodedSize;
+		progress->offset = this->decodedSize - progress->size;
+		progress->receivedSize = this->discardedSize + this->raw.size();
+		progress->expectedBodySize = -1;
+		if (this->bodyComplete)
+		{
+			progress->expectedBodySize = this->decodedSize;
+		}
+		else if (this->parserState == PARSER_BODY && this->chunkSize >= 0)
+		{
+			progress->expectedBodySize = this->chunkSize;
+		}
+		progress->data.clear();
+		// the new data is always at the end of the body
+		if (this->bodySink == NULL && progress->size > 0)
+		{
+			offset = this->body.size() - progress->size;
+			progress->data.writeRaw(&this->body[0] + offset, progress->size);
+			progress->data.rewind();
+		}
 	}
 
 	HttpResponse* HttpResponse::clone() const
@@ -244,6 +399,14 @@ namespace sakit
 		result->chunkSize = this->chunkSize;
 		result->chunkRead = this->chunkRead;
 		result->newDataSize = this->newDataSize;
+		result->decodedSize = this->decodedSize;
+		result->bodyless = this->bodyless;
+		result->parserState = this->parserState;
+		result->parserOffset = this->parserOffset;
+		result->scanOffset = this->scanOffset;
+		result->bodySink = this->bodySink;
+		result->headersSize = this->headersSize;
+		result->discardedSize = this->discardedSize;
 		return result;
 	}
 
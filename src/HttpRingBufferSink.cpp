@@ -0,0 +1,67 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <string.h>
+
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+
+#include "HttpRingBufferSink.h"
+
+namespace sakit
+{
+	HttpRingBufferSink::HttpRingBufferSink(int capacity) : HttpBodySink(), start(0), size(0)
+	{
+		this->capacity = hmax(capacity, 1);
+		this->buffer = new unsigned char[this->capacity];
+	}
+
+	HttpRingBufferSink::~HttpRingBufferSink()
+	{
+		delete [] this->buffer;
+	}
+
+	int HttpRingBufferSink::getAvailableSize()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->size;
+	}
+
+	int HttpRingBufferSink::read(unsigned char* data, int size)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		int result = hmin(size, this->size);
+		// the data can wrap around the end of the buffer
+		int first = hmin(result, this->capacity - this->start);
+		memcpy(data, &this->buffer[this->start], first);
+		memcpy(&data[first], this->buffer, result - first);
+		this->start = (this->start + result) % this->capacity;
+		this->size -= result;
+		return result;
+	}
+
+	void HttpRingBufferSink::clear()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->start = 0;
+		this->size = 0;
+	}
+
+	int HttpRingBufferSink::write(const unsigned char* data, int size)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		int result = hmin(size, this->capacity - this->size);
+		int end = (this->start + this->size) % this->capacity;
+		int first = hmin(result, this->capacity - end);
+		memcpy(&this->buffer[end], data, first);
+		memcpy(this->buffer, &data[first], result - first);
+		this->size += result;
+		return result;
+	}
+
+}
@@ -0,0 +1,422 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hstring.h>
+
+#include "DownloadFile.h"
+#include "HttpDownloadSink.h"
+#include "HttpResponse.h"
+#include "HttpSegmentedDownload.h"
+#include "HttpSegmentedDownloadDelegate.h"
+#include "HttpSocket.h"
+#include "sakit.h"
+
+#define DEFAULT_MIN_SEGMENT_SIZE (1024 * 1024)
+
+namespace sakit
+{
+	HttpSegmentedDownload::SocketDelegate::SocketDelegate(HttpSegmentedDownload* download) : HttpSocketDelegate()
+	{
+		this->download = download;
+	}
+
+	void HttpSegmentedDownload::SocketDelegate::onExecuteBodyProgress(HttpSocket* socket, HttpProgress* progress, Url url)
+	{
+		hmutex::ScopeLock lock(&this->download->mutex);
+		Connection* connection = this->download->_findConnection(socket);
+		if (connection != NULL && connection->sink != NULL)
+		{
+			this->download->_checkProbe(connection);
+		}
+	}
+
+	void HttpSegmentedDownload::SocketDelegate::onExecuteCompleted(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		this->download->_finishSegment(socket, response, true);
+	}
+
+	void HttpSegmentedDownload::SocketDelegate::onExecuteFailed(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		this->download->_finishSegment(socket, response, false);
+	}
+
+	HttpSegmentedDownload::HttpSegmentedDownload(HttpSegmentedDownloadDelegate* downloadDelegate, int connectionCount) : socketDelegate(this),
+		minSegmentSize(DEFAULT_MIN_SEGMENT_SIZE), maxRetries(3), mapped(false), splitCount(0), running(false), probing(false), rangesSupported(false),
+		restarted(false), retries(0), ending(ENDING_NONE)
+	{
+		this->downloadDelegate = downloadDelegate;
+		this->connectionCount = hmax(connectionCount, 1);
+		this->timeout = sakit::getGlobalTimeout();
+		this->retryFrequency = sakit::getGlobalRetryFrequency();
+		this->file = new DownloadFile();
+		Connection connection;
+		connection.sink = NULL;
+		for_iter (i, 0, this->connectionCount)
+		{
+			connection.socket = new HttpSocket(&this->socketDelegate);
+			connection.socket->setKeepAlive(true);
+			// the first response is checked for the size of the file while it's still being received
+			connection.socket->setReportProgress(true);
+			this->connections += connection;
+		}
+	}
+
+	HttpSegmentedDownload::~HttpSegmentedDownload()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		// the sockets finish their work first since they write to the file
+		foreach (Connection, it, this->connections)
+		{
+			delete (*it).socket;
+			if ((*it).sink != NULL)
+			{
+				delete (*it).sink;
+			}
+		}
+		this->connections.clear();
+		delete this->file;
+	}
+
+	void HttpSegmentedDownload::setTimeout(float timeout, float retryFrequency)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->timeout = timeout;
+		this->retryFrequency = retryFrequency;
+	}
+
+	Url HttpSegmentedDownload::getUrl()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->url;
+	}
+
+	hstr HttpSegmentedDownload::getFilename()
+	{
+		return this->file->getFilename();
+	}
+
+	int64_t HttpSegmentedDownload::getSize()
+	{
+		return this->file->getSize();
+	}
+
+	int64_t HttpSegmentedDownload::getDownloadedSize()
+	{
+		return this->file->getReceivedSize();
+	}
+
+	int HttpSegmentedDownload::getActiveConnectionCount()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->_getActiveConnectionCount();
+	}
+
+	bool HttpSegmentedDownload::isRunning()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->running;
+	}
+
+	bool HttpSegmentedDownload::start(Url url, chstr filename)
+	{
+		if (!url.isValid())
+		{
+			hlog::warn(logTag, "Cannot download, URL is not valid!");
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->mutex);
+		if (this->running)
+		{
+			hlog::warn(logTag, "Cannot download, download is already running!");
+			return false;
+		}
+		if (!this->file->open(filename, this->mapped))
+		{
+			return false;
+		}
+		// without a validator it's not certain that the missing parts belong to the same version of the file
+		if (this->file->getSize() < 0 || this->file->getValidator() == "")
+		{
+			if (!this->file->reset(-1, ""))
+			{
+				this->file->close();
+				return false;
+			}
+		}
+		this->url = url;
+		this->splitCount = 0;
+		this->probing = (this->file->getSize() < 0);
+		this->rangesSupported = !this->probing;
+		this->restarted = false;
+		this->retries = 0;
+		this->ending = ENDING_NONE;
+		this->running = true;
+		this->_dispatch();
+		if (this->_getActiveConnectionCount() == 0)
+		{
+			this->running = false;
+			this->file->close();
+			return false;
+		}
+		return true;
+	}
+
+	void HttpSegmentedDownload::stop()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (!this->running)
+		{
+			return;
+		}
+		this->ending = ENDING_STOP;
+		this->_abortConnections();
+		// otherwise the file is closed when the last aborted request has failed
+		if (this->_getActiveConnectionCount() == 0)
+		{
+			this->running = false;
+			this->file->close();
+		}
+	}
+
+	void HttpSegmentedDownload::_checkProbe(Connection* connection)
+	{
+		if (!this->probing || this->file->getSize() < 0)
+		{
+			return;
+		}
+		this->probing = false;
+		this->rangesSupported = connection->sink->partial;
+		if (!this->rangesSupported)
+		{
+			hlog::writef(logTag, "Server does not support ranges, '%s' is downloaded over one connection.", this->file->getFilename().cStr());
+		}
+		this->_dispatch();
+	}
+
+	void HttpSegmentedDownload::_dispatch()
+	{
+		if (!this->running || this->ending != ENDING_NONE)
+		{
+			return;
+		}
+		int segment = -1;
+		foreach (Connection, it, this->connections)
+		{
+			if ((*it).sink != NULL)
+			{
+				continue;
+			}
+			// until it's known that the server supports ranges, only one request is made
+			if ((this->probing || !this->rangesSupported) && this->_getActiveConnectionCount() > 0)
+			{
+				break;
+			}
+			segment = this->_findMissingSegment();
+			if (segment < 0 && !this->probing && this->rangesSupported)
+			{
+				segment = this->_splitSlowestSegment();
+			}
+			if (segment < 0)
+			{
+				break;
+			}
+			if (!this->_startSegment(&(*it), segment))
+			{
+				break;
+			}
+		}
+	}
+
+	bool HttpSegmentedDownload::_startSegment(Connection* connection, int segment)
+	{
+		connection->sink = new HttpDownloadSink(this->file, segment);
+		connection->socket->setTimeout(this->timeout, this->retryFrequency);
+		if (!connection->socket->executeDownloadAsync(this->url, connection->sink))
+		{
+			delete connection->sink;
+			connection->sink = NULL;
+			return false;
+		}
+		return true;
+	}
+
+	int HttpSegmentedDownload::_findMissingSegment()
+	{
+		harray<DownloadFile::Segment> segments = this->file->getSegments();
+		bool assigned = false;
+		for_iter (i, 0, segments.size())
+		{
+			if (segments[i].getRemaining() == 0)
+			{
+				continue;
+			}
+			assigned = false;
+			foreach (Connection, it, this->connections)
+			{
+				if ((*it).sink != NULL && (*it).sink->segment == i)
+				{
+					assigned = true;
+					break;
+				}
+			}
+			if (!assigned)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	int HttpSegmentedDownload::_splitSlowestSegment()
+	{
+		harray<DownloadFile::Segment> segments = this->file->getSegments();
+		int index = -1;
+		int64_t remaining = 0;
+		// the segment with the most remaining data will take the longest to finish
+		foreach (Connection, it, this->connections)
+		{
+			if ((*it).sink != NULL && (*it).sink->segment < segments.size() && segments[(*it).sink->segment].getRemaining() > remaining)
+			{
+				index = (*it).sink->segment;
+				remaining = segments[index].getRemaining();
+			}
+		}
+		if (index < 0)
+		{
+			return -1;
+		}
+		int result = this->file->split(index, this->minSegmentSize);
+		if (result >= 0)
+		{
+			++this->splitCount;
+		}
+		return result;
+	}
+
+	void HttpSegmentedDownload::_finishSegment(HttpSocket* socket, HttpResponse* response, bool completed)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		Connection* connection = this->_findConnection(socket);
+		if (connection == NULL || connection->sink == NULL)
+		{
+			return;
+		}
+		HttpDownloadSink* sink = connection->sink;
+		connection->sink = NULL;
+		int segment = sink->segment;
+		if (this->probing)
+		{
+			this->probing = false;
+			this->rangesSupported = sink->partial;
+		}
+		delete sink;
+		harray<DownloadFile::Segment> segments = this->file->getSegments();
+		// a request also fails when it receives data beyond its segment after the segment was split
+		bool received = (segment < segments.size() && segments[segment].getRemaining() == 0);
+		if (!received && this->ending == ENDING_NONE)
+		{
+			if (response->headersComplete && response->statusCode == HttpResponse::OK && this->file->getSize() >= 0 && !this->restarted)
+			{
+				hlog::writef(logTag, "File '%s' has changed on the server, download starts over.", this->file->getFilename().cStr());
+				this->restarted = true;
+				this->ending = ENDING_RESTART;
+			}
+			else if (response->headersComplete && response->statusCode != HttpResponse::OK && response->statusCode != HttpResponse::PARTIAL_CONTENT)
+			{
+				this->ending = ENDING_FAIL;
+			}
+			else if (this->retries < this->maxRetries)
+			{
+				++this->retries;
+				hlog::writef(logTag, "Download of segment %d failed, retrying (%d/%d).", segment, this->retries, this->maxRetries);
+			}
+			else
+			{
+				this->ending = ENDING_FAIL;
+			}
+			if (this->ending != ENDING_NONE)
+			{
+				this->_abortConnections();
+			}
+		}
+		this->_dispatch();
+		if (!this->running || this->_getActiveConnectionCount() > 0)
+		{
+			return;
+		}
+		if (this->ending == ENDING_RESTART)
+		{
+			this->ending = ENDING_NONE;
+			this->probing = true;
+			this->rangesSupported = false;
+			if (this->file->reset(-1, ""))
+			{
+				this->_dispatch();
+				if (this->_getActiveConnectionCount() > 0)
+				{
+					return;
+				}
+			}
+		}
+		bool complete = this->file->isComplete();
+		Ending ending = this->ending;
+		this->running = false;
+		this->ending = ENDING_NONE;
+		this->file->close();
+		lock.release();
+		// released before the delegate call so the download can be started again from within the delegate
+		if (ending == ENDING_NONE && complete)
+		{
+			this->downloadDelegate->onDownloadCompleted(this);
+		}
+		else if (ending != ENDING_STOP)
+		{
+			this->downloadDelegate->onDownloadFailed(this);
+		}
+	}
+
+	void HttpSegmentedDownload::_abortConnections()
+	{
+		// aborted requests still fail regularly, their sinks are kept until then
+		foreach (Connection, it, this->connections)
+		{
+			if ((*it).sink != NULL && (*it).socket->isExecuting())
+			{
+				(*it).socket->abort();
+			}
+		}
+	}
+
+	int HttpSegmentedDownload::_getActiveConnectionCount()
+	{
+		int result = 0;
+		foreach (Connection, it, this->connections)
+		{
+			if ((*it).sink != NULL)
+			{
+				++result;
+			}
+		}
+		return result;
+	}
+
+	HttpSegmentedDownload::Connection* HttpSegmentedDownload::_findConnection(HttpSocket* socket)
+	{
+		foreach (Connection, it, this->connections)
+		{
+			if ((*it).socket == socket)
+			{
+				return &(*it);
+			}
+		}
+		return NULL;
+	}
+
+}
@@ -0,0 +1,29 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "HttpSegmentedDownloadDelegate.h"
+
+namespace sakit
+{
+	HttpSegmentedDownloadDelegate::HttpSegmentedDownloadDelegate()
+	{
+	}
+
+	HttpSegmentedDownloadDelegate::~HttpSegmentedDownloadDelegate()
+	{
+	}
+
+	void HttpSegmentedDownloadDelegate::onDownloadCompleted(HttpSegmentedDownload* download)
+	{
+	}
+
+	void HttpSegmentedDownloadDelegate::onDownloadFailed(HttpSegmentedDownload* download)
+	{
+	}
+
+}
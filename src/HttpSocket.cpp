@@ -9,7 +9,10 @@
 #include <hltypes/hlog.h>
 #include <hltypes/hmap.h>
 #include <hltypes/hstring.h>
+#include <hltypes/hthread.h>
 
+#include "HttpDownloadSink.h"
+#include "HttpProgress.h"
 #include "HttpResponse.h"
 #include "HttpSocket.h"
 #include "HttpSocketDelegate.h"
@@ -56,7 +59,12 @@ namespace sakit
 {
 	unsigned short HttpSocket::DefaultPort = 80;
 
-	HttpSocket::HttpSocket(HttpSocketDelegate* socketDelegate, Protocol protocol) : SocketBase(), keepAlive(false), reportProgress(false)
+	static bool _isIdempotent(chstr method)
+	{
+		return (method == REQUEST_GET || method == REQUEST_HEAD || method == REQUEST_OPTIONS || method == REQUEST_TRACE || method == REQUEST_PUT || method == REQUEST_DELETE);
+	}
+
+	HttpSocket::HttpSocket(HttpSocketDelegate* socketDelegate, Protocol protocol) : SocketBase(), keepAlive(false), reportProgress(false), pipelining(false), maxPipelinedRequests(8), bodySink(NULL)
 	{
 		this->socketDelegate = socketDelegate;
 		this->protocol = protocol;
@@ -71,7 +79,7 @@ namespace sakit
 		hlog::warnf(DEBUG_LOG_TAG, "Starting unregister: %p", this);
 		this->__unregister();
 		hlog::warnf(DEBUG_LOG_TAG, "Finished unregister: %p", this);
-		this->thread->join();
+		this->thread->joinWork();
 		delete this->thread;
 		hlog::warnf(DEBUG_LOG_TAG, "Finished delete: %p", this);
 	}
@@ -88,33 +96,98 @@ namespace sakit
 		return (this->state == RUNNING);
 	}
 
+	int HttpSocket::getPendingRequestCount()
+	{
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (this->state != RUNNING)
+		{
+			return 0;
+		}
+		hmutex::ScopeLock lockThread(&this->thread->mutex);
+		return (this->thread->pipelined ? this->thread->requests.size() : 1);
+	}
+
 	void HttpSocket::update(float timeDelta)
 	{
 		hmutex::ScopeLock lock(&this->mutexState);
 		hmutex::ScopeLock lockThread(&this->thread->mutex);
 		State result = this->thread->result;
 		HttpResponse* response = NULL;
+		HttpProgress* progress = NULL;
+		// responses to pipelined requests are delivered in the order the requests were executed
+		harray<HttpSocketThread::PipelinedRequest> requests = this->thread->completedRequests;
+		this->thread->completedRequests.clear();
 		if (result == RUNNING || result == IDLE)
 		{
+			Url url = this->url;
 			if (this->reportProgress && this->thread->response->hasNewData())
 			{
-				hlog::warnf(DEBUG_LOG_TAG, "Cloning response from (for report): %p", this);
-				response = this->thread->response->clone();
-				this->thread->response->consumeNewData();
-				Url url = this->url;
-				lockThread.release();
-				lock.release();
+				if (this->socketDelegate->responseProgress)
+				{
+					response = this->thread->response->clone();
+				}
+				progress = new HttpProgress();
+				this->thread->response->_consumeProgress(progress);
+				if (this->thread->pipelined && this->thread->requests.size() > 0)
+				{
+					url = this->thread->requests.first().url;
+				}
+			}
+			lockThread.release();
+			lock.release();
+			foreach (HttpSocketThread::PipelinedRequest, it, requests)
+			{
+				this->_deliverResponse((*it).result, (*it).response, (*it).url);
+			}
+			if (response != NULL)
+			{
 				this->socketDelegate->onExecuteProgress(this, response, url);
 				delete response;
 			}
+			if (progress != NULL)
+			{
+				this->socketDelegate->onExecuteBodyProgress(this, progress, url);
+				delete progress;
+			}
 			return;
 		}
 		this->thread->result = IDLE;
-		hlog::warnf(DEBUG_LOG_TAG, "Cloning response from (for complete): %p", this);
-		response = this->thread->response->clone();
-		this->thread->response->clear();
+		this->socket->releaseBuffer();
+		if (this->thread->pipelined)
+		{
+			// requests that didn't receive a response have failed
+			foreach (HttpSocketThread::PipelinedRequest, it, this->thread->requests)
+			{
+				(*it).response = new HttpResponse();
+				(*it).result = FAILED;
+				requests += (*it);
+			}
+			this->thread->requests.clear();
+			this->thread->sentCount = 0;
+			this->thread->response->clear();
+			if (!this->socket->isConnected())
+			{
+				this->_terminateConnection();
+				this->state = IDLE;
+			}
+			else
+			{
+				this->state = CONNECTED;
+			}
+			lockThread.release();
+			lock.release();
+			foreach (HttpSocketThread::PipelinedRequest, it, requests)
+			{
+				this->_deliverResponse((*it).result, (*it).response, (*it).url);
+			}
+			return;
+		}
+		// the thread is done with the response so it's handed over instead of being copied
+		response = this->thread->response;
+		this->thread->response = new HttpResponse();
 		Url url = this->url; // _terminateConnection() deletes this, but it's needed for the delegate call ahead
-		if (!this->keepAlive || response->headers.tryGet(SAKIT_HTTP_REQUEST_HEADER_CONNECTION, "") == "close" || !this->socket->isConnected())
+		// the rest of an incomplete response would be received as the start of the next one
+		if (!this->keepAlive || result != FINISHED || response->headers.tryGet(SAKIT_HTTP_REQUEST_HEADER_CONNECTION, "") == "close" || !this->socket->isConnected())
 		{
 			this->_terminateConnection();
 			this->state = IDLE;
@@ -125,12 +198,22 @@ namespace sakit
 		}
 		lockThread.release();
 		lock.release();
+		this->_deliverResponse(result, response, url);
+	}
+
+	void HttpSocket::_deliverResponse(State result, HttpResponse* response, Url& url)
+	{
 		// some final data might be available
 		if (this->reportProgress && response->hasNewData())
 		{
-			this->socketDelegate->onExecuteProgress(this, response, url);
+			if (this->socketDelegate->responseProgress)
+			{
+				this->socketDelegate->onExecuteProgress(this, response, url);
+			}
+			HttpProgress progress;
+			response->_consumeProgress(&progress);
+			this->socketDelegate->onExecuteBodyProgress(this, &progress, url);
 		}
-		// the data can be rewinded after reporting progress
 		response->raw.rewind();
 		response->body.rewind();
 		switch (result)
@@ -178,6 +261,54 @@ namespace sakit
 	CONNECTED_EXECUTE_ASYNC(Trace, TRACE);
 	CONNECTED_EXECUTE_ASYNC(Connect, CONNECT);
 
+	bool HttpSocket::executeDownload(HttpResponse* response, Url url, HttpDownloadSink* downloadSink, hmap<hstr, hstr> customHeaders)
+	{
+		if (!this->_prepareDownload(downloadSink, customHeaders))
+		{
+			return false;
+		}
+		// the body sink is only replaced for this request
+		HttpBodySink* bodySink = this->bodySink;
+		this->bodySink = downloadSink;
+		bool result = this->_executeMethod(response, REQUEST_GET, url, "", customHeaders);
+		this->bodySink = bodySink;
+		return result;
+	}
+
+	bool HttpSocket::executeDownloadAsync(Url url, HttpDownloadSink* downloadSink, hmap<hstr, hstr> customHeaders)
+	{
+		if (!this->_prepareDownload(downloadSink, customHeaders))
+		{
+			return false;
+		}
+		// the response of the thread keeps the download sink after it has been started
+		HttpBodySink* bodySink = this->bodySink;
+		this->bodySink = downloadSink;
+		bool result = this->_executeMethodAsync(REQUEST_GET, url, "", customHeaders);
+		this->bodySink = bodySink;
+		return result;
+	}
+
+	bool HttpSocket::_prepareDownload(HttpDownloadSink* downloadSink, hmap<hstr, hstr>& customHeaders)
+	{
+		if (downloadSink == NULL || !downloadSink->isOpen())
+		{
+			hlog::warn(logTag, "Cannot download, file is not open!");
+			return false;
+		}
+		if (downloadSink->isComplete())
+		{
+			hlog::warn(logTag, "Cannot download, file is already complete!");
+			return false;
+		}
+		hmap<hstr, hstr> headers = downloadSink->makeRequestHeaders();
+		foreach_m (hstr, it, headers)
+		{
+			customHeaders[it->first] = it->second;
+		}
+		return true;
+	}
+
 	bool HttpSocket::_executeMethodInternal(HttpResponse* response, chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders)
 	{
 		if (response == NULL)
@@ -215,6 +346,8 @@ namespace sakit
 			return false;
 		}
 		response->clear();
+		response->bodyless = (method == REQUEST_HEAD);
+		response->bodySink = this->bodySink;
 		if (this->_receiveHttpDirect(response) == 0)
 		{
 			this->_terminateConnection();
@@ -224,7 +357,7 @@ namespace sakit
 		}
 		response->body.rewind();
 		response->raw.rewind();
-		if (!this->keepAlive || response->headers.tryGet(SAKIT_HTTP_REQUEST_HEADER_CONNECTION, "") == "close")
+		if (!this->keepAlive || !response->headersComplete || !response->bodyComplete || response->headers.tryGet(SAKIT_HTTP_REQUEST_HEADER_CONNECTION, "") == "close")
 		{
 			this->_terminateConnection();
 			lock.acquire(&this->mutexState);
@@ -242,8 +375,16 @@ namespace sakit
 	{
 		if (this->isConnected())
 		{
-			hlog::warn(logTag, "Already existing connection will be closed!");
-			this->_terminateConnection();
+			// a persistent connection to the same host can be used for the new URL
+			if (!this->_isSameConnection(url))
+			{
+				hlog::warn(logTag, "Already existing connection will be closed!");
+				this->_terminateConnection();
+			}
+			else
+			{
+				this->_checkIdleConnection();
+			}
 		}
 		return this->_executeMethodInternal(response, method, url, customBody, customHeaders);
 	}
@@ -273,28 +414,99 @@ namespace sakit
 		}
 		hstr request = this->_processRequest(method, url, customBody, customHeaders);
 		this->thread->response->clear();
+		this->thread->response->bodyless = (method == REQUEST_HEAD);
+		this->thread->response->bodySink = this->bodySink;
 		this->thread->stream->clear();
-		this->thread->stream->writeRaw((void*)request.cStr(), request.size());
-		this->thread->stream->rewind();
+		this->thread->pipelined = (this->pipelining && this->keepAlive && this->bodySink == NULL);
+		if (this->thread->pipelined)
+		{
+			HttpSocketThread::PipelinedRequest pipelinedRequest;
+			pipelinedRequest.method = method;
+			pipelinedRequest.url = this->url;
+			pipelinedRequest.data = request;
+			pipelinedRequest.idempotent = _isIdempotent(method);
+			pipelinedRequest.response = NULL;
+			pipelinedRequest.result = RUNNING;
+			this->thread->requests.clear();
+			this->thread->requests += pipelinedRequest;
+			this->thread->maxPipelinedRequests = this->maxPipelinedRequests;
+			this->thread->sentCount = 0;
+			this->thread->pipelineOpen = true;
+		}
+		else
+		{
+			this->thread->stream->writeRaw((void*)request.cStr(), request.size());
+			this->thread->stream->rewind();
+		}
 		this->thread->host = this->remoteHost;
 		this->thread->port = (this->url.getPort() == 0 ? this->remotePort : this->url.getPort());
 		this->state = RUNNING;
-		this->thread->start();
+		this->thread->startWork();
+		return true;
+	}
+
+	bool HttpSocket::_pipelineMethodAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders)
+	{
+		if (!this->pipelining || !this->keepAlive || this->bodySink != NULL || !url.isValid() || !_isIdempotent(method))
+		{
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		hmutex::ScopeLock lockThread(&this->thread->mutex);
+		// as many requests wait as are sent so the thread can send the next ones as soon as responses arrive
+		if (this->state != RUNNING || !this->thread->pipelined || !this->thread->pipelineOpen ||
+			this->thread->requests.size() >= this->maxPipelinedRequests * 2 || !this->_isSameConnection(url))
+		{
+			return false;
+		}
+		// nothing may be pipelined after a non-idempotent request until its response has arrived
+		foreach (HttpSocketThread::PipelinedRequest, it, this->thread->requests)
+		{
+			if (!_isIdempotent((*it).method))
+			{
+				return false;
+			}
+		}
+		HttpSocketThread::PipelinedRequest request;
+		request.method = method;
+		request.url = url;
+		request.data = this->_processRequest(method, url, customBody, customHeaders);
+		request.idempotent = true;
+		request.response = NULL;
+		request.result = RUNNING;
+		this->thread->maxPipelinedRequests = this->maxPipelinedRequests;
+		this->thread->requests += request;
 		return true;
 	}
 
 	bool HttpSocket::_executeMethodAsync(chstr method, Url& url, chstr customBody, hmap<hstr, hstr>& customHeaders)
 	{
+		if (this->_pipelineMethodAsync(method, url, customBody, customHeaders))
+		{
+			return true;
+		}
 		if (this->isConnected())
 		{
-			hlog::warn(logTag, "Already existing connection will be closed!");
-			this->_terminateConnection();
+			// a persistent connection to the same host can be used for the new URL
+			if (!this->_isSameConnection(url))
+			{
+				hlog::warn(logTag, "Already existing connection will be closed!");
+				this->_terminateConnection();
+			}
+			else
+			{
+				this->_checkIdleConnection();
+			}
 		}
 		return this->_executeMethodInternalAsync(method, url, customBody, customHeaders);
 	}
 
 	bool HttpSocket::_executeMethodAsync(chstr method, chstr customBody, hmap<hstr, hstr>& customHeaders)
 	{
+		if (this->_pipelineMethodAsync(method, this->url, customBody, customHeaders))
+		{
+			return true;
+		}
 		if (!this->isConnected())
 		{
 			hlog::warn(logTag, "Cannot execute, there is no existing connection!");
@@ -306,38 +518,57 @@ namespace sakit
 	int HttpSocket::_receiveHttpDirect(HttpResponse* response)
 	{
 		hmutex mutex;
+		int64_t start = htickCount();
 		float time = 0.0f;
+		bool ready = false;
 		int64_t size = 0;
 		int64_t lastSize = 0;
+		bool closed = false;
 		while (true)
 		{
-			if (!this->socket->receive(response, mutex))
+			if (response->bodySinkBlocked)
 			{
+				// nothing is received until the body sink accepts more data so the server is slowed down
+				response->parseFromRaw();
+			}
+			else if (!this->socket->receive(response, mutex))
+			{
+				closed = true;
 				break;
 			}
-			if (response->headersComplete && response->bodyComplete)
+			if ((response->headersComplete && response->bodyComplete) || response->parserState == HttpResponse::PARSER_FAILED)
 			{
 				break;
 			}
-			size = response->raw.size();
+			size = response->_getProgress();
 			if (lastSize != size)
 			{
 				lastSize = size;
-				// retry attempts are reset after a successful read
+				// the timeout is reset after a successful read
+				start = htickCount();
 				time = 0.0f;
+				ready = false;
+				continue;
+			}
+			if (response->bodySinkBlocked)
+			{
+				// waiting for the body sink to accept more data isn't waiting for the server
+				start = htickCount();
+				hthread::sleep(this->retryFrequency * 1000.0f);
 				continue;
 			}
-			time += this->retryFrequency;
+			time = (htickCount() - start) * 0.001f;
 			if (time >= this->timeout)
 			{
 				break;
 			}
-			hthread::sleep(this->retryFrequency * 1000.0f);
+			this->_waitReceive(ready, this->timeout - time);
 		}
-		// if timed out, has no predefined length, all headers were received and there is a body
-		if (time >= this->timeout && response->headersComplete)
+		this->socket->releaseBuffer();
+		// if timed out or closed, has no predefined length, all headers were received and there is a body
+		if ((time >= this->timeout || closed) && response->headersComplete)
 		{
-			if (!response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) && response->body.size() > 0)
+			if (!response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) && (response->body.size() > 0 || response->chunkRead > 0))
 			{
 				// let's say it's complete, we don't know its supposed length anyway
 				hlog::warn(logTag, "HttpSocket did not return header Content-Length! Body might be incomplete, but will be considered complete.");
@@ -395,6 +626,43 @@ namespace sakit
 		this->url = Url();
 	}
 
+	bool HttpSocket::_isSameConnection(Url& url)
+	{
+		if (!this->url.isValid() || !url.isValid() || this->url.getHost().lowered() != url.getHost().lowered())
+		{
+			return false;
+		}
+		unsigned short port = (url.getPort() == 0 ? this->remotePort : url.getPort());
+		return ((this->url.getPort() == 0 ? this->remotePort : this->url.getPort()) == port);
+	}
+
+	bool HttpSocket::_checkIdleConnection()
+	{
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (this->state != CONNECTED)
+		{
+			return false;
+		}
+		// nothing is expected on an idle connection, so anything that can be received means the server has closed it
+		if (this->socket->waitReceive(0.0f))
+		{
+			hlog::debug(logTag, "Persistent connection was closed by the server, reconnecting.");
+			this->_terminateConnection();
+			return false;
+		}
+		return true;
+	}
+
+	void HttpSocket::_closeIdleConnection()
+	{
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (this->state == CONNECTED)
+		{
+			this->_terminateConnection();
+			this->state = IDLE;
+		}
+	}
+
 	bool HttpSocket::_canExecute(State state)
 	{
 		harray<State> allowed;
@@ -414,7 +682,8 @@ namespace sakit
 	{
 		this->url = url;
 		this->remoteHost = Host(this->url.getHost());
-		customHeaders[SAKIT_HTTP_REQUEST_HEADER_HOST] = this->remoteHost.toString();
+		// IPv6 addresses need brackets in the Host header as well, but not the scope ID
+		customHeaders[SAKIT_HTTP_REQUEST_HEADER_HOST] = (this->remoteHost.isIpv6() ? "[" + this->remoteHost.toString().split('%', 1).first() + "]" : this->remoteHost.toString());
 		customHeaders[SAKIT_HTTP_REQUEST_HEADER_CONNECTION] = (this->keepAlive ? "keep-alive" : "close");
 		if (!customHeaders.hasKey(SAKIT_HTTP_REQUEST_HEADER_ACCEPT_ENCODING))
 		{
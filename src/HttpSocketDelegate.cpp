@@ -10,7 +10,7 @@
 
 namespace sakit
 {
-	HttpSocketDelegate::HttpSocketDelegate()
+	HttpSocketDelegate::HttpSocketDelegate() : responseProgress(true)
 	{
 	}
 
@@ -19,6 +19,12 @@ namespace sakit
 	}
 
 	void HttpSocketDelegate::onExecuteProgress(HttpSocket* socket, HttpResponse* response, Url url)
+	{
+		// not overridden so the response doesn't have to be copied anymore
+		this->responseProgress = false;
+	}
+
+	void HttpSocketDelegate::onExecuteBodyProgress(HttpSocket* socket, HttpProgress* progress, Url url)
 	{
 	}
 
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 
 #include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
 #include <hltypes/hstream.h>
 #include <hltypes/hthread.h>
 
@@ -22,7 +23,7 @@
 
 namespace sakit
 {
-	HttpSocketThread::HttpSocketThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : TimedThread(socket, timeout, retryFrequency)
+	HttpSocketThread::HttpSocketThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : TimedThread(socket, timeout, retryFrequency), pipelined(false), pipelineOpen(false), maxPipelinedRequests(1), sentCount(0)
 	{
 		this->name = "SAKit HTTP Socket";
 		this->stream = new hstream();
@@ -33,6 +34,10 @@ namespace sakit
 	{
 		delete this->stream;
 		delete this->response;
+		foreach (PipelinedRequest, it, this->completedRequests)
+		{
+			delete (*it).response;
+		}
 	}
 
 	void HttpSocketThread::_updateConnect()
@@ -42,24 +47,33 @@ namespace sakit
 		if (!this->socket->isConnected() && !this->socket->connect(this->host, this->port, localHost, localPort, *this->timeout, *this->retryFrequency))
 		{
 			hmutex::ScopeLock lock(&this->mutex);
-			this->result = FAILED;
+			this->_setResult(FAILED);
 			this->executing = false;
 		}
 	}
 
 	void HttpSocketThread::_updateSend()
+	{
+		if (!this->_sendStream())
+		{
+			hmutex::ScopeLock lock(&this->mutex);
+			this->_setResult(FAILED);
+			lock.release();
+			this->executing = false;
+			this->socket->disconnect();
+		}
+	}
+
+	bool HttpSocketThread::_sendStream()
 	{
 		int sent = 0;
 		int count = (int)this->stream->size();
-		while (this->isRunning() && this->executing)
+		bool result = true;
+		while (this->_isActive())
 		{
 			if (!this->socket->send(this->stream, count, sent))
 			{
-				hmutex::ScopeLock lock(&this->mutex);
-				this->result = FAILED;
-				lock.release();
-				this->executing = false;
-				this->socket->disconnect();
+				result = false;
 				break;
 			}
 			if (this->stream->eof())
@@ -69,42 +83,66 @@ namespace sakit
 			hthread::sleep(*this->retryFrequency * 1000.0f);
 		}
 		this->stream->clear();
+		return result;
 	}
 
 	void HttpSocketThread::_updateReceive()
 	{
+		int64_t start = htickCount();
 		float time = 0.0f;
 		int64_t size = 0;
 		int64_t lastSize = 0;
-		while (this->isRunning() && this->executing)
+		bool ready = false;
+		bool closed = false;
+		hmutex::ScopeLock lock;
+		while (this->_isActive())
 		{
-			if (!this->socket->receive(this->response, this->mutex))
+			if (this->response->bodySinkBlocked)
+			{
+				// nothing is received until the body sink accepts more data so the server is slowed down
+				lock.acquire(&this->mutex);
+				this->response->parseFromRaw();
+				lock.release();
+			}
+			else if (!this->socket->receive(this->response, this->mutex))
 			{
+				closed = true;
 				break;
 			}
-			if (this->response->headersComplete && this->response->bodyComplete)
+			if ((this->response->headersComplete && this->response->bodyComplete) || this->response->parserState == HttpResponse::PARSER_FAILED)
 			{
 				break;
 			}
-			size = this->response->raw.size();
+			size = this->response->_getProgress();
 			if (lastSize != size)
 			{
 				lastSize = size;
-				// retry attempts are reset after a successful read
+				// the timeout is reset after a successful read
+				start = htickCount();
 				time = 0.0f;
+				ready = false;
+				this->_queueUpdate(); // for progress reporting
+				continue;
+			}
+			if (this->response->bodySinkBlocked)
+			{
+				// waiting for the body sink to accept more data isn't waiting for the server
+				start = htickCount();
+				hthread::sleep(*this->retryFrequency * 1000.0f);
 				continue;
 			}
-			time += *this->retryFrequency;
+			time = (htickCount() - start) * 0.001f;
 			if (time >= *this->timeout)
 			{
 				break;
 			}
-			hthread::sleep(*this->retryFrequency * 1000.0f);
+			this->_waitReceive(ready, *this->timeout - time);
 		}
-		// if timed out, has no predefined length, all headers were received and there is a body
-		if (time >= *this->timeout && !this->response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) && this->response->headersComplete && this->response->body.size() > 0)
+		// if timed out or closed, has no predefined length, all headers were received and there is a body
+		bool hasBody = (this->response->body.size() > 0 || this->response->chunkRead > 0);
+		if ((time >= *this->timeout || closed) && !this->response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) && this->response->headersComplete && hasBody)
 		{
-			if (!this->response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) && this->response->body.size() > 0)
+			if (!this->response->headers.hasKey(SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH) && hasBody)
 			{
 				// let's say it's complete, we don't know its supposed length anyway
 				hlog::warn(logTag, "HttpSocket did not return header " SAKIT_HTTP_REQUEST_HEADER_CONTENT_LENGTH "! Body might be incomplete, but will be considered complete.");
@@ -115,31 +153,252 @@ namespace sakit
 				this->response->bodyComplete = true;
 			}
 		}
-		hmutex::ScopeLock lock(&this->mutex);
+		lock.acquire(&this->mutex);
 		// only a response with complete headers and a complete body is considered
 		if (this->response->headersComplete && this->response->bodyComplete)
 		{
-			this->result = FINISHED;
+			this->_setResult(FINISHED);
 		}
 		else
 		{
-			this->result = FAILED;
+			this->_setResult(FAILED);
 			this->response->clear();
 			this->socket->disconnect();
 		}
 	}
 
+	void HttpSocketThread::_updatePipelined()
+	{
+		int64_t start = 0;
+		float time = 0.0f;
+		int64_t size = 0;
+		int64_t lastSize = 0;
+		int answered = 0;
+		int lastAnswered = 0;
+		int attempts = 0;
+		bool ready = false;
+		bool closed = false;
+		hmutex::ScopeLock lock;
+		while (true)
+		{
+			start = htickCount();
+			time = 0.0f;
+			lastSize = 0;
+			answered = 0;
+			lastAnswered = 0;
+			ready = false;
+			closed = false;
+			while (this->_isActive())
+			{
+				// requests that were added in the meantime and the ones that can follow answered requests are sent before waiting for further responses
+				if (!this->_sendPipelined())
+				{
+					break;
+				}
+				if (!this->socket->receive(this->response, this->mutex))
+				{
+					closed = true;
+					break;
+				}
+				if (!this->_completePipelinedResponses(answered))
+				{
+					break;
+				}
+				size = this->response->raw.size();
+				// the next response can have as much data as the completed one had
+				if (lastSize != size || lastAnswered != answered)
+				{
+					lastSize = size;
+					lastAnswered = answered;
+					// the timeout is reset after a successful read
+					start = htickCount();
+					time = 0.0f;
+					ready = false;
+					this->_queueUpdate(); // for progress reporting and for delivering completed responses
+					continue;
+				}
+				time = (htickCount() - start) * 0.001f;
+				if (time >= *this->timeout)
+				{
+					break;
+				}
+				this->_waitReceive(ready, *this->timeout - time);
+			}
+			lock.acquire(&this->mutex);
+			closed = (closed || !this->socket->isConnected());
+			// a response without a predefined length ends when the connection does
+			if (this->requests.size() > 0 && (closed || time >= *this->timeout) && this->response->headersComplete && !this->response->bodyComplete &&
+				!this->response->headers.hasKey(SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH) && this->response->body.size() > 0 &&
+				this->response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_TRANSFER_ENCODING, "identity") != "chunked")
+			{
+				hlog::warn(logTag, "HttpSocket did not return header " SAKIT_HTTP_RESPONSE_HEADER_CONTENT_LENGTH "! Body might be incomplete, but will be considered complete.");
+				this->response->bodyComplete = true;
+				PipelinedRequest request = this->requests.removeFirst();
+				--this->sentCount;
+				request.response = this->response;
+				request.result = FINISHED;
+				this->completedRequests += request;
+				this->response = new HttpResponse();
+				++answered;
+			}
+			// a server may close a persistent connection after any response so the unanswered requests are sent again on a new connection
+			if (this->requests.size() == 0 || !closed || !this->_isActive() || !this->_canResendPipelined())
+			{
+				break;
+			}
+			// if the server doesn't answer anything on a new connection either, it's not going to
+			attempts = (answered > 0 ? 0 : attempts + 1);
+			if (attempts > 1)
+			{
+				break;
+			}
+			this->socket->disconnect();
+			this->response->clear();
+			this->response->bodyless = (this->requests.first().method == "HEAD");
+			this->sentCount = 0;
+			lock.release();
+			this->_queueUpdate(); // for delivering the responses that were completed before the connection was closed
+			this->_updateConnect();
+		}
+		this->pipelineOpen = false;
+		// the remaining requests are failed when the result is delivered
+		if (this->requests.size() > 0)
+		{
+			this->_setResult(FAILED);
+			this->response->clear();
+			this->socket->disconnect();
+		}
+		else
+		{
+			this->_setResult(FINISHED);
+		}
+	}
+
+	void HttpSocketThread::_waitReceive(bool& ready, float timeout)
+	{
+		// being ready without anything received (e.g. a closed connection) would turn waiting into a busy loop
+		if (ready)
+		{
+			hthread::sleep(hmin(*this->retryFrequency, timeout) * 1000.0f);
+		}
+		// stopping the work is only noticed between the waits
+		ready = this->socket->waitReceive(hmin(*this->retryFrequency, timeout));
+	}
+
+	bool HttpSocketThread::_sendPipelined()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		int count = hmin(this->requests.size(), hmax(this->maxPipelinedRequests, 1)) - this->sentCount;
+		if (count <= 0)
+		{
+			return true;
+		}
+		this->stream->clear();
+		for_iter (i, this->sentCount, this->sentCount + count)
+		{
+			this->stream->writeRaw((void*)this->requests[i].data.cStr(), this->requests[i].data.size());
+		}
+		this->stream->rewind();
+		this->sentCount += count;
+		lock.release();
+		// the server may have closed the connection after its last response, the responses before that are still received and the
+		// unanswered requests are sent again on a new connection once the close is noticed
+		this->_sendStream();
+		return this->_isActive();
+	}
+
+	bool HttpSocketThread::_completePipelinedResponses(int& answered)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		PipelinedRequest request;
+		HttpResponse* next = NULL;
+		int64_t end = 0;
+		int remaining = 0;
+		hstream raw;
+		while (this->response->headersComplete && this->response->bodyComplete)
+		{
+			request = this->requests.removeFirst();
+			--this->sentCount;
+			request.response = this->response;
+			request.result = FINISHED;
+			this->completedRequests += request;
+			++answered;
+			next = new HttpResponse();
+			// data beyond the end of the response already belongs to the next one
+			end = this->response->raw.position();
+			remaining = (int)(this->response->raw.size() - end);
+			if (remaining > 0)
+			{
+				next->raw.writeRaw(this->response->raw, remaining);
+				next->raw.rewind();
+				raw.clear();
+				this->response->raw.rewind();
+				raw.writeRaw(this->response->raw, (int)end);
+				this->response->raw = raw;
+			}
+			this->response = next;
+			if (request.response->headers.tryGet(SAKIT_HTTP_RESPONSE_HEADER_CONNECTION, "") == "close")
+			{
+				// the server won't answer the remaining requests
+				this->socket->disconnect();
+				return false;
+			}
+			if (this->requests.size() == 0)
+			{
+				// requests can't be added anymore once all were answered, they are executed as new work
+				this->pipelineOpen = false;
+				return false;
+			}
+			this->response->bodyless = (this->requests.first().method == "HEAD");
+			if (remaining > 0)
+			{
+				this->response->parseFromRaw();
+			}
+		}
+		return true;
+	}
+
+	bool HttpSocketThread::_canResendPipelined()
+	{
+		foreach (PipelinedRequest, it, this->requests)
+		{
+			if (!(*it).idempotent)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
 	void HttpSocketThread::_updateProcess()
 	{
 		this->_updateConnect();
-		if (this->isRunning() && this->executing)
+		if (this->pipelined)
+		{
+			if (this->_isActive())
+			{
+				this->_updatePipelined();
+			}
+			else
+			{
+				hmutex::ScopeLock lock(&this->mutex);
+				this->pipelineOpen = false;
+			}
+			return;
+		}
+		if (this->_isActive())
 		{
 			this->_updateSend();
 		}
-		if (this->isRunning() && this->executing)
+		if (this->_isActive())
 		{
 			this->_updateReceive();
 		}
 	}
 
+	bool HttpSocketThread::_isPoolable()
+	{
+		return false;
+	}
+
 }
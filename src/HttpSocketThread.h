@@ -18,6 +18,7 @@
 
 #include "Socket.h"
 #include "TimedThread.h"
+#include "Url.h"
 
 namespace sakit
 {
@@ -34,13 +35,56 @@ namespace sakit
 		~HttpSocketThread();
 
 	protected:
+		/// @brief A request on a pipelined connection and, once received, its response.
+		struct PipelinedRequest
+		{
+			hstr method;
+			Url url;
+			/// @brief The request as it was sent so it can be sent again on a new connection.
+			hstr data;
+			bool idempotent;
+			HttpResponse* response;
+			State result;
+		};
+
 		hstream* stream;
 		HttpResponse* response;
+		/// @brief Whether the current work sends further requests on the connection before the earlier ones were answered.
+		bool pipelined;
+		/// @brief Whether requests can still be added to the current pipelined work.
+		bool pipelineOpen;
+		/// @brief Number of requests that are sent before their responses have arrived.
+		int maxPipelinedRequests;
+		/// @brief Number of requests at the start of requests that were already sent.
+		int sentCount;
+		/// @brief Pipelined requests that are waiting for their responses, in the order they are sent.
+		harray<PipelinedRequest> requests;
+		/// @brief Pipelined requests that have received their responses and haven't been delivered yet.
+		harray<PipelinedRequest> completedRequests;
 
 		void _updateConnect();
 		void _updateSend();
+		/// @brief Sends the whole stream.
+		/// @return False if sending failed.
+		bool _sendStream();
 		void _updateReceive();
+		void _updatePipelined();
+		/// @brief Waits until the socket can receive, but not longer than the retry frequency.
+		/// @param[in,out] ready Whether the last wait reported the socket as ready, the next one sleeps first then.
+		void _waitReceive(bool& ready, float timeout);
+		/// @brief Sends waiting requests until maxPipelinedRequests are waiting for their responses.
+		/// @return False if the work was stopped.
+		/// @note A failed send is noticed by the receive that follows it.
+		bool _sendPipelined();
+		/// @brief Moves all complete responses to their requests.
+		/// @param[out] answered Is increased by the number of requests that received their response.
+		/// @return False if no further responses are expected.
+		bool _completePipelinedResponses(int& answered);
+		/// @return True if all unanswered requests can be sent again after the server closed the connection.
+		bool _canResendPipelined();
 		void _updateProcess();
+		/// @note A request blocks for its whole duration so it would hold up other work in the pool.
+		bool _isPoolable();
 
 	};
 
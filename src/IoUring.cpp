@@ -0,0 +1,603 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "IoUring.h"
+
+#ifdef _SAKIT_IO_URING
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <hltypes/hlog.h>
+#include <hltypes/hstring.h>
+
+#include "sakit.h"
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+// the user data of an operation holds the slot of the attached ring above the operation, own rings use slot 0
+#define SLOT_SHIFT 8
+#define OPERATION_MASK 0xFF
+
+namespace sakit
+{
+	IoUring::IoUring() : fd(-1), sqRing(MAP_FAILED), cqRing(MAP_FAILED), sqRingSize(0), cqRingSize(0), sqes((io_uring_sqe*)MAP_FAILED), sqesSize(0),
+		sqHead(NULL), sqTail(NULL), sqMask(NULL), sqFlags(NULL), sqArray(NULL), sqEntries(0), sqLocalTail(0), sqPending(0), cqHead(NULL), cqTail(NULL),
+		cqMask(NULL), cqes(NULL), bufferRing(NULL), bufferRingSize(0), buffers(NULL), bufferCount(0), bufferSize(0), bufferTail(0), receiveArmed(false),
+		receiveMultishot(true), receiveStarved(false), receiveSelected(false), receiveFinished(false), acceptArmed(false), acceptMultishot(true), pendingData(NULL), pendingSize(0), pendingBufferId(-1),
+		shared(NULL), slot(0), queued(false), buffersInUse(0), nextSlot(1), batching(false)
+	{
+		memset(&this->message, 0, sizeof(this->message));
+		memset(&this->vector, 0, sizeof(this->vector));
+		memset(&this->address, 0, sizeof(this->address));
+	}
+
+	IoUring::~IoUring()
+	{
+		if (this->shared != NULL)
+		{
+			this->_detach();
+			return;
+		}
+		// the sockets of attached rings that are still around fall back to sockets, see PlatformSocket::_uringPrepare()
+		foreach_map (unsigned int, IoUring*, it, this->slots)
+		{
+			it->second->shared = NULL;
+			it->second->completions.clear();
+			it->second->receiveArmed = false;
+			it->second->acceptArmed = false;
+			it->second->pendingData = NULL;
+			it->second->pendingSize = 0;
+			it->second->pendingBufferId = -1;
+		}
+		this->slots.clear();
+		if (this->receiveArmed)
+		{
+			this->cancel(RECEIVE);
+			this->cancel(RECEIVE_FROM);
+		}
+		if (this->acceptArmed)
+		{
+			this->cancel(ACCEPT);
+		}
+		this->_destroy();
+	}
+
+	bool IoUring::isValid()
+	{
+		return (this->fd >= 0 || this->shared != NULL);
+	}
+
+	bool IoUring::isAttached()
+	{
+		return (this->shared != NULL);
+	}
+
+	bool IoUring::hasBuffers()
+	{
+		return (this->shared != NULL ? this->shared->bufferRing != NULL : this->bufferRing != NULL);
+	}
+
+	bool IoUring::isSupported()
+	{
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		int fd = (int)syscall(__NR_io_uring_setup, 2, &params);
+		if (fd < 0)
+		{
+			return false;
+		}
+		close(fd);
+		return true;
+	}
+
+	bool IoUring::create(unsigned int entries)
+	{
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		this->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+		if (this->fd < 0)
+		{
+			hlog::error(logTag, "io_uring_setup(): " + hstr(strerror(errno)));
+			return false;
+		}
+		this->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+		this->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		bool singleMmap = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+		if (singleMmap)
+		{
+			this->sqRingSize = this->cqRingSize = hmax(this->sqRingSize, this->cqRingSize);
+		}
+		this->sqRing = mmap(NULL, this->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQ_RING);
+		if (this->sqRing == MAP_FAILED)
+		{
+			hlog::error(logTag, "mmap(): " + hstr(strerror(errno)));
+			this->_destroy();
+			return false;
+		}
+		this->cqRing = this->sqRing;
+		if (!singleMmap)
+		{
+			this->cqRing = mmap(NULL, this->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_CQ_RING);
+			if (this->cqRing == MAP_FAILED)
+			{
+				hlog::error(logTag, "mmap(): " + hstr(strerror(errno)));
+				this->_destroy();
+				return false;
+			}
+		}
+		this->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		this->sqes = (io_uring_sqe*)mmap(NULL, this->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->fd, IORING_OFF_SQES);
+		if (this->sqes == MAP_FAILED)
+		{
+			hlog::error(logTag, "mmap(): " + hstr(strerror(errno)));
+			this->_destroy();
+			return false;
+		}
+		unsigned char* sq = (unsigned char*)this->sqRing;
+		unsigned char* cq = (unsigned char*)this->cqRing;
+		this->sqHead = (unsigned int*)(sq + params.sq_off.head);
+		this->sqTail = (unsigned int*)(sq + params.sq_off.tail);
+		this->sqMask = (unsigned int*)(sq + params.sq_off.ring_mask);
+		this->sqFlags = (unsigned int*)(sq + params.sq_off.flags);
+		this->sqArray = (unsigned int*)(sq + params.sq_off.array);
+		this->sqEntries = params.sq_entries;
+		this->sqLocalTail = *this->sqTail;
+		this->cqHead = (unsigned int*)(cq + params.cq_off.head);
+		this->cqTail = (unsigned int*)(cq + params.cq_off.tail);
+		this->cqMask = (unsigned int*)(cq + params.cq_off.ring_mask);
+		this->cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+		return true;
+	}
+
+	void IoUring::_destroy()
+	{
+		if (this->bufferRing != NULL)
+		{
+			munmap(this->bufferRing, this->bufferRingSize);
+			this->bufferRing = NULL;
+		}
+		if (this->buffers != NULL)
+		{
+			delete [] this->buffers;
+			this->buffers = NULL;
+		}
+		if (this->sqes != MAP_FAILED)
+		{
+			munmap(this->sqes, this->sqesSize);
+			this->sqes = (io_uring_sqe*)MAP_FAILED;
+		}
+		if (this->cqRing != MAP_FAILED && this->cqRing != this->sqRing)
+		{
+			munmap(this->cqRing, this->cqRingSize);
+		}
+		this->cqRing = MAP_FAILED;
+		if (this->sqRing != MAP_FAILED)
+		{
+			munmap(this->sqRing, this->sqRingSize);
+			this->sqRing = MAP_FAILED;
+		}
+		if (this->fd >= 0)
+		{
+			close(this->fd);
+			this->fd = -1;
+		}
+	}
+
+	bool IoUring::attach(IoUring* shared)
+	{
+		if (shared->bufferRing == NULL)
+		{
+			return false;
+		}
+		hmutex::ScopeLock lock(&shared->mutex);
+		this->shared = shared;
+		this->slot = shared->nextSlot;
+		++shared->nextSlot;
+		if (shared->nextSlot == 0)
+		{
+			shared->nextSlot = 1;
+		}
+		shared->slots[this->slot] = this;
+		return true;
+	}
+
+	void IoUring::_detach()
+	{
+		IoUring* shared = this->shared;
+		hmutex::ScopeLock lock(&shared->mutex);
+		if (this->receiveArmed)
+		{
+			this->cancel(RECEIVE);
+		}
+		if (this->acceptArmed)
+		{
+			this->cancel(ACCEPT);
+		}
+		foreach (Completion, it, this->completions)
+		{
+			shared->_drop(*it);
+		}
+		this->completions.clear();
+		if (this->pendingBufferId >= 0)
+		{
+			shared->_recycleShared((unsigned short)this->pendingBufferId);
+			this->pendingBufferId = -1;
+		}
+		shared->slots.removeKey(this->slot);
+		shared->readySlots.tryRemove(this->slot);
+		shared->starvedSlots.tryRemove(this->slot);
+		this->shared = NULL;
+	}
+
+	void IoUring::lock(hmutex::ScopeLock& lock)
+	{
+		if (this->shared != NULL)
+		{
+			lock.acquire(&this->shared->mutex);
+		}
+	}
+
+	bool IoUring::registerBuffers(unsigned short groupId, unsigned int count, int size)
+	{
+		this->bufferRingSize = count * sizeof(io_uring_buf);
+		// the kernel requires page aligned memory for the buffer ring
+		void* memory = mmap(NULL, this->bufferRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED)
+		{
+			return false;
+		}
+		memset(memory, 0, this->bufferRingSize);
+		this->bufferRing = (io_uring_buf_ring*)memory;
+		io_uring_buf_reg registration;
+		memset(&registration, 0, sizeof(registration));
+		registration.ring_addr = (unsigned long)this->bufferRing;
+		registration.ring_entries = count;
+		registration.bgid = groupId;
+		if (syscall(__NR_io_uring_register, this->fd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0)
+		{
+			munmap(this->bufferRing, this->bufferRingSize);
+			this->bufferRing = NULL;
+			return false;
+		}
+		this->bufferCount = count;
+		this->bufferSize = size;
+		this->buffers = new unsigned char[count * size];
+		this->bufferTail = 0;
+		for_itert (unsigned int, i, 0, count)
+		{
+			this->recycleBuffer((unsigned short)i);
+		}
+		return true;
+	}
+
+	unsigned char* IoUring::getBuffer(unsigned short id)
+	{
+		if (this->shared != NULL)
+		{
+			return this->shared->getBuffer(id);
+		}
+		return (this->buffers + id * this->bufferSize);
+	}
+
+	void IoUring::recycleBuffer(unsigned short id)
+	{
+		if (this->shared != NULL)
+		{
+			this->shared->_recycleShared(id);
+			return;
+		}
+		// bufs isn't used because in C++ the empty struct of its declaration moves it behind the start of the ring
+		io_uring_buf* buffer = (io_uring_buf*)this->bufferRing + (this->bufferTail & (this->bufferCount - 1));
+		buffer->addr = (unsigned long)this->getBuffer(id);
+		buffer->len = this->bufferSize;
+		buffer->bid = id;
+		++this->bufferTail;
+		__atomic_store_n(&this->bufferRing->tail, this->bufferTail, __ATOMIC_RELEASE);
+	}
+
+	void IoUring::_recycleShared(unsigned short id)
+	{
+		this->recycleBuffer(id);
+		if (this->buffersInUse > 0)
+		{
+			--this->buffersInUse;
+		}
+		// receives that ran out of buffers can continue now
+		foreach (unsigned int, it, this->starvedSlots)
+		{
+			if (this->slots.hasKey(*it))
+			{
+				this->slots[*it]->receiveStarved = false;
+				this->slots[*it]->_queue();
+			}
+		}
+		this->starvedSlots.clear();
+	}
+
+	void IoUring::_drop(const Completion& completion)
+	{
+		// the buffers are needed by the other sockets and accepted connections would never be closed otherwise
+		if ((completion.flags & IORING_CQE_F_BUFFER) != 0)
+		{
+			this->_recycleShared((unsigned short)(completion.flags >> IORING_CQE_BUFFER_SHIFT));
+		}
+		if (completion.operation == ACCEPT && completion.result >= 0)
+		{
+			close(completion.result);
+		}
+	}
+
+	void IoUring::starve()
+	{
+		// a buffer might have been recycled since the kernel ran out of them
+		if (this->shared->buffersInUse < this->shared->bufferCount)
+		{
+			return;
+		}
+		this->receiveStarved = true;
+		this->shared->starvedSlots += this->slot;
+	}
+
+	io_uring_sqe* IoUring::getSqe(Operation operation)
+	{
+		if (this->shared != NULL)
+		{
+			io_uring_sqe* sqe = this->shared->getSqe(operation);
+			if (sqe != NULL)
+			{
+				sqe->user_data = ((unsigned long long)this->slot << SLOT_SHIFT) | (unsigned long long)operation;
+			}
+			return sqe;
+		}
+		unsigned int head = __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+		if (this->sqLocalTail - head >= this->sqEntries)
+		{
+			// what has been prepared so far is submitted early to make room
+			if (this->sqPending == 0 || this->submit() < 0)
+			{
+				return NULL;
+			}
+			head = __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+			if (this->sqLocalTail - head >= this->sqEntries)
+			{
+				return NULL;
+			}
+		}
+		unsigned int index = this->sqLocalTail & *this->sqMask;
+		io_uring_sqe* sqe = &this->sqes[index];
+		memset(sqe, 0, sizeof(io_uring_sqe));
+		sqe->user_data = (unsigned long long)operation;
+		this->sqArray[index] = index;
+		++this->sqLocalTail;
+		++this->sqPending;
+		return sqe;
+	}
+
+	int IoUring::submit(unsigned int waitCount)
+	{
+		__atomic_store_n(this->sqTail, this->sqLocalTail, __ATOMIC_RELEASE);
+		unsigned int count = this->sqPending;
+		this->sqPending = 0;
+		unsigned int flags = (waitCount > 0 ? IORING_ENTER_GETEVENTS : 0);
+		int result = 0;
+		do
+		{
+			result = (int)syscall(__NR_io_uring_enter, this->fd, count, waitCount, flags, NULL, 0);
+		} while (result < 0 && errno == EINTR);
+		if (result < 0)
+		{
+			hlog::error(logTag, "io_uring_enter(): " + hstr(strerror(errno)));
+		}
+		return result;
+	}
+
+	int IoUring::flush()
+	{
+		if (this->shared == NULL)
+		{
+			return this->submit();
+		}
+		// the reactor that owns the shared ring submits everything after it has processed all sockets
+		if (this->shared->batching || this->shared->sqPending == 0)
+		{
+			return 0;
+		}
+		return this->shared->submit();
+	}
+
+	io_uring_cqe* IoUring::peekCqe()
+	{
+		unsigned int head = *this->cqHead;
+		if (head == __atomic_load_n(this->cqTail, __ATOMIC_ACQUIRE))
+		{
+			// completions that didn't fit into the queue are only flushed when entering the kernel
+			if ((__atomic_load_n(this->sqFlags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) == 0)
+			{
+				return NULL;
+			}
+			syscall(__NR_io_uring_enter, this->fd, 0, 0, IORING_ENTER_GETEVENTS, NULL, 0);
+			if (head == __atomic_load_n(this->cqTail, __ATOMIC_ACQUIRE))
+			{
+				return NULL;
+			}
+		}
+		return &this->cqes[head & *this->cqMask];
+	}
+
+	void IoUring::seenCqe()
+	{
+		__atomic_store_n(this->cqHead, *this->cqHead + 1, __ATOMIC_RELEASE);
+	}
+
+	bool IoUring::takeCompletion(Completion& completion)
+	{
+		if (this->shared != NULL)
+		{
+			if (this->completions.size() == 0)
+			{
+				return false;
+			}
+			completion = this->completions.removeFirst();
+			return true;
+		}
+		io_uring_cqe* cqe = this->peekCqe();
+		if (cqe == NULL)
+		{
+			return false;
+		}
+		completion.operation = (Operation)(cqe->user_data & OPERATION_MASK);
+		completion.result = cqe->res;
+		completion.flags = cqe->flags;
+		this->seenCqe();
+		return true;
+	}
+
+	void IoUring::cancel(Operation operation)
+	{
+		io_uring_sqe* sqe = this->getSqe(CANCEL);
+		if (sqe == NULL)
+		{
+			return;
+		}
+		sqe->opcode = IORING_OP_ASYNC_CANCEL;
+		sqe->fd = -1;
+		sqe->addr = ((unsigned long long)this->slot << SLOT_SHIFT) | (unsigned long long)operation;
+		if (this->shared != NULL)
+		{
+			// completions of canceled operations are dropped or taken as usual, the kernel never writes into this ring's memory
+			this->flush();
+			return;
+		}
+		if (this->submit(0) < 0)
+		{
+			return;
+		}
+		io_uring_cqe* cqe = NULL;
+		bool canceled = false;
+		bool released = false;
+		// the operation's memory may only be released after its final completion has arrived
+		while (!canceled || !released)
+		{
+			cqe = this->peekCqe();
+			if (cqe == NULL)
+			{
+				if (this->submit(1) < 0)
+				{
+					return;
+				}
+				continue;
+			}
+			if (cqe->user_data == (unsigned long long)CANCEL)
+			{
+				canceled = true;
+				if (cqe->res == -ENOENT)
+				{
+					released = true;
+				}
+			}
+			else if (cqe->user_data == (unsigned long long)operation && (cqe->flags & IORING_CQE_F_MORE) == 0)
+			{
+				released = true;
+			}
+			this->seenCqe();
+		}
+	}
+
+	void IoUring::beginBatch()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->batching = true;
+	}
+
+	int IoUring::endBatch()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->batching = false;
+		if (this->sqPending == 0)
+		{
+			return 0;
+		}
+		return this->submit();
+	}
+
+	void IoUring::dispatch()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		io_uring_cqe* cqe = NULL;
+		IoUring* ring = NULL;
+		Completion completion;
+		while ((cqe = this->peekCqe()) != NULL)
+		{
+			ring = this->slots.tryGet((unsigned int)(cqe->user_data >> SLOT_SHIFT), NULL);
+			completion.operation = (Operation)(cqe->user_data & OPERATION_MASK);
+			completion.result = cqe->res;
+			completion.flags = cqe->flags;
+			this->seenCqe();
+			if ((completion.flags & IORING_CQE_F_BUFFER) != 0)
+			{
+				++this->buffersInUse;
+			}
+			if (ring == NULL || completion.operation == CANCEL)
+			{
+				this->_drop(completion);
+				continue;
+			}
+			ring->completions += completion;
+			ring->_queue();
+		}
+	}
+
+	void IoUring::_queue()
+	{
+		if (!this->queued)
+		{
+			this->queued = true;
+			this->shared->readySlots += this->slot;
+		}
+	}
+
+	void IoUring::takeReady(harray<unsigned int>& slots)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		foreach (unsigned int, it, this->readySlots)
+		{
+			this->slots[*it]->queued = false;
+		}
+		slots += this->readySlots;
+		this->readySlots.clear();
+	}
+
+	void IoUring::requeue(unsigned int slot)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		IoUring* ring = this->slots.tryGet(slot, NULL);
+		if (ring != NULL && (ring->completions.size() > 0 || ring->pendingSize > 0 || ring->receiveFinished))
+		{
+			ring->_queue();
+		}
+	}
+
+	bool IoUring::hasReady()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return (this->readySlots.size() > 0);
+	}
+
+}
+#endif
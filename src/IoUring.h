@@ -0,0 +1,192 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a minimal io_uring submission and completion ring used by the io_uring I/O backend.
+/// A ring is either owned by a single socket or shared by all sockets of a reactor, then each
+/// socket has an attached ring that only holds its own state and completions.
+
+#ifndef SAKIT_IO_URING_H
+#define SAKIT_IO_URING_H
+
+#if defined(__linux__) && !defined(_ANDROID)
+#define _SAKIT_IO_URING
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+
+namespace sakit
+{
+	class PlatformSocket;
+
+#ifdef _SAKIT_IO_URING
+	class IoUring
+	{
+	public:
+		friend class PlatformSocket;
+
+		/// @brief Identifies which operation a completion belongs to.
+		enum Operation
+		{
+			RECEIVE = 1,
+			RECEIVE_FROM,
+			ACCEPT,
+			CONNECT,
+			TIMEOUT,
+			CANCEL
+		};
+
+		/// @brief A completion that was taken from a ring, attached rings receive them from the shared ring.
+		struct Completion
+		{
+			Operation operation;
+			int result;
+			unsigned int flags;
+		};
+
+		IoUring();
+		~IoUring();
+
+		HL_DEFINE_GET(int, fd, Fd);
+		HL_DEFINE_GET(unsigned int, slot, Slot);
+		bool isValid();
+		/// @return True if the operations are submitted to a shared ring instead of an own one.
+		bool isAttached();
+		/// @return True if received data is written into provided buffers instead of the socket's receive buffer.
+		bool hasBuffers();
+
+		bool create(unsigned int entries);
+		/// @note The buffer count has to be a power of 2.
+		bool registerBuffers(unsigned short groupId, unsigned int count, int size);
+		/// @brief Submits all operations of this ring to a shared ring from now on.
+		/// @note The shared ring has to have provided buffers because the socket's memory can't be used by operations that might outlive it.
+		bool attach(IoUring* shared);
+		/// @brief Locks the shared ring if this ring is attached, has to be held while operations or completions are accessed.
+		void lock(hmutex::ScopeLock& lock);
+
+		/// @return NULL if the submission queue is full.
+		io_uring_sqe* getSqe(Operation operation);
+		/// @return Number of consumed submissions or a negative value on error.
+		int submit(unsigned int waitCount = 0);
+		/// @brief Submits new operations unless the owner of the shared ring submits them together later.
+		/// @return Number of consumed submissions or a negative value on error.
+		int flush();
+		/// @return NULL if there are no completions available.
+		/// @note Only used for own rings.
+		io_uring_cqe* peekCqe();
+		void seenCqe();
+		/// @brief Takes the next completion of this ring.
+		/// @return False if there are no completions available.
+		bool takeCompletion(Completion& completion);
+		unsigned char* getBuffer(unsigned short id);
+		void recycleBuffer(unsigned short id);
+		/// @brief Cancels an armed operation and waits until the kernel has released it.
+		/// @note Attached rings don't wait because their operations only use memory of the shared ring.
+		void cancel(Operation operation);
+		/// @brief Keeps the receive of an attached ring from being armed again until the shared ring has a free buffer.
+		void starve();
+		/// @brief Keeps attached rings from submitting on their own, the operations of all of them are submitted at once by endBatch().
+		void beginBatch();
+		/// @return Number of consumed submissions or a negative value on error.
+		int endBatch();
+		/// @brief Distributes all completions of a shared ring to the attached rings.
+		void dispatch();
+		/// @brief Takes the slots of the attached rings that have completions or can continue receiving.
+		void takeReady(harray<unsigned int>& slots);
+		/// @brief Marks the slot as ready again if its attached ring still has completions, data or a close that weren't taken.
+		void requeue(unsigned int slot);
+		bool hasReady();
+
+		static bool isSupported();
+
+	protected:
+		int fd;
+		void* sqRing;
+		void* cqRing;
+		size_t sqRingSize;
+		size_t cqRingSize;
+		io_uring_sqe* sqes;
+		size_t sqesSize;
+		unsigned int* sqHead;
+		unsigned int* sqTail;
+		unsigned int* sqMask;
+		unsigned int* sqFlags;
+		unsigned int* sqArray;
+		unsigned int sqEntries;
+		unsigned int sqLocalTail;
+		unsigned int sqPending;
+		unsigned int* cqHead;
+		unsigned int* cqTail;
+		unsigned int* cqMask;
+		io_uring_cqe* cqes;
+		// provided buffers for multishot receiving
+		io_uring_buf_ring* bufferRing;
+		size_t bufferRingSize;
+		unsigned char* buffers;
+		unsigned int bufferCount;
+		int bufferSize;
+		unsigned short bufferTail;
+		// state of armed operations of the owning socket
+		bool receiveArmed;
+		bool receiveMultishot;
+		/// @note A receive of an attached ring ran out of the shared ring's buffers and is armed again once some are recycled.
+		bool receiveStarved;
+		/// @note Used to detect kernels that accept provided buffers but never select them.
+		bool receiveSelected;
+		bool receiveFinished;
+		bool acceptArmed;
+		bool acceptMultishot;
+		unsigned char* pendingData;
+		int pendingSize;
+		int pendingBufferId;
+		msghdr message;
+		iovec vector;
+		sockaddr_storage address;
+		// state of attached rings
+		IoUring* shared;
+		unsigned int slot;
+		harray<Completion> completions;
+		/// @note Whether the slot is in the shared ring's ready slots already.
+		bool queued;
+		// state of shared rings
+		hmap<unsigned int, IoUring*> slots;
+		harray<unsigned int> readySlots;
+		harray<unsigned int> starvedSlots;
+		/// @note Number of provided buffers that the kernel has filled and that haven't been recycled yet.
+		unsigned int buffersInUse;
+		unsigned int nextSlot;
+		bool batching;
+		/// @note Protects shared rings and the state of all rings attached to them.
+		hmutex mutex;
+
+		void _destroy();
+		void _detach();
+		/// @note Has to be called while the mutex of the shared ring is locked.
+		void _queue();
+		/// @note Has to be called while the mutex is locked.
+		void _recycleShared(unsigned short id);
+		/// @brief Releases what a completion of a shared ring holds if nobody takes it.
+		/// @note Has to be called while the mutex is locked.
+		void _drop(const Completion& completion);
+
+	private:
+		IoUring(const IoUring& other); // prevents copying
+
+	};
+#endif
+
+}
+#endif
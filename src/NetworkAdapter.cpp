@@ -29,21 +29,17 @@ namespace sakit
 
 	Host NetworkAdapter::getBroadcastIp() const
 	{
-		if (!this->address.isIp())
+		unsigned char bytes[4];
+		unsigned char maskBytes[4];
+		if (!this->address.getIpBytes(bytes) || !this->mask.getIpBytes(maskBytes))
 		{
 			return Host("255.255.255.255");
 		}
-		if (!this->mask.isIp())
-		{
-			return Host("255.255.255.255");
-		}
-		harray<int> numerics = this->address.toString().split('.').cast<int>();
-		harray<int> maskNumerics = this->mask.toString().split('.').cast<int>();
 		for_iter (i, 0, 4)
 		{
-			numerics[i] = ((numerics[i] & maskNumerics[i]) | (~maskNumerics[i])) & 0xFF;
+			bytes[i] = (unsigned char)(((bytes[i] & maskBytes[i]) | (~maskBytes[i])) & 0xFF);
 		}
-		return Host((unsigned char)numerics[0], (unsigned char)numerics[1], (unsigned char)numerics[2], (unsigned char)numerics[3]);
+		return Host(bytes[0], bytes[1], bytes[2], bytes[3]);
 	}
 	
 }
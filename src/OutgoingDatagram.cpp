@@ -0,0 +1,35 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "OutgoingDatagram.h"
+
+namespace sakit
+{
+	OutgoingDatagram::OutgoingDatagram() : remotePort(0), data(NULL), size(0)
+	{
+	}
+
+	OutgoingDatagram::OutgoingDatagram(const void* data, int size) : remotePort(0), data((const unsigned char*)data), size(size)
+	{
+	}
+
+	OutgoingDatagram::OutgoingDatagram(Host remoteHost, unsigned short remotePort, const void* data, int size) : remoteHost(remoteHost), remotePort(remotePort),
+		data((const unsigned char*)data), size(size)
+	{
+	}
+
+	OutgoingDatagram::~OutgoingDatagram()
+	{
+	}
+
+	bool OutgoingDatagram::hasRemoteHost() const
+	{
+		return (this->remoteHost != Host());
+	}
+
+}
@@ -11,7 +11,9 @@
 #include <hltypes/hplatform.h>
 #include <hltypes/hstring.h>
 
+#include "BufferPool.h"
 #include "HttpResponse.h"
+#include "IoUring.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 
@@ -21,29 +23,76 @@
 
 namespace sakit
 {
+	extern BufferPool bufferPool;
+
 	// making this thread-safe, you never know
 	static hmutex mutexPrint;
 
 	PlatformSocket::~PlatformSocket()
 	{
 		this->disconnect();
-		delete [] this->receiveBuffer;
+		this->releaseBuffer();
+	}
+
+	void PlatformSocket::_acquireBuffer()
+	{
+		if (this->receiveBuffer == NULL)
+		{
+			this->receiveBuffer = bufferPool.acquire(this->bufferSize);
+		}
+	}
+
+	void PlatformSocket::releaseBuffer()
+	{
+		if (this->receiveBuffer == NULL)
+		{
+			return;
+		}
+#ifdef _SAKIT_IO_URING
+		// an armed receive or data that wasn't delivered yet might still be using the buffer, attached rings only use the buffers of the shared ring
+		if (this->ring != NULL && !this->ring->isAttached() && (this->ring->receiveArmed || this->ring->pendingSize > 0))
+		{
+			return;
+		}
+#endif
+		bufferPool.release(this->receiveBuffer, this->bufferSize);
+		this->receiveBuffer = NULL;
 	}
 	
 	bool PlatformSocket::receive(HttpResponse* response, hmutex& mutex)
 	{
 		response->raw.seek(0, hstream::END);
-		int64_t position = response->raw.position();
 		int count = 0;
 		bool result = this->receive(&response->raw, mutex, count);
 		if (result)
 		{
-			response->raw.seek(position, hstream::START);
+			// the parser continues where it stopped, only the new data is processed
+			hmutex::ScopeLock lock(&mutex);
 			response->parseFromRaw();
 		}
 		return result;
 	}
 
+	void PlatformSocket::_advanceSpans(harray<Span>& spans, int count)
+	{
+		// sent spans are removed from the front and a partially sent one is moved forward
+		int index = 0;
+		while (index < spans.size() && count >= spans[index].size)
+		{
+			count -= spans[index].size;
+			++index;
+		}
+		if (index > 0)
+		{
+			spans.removeAt(0, index);
+		}
+		if (count > 0)
+		{
+			spans[0].data += count;
+			spans[0].size -= count;
+		}
+	}
+
 	bool PlatformSocket::_printLastError(chstr basicMessage, int code)
 	{
 		hstr message;
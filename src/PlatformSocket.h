@@ -22,8 +22,11 @@
 #include <hltypes/hstring.h>
 #include <hltypes/hthread.h>
 
+#include "Endpoint.h"
 #include "Host.h"
 #include "NetworkAdapter.h"
+#include "OutgoingDatagram.h"
+#include "Span.h"
 #include "State.h"
 
 #ifdef __APPLE__
@@ -37,30 +40,72 @@ using namespace Windows::Storage::Streams;
 
 namespace sakit
 {
+	class Base;
+	class DatagramBatch;
+	class DnsResolver;
+	class FileTransfer;
 	class HttpResponse;
+	class IoUring;
+	class ReactorThread;
 	class Socket;
 
 	class PlatformSocket
 	{
 	public:
+		friend class DnsResolver;
+		friend class ReactorThread;
+
 		PlatformSocket();
 		~PlatformSocket();
 
 		HL_DEFINE_IS(connected, Connected);
 		HL_DEFINE_ISSET(connectionLess, ConnectionLess);
 		HL_DEFINE_ISSET(serverMode, ServerMode); // actually used only in WinRT
+		/// @note The connection object whose update() delivers the results of this socket's workers.
+		HL_DEFINE_GETSET(Base*, owner, Owner);
 
 		bool tryCreateSocket();
 		bool setRemoteAddress(Host remoteHost, unsigned short remotePort);
 		bool setLocalAddress(Host localHost, unsigned short localPort);
+		/// @note Domains with multiple addresses are connected like with the array of IPs.
 		bool connect(Host remoteHost, unsigned short remotePort, Host& localHost, unsigned short& localPort, float timeout, float retryFrequency);
+		/// @brief Connects to the first address that answers, the next attempt is started if the previous one hasn't finished after a short delay (Happy Eyeballs, RFC 8305).
+		/// @note IPv4 and IPv6 addresses are tried alternately, starting with the family of the first address.
+		bool connect(const harray<Host>& remoteIps, unsigned short remotePort, Host& localHost, unsigned short& localPort, float timeout, float retryFrequency);
 		/// @note Since binding can be done on "any IP" and "any port", the set values are returned.
 		bool bind(Host localHost, unsigned short& localPort);
 		bool disconnect();
 		bool send(hstream* stream, int& sent, int& count);
+		/// @brief Sends all spans with a single system call without joining them first.
+		/// @note Sent spans are removed and a partially sent span is advanced.
+		bool send(harray<Span>& spans, int& sent);
+		/// @brief Sends the next part of the file transfer.
+		bool sendFile(FileTransfer* transfer, int& sent);
+		/// @brief Sends as many datagrams as possible with a single system call.
+		/// @param[in,out] sent Index of the next datagram to send.
+		bool sendBatch(harray<OutgoingDatagram>& datagrams, int& sent);
+		/// @brief Sends the data split into datagrams of segmentSize bytes, letting the kernel do the splitting where supported.
+		/// @param[in,out] sent Number of bytes already sent.
+		bool sendSegmented(const unsigned char* data, int size, int segmentSize, int& sent);
 		bool receive(hstream* stream, hmutex& mutex, int& maxBytes);
 		bool receive(HttpResponse* response, hmutex& mutex);
-		bool receiveFrom(hstream* stream, Host& remoteHost, unsigned short& remotePort);
+		/// @brief Receives directly into the given memory without going through the receive buffer.
+		/// @param[out] read Number of bytes that were received.
+		bool receive(unsigned char* data, int size, int& read);
+		/// @note The sender address is not formatted as text.
+		bool receiveFrom(hstream* stream, Endpoint& remoteEndpoint);
+		/// @brief Receives all datagrams that are already available, up to the capacity of the batch, without waiting for more.
+		/// @param[in] maxCount Limits the number of received datagrams if larger than 0.
+		bool receiveBatch(DatagramBatch* batch, int maxCount);
+		/// @brief Returns the receive buffer to the buffer pool while the socket isn't receiving.
+		/// @note The buffer is acquired again by the next receive call.
+		void releaseBuffer();
+		/// @brief Blocks until data (or a connection on a listening socket) can be received or the timeout in seconds has passed.
+		/// @return False if the timeout has passed without anything to receive.
+		bool waitReceive(float timeout);
+		/// @brief Blocks until one of the sockets can receive or the timeout in seconds has passed.
+		/// @return False if the timeout has passed without anything to receive.
+		static bool waitReceive(const harray<PlatformSocket*>& sockets, float timeout);
 		bool listen();
 		bool accept(Socket* socket);
 
@@ -73,7 +118,17 @@ namespace sakit
 		bool setMulticastTtl(int value);
 		bool setMulticastLoopback(bool value);
 
+		/// @brief Size of the raw socket addresses stored in a DatagramBatch.
+		static const int AddressSize;
+
+		static void getAddressHostPort(const void* address, int size, Host& host, unsigned short& port);
+		static unsigned short getAddressPort(const void* address, int size);
+		/// @brief Converts an IP address into a raw socket address without resolving it.
+		/// @param[out] address Has to have room for Endpoint::MaxSize bytes.
+		static bool makeAddress(Host host, unsigned short port, void* address, int& size);
 		static Host resolveHost(Host domain);
+		/// @return All IPv4 and IPv6 addresses of the domain in the order the system prefers them.
+		static harray<Host> resolveHosts(Host domain);
 		static Host resolveIp(Host ip);
 		static unsigned short resolveServiceName(chstr serviceName);
 		static harray<NetworkAdapter> getNetworkAdapters();
@@ -84,9 +139,11 @@ namespace sakit
 	protected:
 		bool connected;
 		bool connectionLess;
+		/// @note Acquired from the buffer pool at the first receive call.
 		char* receiveBuffer;
 		int bufferSize;
 		bool serverMode;
+		Base* owner;
 
 #if !defined(_WIN32) || !defined(_WINRT)
 		unsigned int sock;
@@ -94,11 +151,54 @@ namespace sakit
 		struct addrinfo* localInfo;
 		struct addrinfo* remoteInfo;
 		struct sockaddr_storage* address;
+		/// @note Only used with the io_uring I/O backend.
+		IoUring* ring;
+		bool uringFailed;
+		/// @note Cleared when the kernel rejects UDP segmentation offloading.
+		bool segmentationSupported;
 
 		bool _setAddress(Host& host, unsigned short& port, addrinfo** info);
+		/// @brief Keeps sending on a connection that the peer has closed from raising SIGPIPE where send() has no flag for it.
+		void _setNoSigPipe();
+		bool _connectAddress(Host remoteHost, unsigned short remotePort, Host& localHost, unsigned short& localPort, float timeout);
+		/// @param[out] sock The connected socket of the attempt that won, all others are closed.
+		bool _connectRacing(const harray<Host>& ips, unsigned short port, float timeout, Host& remoteIp, unsigned int& sock);
+		/// @note Fails if neither a remote host nor a received address has been set.
+		bool _getRemoteAddress(struct sockaddr** address, int* size);
+		bool _resolveAddress(Host host, unsigned short port, struct sockaddr_storage* address, int* size);
 		bool _checkReceivedBytes(unsigned long* received);
 		bool _checkResult(int result, chstr functionName, bool disconnectOnError = true);
 		void _getLocalHostPort(Host& host, unsigned short& port);
+		/// @return The descriptor that becomes readable when this socket has data or completions available, -1 if a reactor waits for them.
+		/// @note Creates the io_uring instance if that backend is active.
+		int _getPollDescriptor();
+
+		/// @param[out] temporaryFailure Whether the lookup might succeed if it's done again.
+		static bool _resolveHosts(Host domain, harray<Host>& ips, bool& temporaryFailure);
+
+		bool _uringAvailable();
+		bool _uringPrepare();
+		/// @brief Makes this socket use the shared ring of a reactor instead of an own one.
+		/// @return False if the socket can't use the shared ring, e.g. because it has operations in progress on its own ring.
+		bool _uringAttach(IoUring* shared);
+		/// @note The ring has to be one of the borrowed ones.
+		bool _uringConnect(IoUring* ring, float timeout);
+		/// @note Writes into the memory at data if stream is NULL.
+		bool _uringReceive(hstream* stream, unsigned char* data, hmutex& mutex, int& maxBytes);
+		bool _uringReceiveFrom(hstream* stream, Endpoint& remoteEndpoint);
+		/// @note Waiting for the descriptor of a connection-less socket needs the receive to be armed before the first receive call.
+		bool _uringArmReceiveFrom();
+		bool _uringAccept(Socket* socket);
+		/// @brief Stops the armed operations of a socket that is attached to a shared ring.
+		void _uringCancel();
+
+		/// @brief Borrows a ring for operations that are completed before the call returns, e.g. connecting.
+		/// @return NULL if no ring could be created.
+		static IoUring* _uringAcquire();
+		static void _uringRelease(IoUring* ring);
+		static void _uringDestroyRings();
+		/// @return NULL if no ring with provided buffers could be created.
+		static IoUring* _uringCreateShared();
 #else
 		// there is no other way to make this work
 		[Windows::Foundation::Metadata::WebHostHidden]
@@ -170,7 +270,9 @@ namespace sakit
 #endif
 
 		bool _setNonBlocking(bool value);
+		void _acquireBuffer();
 
+		static void _advanceSpans(harray<Span>& spans, int count);
 		static bool _printLastError(chstr basicMessage, int code = 0);
 
 	};
@@ -0,0 +1,550 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "IoUring.h"
+
+#ifdef _SAKIT_IO_URING
+#include <errno.h>
+#include <netdb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hstream.h>
+#include <hltypes/hstring.h>
+
+#include "Endpoint.h"
+#include "PlatformSocket.h"
+#include "sakit.h"
+#include "Socket.h"
+
+#define RING_ENTRIES 16
+#define BUFFER_GROUP 0
+#define BUFFER_COUNT 8
+#define MIN_BUFFER_SIZE 2048
+#define MAX_CONNECT_RINGS 8
+#define SHARED_RING_ENTRIES 256
+#define SHARED_BUFFER_COUNT 256
+
+namespace sakit
+{
+	extern IoBackend ioBackend;
+
+	static harray<IoUring*> connectRings;
+	static hmutex connectRingsMutex;
+
+	bool PlatformSocket::_uringAvailable()
+	{
+		return (ioBackend == IO_BACKEND_IO_URING && !this->uringFailed && this->sock != (unsigned int)-1);
+	}
+
+	bool PlatformSocket::_uringPrepare()
+	{
+		if (!this->_uringAvailable())
+		{
+			return false;
+		}
+		// the shared ring of a reactor has been destroyed while this socket was still attached to it
+		if (this->ring != NULL && !this->ring->isValid())
+		{
+			delete this->ring;
+			this->ring = NULL;
+			this->uringFailed = true;
+			return false;
+		}
+		if (this->ring == NULL)
+		{
+			this->ring = new IoUring();
+			if (!this->ring->create(RING_ENTRIES))
+			{
+				hlog::warn(logTag, "Could not create io_uring instance, using sockets for this connection.");
+				delete this->ring;
+				this->ring = NULL;
+				this->uringFailed = true;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool PlatformSocket::_uringAttach(IoUring* shared)
+	{
+		if (!this->_uringAvailable() || this->connectionLess)
+		{
+			return false;
+		}
+		if (this->ring != NULL)
+		{
+			if (this->ring->shared == shared)
+			{
+				return true;
+			}
+			// armed operations and data that wasn't delivered yet would get lost
+			if (this->ring->isAttached() || !this->ring->isValid() || this->ring->receiveArmed || this->ring->acceptArmed ||
+				this->ring->pendingSize > 0 || this->ring->peekCqe() != NULL)
+			{
+				return false;
+			}
+			delete this->ring;
+			this->ring = NULL;
+		}
+		this->ring = new IoUring();
+		if (!this->ring->attach(shared))
+		{
+			delete this->ring;
+			this->ring = NULL;
+			return false;
+		}
+		return true;
+	}
+
+	void PlatformSocket::_uringCancel()
+	{
+		if (this->ring == NULL || !this->ring->isAttached())
+		{
+			return;
+		}
+		hmutex::ScopeLock lock;
+		this->ring->lock(lock);
+		if (this->ring->receiveArmed)
+		{
+			this->ring->cancel(IoUring::RECEIVE);
+		}
+		if (this->ring->acceptArmed)
+		{
+			this->ring->cancel(IoUring::ACCEPT);
+		}
+	}
+
+	IoUring* PlatformSocket::_uringCreateShared()
+	{
+		IoUring* ring = new IoUring();
+		if (!ring->create(SHARED_RING_ENTRIES) || !ring->registerBuffers(BUFFER_GROUP, SHARED_BUFFER_COUNT, hmax(sakit::getBufferSize() / BUFFER_COUNT, MIN_BUFFER_SIZE)))
+		{
+			delete ring;
+			return NULL;
+		}
+		return ring;
+	}
+
+	IoUring* PlatformSocket::_uringAcquire()
+	{
+		hmutex::ScopeLock lock(&connectRingsMutex);
+		if (connectRings.size() > 0)
+		{
+			return connectRings.removeLast();
+		}
+		lock.release();
+		IoUring* ring = new IoUring();
+		if (!ring->create(RING_ENTRIES))
+		{
+			delete ring;
+			return NULL;
+		}
+		return ring;
+	}
+
+	void PlatformSocket::_uringRelease(IoUring* ring)
+	{
+		hmutex::ScopeLock lock(&connectRingsMutex);
+		// a ring that failed might still have operations in flight
+		if (!ring->isValid() || connectRings.size() >= MAX_CONNECT_RINGS)
+		{
+			lock.release();
+			delete ring;
+			return;
+		}
+		connectRings += ring;
+	}
+
+	void PlatformSocket::_uringDestroyRings()
+	{
+		hmutex::ScopeLock lock(&connectRingsMutex);
+		foreach (IoUring*, it, connectRings)
+		{
+			delete (*it);
+		}
+		connectRings.clear();
+	}
+
+	bool PlatformSocket::_uringConnect(IoUring* ring, float timeout)
+	{
+		io_uring_sqe* sqe = ring->getSqe(IoUring::CONNECT);
+		io_uring_sqe* timeoutSqe = ring->getSqe(IoUring::TIMEOUT);
+		if (sqe == NULL || timeoutSqe == NULL)
+		{
+			hlog::error(logTag, "io_uring submission queue is full.");
+			ring->_destroy();
+			this->disconnect();
+			return false;
+		}
+		// the timeout is linked to the connect so both are submitted and awaited with a single system call
+		sqe->opcode = IORING_OP_CONNECT;
+		sqe->fd = this->sock;
+		sqe->addr = (unsigned long)this->remoteInfo->ai_addr;
+		sqe->off = this->remoteInfo->ai_addrlen;
+		sqe->flags = IOSQE_IO_LINK;
+		__kernel_timespec interval;
+		interval.tv_sec = (long long)timeout;
+		interval.tv_nsec = (long long)((timeout - (long long)timeout) * 1000000000);
+		timeoutSqe->opcode = IORING_OP_LINK_TIMEOUT;
+		timeoutSqe->fd = -1;
+		timeoutSqe->addr = (unsigned long)&interval;
+		timeoutSqe->len = 1;
+		if (ring->submit(2) < 0)
+		{
+			ring->_destroy();
+			this->disconnect();
+			return false;
+		}
+		int result = -ECANCELED;
+		int remaining = 2;
+		IoUring::Completion completion;
+		// both completions have to arrive before the ring can be used for the next connect
+		while (remaining > 0)
+		{
+			if (!ring->takeCompletion(completion))
+			{
+				if (ring->submit(1) < 0)
+				{
+					ring->_destroy();
+					this->disconnect();
+					return false;
+				}
+				continue;
+			}
+			if (completion.operation == IoUring::CONNECT)
+			{
+				result = completion.result;
+			}
+			--remaining;
+		}
+		if (result == -ECANCELED)
+		{
+			hlog::error(logTag, "Unable to connect, timed out.");
+			this->disconnect();
+			return false;
+		}
+		if (result < 0)
+		{
+			PlatformSocket::_printLastError("connect()", -result);
+			this->disconnect();
+			return false;
+		}
+		return true;
+	}
+
+	bool PlatformSocket::_uringReceive(hstream* stream, unsigned char* data, hmutex& mutex, int& maxBytes)
+	{
+		IoUring* ring = this->ring;
+		if (!ring->isAttached() && ring->receiveMultishot && ring->bufferRing == NULL)
+		{
+			ring->receiveMultishot = ring->registerBuffers(BUFFER_GROUP, BUFFER_COUNT, hmax(this->bufferSize / BUFFER_COUNT, MIN_BUFFER_SIZE));
+		}
+		bool limited = (maxBytes > 0);
+		IoUring::Completion completion;
+		int size = 0;
+		bool delivered = false;
+		bool submitted = false;
+		bool retried = false;
+		hmutex::ScopeLock lockRing;
+		hmutex::ScopeLock lock;
+		ring->lock(lockRing);
+		while (true)
+		{
+			// consumes all completed receives that are available without a system call
+			while (!limited || maxBytes > 0)
+			{
+				if (ring->pendingSize == 0)
+				{
+					if (!ring->takeCompletion(completion))
+					{
+						break;
+					}
+					if (completion.operation != IoUring::RECEIVE)
+					{
+						continue;
+					}
+					if ((completion.flags & IORING_CQE_F_MORE) == 0)
+					{
+						ring->receiveArmed = false;
+					}
+					if (completion.result == 0)
+					{
+						ring->receiveFinished = true;
+						break;
+					}
+					if (completion.result < 0)
+					{
+						if (completion.result == -EINVAL && ring->receiveMultishot) // kernel does not support multishot receiving
+						{
+							ring->receiveMultishot = false;
+							continue;
+						}
+						if (completion.result == -ENOBUFS && ring->isAttached())
+						{
+							ring->starve();
+							continue;
+						}
+						// running out of buffers before any of them was used means they can't be used at all
+						if (completion.result == -ENOBUFS && ring->receiveMultishot && !ring->receiveSelected)
+						{
+							ring->receiveMultishot = false;
+							continue;
+						}
+						// receives of paused sockets are canceled so they don't hold on to the buffers of a shared ring
+						if (completion.result == -ENOBUFS || completion.result == -EAGAIN || completion.result == -EINTR || completion.result == -ECANCELED)
+						{
+							continue;
+						}
+						PlatformSocket::_printLastError("recv()", -completion.result);
+						return false;
+					}
+					ring->pendingBufferId = -1;
+					ring->pendingData = (unsigned char*)this->receiveBuffer;
+					if ((completion.flags & IORING_CQE_F_BUFFER) != 0)
+					{
+						ring->receiveSelected = true;
+						ring->pendingBufferId = (int)(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+						ring->pendingData = ring->getBuffer((unsigned short)ring->pendingBufferId);
+					}
+					ring->pendingSize = completion.result;
+				}
+				size = ring->pendingSize;
+				if (limited)
+				{
+					size = hmin(size, maxBytes);
+					maxBytes -= size;
+				}
+				if (stream != NULL)
+				{
+					lock.acquire(&mutex);
+					stream->writeRaw(ring->pendingData, size);
+					lock.release();
+				}
+				else
+				{
+					memcpy(data, ring->pendingData, size);
+					data += size;
+				}
+				ring->pendingData += size;
+				ring->pendingSize -= size;
+				delivered = true;
+				if (ring->pendingSize == 0 && ring->pendingBufferId >= 0)
+				{
+					ring->recycleBuffer((unsigned short)ring->pendingBufferId);
+					ring->pendingBufferId = -1;
+				}
+			}
+			// the other side has closed the connection once everything it sent was delivered, callers only process data of successful calls
+			if (ring->receiveFinished && ring->pendingSize == 0 && !delivered)
+			{
+				lockRing.release();
+				this->disconnect();
+				return false;
+			}
+			// the receive buffer cannot be reused while it still holds data that wasn't delivered yet
+			if (!ring->receiveArmed && !ring->receiveStarved && !ring->receiveFinished && ring->pendingSize == 0 && (!limited || maxBytes > 0))
+			{
+				io_uring_sqe* sqe = ring->getSqe(IoUring::RECEIVE);
+				if (sqe != NULL)
+				{
+					sqe->opcode = IORING_OP_RECV;
+					sqe->fd = this->sock;
+					// attached rings always use the shared ring's buffers because a canceled receive could still write into the socket's buffer otherwise
+					if (ring->receiveMultishot || ring->isAttached())
+					{
+						sqe->flags = IOSQE_BUFFER_SELECT;
+						sqe->buf_group = BUFFER_GROUP;
+						if (ring->receiveMultishot)
+						{
+							ring->receiveSelected = false;
+							sqe->ioprio = IORING_RECV_MULTISHOT;
+						}
+					}
+					else
+					{
+						sqe->addr = (unsigned long)this->receiveBuffer;
+						sqe->len = (limited ? hmin(this->bufferSize, maxBytes) : this->bufferSize);
+					}
+					if (ring->flush() < 0)
+					{
+						return false;
+					}
+					ring->receiveArmed = true;
+					submitted = true;
+				}
+			}
+			// a receive on a socket that has data waiting already completes while it's submitted, attached rings get it with the next dispatch
+			if (!submitted || retried || ring->isAttached())
+			{
+				break;
+			}
+			retried = true;
+		}
+		return true;
+	}
+
+	bool PlatformSocket::_uringReceiveFrom(hstream* stream, Endpoint& remoteEndpoint)
+	{
+		IoUring* ring = this->ring;
+		IoUring::Completion completion;
+		bool found = false;
+		bool submitted = false;
+		while (true)
+		{
+			while (ring->takeCompletion(completion))
+			{
+				if (completion.operation == IoUring::RECEIVE_FROM)
+				{
+					found = true;
+					break;
+				}
+			}
+			// a datagram that is waiting already completes the receive while it's submitted
+			if (found || submitted || ring->receiveArmed)
+			{
+				break;
+			}
+			if (!this->_uringArmReceiveFrom())
+			{
+				return false;
+			}
+			submitted = true;
+		}
+		if (found)
+		{
+			ring->receiveArmed = false;
+			if (completion.result < 0 && completion.result != -EAGAIN && completion.result != -EINTR)
+			{
+				PlatformSocket::_printLastError("recvfrom()", -completion.result);
+				this->disconnect();
+				return false;
+			}
+			if (completion.result > 0)
+			{
+				stream->writeRaw(this->receiveBuffer, completion.result);
+				remoteEndpoint = Endpoint(&ring->address, (int)ring->message.msg_namelen);
+			}
+		}
+		return this->_uringArmReceiveFrom();
+	}
+
+	bool PlatformSocket::_uringArmReceiveFrom()
+	{
+		IoUring* ring = this->ring;
+		// only one datagram is received per call, the same as with sockets
+		if (!ring->receiveArmed)
+		{
+			io_uring_sqe* sqe = ring->getSqe(IoUring::RECEIVE_FROM);
+			if (sqe != NULL)
+			{
+				ring->vector.iov_base = this->receiveBuffer;
+				ring->vector.iov_len = this->bufferSize;
+				memset(&ring->message, 0, sizeof(ring->message));
+				ring->message.msg_name = &ring->address;
+				ring->message.msg_namelen = sizeof(ring->address);
+				ring->message.msg_iov = &ring->vector;
+				ring->message.msg_iovlen = 1;
+				sqe->opcode = IORING_OP_RECVMSG;
+				sqe->fd = this->sock;
+				sqe->addr = (unsigned long)&ring->message;
+				sqe->len = 1;
+				if (ring->submit() < 0)
+				{
+					return false;
+				}
+				ring->receiveArmed = true;
+			}
+		}
+		return true;
+	}
+
+	bool PlatformSocket::_uringAccept(Socket* socket)
+	{
+		IoUring* ring = this->ring;
+		int result = -EAGAIN;
+		IoUring::Completion completion;
+		hmutex::ScopeLock lockRing;
+		ring->lock(lockRing);
+		while (result == -EAGAIN && ring->takeCompletion(completion))
+		{
+			if (completion.operation == IoUring::ACCEPT)
+			{
+				result = completion.result;
+				if ((completion.flags & IORING_CQE_F_MORE) == 0)
+				{
+					ring->acceptArmed = false;
+				}
+				if (result == -EINVAL && ring->acceptMultishot) // kernel does not support multishot accepting
+				{
+					ring->acceptMultishot = false;
+					result = -EAGAIN;
+				}
+				else if (result == -EINTR || result == -ECANCELED)
+				{
+					result = -EAGAIN;
+				}
+			}
+		}
+		// a multishot accept stays armed so further connections don't need any system call
+		if (!ring->acceptArmed)
+		{
+			io_uring_sqe* sqe = ring->getSqe(IoUring::ACCEPT);
+			if (sqe != NULL)
+			{
+				sqe->opcode = IORING_OP_ACCEPT;
+				sqe->fd = this->sock;
+				if (ring->acceptMultishot)
+				{
+					sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+				}
+				if (ring->flush() >= 0)
+				{
+					ring->acceptArmed = true;
+				}
+			}
+		}
+		lockRing.release();
+		if (result < 0)
+		{
+			if (result != -EAGAIN)
+			{
+				PlatformSocket::_printLastError("accept()", -result);
+			}
+			return false;
+		}
+		PlatformSocket* other = socket->socket;
+		other->sock = result;
+		other->_setNoSigPipe();
+		// like with connected sockets, small responses are sent right away instead of waiting for the acknowledgement of earlier ones
+		other->setNagleAlgorithmActive(false);
+		socklen_t size = (socklen_t)sizeof(sockaddr_storage);
+		other->address = (sockaddr_storage*)malloc(size);
+		if (!other->_checkResult(getpeername(other->sock, (sockaddr*)other->address, &size), "getpeername()"))
+		{
+			return false;
+		}
+		// get the IP and port of the connected client, getnameinfo() is thread-safe on this platform
+		char hostString[NI_MAXHOST] = {'\0'};
+		char portString[NI_MAXSERV] = {'\0'};
+		getnameinfo((sockaddr*)other->address, size, hostString, NI_MAXHOST, portString, NI_MAXSERV, NI_NUMERICHOST | NI_NUMERICSERV);
+		Host localHost;
+		unsigned short localPort = 0;
+		this->_getLocalHostPort(localHost, localPort);
+		((SocketBase*)socket)->_activateConnection(Host(hostString), (unsigned short)(int)hstr(portString), localHost, localPort);
+		other->connected = true;
+		return true;
+	}
+
+}
+#endif
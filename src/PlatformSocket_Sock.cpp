@@ -23,6 +23,9 @@
 
 typedef int socklen_t;
 
+#define poll WSAPoll
+#define SEND_FLAGS 0
+
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <Iphlpapi.h>
@@ -31,10 +34,16 @@ typedef int socklen_t;
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#include <sys/uio.h>
 #include <sys/ioctl.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <arpa/inet.h>
+#include <net/if.h>
 #ifndef _ANDROID
 #include <ifaddrs.h>
 #else
@@ -44,6 +53,7 @@ typedef int socklen_t;
 #include <fcntl.h>
 #include <netdb.h>
 #include <errno.h>
+#include <poll.h>
 
 extern int h_errno;
 
@@ -60,6 +70,12 @@ extern int h_errno;
 #define optlen_t socklen_t
 #define CONNECT_WOULD_BLOCK EINPROGRESS
 #define EWOULDBLOCK EAGAIN
+// sending on a connection that the peer has closed would raise SIGPIPE and terminate the process
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
 #endif
 
 #include <hltypes/hlog.h>
@@ -67,21 +83,64 @@ extern int h_errno;
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 
+#include "BufferPool.h"
+#include "DatagramBatch.h"
+#include "DnsCache.h"
+#include "Endpoint.h"
+#include "FileTransfer.h"
 #include "Host.h"
+#include "IoUring.h"
+#include "OutgoingDatagram.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "Server.h"
 #include "Socket.h"
 
+// more spans are sent with additional calls
+#define MAX_SEND_SPANS 64
+// files are sent in parts so progress can be reported
+#define MAX_SEND_FILE_SIZE 1048576
+// larger batches are received and sent with additional calls
+#define MAX_RECEIVE_BATCH 64
+#define MAX_SEND_BATCH 64
+#if defined(__linux__) && !defined(_ANDROID)
+#define _SAKIT_RECVMMSG
+#define _SAKIT_SENDMMSG
+#define _SAKIT_UDP_SEGMENT
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#endif
+// limits of segmentation offloading in the kernel
+#define MAX_SEGMENT_COUNT 64
+#define MAX_SEGMENTED_SIZE 65507
+// RFC 8305 recommends waiting this long (in milliseconds) before the next address is tried while a connection attempt is still pending
+#define CONNECTION_ATTEMPT_DELAY 250
+// these resolver functions are reentrant in the system libraries of these platforms
+#if defined(_WIN32) || defined(__APPLE__) || (defined(__linux__) && !defined(_ANDROID))
+#define _SAKIT_REENTRANT_RESOLVER
+#endif
+
 namespace sakit
 {
 	extern int bufferSize;
-	// even though by standard definition these functions should be thread-safe, practice has shown otherwise
+	extern BufferPool bufferPool;
+	extern DnsCache dnsCache;
+	const int PlatformSocket::AddressSize = (int)sizeof(sockaddr_storage);
+#ifdef _SAKIT_REENTRANT_RESOLVER
+	#define __lockResolver(lock, mutex)
+	#define __unlockResolver(lock)
+#else
+	// even though by standard definition these functions should be thread-safe, practice has shown otherwise on some platforms
 	static hmutex mutexGetaddrinfo;
 	static hmutex mutexFreeaddrinfo;
 	static hmutex mutexGetnameinfo;
 	static hmutex mutexGetsockname;
 
+	#define __lockResolver(lock, mutex) (lock).acquire(&(mutex))
+	#define __unlockResolver(lock) (lock).release()
+#endif
+
 	// utility functions
 #ifdef _WIN32
 	#define __gai_strerror(str) hstr::fromUnicode(gai_strerrorW(str))
@@ -111,34 +170,97 @@ namespace sakit
 	#define __inet_pton inet_pton
 #endif
 
-	// wrappers for thread-unsafe functions
-	static hmutex mutexInetNtoa;
-	static hmutex mutexInetAddr;
-	static hmutex mutexHtons;
-	static hmutex mutexNtohs;
+	// replacements for functions that are not thread-safe or that are macros with locks on some platforms, these only work on bytes
+	static inline Host __inet_ntoa(const in_addr& address)
+	{
+		const unsigned char* bytes = (const unsigned char*)&address;
+		return Host(bytes[0], bytes[1], bytes[2], bytes[3]);
+	}
+
+	static inline unsigned long __inet_addr(const char* ip)
+	{
+		in_addr address;
+		if (__inet_pton(AF_INET, ip, &address) != 1)
+		{
+			return INADDR_NONE;
+		}
+		return (unsigned long)address.s_addr;
+	}
+
+	static inline unsigned short __htons(unsigned short value)
+	{
+		unsigned short result = 0;
+		unsigned char* bytes = (unsigned char*)&result;
+		bytes[0] = (unsigned char)(value >> 8);
+		bytes[1] = (unsigned char)(value & 0xFF);
+		return result;
+	}
 
-	static char* __inet_ntoa(struct in_addr in)
+	static inline unsigned short __ntohs(unsigned short value)
 	{
-		hmutex::ScopeLock lock(&mutexInetNtoa);
-		return inet_ntoa(in);
+		const unsigned char* bytes = (const unsigned char*)&value;
+		return (unsigned short)((bytes[0] << 8) | bytes[1]);
 	}
 
-	static unsigned long __inet_addr(const char* cp)
+	static inline bool __isConnectPending()
 	{
-		hmutex::ScopeLock lock(&mutexInetAddr);
-		return inet_addr(cp);
+#ifdef _WIN32
+		return (WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+		return (errno == CONNECT_WOULD_BLOCK);
+#endif
 	}
 
-	static unsigned short __htons(unsigned hostshort)
+	// the same address can be returned for different socket types
+	static harray<Host> __getInfoHosts(const addrinfo* info)
 	{
-		hmutex::ScopeLock lock(&mutexHtons);
-		return htons(hostshort);
+		harray<Host> result;
+		Host host;
+		unsigned short port = 0;
+		for (const addrinfo* it = info; it != NULL; it = it->ai_next)
+		{
+			if (it->ai_family == AF_INET || it->ai_family == AF_INET6)
+			{
+				PlatformSocket::getAddressHostPort(it->ai_addr, (int)it->ai_addrlen, host, port);
+				if (!result.has(host))
+				{
+					result += host;
+				}
+			}
+		}
+		return result;
 	}
 
-	static unsigned short __ntohs(unsigned netshort)
+	// as described in RFC 8305 section 4, the address families alternate, starting with the family of the first address
+	static harray<Host> __interleaveFamilies(const harray<Host>& ips)
 	{
-		hmutex::ScopeLock lock(&mutexNtohs);
-		return ntohs(netshort);
+		harray<Host> first;
+		harray<Host> second;
+		bool firstIpv6 = ips.first().isIpv6();
+		for_iter (i, 0, ips.size())
+		{
+			if (ips[i].isIpv6() == firstIpv6)
+			{
+				first += ips[i];
+			}
+			else
+			{
+				second += ips[i];
+			}
+		}
+		harray<Host> result;
+		while (first.size() > 0 || second.size() > 0)
+		{
+			if (first.size() > 0)
+			{
+				result += first.removeFirst();
+			}
+			if (second.size() > 0)
+			{
+				result += second.removeFirst();
+			}
+		}
+		return result;
 	}
 
 	// normal methods
@@ -157,6 +279,9 @@ namespace sakit
 
 	void PlatformSocket::platformDestroy()
 	{
+#ifdef _SAKIT_IO_URING
+		PlatformSocket::_uringDestroyRings();
+#endif
 #if defined(_WIN32) && !defined(_WINRT)
 		int result = WSACleanup();
 		if (result != 0)
@@ -166,16 +291,18 @@ namespace sakit
 #endif
 	}
 
-	PlatformSocket::PlatformSocket() : connected(false), connectionLess(false)
+	PlatformSocket::PlatformSocket() : connected(false), connectionLess(false), owner(NULL)
 	{
 		this->sock = -1;
 		this->socketInfo = NULL;
 		this->localInfo = NULL;
 		this->remoteInfo = NULL;
 		this->address = NULL;
+		this->ring = NULL;
+		this->uringFailed = false;
+		this->segmentationSupported = true;
 		this->bufferSize = sakit::bufferSize;
-		this->receiveBuffer = new char[this->bufferSize];
-		memset(this->receiveBuffer, 0, this->bufferSize);
+		this->receiveBuffer = NULL;
 	}
 
 	bool PlatformSocket::_setNonBlocking(bool value)
@@ -185,13 +312,25 @@ namespace sakit
 		return this->_checkResult(ioctlsocket(this->sock, FIONBIO, (unsigned long*)&setValue), "ioctlsocket()");
 	}
 
+	void PlatformSocket::_setNoSigPipe()
+	{
+#ifdef SO_NOSIGPIPE
+		int noSigPipe = 1;
+		setsockopt(this->sock, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&noSigPipe, sizeof(noSigPipe));
+#endif
+	}
+
 	bool PlatformSocket::tryCreateSocket()
 	{
 		if (this->sock == (unsigned int)-1)
 		{
 			this->connected = true;
 			this->sock = socket(this->socketInfo->ai_family, this->socketInfo->ai_socktype, this->socketInfo->ai_protocol);
-			return this->_checkResult(this->sock, "socket()");
+			if (!this->_checkResult(this->sock, "socket()"))
+			{
+				return false;
+			}
+			this->_setNoSigPipe();
 		}
 		return true;
 	}
@@ -216,29 +355,59 @@ namespace sakit
 		hmutex::ScopeLock lock;
 		if (*info != NULL)
 		{
-			lock.acquire(&mutexFreeaddrinfo);
+			__lockResolver(lock, mutexFreeaddrinfo);
 			freeaddrinfo(*info);
-			lock.release();
+			__unlockResolver(lock);
 			*info = NULL;
 		}
-#ifndef _ANDROID
-		this->socketInfo->ai_family = AF_INET;
-#else
-		this->socketInfo->ai_family = PF_INET;
-#endif
+		this->socketInfo->ai_family = AF_UNSPEC;
 		this->socketInfo->ai_socktype = (!this->connectionLess ? SOCK_STREAM : SOCK_DGRAM);
 		this->socketInfo->ai_protocol = IPPROTO_IP;
 		this->socketInfo->ai_flags = 0;
-		lock.acquire(&mutexGetaddrinfo);
-		int result = getaddrinfo(host.toString().cStr(), hstr(port).cStr(), this->socketInfo, info);
+		// domains are looked up in the shared cache first so only numeric addresses have to be converted
+		Host address = host;
+		Host domain;
+		if (!host.isIp() && host.toString() != "")
+		{
+			harray<Host> ips;
+			DnsCache::Result cached = dnsCache.get(host, ips);
+			if (cached == DnsCache::FAILED)
+			{
+				hlog::error(logTag, "getaddrinfo() failed recently for: " + host.toString());
+				this->disconnect();
+				return false;
+			}
+			if (cached == DnsCache::FOUND)
+			{
+				// only one address is used, connect() tries all of them
+				address = ips.first();
+			}
+			else
+			{
+				domain = host;
+			}
+		}
+		if (address.isIp())
+		{
+			this->socketInfo->ai_flags = AI_NUMERICHOST;
+		}
+		__lockResolver(lock, mutexGetaddrinfo);
+		int result = getaddrinfo(address.toString().cStr(), hstr(port).cStr(), this->socketInfo, info);
+		__unlockResolver(lock);
 		if (result != 0)
 		{
 			hlog::error(logTag, "getaddrinfo() " + __gai_strerror(result));
-			lock.release();
+			if (domain.toString() != "" && result != EAI_AGAIN)
+			{
+				dnsCache.addFailed(domain);
+			}
 			this->disconnect();
 			return false;
 		}
-		lock.release();
+		if (domain.toString() != "")
+		{
+			dnsCache.add(domain, __getInfoHosts(*info));
+		}
 		this->socketInfo->ai_family = (*info)->ai_family;
 		this->socketInfo->ai_socktype = (*info)->ai_socktype;
 		this->socketInfo->ai_protocol = (*info)->ai_protocol;
@@ -246,6 +415,203 @@ namespace sakit
 	}
 
 	bool PlatformSocket::connect(Host remoteHost, unsigned short remotePort, Host& localHost, unsigned short& localPort, float timeout, float retryFrequency)
+	{
+		if (this->connectionLess || remoteHost.isIp())
+		{
+			return this->_connectAddress(remoteHost, remotePort, localHost, localPort, timeout);
+		}
+		// all addresses of the domain are needed so they can be raced against each other
+		harray<Host> ips;
+		DnsCache::Result cached = dnsCache.get(remoteHost, ips);
+		if (cached == DnsCache::FAILED)
+		{
+			hlog::error(logTag, "getaddrinfo() failed recently for: " + remoteHost.toString());
+			this->disconnect();
+			return false;
+		}
+		if (cached == DnsCache::MISSING)
+		{
+			bool temporaryFailure = false;
+			if (!PlatformSocket::_resolveHosts(remoteHost, ips, temporaryFailure))
+			{
+				if (!temporaryFailure)
+				{
+					dnsCache.addFailed(remoteHost);
+				}
+				this->disconnect();
+				return false;
+			}
+			dnsCache.add(remoteHost, ips);
+		}
+		return this->connect(ips, remotePort, localHost, localPort, timeout, retryFrequency);
+	}
+
+	bool PlatformSocket::connect(const harray<Host>& remoteIps, unsigned short remotePort, Host& localHost, unsigned short& localPort, float timeout, float retryFrequency)
+	{
+		if (remoteIps.size() == 0)
+		{
+			hlog::error(logTag, "Cannot connect, no remote address!");
+			return false;
+		}
+		if (remoteIps.size() == 1 || this->connectionLess)
+		{
+			return this->_connectAddress(remoteIps.first(), remotePort, localHost, localPort, timeout);
+		}
+		Host remoteIp;
+		unsigned int sock = (unsigned int)-1;
+		if (!this->_connectRacing(__interleaveFamilies(remoteIps), remotePort, timeout, remoteIp, sock))
+		{
+			this->disconnect();
+			return false;
+		}
+		// the address info has to match the socket that won
+		if (!this->setRemoteAddress(remoteIp, remotePort))
+		{
+			closesocket(sock);
+			return false;
+		}
+		this->sock = sock;
+		this->connected = true;
+		this->_setNonBlocking(false);
+		if (!this->setNagleAlgorithmActive(false))
+		{
+			return false;
+		}
+		this->_getLocalHostPort(localHost, localPort);
+		return true;
+	}
+
+	bool PlatformSocket::_connectRacing(const harray<Host>& ips, unsigned short port, float timeout, Host& remoteIp, unsigned int& sock)
+	{
+		harray<unsigned int> attempts;
+		harray<Host> attemptIps;
+		int next = 0;
+		int winner = -1;
+		int64_t start = htickCount();
+		int64_t end = start + (int64_t)(timeout * 1000.0f);
+		int64_t nextAttemptTime = start;
+		int64_t time = start;
+		int64_t wait = 0;
+		Endpoint endpoint;
+		unsigned int attempt = (unsigned int)-1;
+		int nonBlocking = 1;
+		int result = 0;
+		int error = 0;
+		socklen_t size = 0;
+		harray<pollfd> entries;
+		pollfd entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.events = POLLOUT;
+		while (winner < 0)
+		{
+			time = htickCount();
+			if (time >= end)
+			{
+				hlog::error(logTag, "Unable to connect, timed out.");
+				break;
+			}
+			// the next attempt starts when the delay has passed or all previous attempts have failed
+			if (next < ips.size() && (time >= nextAttemptTime || attempts.size() == 0))
+			{
+				endpoint = Endpoint(ips[next], port);
+				++next;
+				if (!endpoint.isValid())
+				{
+					continue;
+				}
+				attempt = (unsigned int)socket(((const sockaddr*)endpoint.getAddress())->sa_family, SOCK_STREAM, IPPROTO_TCP);
+				if (attempt == (unsigned int)-1)
+				{
+					continue;
+				}
+				ioctlsocket(attempt, FIONBIO, (unsigned long*)&nonBlocking);
+				result = ::connect(attempt, (const sockaddr*)endpoint.getAddress(), (socklen_t)endpoint.getSize());
+				if (result != 0 && !__isConnectPending())
+				{
+					// e.g. the network of this family is unreachable, the next address is tried right away
+					closesocket(attempt);
+					continue;
+				}
+				attempts += attempt;
+				attemptIps += ips[next - 1];
+				if (result == 0)
+				{
+					winner = attempts.size() - 1;
+					break;
+				}
+				nextAttemptTime = time + CONNECTION_ATTEMPT_DELAY;
+				continue;
+			}
+			if (attempts.size() == 0)
+			{
+				hlog::error(logTag, "Unable to connect to any address.");
+				break;
+			}
+			wait = end - time;
+			if (next < ips.size())
+			{
+				wait = hmin(wait, nextAttemptTime - time);
+			}
+			// poll() is used because select() can't handle descriptors above FD_SETSIZE
+			entries.clear();
+			foreach (unsigned int, it, attempts)
+			{
+				entry.fd = (*it);
+				entries += entry;
+			}
+			result = poll(&entries[0], (int)entries.size(), (int)wait);
+			if (result < 0)
+			{
+#ifndef _WIN32
+				if (errno == EINTR) // interrupted by a signal is not an error
+				{
+					continue;
+				}
+#endif
+				PlatformSocket::_printLastError("poll()");
+				break;
+			}
+			// failed attempts are removed from the entries as well so both keep the same order
+			for_iter (i, 0, entries.size())
+			{
+				if (entries[i].revents == 0)
+				{
+					continue;
+				}
+				error = 0;
+				size = sizeof(error);
+				if (getsockopt(attempts[i], SOL_SOCKET, SO_ERROR, (char*)&error, &size) == 0 && error == 0)
+				{
+					winner = i;
+					break;
+				}
+				// a failed attempt lets the next one start right away
+				closesocket(attempts[i]);
+				attempts.removeAt(i);
+				attemptIps.removeAt(i);
+				entries.removeAt(i);
+				--i;
+				nextAttemptTime = time;
+			}
+		}
+		// all other attempts are aborted
+		for_iter (i, 0, attempts.size())
+		{
+			if (i != winner)
+			{
+				closesocket(attempts[i]);
+			}
+		}
+		if (winner < 0)
+		{
+			return false;
+		}
+		remoteIp = attemptIps[winner];
+		sock = attempts[winner];
+		return true;
+	}
+
+	bool PlatformSocket::_connectAddress(Host remoteHost, unsigned short remotePort, Host& localHost, unsigned short& localPort, float timeout)
 	{
 		if (!this->setRemoteAddress(remoteHost, remotePort))
 		{
@@ -263,6 +629,21 @@ namespace sakit
 		{
 			return false;
 		}
+#ifdef _SAKIT_IO_URING
+		// connecting is finished before this returns so a borrowed ring is used instead of creating one for every socket
+		IoUring* ring = (this->_uringAvailable() ? PlatformSocket::_uringAcquire() : NULL);
+		if (ring != NULL)
+		{
+			bool result = this->_uringConnect(ring, timeout);
+			PlatformSocket::_uringRelease(ring);
+			if (!result)
+			{
+				return false;
+			}
+			this->_getLocalHostPort(localHost, localPort);
+			return true;
+		}
+#endif
 		this->_setNonBlocking(true);
 		int result = ::connect(this->sock, this->remoteInfo->ai_addr, this->remoteInfo->ai_addrlen);
 		this->_setNonBlocking(false);
@@ -273,29 +654,19 @@ namespace sakit
 				this->disconnect();
 				return false;
 			}
-			// non-blocking mode, use select to check when it finally worked
-			double sec = (double)timeout;
-			timeval interval = {0, 1};
-			interval.tv_sec = (long)sec;
-			if (sec != (int)sec)
-			{
-#ifdef __APPLE__
-				interval.tv_usec = (int)((sec - (int)sec) * 1000000);
-#else
-				interval.tv_usec = (long)((sec - (int)sec) * 1000000);
-#endif
-			}
-			fd_set writeSet;
-			FD_ZERO(&writeSet);
-			FD_SET(this->sock, &writeSet);
-			result = select(this->sock + 1, NULL, &writeSet, NULL, &interval);
+			// non-blocking mode, use poll to check when it finally worked
+			pollfd entry;
+			memset(&entry, 0, sizeof(entry));
+			entry.fd = this->sock;
+			entry.events = POLLOUT;
+			result = poll(&entry, 1, (int)(hmax(timeout, 0.0f) * 1000));
 			if (result == 0)
 			{
 				hlog::error(logTag, "Unable to connect, timed out.");
 				this->disconnect();
 				return false;
 			}
-			if (!this->_checkResult(result, "select()"))
+			if (!this->_checkResult(result, "poll()"))
 			{
 				return false;
 			}
@@ -326,6 +697,12 @@ namespace sakit
 		{
 			return false;
 		}
+		if (this->localInfo->ai_family == AF_INET6 && localHost == Host::AnyIpv6)
+		{
+			// IPv4 clients are accepted as well on dual-stack systems, their addresses are IPv4-mapped (e.g. "::ffff:127.0.0.1")
+			int ipv6Only = 0;
+			setsockopt(this->sock, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&ipv6Only, sizeof(ipv6Only));
+		}
 		// bind to host:port
 		if (!this->_checkResult(::bind(this->sock, this->localInfo->ai_addr, this->localInfo->ai_addrlen), "bind()"))
 		{
@@ -340,17 +717,17 @@ namespace sakit
 
 	void PlatformSocket::_getLocalHostPort(Host& host, unsigned short& port)
 	{
-		sockaddr_in address;
-		socklen_t addressSize = (socklen_t)sizeof(sockaddr_in);
+		sockaddr_storage address;
+		socklen_t addressSize = (socklen_t)sizeof(sockaddr_storage);
 		memset(&address, 0, addressSize);
-		address.sin_family = AF_INET;
-		address.sin_addr.s_addr = IN_ADDRT_T_TYPECAST __inet_addr(host.toString().cStr());
-		address.sin_port = __htons(port);
-		hmutex::ScopeLock lock(&mutexGetsockname);
-		getsockname(this->sock, (sockaddr*)&address, &addressSize);
-		lock.release();
-		host = Host(__inet_ntoa(address.sin_addr));
-		port = __ntohs(address.sin_port);
+		hmutex::ScopeLock lock;
+		__lockResolver(lock, mutexGetsockname);
+		int result = getsockname(this->sock, (sockaddr*)&address, &addressSize);
+		__unlockResolver(lock);
+		if (result == 0)
+		{
+			PlatformSocket::getAddressHostPort(&address, (int)addressSize, host, port);
+		}
 	}
 
 	bool PlatformSocket::joinMulticastGroup(Host interfaceHost, Host groupAddress)
@@ -400,7 +777,8 @@ namespace sakit
 			free(this->socketInfo);
 			this->socketInfo = NULL;
 		}
-		hmutex::ScopeLock lock(&mutexFreeaddrinfo);
+		hmutex::ScopeLock lock;
+		__lockResolver(lock, mutexFreeaddrinfo);
 		if (this->localInfo != NULL)
 		{
 			freeaddrinfo(this->localInfo);
@@ -411,12 +789,21 @@ namespace sakit
 			freeaddrinfo(this->remoteInfo);
 			this->remoteInfo = NULL;
 		}
-		lock.release();
+		__unlockResolver(lock);
 		if (this->address != NULL)
 		{
 			free(this->address);
 			this->address = NULL;
 		}
+#ifdef _SAKIT_IO_URING
+		// pending operations have to be canceled while the socket is still open
+		if (this->ring != NULL)
+		{
+			delete this->ring;
+			this->ring = NULL;
+		}
+		this->uringFailed = false;
+#endif
 		if (this->sock != (unsigned int)-1)
 		{
 			closesocket(this->sock);
@@ -434,7 +821,7 @@ namespace sakit
 		int result = 0;
 		if (!this->connectionLess)
 		{
-			result = (int)::send(this->sock, data, size, 0);
+			result = (int)::send(this->sock, data, size, SEND_FLAGS);
 		}
 		else if (this->remoteInfo != NULL)
 		{
@@ -458,104 +845,693 @@ namespace sakit
 		return false;
 	}
 
-	bool PlatformSocket::receive(hstream* stream, hmutex& mutex, int& maxBytes)
+	bool PlatformSocket::send(harray<Span>& spans, int& sent)
 	{
-		unsigned long received = 0;
-		if (!this->_checkReceivedBytes(&received))
+		int count = hmin(spans.size(), MAX_SEND_SPANS);
+		sockaddr* address = NULL;
+		int addressSize = 0;
+		if (this->connectionLess && !this->_getRemoteAddress(&address, &addressSize))
 		{
 			return false;
 		}
-		if (received == 0)
+		int result = 0;
+#ifdef _WIN32
+		WSABUF buffers[MAX_SEND_SPANS];
+		for_iter (i, 0, count)
 		{
-			return true;
+			buffers[i].buf = (char*)spans[i].data;
+			buffers[i].len = (ULONG)spans[i].size;
 		}
-		int read = hmin((int)received, this->bufferSize);
-		if (maxBytes > 0) // if don't read everything
+		DWORD written = 0;
+		result = WSASendTo(this->sock, buffers, (DWORD)count, &written, 0, address, addressSize, NULL, NULL);
+		if (result == 0)
 		{
-			read = hmin(read, maxBytes);
+			result = (int)written;
 		}
-		read = (int)recv(this->sock, this->receiveBuffer, read, 0);
-		if (!this->_checkResult(read, "recv()", false))
+#else
+		iovec buffers[MAX_SEND_SPANS];
+		for_iter (i, 0, count)
 		{
-			return false;
+			buffers[i].iov_base = (void*)spans[i].data;
+			buffers[i].iov_len = (size_t)spans[i].size;
 		}
-		hmutex::ScopeLock lock(&mutex);
-		stream->writeRaw(this->receiveBuffer, read);
-		lock.release();
-		if (maxBytes > 0) // if don't read everything
+		msghdr message;
+		memset(&message, 0, sizeof(message));
+		message.msg_name = address;
+		message.msg_namelen = addressSize;
+		message.msg_iov = buffers;
+		message.msg_iovlen = count;
+		result = (int)sendmsg(this->sock, &message, SEND_FLAGS);
+#endif
+		if (result < 0)
 		{
-			maxBytes -= read;
+			return false;
 		}
+		sent += result;
+		PlatformSocket::_advanceSpans(spans, result);
 		return true;
 	}
 
-	bool PlatformSocket::receiveFrom(hstream* stream, Host& remoteHost, unsigned short& remotePort)
+	bool PlatformSocket::sendFile(FileTransfer* transfer, int& sent)
 	{
-		unsigned long received = 0;
-		if (!this->_checkReceivedBytes(&received))
-		{
-			return false;
-		}
-		if (received == 0)
+		int size = (int)hmin(transfer->remaining, (int64_t)MAX_SEND_FILE_SIZE);
+		if (size == 0)
 		{
 			return true;
 		}
-		int read = hmin((int)received, this->bufferSize);
-		sockaddr_storage address;
-		socklen_t size = (socklen_t)sizeof(sockaddr_storage);
-		this->_setNonBlocking(true);
-		read = (int)recvfrom(this->sock, this->receiveBuffer, read, 0, (sockaddr*)&address, &size);
-		if (!this->_checkResult(read, "recvfrom()"))
+		int result = 0;
+#if defined(_SAKIT_SENDFILE)
+		off_t offset = (off_t)transfer->offset;
+		result = (int)sendfile(this->sock, transfer->descriptor, &offset, (size_t)size);
+#elif defined(_SAKIT_MMAP_SEND)
+		result = (int)::send(this->sock, (const char*)transfer->data, size, SEND_FLAGS);
+#else
+		size = hmin(size, this->bufferSize);
+		char* buffer = bufferPool.acquire(size);
+		int read = transfer->_read((unsigned char*)buffer, size);
+		result = (read > 0 ? (int)::send(this->sock, buffer, read, SEND_FLAGS) : -1);
+		bufferPool.release(buffer, size);
+#endif
+		if (result < 0)
 		{
-			this->_setNonBlocking(false);
+			PlatformSocket::_printLastError("sendfile()");
 			return false;
 		}
-		this->_setNonBlocking(false);
-		if (read > 0)
+		if (result == 0)
 		{
-			stream->writeRaw(this->receiveBuffer, read);
-			// get the IP and port of the connected client
-			char hostString[NI_MAXHOST] = {'\0'};
-			char portString[NI_MAXSERV] = {'\0'};
-			hmutex::ScopeLock lock(&mutexGetnameinfo);
-			getnameinfo((sockaddr*)&address, size, hostString, NI_MAXHOST, portString, NI_MAXSERV, NI_NUMERICHOST | NI_NUMERICSERV);
-			lock.release();
-			remoteHost = Host(hostString);
-			remotePort = (unsigned short)(int)hstr(portString);
+			hlog::error(logTag, "The file ended before everything was sent!");
+			return false;
 		}
+		transfer->advance(result);
+		sent += result;
 		return true;
 	}
 
-	bool PlatformSocket::_checkReceivedBytes(unsigned long* received)
+	bool PlatformSocket::sendBatch(harray<OutgoingDatagram>& datagrams, int& sent)
 	{
-#ifndef _WIN32 // Unix requires a select() call before using ioctl/ioctlsocket
-		timeval interval = {0, 1};
-		fd_set readSet;
-		FD_ZERO(&readSet);
-		FD_SET(this->sock, &readSet);
-		int result = select(this->sock + 1, &readSet, NULL, NULL, &interval);
-		if (!this->_checkResult(result, "select()"))
-		{
-			return false;
-		}
-		if (result == 0)
-		{
-			return true;
-		}
+		sockaddr_storage addresses[MAX_SEND_BATCH];
+		int addressSizes[MAX_SEND_BATCH];
+		sockaddr* address = NULL;
+		int addressSize = 0;
+		int count = 0;
+		int result = 0;
+		OutgoingDatagram* datagram = NULL;
+		OutgoingDatagram* previous = NULL;
+#ifdef _SAKIT_SENDMMSG
+		mmsghdr messages[MAX_SEND_BATCH];
+		iovec vectors[MAX_SEND_BATCH];
 #endif
-		// control socket IO
-		return this->_checkResult(ioctlsocket(this->sock, FIONREAD, (unsigned long*)received), "ioctlsocket()", false);
-	}
-
-	bool PlatformSocket::listen()
-	{
-		return this->_checkResult(::listen(this->sock, SOMAXCONN), "listen()", false);
-	}
-
-	bool PlatformSocket::accept(Socket* socket)
-	{
-		PlatformSocket* other = socket->socket;
-		socklen_t size = (socklen_t)sizeof(sockaddr_storage);
+		while (sent < datagrams.size())
+		{
+			count = hmin(datagrams.size() - sent, MAX_SEND_BATCH);
+			for_iter (i, 0, count)
+			{
+				datagram = &datagrams[sent + i];
+				if (datagram->hasRemoteHost())
+				{
+					// bursts to the same destination resolve the address only once, previous is only set if it's the datagram right before this one
+					if (previous != NULL && previous->getRemoteHost() == datagram->getRemoteHost() && previous->getRemotePort() == datagram->getRemotePort())
+					{
+						addresses[i] = addresses[i - 1];
+						addressSizes[i] = addressSizes[i - 1];
+					}
+					else if (!this->_resolveAddress(datagram->getRemoteHost(), datagram->getRemotePort(), &addresses[i], &addressSizes[i]))
+					{
+						return false;
+					}
+					previous = datagram;
+					continue;
+				}
+				previous = NULL;
+				if (!this->_getRemoteAddress(&address, &addressSize))
+				{
+					return false;
+				}
+				memcpy(&addresses[i], address, addressSize);
+				addressSizes[i] = addressSize;
+			}
+			previous = NULL;
+#ifdef _SAKIT_SENDMMSG
+			memset(messages, 0, sizeof(mmsghdr) * count);
+			for_iter (i, 0, count)
+			{
+				datagram = &datagrams[sent + i];
+				vectors[i].iov_base = (void*)datagram->getData();
+				vectors[i].iov_len = (size_t)datagram->getSize();
+				messages[i].msg_hdr.msg_iov = &vectors[i];
+				messages[i].msg_hdr.msg_iovlen = 1;
+				messages[i].msg_hdr.msg_name = &addresses[i];
+				messages[i].msg_hdr.msg_namelen = addressSizes[i];
+			}
+			result = sendmmsg(this->sock, messages, (unsigned int)count, 0);
+			if (result < 0)
+			{
+				PlatformSocket::_printLastError("sendmmsg()");
+				return false;
+			}
+			sent += result;
+#else
+			for_iter (i, 0, count)
+			{
+				datagram = &datagrams[sent];
+				result = (int)::sendto(this->sock, (const char*)datagram->getData(), datagram->getSize(), 0, (sockaddr*)&addresses[i], addressSizes[i]);
+				if (result < 0)
+				{
+					PlatformSocket::_printLastError("sendto()");
+					return false;
+				}
+				++sent;
+			}
+#endif
+		}
+		return true;
+	}
+
+	bool PlatformSocket::sendSegmented(const unsigned char* data, int size, int segmentSize, int& sent)
+	{
+		sockaddr* address = NULL;
+		int addressSize = 0;
+		if (!this->_getRemoteAddress(&address, &addressSize))
+		{
+			return false;
+		}
+		int count = 0;
+		int result = 0;
+#ifdef _SAKIT_UDP_SEGMENT
+		if (this->segmentationSupported)
+		{
+			iovec vector;
+			msghdr message;
+			char control[CMSG_SPACE(sizeof(uint16_t))];
+			cmsghdr* header = NULL;
+			// the kernel splits the data into datagrams so one call sends up to 64 of them
+			int chunkSize = hmin(segmentSize * MAX_SEGMENT_COUNT, MAX_SEGMENTED_SIZE / segmentSize * segmentSize);
+			while (sent < size)
+			{
+				count = hmin(size - sent, chunkSize);
+				vector.iov_base = (void*)&data[sent];
+				vector.iov_len = (size_t)count;
+				memset(&message, 0, sizeof(message));
+				message.msg_name = address;
+				message.msg_namelen = addressSize;
+				message.msg_iov = &vector;
+				message.msg_iovlen = 1;
+				if (count > segmentSize)
+				{
+					memset(control, 0, sizeof(control));
+					message.msg_control = control;
+					message.msg_controllen = sizeof(control);
+					header = CMSG_FIRSTHDR(&message);
+					header->cmsg_level = SOL_UDP;
+					header->cmsg_type = UDP_SEGMENT;
+					header->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+					*(uint16_t*)CMSG_DATA(header) = (uint16_t)segmentSize;
+				}
+				result = (int)sendmsg(this->sock, &message, SEND_FLAGS);
+				if (result < 0)
+				{
+					// older kernels and some network devices can't segment so every datagram is sent on its own from now on
+					if (sent == 0 && (errno == EINVAL || errno == EIO || errno == ENOPROTOOPT))
+					{
+						this->segmentationSupported = false;
+						break;
+					}
+					PlatformSocket::_printLastError("sendmsg()");
+					return false;
+				}
+				sent += result;
+			}
+			if (this->segmentationSupported)
+			{
+				return true;
+			}
+		}
+#endif
+		while (sent < size)
+		{
+			count = hmin(size - sent, segmentSize);
+			result = (int)::sendto(this->sock, (const char*)&data[sent], count, 0, address, addressSize);
+			if (result < 0)
+			{
+				PlatformSocket::_printLastError("sendto()");
+				return false;
+			}
+			sent += result;
+		}
+		return true;
+	}
+
+	bool PlatformSocket::_getRemoteAddress(sockaddr** address, int* size)
+	{
+		if (this->remoteInfo != NULL)
+		{
+			*address = this->remoteInfo->ai_addr;
+			*size = (int)this->remoteInfo->ai_addrlen;
+			return true;
+		}
+		if (this->address != NULL)
+		{
+			*address = (sockaddr*)this->address;
+			*size = (int)sizeof(*this->address);
+			return true;
+		}
+		hlog::warn(logTag, "Trying to send without a remote host!");
+		return false;
+	}
+
+	bool PlatformSocket::_resolveAddress(Host host, unsigned short port, sockaddr_storage* address, int* size)
+	{
+		addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_DGRAM;
+		hints.ai_flags = (host.isIp() ? AI_NUMERICHOST : 0);
+		addrinfo* info = NULL;
+		hmutex::ScopeLock lock;
+		__lockResolver(lock, mutexGetaddrinfo);
+		int result = getaddrinfo(host.toString().cStr(), hstr(port).cStr(), &hints, &info);
+		__unlockResolver(lock);
+		if (result != 0)
+		{
+			hlog::error(logTag, "getaddrinfo() " + __gai_strerror(result));
+			return false;
+		}
+		memcpy(address, info->ai_addr, info->ai_addrlen);
+		*size = (int)info->ai_addrlen;
+		__lockResolver(lock, mutexFreeaddrinfo);
+		freeaddrinfo(info);
+		return true;
+	}
+
+	bool PlatformSocket::receive(hstream* stream, hmutex& mutex, int& maxBytes)
+	{
+#ifdef _SAKIT_IO_URING
+		if (this->_uringPrepare())
+		{
+			this->_acquireBuffer();
+			return this->_uringReceive(stream, NULL, mutex, maxBytes);
+		}
+#endif
+		unsigned long received = 0;
+		if (!this->_checkReceivedBytes(&received))
+		{
+			return false;
+		}
+		if (received == 0)
+		{
+			return true;
+		}
+		this->_acquireBuffer();
+		int read = hmin((int)received, this->bufferSize);
+		if (maxBytes > 0) // if don't read everything
+		{
+			read = hmin(read, maxBytes);
+		}
+		read = (int)recv(this->sock, this->receiveBuffer, read, 0);
+		if (!this->_checkResult(read, "recv()", false))
+		{
+			return false;
+		}
+		hmutex::ScopeLock lock(&mutex);
+		stream->writeRaw(this->receiveBuffer, read);
+		lock.release();
+		if (maxBytes > 0) // if don't read everything
+		{
+			maxBytes -= read;
+		}
+		return true;
+	}
+
+	bool PlatformSocket::receive(unsigned char* data, int size, int& read)
+	{
+		read = 0;
+#ifdef _SAKIT_IO_URING
+		if (this->_uringPrepare())
+		{
+			this->_acquireBuffer();
+			hmutex mutex;
+			int remaining = size;
+			bool result = this->_uringReceive(NULL, data, mutex, remaining);
+			read = size - remaining;
+			return result;
+		}
+#endif
+		unsigned long received = 0;
+		if (!this->_checkReceivedBytes(&received))
+		{
+			return false;
+		}
+		if (received == 0)
+		{
+			return true;
+		}
+		int result = (int)recv(this->sock, (char*)data, hmin((int)received, size), 0);
+		if (!this->_checkResult(result, "recv()", false))
+		{
+			return false;
+		}
+		read = result;
+		return true;
+	}
+
+	bool PlatformSocket::receiveFrom(hstream* stream, Endpoint& remoteEndpoint)
+	{
+#ifdef _SAKIT_IO_URING
+		if (this->_uringPrepare())
+		{
+			this->_acquireBuffer();
+			return this->_uringReceiveFrom(stream, remoteEndpoint);
+		}
+#endif
+		unsigned long received = 0;
+		if (!this->_checkReceivedBytes(&received))
+		{
+			return false;
+		}
+		if (received == 0)
+		{
+			return true;
+		}
+		this->_acquireBuffer();
+		int read = hmin((int)received, this->bufferSize);
+		sockaddr_storage address;
+		socklen_t size = (socklen_t)sizeof(sockaddr_storage);
+		this->_setNonBlocking(true);
+		read = (int)recvfrom(this->sock, this->receiveBuffer, read, 0, (sockaddr*)&address, &size);
+		if (!this->_checkResult(read, "recvfrom()"))
+		{
+			this->_setNonBlocking(false);
+			return false;
+		}
+		this->_setNonBlocking(false);
+		if (read > 0)
+		{
+			stream->writeRaw(this->receiveBuffer, read);
+			// the address of the client is only formatted when the endpoint is asked for it
+			remoteEndpoint = Endpoint(&address, (int)size);
+		}
+		return true;
+	}
+
+	bool PlatformSocket::receiveBatch(DatagramBatch* batch, int maxCount)
+	{
+		batch->count = 0;
+		int capacity = (maxCount > 0 ? hmin(batch->capacity, maxCount) : batch->capacity);
+		int count = 0;
+		int result = 0;
+#ifdef _SAKIT_RECVMMSG
+		mmsghdr messages[MAX_RECEIVE_BATCH];
+		iovec vectors[MAX_RECEIVE_BATCH];
+		int index = 0;
+		while (batch->count < capacity)
+		{
+			count = hmin(capacity - batch->count, MAX_RECEIVE_BATCH);
+			memset(messages, 0, sizeof(mmsghdr) * count);
+			for_iter (i, 0, count)
+			{
+				index = batch->count + i;
+				vectors[i].iov_base = &batch->data[index * batch->datagramSize];
+				vectors[i].iov_len = (size_t)batch->datagramSize;
+				messages[i].msg_hdr.msg_iov = &vectors[i];
+				messages[i].msg_hdr.msg_iovlen = 1;
+				messages[i].msg_hdr.msg_name = &batch->addresses[index * PlatformSocket::AddressSize];
+				messages[i].msg_hdr.msg_namelen = (socklen_t)PlatformSocket::AddressSize;
+			}
+			// all datagrams that are already queued are taken with one call, without waiting for more
+			result = recvmmsg(this->sock, messages, (unsigned int)count, MSG_DONTWAIT, NULL);
+			if (result < 0)
+			{
+				if (errno == EAGAIN || errno == EINTR)
+				{
+					break;
+				}
+				PlatformSocket::_printLastError("recvmmsg()");
+				return (batch->count > 0);
+			}
+			for_iter (i, 0, result)
+			{
+				index = batch->count + i;
+				batch->sizes[index] = (int)messages[i].msg_len;
+				batch->truncated[index] = ((messages[i].msg_hdr.msg_flags & MSG_TRUNC) != 0);
+				batch->addressSizes[index] = (int)messages[i].msg_hdr.msg_namelen;
+			}
+			batch->count += result;
+			if (result < count)
+			{
+				break;
+			}
+		}
+#else
+		unsigned char* address = NULL;
+		socklen_t addressSize = 0;
+		bool truncated = false;
+		bool failed = false;
+#ifdef _WIN32
+		this->_setNonBlocking(true);
+#endif
+		while (batch->count < capacity)
+		{
+			count = batch->count;
+			address = &batch->addresses[count * PlatformSocket::AddressSize];
+			addressSize = (socklen_t)PlatformSocket::AddressSize;
+			truncated = false;
+#ifdef _WIN32
+			result = (int)recvfrom(this->sock, (char*)&batch->data[count * batch->datagramSize], batch->datagramSize, 0, (sockaddr*)address, &addressSize);
+			if (result < 0 && WSAGetLastError() == WSAEMSGSIZE)
+			{
+				result = batch->datagramSize;
+				truncated = true;
+			}
+			if (result < 0 && WSAGetLastError() == WSAEWOULDBLOCK)
+			{
+				break;
+			}
+#else
+			iovec vector;
+			vector.iov_base = &batch->data[count * batch->datagramSize];
+			vector.iov_len = (size_t)batch->datagramSize;
+			msghdr message;
+			memset(&message, 0, sizeof(message));
+			message.msg_iov = &vector;
+			message.msg_iovlen = 1;
+			message.msg_name = address;
+			message.msg_namelen = addressSize;
+			result = (int)recvmsg(this->sock, &message, MSG_DONTWAIT);
+			if (result < 0 && (errno == EAGAIN || errno == EINTR))
+			{
+				break;
+			}
+			truncated = ((message.msg_flags & MSG_TRUNC) != 0);
+			addressSize = message.msg_namelen;
+#endif
+			if (result < 0)
+			{
+				PlatformSocket::_printLastError("recvmsg()");
+				failed = (batch->count == 0);
+				break;
+			}
+			batch->sizes[count] = result;
+			batch->truncated[count] = truncated;
+			batch->addressSizes[count] = (int)addressSize;
+			++batch->count;
+		}
+#ifdef _WIN32
+		this->_setNonBlocking(false);
+#endif
+		if (failed)
+		{
+			return false;
+		}
+#endif
+		return true;
+	}
+
+	void PlatformSocket::getAddressHostPort(const void* address, int size, Host& host, unsigned short& port)
+	{
+		if (((const sockaddr*)address)->sa_family == AF_INET)
+		{
+			// IPv4 is formatted directly, without going through the service name conversion
+			const sockaddr_in* address4 = (const sockaddr_in*)address;
+			const unsigned char* bytes = (const unsigned char*)&address4->sin_addr;
+			host = Host(bytes[0], bytes[1], bytes[2], bytes[3]);
+			port = __ntohs(address4->sin_port);
+			return;
+		}
+		char hostString[NI_MAXHOST] = {'\0'};
+		char portString[NI_MAXSERV] = {'\0'};
+		hmutex::ScopeLock lock;
+		__lockResolver(lock, mutexGetnameinfo);
+		getnameinfo((const sockaddr*)address, (socklen_t)size, hostString, NI_MAXHOST, portString, NI_MAXSERV, NI_NUMERICHOST | NI_NUMERICSERV);
+		__unlockResolver(lock);
+		host = Host(hostString);
+		port = (unsigned short)(int)hstr(portString);
+	}
+
+	unsigned short PlatformSocket::getAddressPort(const void* address, int size)
+	{
+		switch (((const sockaddr*)address)->sa_family)
+		{
+		case AF_INET:	return __ntohs(((const sockaddr_in*)address)->sin_port);
+		case AF_INET6:	return __ntohs(((const sockaddr_in6*)address)->sin6_port);
+		default:		break;
+		}
+		return 0;
+	}
+
+	bool PlatformSocket::makeAddress(Host host, unsigned short port, void* address, int& size)
+	{
+		unsigned char bytes[4];
+		if (host.getIpBytes(bytes))
+		{
+			sockaddr_in* address4 = (sockaddr_in*)address;
+			memset(address4, 0, sizeof(sockaddr_in));
+#ifdef __APPLE__
+			address4->sin_len = sizeof(sockaddr_in);
+#endif
+			address4->sin_family = AF_INET;
+			address4->sin_port = __htons(port);
+			memcpy(&address4->sin_addr, bytes, 4);
+			size = (int)sizeof(sockaddr_in);
+			return true;
+		}
+		unsigned char bytes6[16];
+		if (host.getIpv6Bytes(bytes6))
+		{
+			sockaddr_in6* address6 = (sockaddr_in6*)address;
+			memset(address6, 0, sizeof(sockaddr_in6));
+#ifdef __APPLE__
+			address6->sin6_len = sizeof(sockaddr_in6);
+#endif
+			address6->sin6_family = AF_INET6;
+			address6->sin6_port = __htons(port);
+			memcpy(&address6->sin6_addr, bytes6, 16);
+			// link-local addresses need the interface, e.g. "fe80::1%eth0"
+			hstr scope = host.toString();
+			int index = scope.indexOf('%');
+			if (index >= 0)
+			{
+				scope = scope(index + 1, -1);
+#ifndef _WIN32
+				address6->sin6_scope_id = (scope.isNumber() ? (unsigned int)scope : if_nametoindex(scope.cStr()));
+#else
+				address6->sin6_scope_id = (unsigned int)scope;
+#endif
+			}
+			size = (int)sizeof(sockaddr_in6);
+			return true;
+		}
+		size = 0;
+		return false;
+	}
+
+	bool PlatformSocket::_checkReceivedBytes(unsigned long* received)
+	{
+#ifndef _WIN32 // Unix requires a poll() call before using ioctl/ioctlsocket
+		pollfd entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.fd = this->sock;
+		entry.events = POLLIN;
+		int result = poll(&entry, 1, 0);
+		if (!this->_checkResult(result, "poll()"))
+		{
+			return false;
+		}
+		if (result == 0)
+		{
+			return true;
+		}
+#endif
+		// control socket IO
+		if (!this->_checkResult(ioctlsocket(this->sock, FIONREAD, (unsigned long*)received), "ioctlsocket()", false))
+		{
+			return false;
+		}
+#ifndef _WIN32
+		// a stream that is readable without any data was closed by the other side
+		if (*received == 0 && !this->connectionLess)
+		{
+			this->disconnect();
+			return false;
+		}
+#endif
+		return true;
+	}
+
+	bool PlatformSocket::waitReceive(float timeout)
+	{
+		int descriptor = this->_getPollDescriptor();
+		if (descriptor < 0)
+		{
+			return true;
+		}
+		// poll() is used because select() can't handle descriptors above FD_SETSIZE
+		pollfd entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.fd = descriptor;
+		entry.events = POLLIN;
+		int result = poll(&entry, 1, (int)(hmax(timeout, 0.0f) * 1000));
+		if (result < 0)
+		{
+#ifndef _WIN32
+			if (errno != EINTR) // interrupted by a signal is not an error
+#endif
+			{
+				this->_checkResult(result, "poll()", false);
+			}
+			// the following receive call reports the actual problem
+			return true;
+		}
+		return (result > 0);
+	}
+
+	bool PlatformSocket::waitReceive(const harray<PlatformSocket*>& sockets, float timeout)
+	{
+		harray<pollfd> entries;
+		pollfd entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.events = POLLIN;
+		foreachc (PlatformSocket*, it, sockets)
+		{
+			entry.fd = (*it)->_getPollDescriptor();
+			if (entry.fd < 0)
+			{
+				return true;
+			}
+			entries += entry;
+		}
+		if (entries.size() == 0)
+		{
+			return false;
+		}
+		int result = poll(&entries[0], (int)entries.size(), (int)(hmax(timeout, 0.0f) * 1000));
+		if (result < 0)
+		{
+#ifndef _WIN32
+			if (errno != EINTR) // interrupted by a signal is not an error
+#endif
+			{
+				sockets.first()->_checkResult(result, "poll()", false);
+			}
+			return true;
+		}
+		return (result > 0);
+	}
+
+	bool PlatformSocket::listen()
+	{
+		return this->_checkResult(::listen(this->sock, SOMAXCONN), "listen()", false);
+	}
+
+	bool PlatformSocket::accept(Socket* socket)
+	{
+#ifdef _SAKIT_IO_URING
+		if (this->_uringPrepare())
+		{
+			return this->_uringAccept(socket);
+		}
+#endif
+		PlatformSocket* other = socket->socket;
+		socklen_t size = (socklen_t)sizeof(sockaddr_storage);
 		other->address = (sockaddr_storage*)malloc(size);
 		this->_setNonBlocking(true);
 		other->sock = ::accept(this->sock, (sockaddr*)other->address, &size);
@@ -565,12 +1541,16 @@ namespace sakit
 			return false;
 		}
 		this->_setNonBlocking(false);
+		other->_setNoSigPipe();
+		// like with connected sockets, small responses are sent right away instead of waiting for the acknowledgement of earlier ones
+		other->setNagleAlgorithmActive(false);
 		// get the IP and port of the connected client
 		char hostString[NI_MAXHOST] = {'\0'};
 		char portString[NI_MAXSERV] = {'\0'};
-		hmutex::ScopeLock lock(&mutexGetnameinfo);
+		hmutex::ScopeLock lock;
+		__lockResolver(lock, mutexGetnameinfo);
 		getnameinfo((sockaddr*)other->address, size, hostString, NI_MAXHOST, portString, NI_MAXSERV, NI_NUMERICHOST | NI_NUMERICSERV);
-		lock.release();
+		__unlockResolver(lock);
 		Host localHost;
 		unsigned short localPort = 0;
 		this->_getLocalHostPort(localHost, localPort);
@@ -579,6 +1559,28 @@ namespace sakit
 		return true;
 	}
 
+	int PlatformSocket::_getPollDescriptor()
+	{
+#ifdef _SAKIT_IO_URING
+		if (this->_uringPrepare())
+		{
+			// the reactor that owns the shared ring waits for the completions of attached sockets, data left over from an earlier
+			// completion and a close that is reported after the last data are available right away, waiting for the ring wouldn't report them again
+			if (this->ring->isAttached() || this->ring->pendingSize > 0 || this->ring->receiveFinished)
+			{
+				return -1;
+			}
+			if (this->connectionLess)
+			{
+				this->_acquireBuffer();
+				this->_uringArmReceiveFrom();
+			}
+			return this->ring->getFd();
+		}
+#endif
+		return (int)this->sock;
+	}
+
 	bool PlatformSocket::_checkResult(int result, chstr functionName, bool disconnectOnError)
 	{
 		if (result < 0)
@@ -614,8 +1616,15 @@ namespace sakit
 		int maxResult = 0;
 		socklen_t addrSize = sizeof(sockaddr_in);
 		Host broadcastIp;
-		HL_LAMBDA_CLASS(_adapterHosts, Host, ((NetworkAdapter const& adapter) { return adapter.getBroadcastIp(); }));
-		harray<Host> ips = adapters.mapped(&_adapterHosts::lambda);
+		harray<Host> ips;
+		foreach (NetworkAdapter, it, adapters)
+		{
+			// there is no broadcasting in IPv6
+			if ((*it).getAddress().isIpv4())
+			{
+				ips += (*it).getBroadcastIp();
+			}
+		}
 		ips.removeDuplicates(); // to avoid broadcasting on the same IP twice, just to be sure
 		foreach (Host, it, ips)
 		{
@@ -642,42 +1651,58 @@ namespace sakit
 
 	Host PlatformSocket::resolveHost(Host domain)
 	{
+		harray<Host> ips = PlatformSocket::resolveHosts(domain);
+		return (ips.size() > 0 ? ips.first() : Host());
+	}
+
+	harray<Host> PlatformSocket::resolveHosts(Host domain)
+	{
+		harray<Host> result;
+		bool temporaryFailure = false;
+		PlatformSocket::_resolveHosts(domain, result, temporaryFailure);
+		return result;
+	}
+
+	bool PlatformSocket::_resolveHosts(Host domain, harray<Host>& ips, bool& temporaryFailure)
+	{
+		ips.clear();
+		temporaryFailure = false;
 		addrinfo hints;
-		addrinfo* info;
+		addrinfo* info = NULL;
 		memset(&hints, 0, sizeof(hints));
-#ifndef _ANDROID
-		hints.ai_family = AF_INET;
-#else
-		hints.ai_family = PF_INET;
-#endif
-		hmutex::ScopeLock lock(&mutexGetaddrinfo);
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM; // otherwise every address is returned once per socket type
+		hints.ai_flags = (domain.isIp() ? AI_NUMERICHOST : 0);
+		hmutex::ScopeLock lock;
+		__lockResolver(lock, mutexGetaddrinfo);
 		int result = getaddrinfo(domain.toString().cStr(), NULL, &hints, &info);
+		__unlockResolver(lock);
 		if (result != 0)
 		{
-			hlog::error(logTag, __gai_strerror(result));
-			return Host();
+			hlog::error(logTag, "getaddrinfo() " + __gai_strerror(result));
+			temporaryFailure = (result == EAI_AGAIN);
+			return false;
 		}
-		lock.release();
-		in_addr address;
-		address.s_addr = ((sockaddr_in*)(info->ai_addr))->sin_addr.s_addr;
-		lock.acquire(&mutexFreeaddrinfo);
+		ips = __getInfoHosts(info);
+		__lockResolver(lock, mutexFreeaddrinfo);
 		freeaddrinfo(info);
-		lock.release();
-		return Host(__inet_ntoa(address));
+		__unlockResolver(lock);
+		return (ips.size() > 0);
 	}
 
 	Host PlatformSocket::resolveIp(Host ip)
 	{
-		sockaddr_in address;
-#ifndef _ANDROID
-		address.sin_family = AF_INET;
-#else
-		address.sin_family = PF_INET;
-#endif
-		__inet_pton(address.sin_family, ip.toString().cStr(), &address.sin_addr);
+		sockaddr_storage address;
+		int size = 0;
+		if (!PlatformSocket::makeAddress(ip, 0, &address, size))
+		{
+			hlog::error(logTag, "Cannot resolve, not an IP address: " + ip.toString());
+			return Host();
+		}
 		char hostName[NI_MAXHOST] = {'\0'};
-		hmutex::ScopeLock lock(&mutexGetnameinfo);
-		int result = getnameinfo((sockaddr*)&address, sizeof(address), hostName, sizeof(hostName), NULL, 0, NI_NUMERICHOST);
+		hmutex::ScopeLock lock;
+		__lockResolver(lock, mutexGetnameinfo);
+		int result = getnameinfo((sockaddr*)&address, (socklen_t)size, hostName, sizeof(hostName), NULL, 0, NI_NUMERICHOST);
 		if (result != 0)
 		{
 			hlog::error(logTag, __gai_strerror(result));
@@ -696,16 +1721,17 @@ namespace sakit
 #else
 		hints.ai_family = PF_INET;
 #endif
-		hmutex::ScopeLock lock(&mutexGetaddrinfo);
+		hmutex::ScopeLock lock;
+		__lockResolver(lock, mutexGetaddrinfo);
 		int result = getaddrinfo(NULL, serviceName.cStr(), &hints, &info);
 		if (result != 0)
 		{
 			hlog::error(logTag, __gai_strerror(result));
 			return 0;
 		}
-		lock.release();
+		__unlockResolver(lock);
 		unsigned short port = ((sockaddr_in*)(info->ai_addr))->sin_port;
-		lock.acquire(&mutexFreeaddrinfo);
+		__lockResolver(lock, mutexFreeaddrinfo);
 		freeaddrinfo(info);
 		return port;
 	}
@@ -791,6 +1817,8 @@ namespace sakit
 		int family;
 		Host host;
 		Host mask;
+		unsigned short port = 0;
+		sockaddr_in6 maskAddress;
 		Host gateway;
 		hstr name;
 		hstr description;
@@ -802,7 +1830,23 @@ namespace sakit
 				if (ifa->ifa_addr != NULL)
 				{
 					family = ifa->ifa_addr->sa_family;
-					if (family == AF_INET)// || family == AF_INET6) // sakit only supports IPV4 for now
+					if (family == AF_INET6)
+					{
+						PlatformSocket::getAddressHostPort(ifa->ifa_addr, (int)sizeof(sockaddr_in6), host, port);
+						mask = Host();
+						if (ifa->ifa_netmask != NULL)
+						{
+							// the family of the mask isn't always set
+							memcpy(&maskAddress, ifa->ifa_netmask, sizeof(sockaddr_in6));
+							maskAddress.sin6_family = AF_INET6;
+							maskAddress.sin6_scope_id = 0;
+							PlatformSocket::getAddressHostPort(&maskAddress, (int)sizeof(sockaddr_in6), mask, port);
+						}
+						name = ifa->ifa_name;
+						description = name + " network adapter";
+						result += NetworkAdapter(0, 0, name, description, type, host, mask, "");
+					}
+					else if (family == AF_INET)
 					{
 						host = __inet_ntoa(((sockaddr_in*)ifa->ifa_addr)->sin_addr);
 						mask = __inet_ntoa(((sockaddr_in*)ifa->ifa_netmask)->sin_addr);
@@ -12,6 +12,8 @@
 #include <hltypes/hstring.h>
 
 #include "Base.h"
+#include "Endpoint.h"
+#include "FileTransfer.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "Socket.h"
@@ -29,6 +31,8 @@ namespace sakit
 	extern harray<Base*> connections;
 	extern hmutex connectionsMutex;
 	extern int bufferSize;
+	// datagrams are delivered with host names instead of raw addresses
+	const int PlatformSocket::AddressSize = 0;
 
 	void PlatformSocket::platformInit()
 	{
@@ -38,14 +42,13 @@ namespace sakit
 	{
 	}
 
-	PlatformSocket::PlatformSocket() : connected(false), connectionLess(false), serverMode(false)
+	PlatformSocket::PlatformSocket() : connected(false), connectionLess(false), serverMode(false), owner(NULL)
 	{
 		this->sSock = nullptr;
 		this->dSock = nullptr;
 		this->sServer = nullptr;
 		this->bufferSize = sakit::bufferSize;
-		this->receiveBuffer = new char[this->bufferSize];
-		memset(this->receiveBuffer, 0, this->bufferSize);
+		this->receiveBuffer = NULL; // data is read into WinRT buffers
 	}
 
 	bool PlatformSocket::_awaitAsync(State& result, hmutex& mutex, hmutex::ScopeLock& lock)
@@ -202,6 +205,19 @@ namespace sakit
 		return _asyncResult;
 	}
 
+	bool PlatformSocket::connect(const harray<Host>& remoteIps, unsigned short remotePort, Host& localHost, unsigned short& localPort, float timeout, float retryFrequency)
+	{
+		// StreamSocket already races the addresses of domains, so IPs are only tried one after another here
+		for_iter (i, 0, remoteIps.size())
+		{
+			if (this->connect(remoteIps[i], remotePort, localHost, localPort, timeout, retryFrequency))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	bool PlatformSocket::_setUdpHost(HostName^ hostName, unsigned short remotePort)
 	{
 		// open socket
@@ -457,6 +473,95 @@ namespace sakit
 		return _asyncResult;
 	}
 
+	bool PlatformSocket::send(harray<Span>& spans, int& sent)
+	{
+		// WinRT needs the data in its own buffer so the spans have to be joined anyway
+		hstream stream;
+		foreach (Span, it, spans)
+		{
+			stream.writeRaw((*it).data, (*it).size);
+		}
+		stream.rewind();
+		int count = (int)stream.size();
+		int result = 0;
+		if (!this->send(&stream, count, result))
+		{
+			return false;
+		}
+		sent += result;
+		PlatformSocket::_advanceSpans(spans, result);
+		return true;
+	}
+
+	bool PlatformSocket::sendBatch(harray<OutgoingDatagram>& datagrams, int& sent)
+	{
+		// WinRT has no batched sending so the output stream is switched for each destination
+		IOutputStream^ udpStream = this->udpStream;
+		HostName^ hostName = nullptr;
+		OutgoingDatagram* datagram = NULL;
+		OutgoingDatagram* previous = NULL;
+		hstream stream;
+		int count = 0;
+		int result = 0;
+		bool success = true;
+		while (sent < datagrams.size())
+		{
+			datagram = &datagrams[sent];
+			if (datagram->hasRemoteHost())
+			{
+				if (previous == NULL || previous->getRemoteHost() != datagram->getRemoteHost() || previous->getRemotePort() != datagram->getRemotePort())
+				{
+					hostName = PlatformSocket::_makeHostName(datagram->getRemoteHost());
+					if (hostName == nullptr || !this->_setUdpHost(hostName, datagram->getRemotePort()))
+					{
+						success = false;
+						break;
+					}
+				}
+				previous = datagram;
+			}
+			else
+			{
+				this->udpStream = udpStream;
+				previous = NULL;
+			}
+			stream.clear();
+			stream.writeRaw(datagram->getData(), datagram->getSize());
+			stream.rewind();
+			count = datagram->getSize();
+			result = 0;
+			if (!this->send(&stream, count, result))
+			{
+				success = false;
+				break;
+			}
+			++sent;
+		}
+		this->udpStream = udpStream;
+		return success;
+	}
+
+	bool PlatformSocket::sendSegmented(const unsigned char* data, int size, int segmentSize, int& sent)
+	{
+		hstream stream;
+		int count = 0;
+		int result = 0;
+		while (sent < size)
+		{
+			count = hmin(size - sent, segmentSize);
+			stream.clear();
+			stream.writeRaw(&data[sent], count);
+			stream.rewind();
+			result = 0;
+			if (!this->send(&stream, count, result))
+			{
+				return false;
+			}
+			sent += result;
+		}
+		return true;
+	}
+
 	bool PlatformSocket::receive(hstream* stream, hmutex& mutex, int& count)
 	{
 		if (this->sSock != nullptr)
@@ -466,6 +571,60 @@ namespace sakit
 		return false;
 	}
 
+	bool PlatformSocket::sendFile(FileTransfer* transfer, int& sent)
+	{
+		int size = (int)hmin(transfer->remaining, (int64_t)this->bufferSize);
+		if (size == 0)
+		{
+			return true;
+		}
+		// WinRT needs the data in its own buffer so the file is read in chunks
+		unsigned char* buffer = new unsigned char[size];
+		int read = transfer->_read(buffer, size);
+		hstream stream;
+		stream.writeRaw(buffer, read);
+		delete [] buffer;
+		stream.rewind();
+		int result = 0;
+		if (read <= 0 || !this->send(&stream, read, result))
+		{
+			return false;
+		}
+		transfer->advance(result);
+		sent += result;
+		return true;
+	}
+
+	bool PlatformSocket::receive(unsigned char* data, int size, int& read)
+	{
+		read = 0;
+		if (this->sSock == nullptr)
+		{
+			return false;
+		}
+		// WinRT delivers data in its own buffers so it has to be copied anyway
+		hstream stream;
+		hmutex mutex;
+		int count = size;
+		bool result = this->_readStream(&stream, mutex, count, this->sSock->InputStream);
+		stream.rewind();
+		read = stream.readRaw(data, (int)stream.size());
+		return result;
+	}
+
+	bool PlatformSocket::waitReceive(float timeout)
+	{
+		// data is delivered through async operations so there is no descriptor that could be waited on
+		hthread::sleep(hclamp(timeout, 0.0f, sakit::getGlobalRetryFrequency()) * 1000.0f);
+		return false;
+	}
+
+	bool PlatformSocket::waitReceive(const harray<PlatformSocket*>& sockets, float timeout)
+	{
+		hthread::sleep(hclamp(timeout, 0.0f, sakit::getGlobalRetryFrequency()) * 1000.0f);
+		return false;
+	}
+
 	bool PlatformSocket::listen()
 	{
 		hlog::error(logTag, "Server calls are not supported on WinRT due to the problematic threading and data-sharing model of WinRT.");
@@ -484,15 +643,57 @@ namespace sakit
 		// the socket is closed after this function exits so proper server code is not possible
 	}
 
-	bool PlatformSocket::receiveFrom(hstream* stream, Host& remoteHost, unsigned short& remotePort)
+	bool PlatformSocket::receiveBatch(DatagramBatch* batch, int maxCount)
+	{
+		hlog::error(logTag, "Batched receiving is not supported on WinRT.");
+		return false;
+	}
+
+	// WinRT has no socket address types so endpoints use the layout of an IPv4 sockaddr_in: family, port in network byte order, IP
+	void PlatformSocket::getAddressHostPort(const void* address, int size, Host& host, unsigned short& port)
+	{
+		const unsigned char* bytes = (const unsigned char*)address;
+		if (size < 8)
+		{
+			host = Host();
+			port = 0;
+			return;
+		}
+		host = Host(bytes[4], bytes[5], bytes[6], bytes[7]);
+		port = PlatformSocket::getAddressPort(address, size);
+	}
+
+	unsigned short PlatformSocket::getAddressPort(const void* address, int size)
+	{
+		const unsigned char* bytes = (const unsigned char*)address;
+		return (size >= 8 ? (unsigned short)((bytes[2] << 8) | bytes[3]) : 0);
+	}
+
+	bool PlatformSocket::makeAddress(Host host, unsigned short port, void* address, int& size)
+	{
+		unsigned char* bytes = (unsigned char*)address;
+		memset(bytes, 0, 16);
+		if (!host.getIpBytes(&bytes[4]))
+		{
+			size = 0;
+			return false;
+		}
+		bytes[0] = 2; // AF_INET
+		bytes[2] = (unsigned char)(port >> 8);
+		bytes[3] = (unsigned char)(port & 0xFF);
+		size = 16;
+		return true;
+	}
+
+	bool PlatformSocket::receiveFrom(hstream* stream, Endpoint& remoteEndpoint)
 	{
 		hmutex::ScopeLock _lock(&this->udpReceiver->dataMutex);
 		if (this->udpReceiver->streams.size() == 0)
 		{
 			return false;
 		}
-		remoteHost = this->udpReceiver->hosts.removeFirst();
-		remotePort = this->udpReceiver->ports.removeFirst();
+		Host remoteHost = this->udpReceiver->hosts.removeFirst();
+		unsigned short remotePort = this->udpReceiver->ports.removeFirst();
 		hstream* data = this->udpReceiver->streams.removeFirst();
 		_lock.release();
 		if (data->size() == 0)
@@ -502,6 +703,7 @@ namespace sakit
 		}
 		stream->writeRaw(*data);
 		delete data;
+		remoteEndpoint = Endpoint(remoteHost, remotePort);
 		return true;
 	}
 
@@ -619,6 +821,17 @@ namespace sakit
 		return Host(PlatformSocket::_resolve(domain.toString(), "0", true, false));
 	}
 
+	harray<Host> PlatformSocket::resolveHosts(Host domain)
+	{
+		harray<Host> result;
+		Host ip = PlatformSocket::resolveHost(domain);
+		if (ip.toString() != "")
+		{
+			result += ip;
+		}
+		return result;
+	}
+
 	Host PlatformSocket::resolveIp(Host ip)
 	{
 		// wow, Microsoft, just wow
@@ -0,0 +1,556 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#if defined(__linux__) || defined(_ANDROID)
+#define _SAKIT_EPOLL
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#include <hltypes/hlog.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hthread.h>
+
+#include "IoUring.h"
+#include "PlatformSocket.h"
+#include "ReactorThread.h"
+#include "sakit.h"
+#include "WorkerThread.h"
+
+#define MAX_EVENTS 64
+#define WAIT_TIMEOUT 1000
+
+namespace sakit
+{
+	extern IoBackend ioBackend;
+
+	ReactorThread::ReactorThread() : hthread(&process, "SAKit reactor"), pollFd(-1), wakeFd(-1), ring(NULL), current(NULL), waiting(0)
+	{
+#ifdef _SAKIT_EPOLL
+		this->pollFd = epoll_create(MAX_EVENTS);
+		if (this->pollFd < 0)
+		{
+			PlatformSocket::_printLastError("epoll_create()");
+			return;
+		}
+		this->wakeFd = eventfd(0, EFD_NONBLOCK);
+		if (this->wakeFd < 0)
+		{
+			PlatformSocket::_printLastError("eventfd()");
+			return;
+		}
+		epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.ptr = NULL; // NULL marks the wake-up descriptor
+		if (epoll_ctl(this->pollFd, EPOLL_CTL_ADD, this->wakeFd, &event) != 0)
+		{
+			PlatformSocket::_printLastError("epoll_ctl()");
+			close(this->wakeFd);
+			this->wakeFd = -1;
+			return;
+		}
+#ifdef _SAKIT_IO_URING
+		// all sockets share one ring so their operations are submitted together and their completions need only one descriptor
+		if (ioBackend == IO_BACKEND_IO_URING)
+		{
+			this->ring = PlatformSocket::_uringCreateShared();
+			if (this->ring != NULL)
+			{
+				event.data.ptr = this; // the reactor itself marks the shared ring
+				if (epoll_ctl(this->pollFd, EPOLL_CTL_ADD, this->ring->getFd(), &event) != 0)
+				{
+					PlatformSocket::_printLastError("epoll_ctl()");
+					delete this->ring;
+					this->ring = NULL;
+				}
+			}
+			if (this->ring == NULL)
+			{
+				hlog::warn(logTag, "Could not create a shared io_uring instance, the sockets of this reactor use their own.");
+			}
+		}
+#endif
+#endif
+	}
+
+	ReactorThread::~ReactorThread()
+	{
+#ifdef _SAKIT_IO_URING
+		// sockets that are still attached fall back to plain sockets
+		if (this->ring != NULL)
+		{
+			delete this->ring;
+		}
+#endif
+#ifdef _SAKIT_EPOLL
+		if (this->wakeFd >= 0)
+		{
+			close(this->wakeFd);
+		}
+		if (this->pollFd >= 0)
+		{
+			close(this->pollFd);
+		}
+#endif
+	}
+
+	bool ReactorThread::isValid()
+	{
+		return (this->pollFd >= 0 && this->wakeFd >= 0);
+	}
+
+	bool ReactorThread::isSupported()
+	{
+#ifdef _SAKIT_EPOLL
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void ReactorThread::add(WorkerThread* worker)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (!this->pending.has(worker))
+		{
+			this->pending += worker;
+		}
+		lock.release();
+		this->_wake();
+	}
+
+	void ReactorThread::cancel(WorkerThread* worker)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (!this->canceled.has(worker))
+		{
+			this->canceled += worker;
+		}
+		lock.release();
+		this->_wake();
+	}
+
+	void ReactorThread::resume(WorkerThread* worker)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		if (!this->resumed.has(worker))
+		{
+			this->resumed += worker;
+		}
+		lock.release();
+		this->_wake();
+	}
+
+	bool ReactorThread::remove(WorkerThread* worker)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		while (this->current == worker)
+		{
+			++this->waiting;
+			lock.release();
+			this->finished.wait();
+			lock.acquire(&this->mutex);
+		}
+		bool result = false;
+		if (this->pending.has(worker))
+		{
+			this->pending -= worker;
+			result = true;
+		}
+		this->canceled.tryRemove(worker);
+		this->resumed.tryRemove(worker);
+		if (this->_isRegistered(worker))
+		{
+			this->_unregister(worker);
+			result = true;
+		}
+		return result;
+	}
+
+	void ReactorThread::shutdown()
+	{
+		this->executing = false;
+		this->_wake();
+		this->join();
+	}
+
+	void ReactorThread::_wake()
+	{
+#ifdef _SAKIT_EPOLL
+		uint64_t value = 1;
+		if (write(this->wakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+		{
+			PlatformSocket::_printLastError("write()");
+		}
+#endif
+	}
+
+	void ReactorThread::_finishCurrent()
+	{
+		this->current = NULL;
+		for_iter (i, 0, this->waiting)
+		{
+			this->finished.post();
+		}
+		this->waiting = 0;
+	}
+
+	void ReactorThread::_updateQueues()
+	{
+		WorkerThread* worker = NULL;
+		bool active = false;
+		bool parked = false;
+#ifdef _SAKIT_IO_URING
+		if (this->ring != NULL)
+		{
+			this->ring->beginBatch();
+		}
+#endif
+		hmutex::ScopeLock lock(&this->mutex);
+		// newly started workers have to be registered before cancellations are handled
+		while (this->pending.size() > 0)
+		{
+			worker = this->current = this->pending.removeFirst();
+			lock.release();
+			active = (worker->_startReady() && this->_register(worker));
+			// io_uring operations have to be armed once before their completions can signal readiness
+			if (active && worker->socket->_getPollDescriptor() != (int)worker->socket->sock)
+			{
+				active = worker->_updateReady();
+			}
+			if (!active)
+			{
+				worker->_queueUpdate();
+			}
+			lock.acquire(&this->mutex);
+			if (!active && this->_isRegistered(worker))
+			{
+				this->_unregister(worker);
+			}
+			this->_finishCurrent();
+		}
+		// paused workers hand over what they couldn't before, parked ones also receive what arrived before the hangup
+		while (this->resumed.size() > 0)
+		{
+			worker = this->resumed.removeFirst();
+			if (this->_isRegistered(worker))
+			{
+				parked = (this->descriptors.hasKey(worker) && this->descriptors[worker] < 0);
+				this->current = worker;
+				lock.release();
+				active = (!parked ? worker->_updateReady() : this->_drain(worker));
+				if (!active)
+				{
+					worker->_queueUpdate();
+				}
+				lock.acquire(&this->mutex);
+				if (!active)
+				{
+					this->_unregister(worker);
+				}
+				else if (!parked && !worker->_isPaused())
+				{
+					this->_setReceiving(worker, true);
+				}
+				this->_finishCurrent();
+			}
+		}
+		while (this->canceled.size() > 0)
+		{
+			worker = this->canceled.removeFirst();
+			if (this->_isRegistered(worker))
+			{
+				this->current = worker;
+				lock.release();
+				worker->_finishReady();
+				worker->_queueUpdate();
+				lock.acquire(&this->mutex);
+				this->_unregister(worker);
+				this->_finishCurrent();
+			}
+		}
+		lock.release();
+#ifdef _SAKIT_IO_URING
+		if (this->ring != NULL)
+		{
+			this->ring->endBatch();
+		}
+#endif
+	}
+
+	void ReactorThread::_updateEvents()
+	{
+#ifdef _SAKIT_EPOLL
+		epoll_event events[MAX_EVENTS];
+		int timeout = WAIT_TIMEOUT;
+#ifdef _SAKIT_IO_URING
+		// completions that have been taken from the ring already don't make its descriptor readable again
+		if (this->ring != NULL && this->ring->hasReady())
+		{
+			timeout = 0;
+		}
+#endif
+		int count = epoll_wait(this->pollFd, events, MAX_EVENTS, timeout);
+		if (count < 0)
+		{
+			if (errno != EINTR)
+			{
+				PlatformSocket::_printLastError("epoll_wait()");
+				hthread::sleep(1.0f);
+			}
+			return;
+		}
+		WorkerThread* worker = NULL;
+		uint64_t value = 0;
+		bool active = false;
+		bool hangup = false;
+		hmutex::ScopeLock lock;
+#ifdef _SAKIT_IO_URING
+		if (this->ring != NULL)
+		{
+			this->ring->beginBatch();
+		}
+#endif
+		for_iter (i, 0, count)
+		{
+			worker = (WorkerThread*)events[i].data.ptr;
+			if (worker == NULL)
+			{
+				while (read(this->wakeFd, &value, sizeof(value)) > 0);
+				continue;
+			}
+			// the completions of the shared ring are handled after all other events
+			if (worker == (WorkerThread*)this)
+			{
+				continue;
+			}
+			lock.acquire(&this->mutex);
+			// the worker might have been removed or parked while this event was already pending
+			if (!this->descriptors.hasKey(worker) || this->descriptors[worker] < 0)
+			{
+				lock.release();
+				continue;
+			}
+			this->current = worker;
+			lock.release();
+			hangup = ((events[i].events & (EPOLLHUP | EPOLLRDHUP)) != 0);
+			active = (!hangup ? worker->_updateReady() : this->_drain(worker));
+			if (!active)
+			{
+				worker->_queueUpdate();
+			}
+			lock.acquire(&this->mutex);
+			if (!active)
+			{
+				this->_unregister(worker);
+			}
+			else if (hangup)
+			{
+				this->_park(worker);
+			}
+			else if (worker->_isPaused())
+			{
+				// level-triggered readiness would wake the reactor over and over while the worker can't take more data
+				this->_setReceiving(worker, false);
+			}
+			this->_finishCurrent();
+			lock.release();
+		}
+#ifdef _SAKIT_IO_URING
+		if (this->ring != NULL)
+		{
+			this->_updateRing();
+			this->ring->endBatch();
+		}
+#endif
+#endif
+	}
+
+	void ReactorThread::_updateRing()
+	{
+#ifdef _SAKIT_IO_URING
+		harray<unsigned int> ready;
+		WorkerThread* worker = NULL;
+		bool active = false;
+		hmutex::ScopeLock lock;
+		this->ring->dispatch();
+		this->ring->takeReady(ready);
+		foreach (unsigned int, it, ready)
+		{
+			lock.acquire(&this->mutex);
+			worker = this->slotWorkers.tryGet(*it, NULL);
+			// paused workers take their completions once they are resumed
+			if (worker == NULL || worker->_isPaused())
+			{
+				lock.release();
+				continue;
+			}
+			this->current = worker;
+			lock.release();
+			active = worker->_updateReady();
+			if (!active)
+			{
+				worker->_queueUpdate();
+			}
+			lock.acquire(&this->mutex);
+			if (!active)
+			{
+				this->_unregister(worker);
+			}
+			else if (worker->_isPaused())
+			{
+				this->_setReceiving(worker, false);
+			}
+			else
+			{
+				// e.g. a limited receive leaves the rest for the next update
+				this->ring->requeue(*it);
+			}
+			this->_finishCurrent();
+			lock.release();
+		}
+#endif
+	}
+
+	bool ReactorThread::_isRegistered(WorkerThread* worker)
+	{
+		return (this->descriptors.hasKey(worker) || this->slots.hasKey(worker));
+	}
+
+	bool ReactorThread::_register(WorkerThread* worker)
+	{
+#ifdef _SAKIT_EPOLL
+#ifdef _SAKIT_IO_URING
+		// sockets that use io_uring don't need a registration of their own, the completions of the shared ring say which one is ready
+		if (this->ring != NULL && worker->socket->_uringAttach(this->ring))
+		{
+			unsigned int slot = worker->socket->ring->getSlot();
+			hmutex::ScopeLock lock(&this->mutex);
+			if (this->slots.hasKey(worker))
+			{
+				this->slotWorkers.removeKey(this->slots[worker]);
+			}
+			this->slots[worker] = slot;
+			this->slotWorkers[slot] = worker;
+			return true;
+		}
+#endif
+		int fd = worker->socket->_getPollDescriptor();
+		epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.ptr = worker;
+		if (epoll_ctl(this->pollFd, EPOLL_CTL_ADD, fd, &event) != 0 && (errno != EEXIST || epoll_ctl(this->pollFd, EPOLL_CTL_MOD, fd, &event) != 0))
+		{
+			PlatformSocket::_printLastError("epoll_ctl()");
+			hmutex::ScopeLock lock(&worker->mutex);
+			worker->_setResult(FAILED);
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->mutex);
+		this->descriptors[worker] = fd;
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void ReactorThread::_unregister(WorkerThread* worker)
+	{
+		if (this->slots.hasKey(worker))
+		{
+			// the socket stays attached, but it must not keep receiving into the shared buffers or accepting connections nobody takes
+			this->_setReceiving(worker, false);
+			this->slotWorkers.removeKey(this->slots[worker]);
+			this->slots.removeKey(worker);
+			return;
+		}
+#ifdef _SAKIT_EPOLL
+		int fd = this->descriptors[worker];
+		// a closed descriptor is removed by the kernel already and its number might have been reused since
+		if (fd >= 0 && worker->socket->_getPollDescriptor() == fd)
+		{
+			epoll_event event;
+			memset(&event, 0, sizeof(event));
+			epoll_ctl(this->pollFd, EPOLL_CTL_DEL, fd, &event);
+		}
+#endif
+		this->descriptors.removeKey(worker);
+	}
+
+	void ReactorThread::_park(WorkerThread* worker)
+	{
+		this->_unregister(worker);
+		// parked workers stay active until they are canceled, the same as a polling thread would
+		this->descriptors[worker] = -1;
+	}
+
+	void ReactorThread::_setReceiving(WorkerThread* worker, bool receiving)
+	{
+#ifdef _SAKIT_IO_URING
+		if (this->slots.hasKey(worker))
+		{
+			// a paused socket must not hold on to the shared buffers, the next update arms the receive again
+			if (!receiving)
+			{
+				worker->socket->_uringCancel();
+			}
+			else
+			{
+				this->ring->requeue(this->slots[worker]);
+			}
+			return;
+		}
+#endif
+#ifdef _SAKIT_EPOLL
+		int fd = this->descriptors[worker];
+		if (fd < 0)
+		{
+			return;
+		}
+		epoll_event event;
+		memset(&event, 0, sizeof(event));
+		event.events = (receiving ? EPOLLIN | EPOLLRDHUP : 0);
+		event.data.ptr = worker;
+		if (epoll_ctl(this->pollFd, EPOLL_CTL_MOD, fd, &event) != 0)
+		{
+			PlatformSocket::_printLastError("epoll_ctl()");
+		}
+#endif
+	}
+
+	bool ReactorThread::_drain(WorkerThread* worker)
+	{
+		bool result = true;
+#ifdef _SAKIT_EPOLL
+		int received = 0;
+		do
+		{
+			result = worker->_updateReady();
+		} while (result && !worker->_isPaused() && ioctl((int)worker->socket->sock, FIONREAD, &received) == 0 && received > 0);
+#endif
+		return result;
+	}
+
+	void ReactorThread::process(hthread* thread)
+	{
+		ReactorThread* reactor = (ReactorThread*)thread;
+		while (reactor->isRunning() && reactor->executing)
+		{
+			reactor->_updateQueues();
+			reactor->_updateEvents();
+		}
+	}
+
+}
@@ -0,0 +1,92 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines an event loop thread that drives workers through readiness notifications instead of polling.
+
+#ifndef SAKIT_REACTOR_THREAD_H
+#define SAKIT_REACTOR_THREAD_H
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmap.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hthread.h>
+
+#include "Semaphore.h"
+
+namespace sakit
+{
+	class IoUring;
+	class WorkerThread;
+
+	class ReactorThread : public hthread
+	{
+	public:
+		ReactorThread();
+		~ReactorThread();
+
+		bool isValid();
+
+		/// @brief Queues a worker to be started and registered on the event loop.
+		void add(WorkerThread* worker);
+		/// @brief Queues a worker to be finished and unregistered from the event loop.
+		void cancel(WorkerThread* worker);
+		/// @brief Queues a paused worker to receive readiness notifications again.
+		void resume(WorkerThread* worker);
+		/// @brief Removes a worker immediately, waits if the worker is being processed at the moment.
+		/// @return True if the worker was still active and has not been finished yet.
+		bool remove(WorkerThread* worker);
+		void shutdown();
+
+		static bool isSupported();
+
+	protected:
+		int pollFd;
+		int wakeFd;
+		/// @note Negative descriptors are used for workers that have been parked after a hangup.
+		hmap<WorkerThread*, int> descriptors;
+		/// @brief The ring that all sockets of this reactor share with the io_uring I/O backend, NULL otherwise.
+		IoUring* ring;
+		/// @note Workers whose sockets are attached to the shared ring instead of having a descriptor registered.
+		hmap<WorkerThread*, unsigned int> slots;
+		hmap<unsigned int, WorkerThread*> slotWorkers;
+		harray<WorkerThread*> pending;
+		harray<WorkerThread*> canceled;
+		harray<WorkerThread*> resumed;
+		WorkerThread* current;
+		/// @note Number of threads in remove() that wait for the current worker to be processed.
+		int waiting;
+		Semaphore finished;
+		hmutex mutex;
+
+		void _wake();
+		/// @note Has to be called while the mutex is locked.
+		void _finishCurrent();
+		void _updateQueues();
+		void _updateEvents();
+		/// @brief Updates the workers whose sockets have completions on the shared ring.
+		void _updateRing();
+		bool _isRegistered(WorkerThread* worker);
+		bool _register(WorkerThread* worker);
+		void _unregister(WorkerThread* worker);
+		void _park(WorkerThread* worker);
+		/// @brief Enables or disables notifications about incoming data, e.g. while a worker is paused.
+		void _setReceiving(WorkerThread* worker, bool receiving);
+		bool _drain(WorkerThread* worker);
+
+		static void process(hthread* thread);
+
+	private:
+		ReactorThread(const ReactorThread& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -0,0 +1,68 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "BufferPool.h"
+#include "ReceiveBuffer.h"
+
+namespace sakit
+{
+	extern BufferPool bufferPool;
+
+	ReceiveBuffer::ReceiveBuffer(int capacity) : size(0), capacity(capacity), references(1), block(NULL)
+	{
+		this->data = (unsigned char*)bufferPool.acquire(capacity);
+	}
+
+	ReceiveBuffer::ReceiveBuffer(ReceiveBuffer* block, int offset, int capacity) : size(0), capacity(capacity), references(1), block(block)
+	{
+		this->data = block->data + offset;
+		block->retain();
+	}
+
+	ReceiveBuffer::~ReceiveBuffer()
+	{
+		if (this->block != NULL)
+		{
+			this->block->release();
+			return;
+		}
+		bufferPool.release((char*)this->data, this->capacity);
+	}
+
+	void ReceiveBuffer::retain()
+	{
+#if defined(__ATOMIC_ACQ_REL)
+		__atomic_add_fetch(&this->references, 1, __ATOMIC_ACQ_REL);
+#elif defined(_MSC_VER)
+		_InterlockedIncrement((volatile long*)&this->references);
+#else
+		__sync_add_and_fetch(&this->references, 1);
+#endif
+	}
+
+	void ReceiveBuffer::release()
+	{
+		int references = 0;
+#if defined(__ATOMIC_ACQ_REL)
+		references = __atomic_sub_fetch(&this->references, 1, __ATOMIC_ACQ_REL);
+#elif defined(_MSC_VER)
+		references = (int)_InterlockedDecrement((volatile long*)&this->references);
+#else
+		references = __sync_sub_and_fetch(&this->references, 1);
+#endif
+		if (references == 0)
+		{
+			delete this;
+		}
+	}
+
+}
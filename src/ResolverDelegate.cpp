@@ -0,0 +1,37 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <hltypes/harray.h>
+
+#include "Host.h"
+#include "ResolverDelegate.h"
+
+namespace sakit
+{
+	ResolverDelegate::ResolverDelegate()
+	{
+	}
+
+	ResolverDelegate::~ResolverDelegate()
+	{
+	}
+
+	void ResolverDelegate::onResolved(Host domain, Host ip)
+	{
+	}
+
+	void ResolverDelegate::onResolved(Host domain, const harray<Host>& ips)
+	{
+		this->onResolved(domain, ips.first());
+	}
+
+	void ResolverDelegate::onResolveFailed(Host domain)
+	{
+	}
+
+}
@@ -0,0 +1,114 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#define __HL_INCLUDE_PLATFORM_HEADERS
+#include <hltypes/hplatform.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
+#include "Semaphore.h"
+
+namespace sakit
+{
+	Semaphore::Semaphore() : count(0)
+	{
+#ifdef _WIN32
+		this->mutex = new CRITICAL_SECTION();
+		this->condition = new CONDITION_VARIABLE();
+		InitializeCriticalSectionEx((CRITICAL_SECTION*)this->mutex, 0, 0);
+		InitializeConditionVariable((CONDITION_VARIABLE*)this->condition);
+#else
+		this->mutex = new pthread_mutex_t();
+		this->condition = new pthread_cond_t();
+		pthread_mutex_init((pthread_mutex_t*)this->mutex, NULL);
+		pthread_cond_init((pthread_cond_t*)this->condition, NULL);
+#endif
+	}
+
+	Semaphore::~Semaphore()
+	{
+#ifdef _WIN32
+		DeleteCriticalSection((CRITICAL_SECTION*)this->mutex);
+		delete (CRITICAL_SECTION*)this->mutex;
+		delete (CONDITION_VARIABLE*)this->condition;
+#else
+		pthread_cond_destroy((pthread_cond_t*)this->condition);
+		pthread_mutex_destroy((pthread_mutex_t*)this->mutex);
+		delete (pthread_mutex_t*)this->mutex;
+		delete (pthread_cond_t*)this->condition;
+#endif
+	}
+
+	void Semaphore::post()
+	{
+#ifdef _WIN32
+		EnterCriticalSection((CRITICAL_SECTION*)this->mutex);
+		++this->count;
+		LeaveCriticalSection((CRITICAL_SECTION*)this->mutex);
+		WakeConditionVariable((CONDITION_VARIABLE*)this->condition);
+#else
+		pthread_mutex_lock((pthread_mutex_t*)this->mutex);
+		++this->count;
+		pthread_mutex_unlock((pthread_mutex_t*)this->mutex);
+		pthread_cond_signal((pthread_cond_t*)this->condition);
+#endif
+	}
+
+	bool Semaphore::wait(float timeout)
+	{
+		bool result = true;
+#ifdef _WIN32
+		EnterCriticalSection((CRITICAL_SECTION*)this->mutex);
+		DWORD milliseconds = (timeout >= 0.0f ? (DWORD)timeout : INFINITE);
+		while (this->count == 0 && result)
+		{
+			result = (SleepConditionVariableCS((CONDITION_VARIABLE*)this->condition, (CRITICAL_SECTION*)this->mutex, milliseconds) != 0 || this->count > 0);
+		}
+		if (result)
+		{
+			--this->count;
+		}
+		LeaveCriticalSection((CRITICAL_SECTION*)this->mutex);
+#else
+		timespec deadline;
+		if (timeout >= 0.0f)
+		{
+			timeval now;
+			gettimeofday(&now, NULL);
+			long long nanoseconds = (long long)now.tv_usec * 1000LL + (long long)(timeout * 1000000.0f);
+			deadline.tv_sec = now.tv_sec + (time_t)(nanoseconds / 1000000000LL);
+			deadline.tv_nsec = (long)(nanoseconds % 1000000000LL);
+		}
+		pthread_mutex_lock((pthread_mutex_t*)this->mutex);
+		int error = 0;
+		while (this->count == 0 && error != ETIMEDOUT)
+		{
+			if (timeout >= 0.0f)
+			{
+				error = pthread_cond_timedwait((pthread_cond_t*)this->condition, (pthread_mutex_t*)this->mutex, &deadline);
+			}
+			else
+			{
+				pthread_cond_wait((pthread_cond_t*)this->condition, (pthread_mutex_t*)this->mutex);
+			}
+		}
+		result = (this->count > 0);
+		if (result)
+		{
+			--this->count;
+		}
+		pthread_mutex_unlock((pthread_mutex_t*)this->mutex);
+#endif
+		return result;
+	}
+
+}
@@ -0,0 +1,40 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a counting semaphore that lets threads block until work is signaled.
+
+#ifndef SAKIT_SEMAPHORE_H
+#define SAKIT_SEMAPHORE_H
+
+namespace sakit
+{
+	class Semaphore
+	{
+	public:
+		Semaphore();
+		~Semaphore();
+
+		void post();
+		/// @param[in] timeout Maximum time to wait in milliseconds. Negative values wait indefinitely.
+		/// @return True if a signal was consumed, false if the timeout elapsed.
+		bool wait(float timeout = -1.0f);
+
+	protected:
+		void* mutex;
+		void* condition;
+		int count;
+
+	private:
+		Semaphore(const Semaphore& other); // prevents copying
+
+	};
+
+}
+#endif
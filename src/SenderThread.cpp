@@ -11,14 +11,17 @@
 #include <hltypes/hstream.h>
 #include <hltypes/hthread.h>
 
+#include "FileTransfer.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "SocketDelegate.h"
 #include "SenderThread.h"
 
+#define QUEUE_CAPACITY 64
+
 namespace sakit
 {
-	SenderThread::SenderThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : TimedThread(socket, timeout, retryFrequency), lastSent(0)
+	SenderThread::SenderThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : TimedThread(socket, timeout, retryFrequency), sentCounts(QUEUE_CAPACITY), lastSent(0), remaining(0)
 	{
 		this->name = "SAKit sender";
 		this->stream = new hstream();
@@ -31,31 +34,84 @@ namespace sakit
 
 	void SenderThread::_updateProcess()
 	{
-		int count = (int)this->stream->size();
-		int sent = 0;
-		hmutex::ScopeLock lock;
-		while (this->isRunning() && this->executing)
+		this->remaining = (int)this->stream->size();
+		while (this->_isActive())
 		{
-			sent = 0;
-			if (!this->socket->send(this->stream, count, sent))
+			if (!this->_updateSending())
 			{
-				lock.acquire(&this->mutex);
-				this->result = FAILED;
-				this->stream->clear();
 				return;
 			}
-			lock.acquire(&this->mutex);
-			this->lastSent += sent;
-			lock.release();
-			if (this->stream->eof())
-			{
-				break;
-			}
 			hthread::sleep(*this->retryFrequency * 1000.0f);
 		}
-		lock.acquire(&this->mutex);
-		this->result = FINISHED;
+		this->_finishSending(FINISHED);
+	}
+
+	float SenderThread::_updatePooled()
+	{
+		if (!this->poolStarted)
+		{
+			this->poolStarted = true;
+			this->remaining = (int)this->stream->size();
+		}
+		if (!this->executing)
+		{
+			this->_finishSending(FINISHED);
+			return -1.0f;
+		}
+		if (!this->_updateSending())
+		{
+			return -1.0f;
+		}
+		return (*this->retryFrequency * 1000.0f);
+	}
+
+	bool SenderThread::_updateSending()
+	{
+		int sent = 0;
+		bool result = false;
+		if (this->fileTransfer.isOpen())
+		{
+			result = this->socket->sendFile(&this->fileTransfer, sent);
+		}
+		else if (this->spans.size() > 0)
+		{
+			result = this->socket->send(this->spans, sent);
+		}
+		else
+		{
+			result = this->socket->send(this->stream, this->remaining, sent);
+		}
+		if (!result)
+		{
+			this->_finishSending(FAILED);
+			return false;
+		}
+		this->lastSent += sent;
+		if (this->lastSent > 0 && this->sentCounts.push(this->lastSent))
+		{
+			this->lastSent = 0;
+			this->_queueUpdate();
+		}
+		if (this->spans.size() == 0 && this->fileTransfer.getRemaining() == 0 && this->stream->eof())
+		{
+			this->_finishSending(FINISHED);
+			return false;
+		}
+		return true;
+	}
+
+	void SenderThread::_finishSending(State result)
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->_setResult(result);
 		this->stream->clear();
+		this->spans.clear();
+		this->fileTransfer.close();
+	}
+
+	void SenderThread::_finishReady()
+	{
+		this->_finishSending(FINISHED);
 	}
 
 }
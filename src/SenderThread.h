@@ -13,10 +13,14 @@
 #ifndef SAKIT_SENDER_THREAD_H
 #define SAKIT_SENDER_THREAD_H
 
+#include <hltypes/harray.h>
 #include <hltypes/hltypesUtil.h>
 #include <hltypes/hstream.h>
 
+#include "FileTransfer.h"
 #include "Socket.h"
+#include "Span.h"
+#include "SpscQueue.h"
 #include "TimedThread.h"
 
 namespace sakit
@@ -34,9 +38,24 @@ namespace sakit
 
 	protected:
 		hstream* stream;
+		/// @note Sent instead of the stream if not empty.
+		harray<Span> spans;
+		/// @note Sent instead of the stream if open.
+		FileTransfer fileTransfer;
+		/// @note Sent byte counts that are handed to update() without locking.
+		SpscQueue<int> sentCounts;
+		/// @note Sent bytes that didn't fit into the queue, only accessed by update() while the result isn't RUNNING.
 		int lastSent;
+		/// @note Bytes of the stream that haven't been sent yet.
+		int remaining;
 
 		void _updateProcess();
+		/// @note Sends only once per call so other work in the pool isn't blocked while the socket can't take more data.
+		float _updatePooled();
+		/// @return True if there is more data to be sent.
+		bool _updateSending();
+		void _finishSending(State result);
+		void _finishReady();
 
 	};
 
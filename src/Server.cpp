@@ -33,7 +33,7 @@ namespace sakit
 	{
 		if (this->serverThread != NULL)
 		{
-			this->serverThread->join();
+			this->serverThread->joinWork();
 			delete this->serverThread;
 		}
 	}
@@ -53,7 +53,7 @@ namespace sakit
 		}
 		this->state = RUNNING;
 		this->serverThread->result = RUNNING;
-		this->serverThread->start();
+		this->serverThread->startWork();
 		return true;
 	}
 
@@ -64,7 +64,7 @@ namespace sakit
 		{
 			return false;
 		}
-		this->serverThread->executing = false;
+		this->serverThread->stopWork();
 		return true;
 	}
 
@@ -79,6 +79,7 @@ namespace sakit
 			return;
 		}
 		this->serverThread->result = IDLE;
+		this->socket->releaseBuffer();
 		this->state = BOUND;
 		lockThread.release();
 		lock.release();
@@ -10,6 +10,7 @@
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 
+#include "FileTransfer.h"
 #include "PlatformSocket.h"
 #include "ReceiverThread.h"
 #include "sakit.h"
@@ -30,11 +31,11 @@ namespace sakit
 
 	Socket::~Socket()
 	{
-		this->sender->join();
+		this->sender->joinWork();
 		delete this->sender;
 		if (this->receiver != NULL)
 		{
-			this->receiver->join();
+			this->receiver->joinWork();
 			delete this->receiver;
 		}
 	}
@@ -60,13 +61,13 @@ namespace sakit
 	void Socket::_updateSending()
 	{
 		int sent = 0;
-		hmutex::ScopeLock lock(&this->mutexState);
-		hmutex::ScopeLock lockThread(&this->sender->mutex);
-		if (this->sender->lastSent > 0)
+		int count = 0;
+		while (this->sender->sentCounts.pop(count))
 		{
-			sent = this->sender->lastSent;
-			this->sender->lastSent = 0;
+			sent += count;
 		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		hmutex::ScopeLock lockThread(&this->sender->mutex);
 		State result = this->sender->result;
 		if (result == RUNNING || result == IDLE)
 		{
@@ -78,6 +79,13 @@ namespace sakit
 			}
 			return;
 		}
+		// the sender has stopped so counts that were queued in the meantime or that didn't fit into the queue can be taken as well
+		while (this->sender->sentCounts.pop(count))
+		{
+			sent += count;
+		}
+		sent += this->sender->lastSent;
+		this->sender->lastSent = 0;
 		this->sender->result = IDLE;
 		this->state = (this->state == SENDING_RECEIVING ? RECEIVING : this->idleState);
 		lockThread.release();
@@ -113,6 +121,45 @@ namespace sakit
 		return this->sendAsync(&stream, (int)stream.size());
 	}
 
+	int Socket::send(harray<Span> spans)
+	{
+		if (!this->_checkSendParameters(spans))
+		{
+			return 0;
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (!this->_canSend(this->state))
+		{
+			return 0;
+		}
+		this->state = (this->state == RECEIVING ? SENDING_RECEIVING : SENDING);
+		lock.release();
+		int result = this->_sendDirect(spans);
+		lock.acquire(&this->mutexState);
+		this->state = (this->state == SENDING_RECEIVING ? RECEIVING : this->idleState);
+		return result;
+	}
+
+	bool Socket::sendAsync(harray<Span> spans)
+	{
+		if (!this->_checkSendParameters(spans))
+		{
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		hmutex::ScopeLock lockThread(&this->sender->mutex);
+		if (!this->_canSend(this->state))
+		{
+			return false;
+		}
+		this->state = (this->state == RECEIVING ? SENDING_RECEIVING : SENDING);
+		this->sender->result = RUNNING;
+		this->sender->stream->clear();
+		this->sender->spans = spans;
+		this->sender->startWork();
+		return true;
+	}
+
 	int Socket::_send(hstream* stream, int count)
 	{
 		if (!this->_checkSendParameters(stream, count))
@@ -132,6 +179,45 @@ namespace sakit
 		return result;
 	}
 
+	int64_t Socket::_sendFile(chstr filename, int64_t offset, int64_t length)
+	{
+		FileTransfer transfer;
+		if (!transfer.open(filename, offset, length))
+		{
+			return 0;
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (!this->_canSend(this->state))
+		{
+			return 0;
+		}
+		this->state = (this->state == RECEIVING ? SENDING_RECEIVING : SENDING);
+		lock.release();
+		int64_t result = this->_sendDirect(&transfer);
+		lock.acquire(&this->mutexState);
+		this->state = (this->state == SENDING_RECEIVING ? RECEIVING : this->idleState);
+		return result;
+	}
+
+	bool Socket::_sendFileAsync(chstr filename, int64_t offset, int64_t length)
+	{
+		hmutex::ScopeLock lock(&this->mutexState);
+		hmutex::ScopeLock lockThread(&this->sender->mutex);
+		if (!this->_canSend(this->state))
+		{
+			return false;
+		}
+		if (!this->sender->fileTransfer.open(filename, offset, length))
+		{
+			return false;
+		}
+		this->state = (this->state == RECEIVING ? SENDING_RECEIVING : SENDING);
+		this->sender->result = RUNNING;
+		this->sender->stream->clear();
+		this->sender->startWork();
+		return true;
+	}
+
 	bool Socket::sendAsync(hstream* stream, int count)
 	{
 		if (!this->_checkSendParameters(stream, count))
@@ -149,21 +235,27 @@ namespace sakit
 		this->sender->stream->clear();
 		this->sender->stream->writeRaw(*stream, (int)hmin((int64_t)count, stream->size() - stream->position()));
 		this->sender->stream->rewind();
-		this->sender->start();
+		this->sender->startWork();
 		return true;
 	}
 
 	bool Socket::_prepareReceive(hstream* stream)
 	{
-		bool result = false;
-		if (this->_checkReceiveParameters(stream))
+		return (this->_checkReceiveParameters(stream) && this->_prepareReceive());
+	}
+
+	bool Socket::_prepareReceive(unsigned char* data, int size)
+	{
+		return (this->_checkReceiveParameters(data, size) && this->_prepareReceive());
+	}
+
+	bool Socket::_prepareReceive()
+	{
+		hmutex::ScopeLock lock(&this->mutexState);
+		bool result = this->_canReceive(this->state);
+		if (result)
 		{
-			hmutex::ScopeLock lock(&this->mutexState);
-			result = this->_canReceive(this->state);
-			if (result)
-			{
-				this->state = (this->state == SENDING ? SENDING_RECEIVING : RECEIVING);
-			}
+			this->state = (this->state == SENDING ? SENDING_RECEIVING : RECEIVING);
 		}
 		return result;
 	}
@@ -186,7 +278,7 @@ namespace sakit
 		this->state = (this->state == SENDING ? SENDING_RECEIVING : RECEIVING);
 		this->receiver->result = RUNNING;
 		this->receiver->maxValue = maxValue;
-		this->receiver->start();
+		this->receiver->startWork();
 		return true;
 	}
 
@@ -197,9 +289,9 @@ namespace sakit
 		{
 			return false;
 		}
-		this->receiver->executing = false;
+		this->receiver->stopWork();
 		lock.release();
-		this->receiver->join();
+		this->receiver->joinWork();
 		this->_updateReceiving();
 		return true;
 	}
@@ -211,7 +303,7 @@ namespace sakit
 		{
 			return false;
 		}
-		this->receiver->executing = false;
+		this->receiver->stopWork();
 		return true;
 	}
 
@@ -270,6 +362,26 @@ namespace sakit
 		return true;
 	}
 
+	bool Socket::_checkSendParameters(harray<Span>& spans)
+	{
+		int size = 0;
+		foreach (Span, it, spans)
+		{
+			if ((*it).getData() == NULL && (*it).getSize() > 0)
+			{
+				hlog::warn(logTag, "Cannot send, span data is NULL!");
+				return false;
+			}
+			size += (*it).getSize();
+		}
+		if (size == 0)
+		{
+			hlog::warn(logTag, "Cannot send, no data to send!");
+			return false;
+		}
+		return true;
+	}
+
 	bool Socket::_checkReceiveParameters(hstream* stream)
 	{
 		if (stream == NULL)
@@ -280,4 +392,19 @@ namespace sakit
 		return true;
 	}
 
+	bool Socket::_checkReceiveParameters(unsigned char* data, int size)
+	{
+		if (data == NULL)
+		{
+			hlog::warn(logTag, "Cannot receive, data is NULL!");
+			return false;
+		}
+		if (size <= 0)
+		{
+			hlog::warn(logTag, "Cannot receive, size is 0!");
+			return false;
+		}
+		return true;
+	}
+
 }
@@ -0,0 +1,25 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "Span.h"
+
+namespace sakit
+{
+	Span::Span() : data(NULL), size(0)
+	{
+	}
+
+	Span::Span(const void* data, int size) : data((const unsigned char*)data), size(size)
+	{
+	}
+
+	Span::~Span()
+	{
+	}
+
+}
@@ -0,0 +1,108 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a lock-free single-producer/single-consumer ring queue for handing results from workers to update().
+
+#ifndef SAKIT_SPSC_QUEUE_H
+#define SAKIT_SPSC_QUEUE_H
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define SAKIT_CACHE_LINE_SIZE 64
+
+namespace sakit
+{
+	/// @note Only one thread may push and only one thread may pop at the same time.
+	template <typename T>
+	class SpscQueue
+	{
+	public:
+		/// @param[in] capacity Has to be a power of 2.
+		SpscQueue(unsigned int capacity) : mask(capacity - 1), head(0), tail(0)
+		{
+			this->items = new T[capacity];
+		}
+
+		~SpscQueue()
+		{
+			delete [] this->items;
+		}
+
+		/// @note Only to be called by the producer.
+		/// @return False if the queue is full.
+		bool push(const T& item)
+		{
+			unsigned int tail = this->tail;
+			if (tail - SpscQueue::_load(&this->head) > this->mask)
+			{
+				return false;
+			}
+			this->items[tail & this->mask] = item;
+			SpscQueue::_store(&this->tail, tail + 1);
+			return true;
+		}
+
+		/// @note Only to be called by the consumer.
+		/// @return False if the queue is empty.
+		bool pop(T& item)
+		{
+			unsigned int head = this->head;
+			if (head == SpscQueue::_load(&this->tail))
+			{
+				return false;
+			}
+			item = this->items[head & this->mask];
+			this->items[head & this->mask] = T(); // releases the queue's copy
+			SpscQueue::_store(&this->head, head + 1);
+			return true;
+		}
+
+	protected:
+		T* items;
+		unsigned int mask;
+		// the indices are written by different threads so they are kept on different cache lines
+		char paddingHead[SAKIT_CACHE_LINE_SIZE];
+		volatile unsigned int head;
+		char paddingTail[SAKIT_CACHE_LINE_SIZE];
+		volatile unsigned int tail;
+		char paddingEnd[SAKIT_CACHE_LINE_SIZE];
+
+		static inline unsigned int _load(volatile unsigned int* value)
+		{
+#if defined(__ATOMIC_ACQUIRE)
+			return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#elif defined(_MSC_VER)
+			return (unsigned int)_InterlockedOr((volatile long*)value, 0);
+#else
+			return __sync_fetch_and_add(value, 0);
+#endif
+		}
+
+		static inline void _store(volatile unsigned int* value, unsigned int newValue)
+		{
+#if defined(__ATOMIC_RELEASE)
+			__atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+#elif defined(_MSC_VER)
+			_InterlockedExchange((volatile long*)value, (long)newValue);
+#else
+			__sync_synchronize();
+			*value = newValue;
+#endif
+		}
+
+	private:
+		SpscQueue(const SpscQueue& other); // prevents copying
+
+	};
+
+}
+#endif
@@ -6,47 +6,154 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
-#include <hltypes/hstream.h>
+#include <hltypes/hltypesUtil.h>
 #include <hltypes/hthread.h>
 
 #include "PlatformSocket.h"
+#include "ReceiveBuffer.h"
 #include "sakit.h"
 #include "SocketDelegate.h"
 #include "TcpReceiverThread.h"
 
+#define QUEUE_CAPACITY 64
+
 namespace sakit
 {
-	TcpReceiverThread::TcpReceiverThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : ReceiverThread(socket, timeout, retryFrequency)
+	TcpReceiverThread::TcpReceiverThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : ReceiverThread(socket, timeout, retryFrequency),
+		buffers(QUEUE_CAPACITY), buffer(NULL), block(NULL), blockSize(0), remaining(0), paused(false)
 	{
 		this->name = "SAKit TCP receiver";
-		this->stream = new hstream();
 	}
 
 	TcpReceiverThread::~TcpReceiverThread()
 	{
-		delete this->stream;
+		ReceiveBuffer* buffer = NULL;
+		while (this->buffers.pop(buffer))
+		{
+			buffer->release();
+		}
+		if (this->buffer != NULL)
+		{
+			this->buffer->release();
+		}
+		this->_releaseBlock();
+	}
+
+	bool TcpReceiverThread::_isReactive()
+	{
+		return true;
+	}
+
+	bool TcpReceiverThread::_startReady()
+	{
+		this->remaining = this->maxValue;
+		this->paused = false;
+		this->_releaseBlock();
+		return true;
 	}
 
-	void TcpReceiverThread::_updateProcess()
+	bool TcpReceiverThread::_updateReady()
 	{
-		int remaining = this->maxValue;
-		hmutex::ScopeLock lock;
-		while (this->isRunning() && this->executing)
+		// nothing else is received while the data from before is still waiting for space in the queue
+		if (this->buffer != NULL && !this->_pushBuffer())
 		{
-			if (!this->socket->receive(this->stream, this->mutex, remaining))
-			{
-				lock.acquire(&this->mutex);
-				this->result = FAILED;
-				return;
-			}
-			if (this->maxValue > 0 && remaining == 0)
+			return true;
+		}
+		bool received = this->_receiveBuffer();
+		if (this->buffer != NULL)
+		{
+			this->_pushBuffer();
+		}
+		if (!received)
+		{
+			this->_releaseBlock();
+			hmutex::ScopeLock lock(&this->mutex);
+			this->_setResult(FAILED);
+			return false;
+		}
+		if (this->maxValue > 0 && this->remaining == 0)
+		{
+			this->_releaseBlock();
+			hmutex::ScopeLock lock(&this->mutex);
+			this->_setResult(FINISHED);
+			return false;
+		}
+		return true;
+	}
+
+	void TcpReceiverThread::_finishReady()
+	{
+		this->_releaseBlock();
+		ReceiverThread::_finishReady();
+	}
+
+	bool TcpReceiverThread::_isPaused()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		return this->paused;
+	}
+
+	bool TcpReceiverThread::_receiveBuffer()
+	{
+		int size = sakit::getBufferSize();
+		if (this->maxValue > 0)
+		{
+			size = hmin(size, this->remaining);
+		}
+		// the rest of the block is shared by the following views as long as it's not too small
+		if (this->block != NULL && this->block->capacity - this->blockSize < hmin(size, this->block->capacity / 4))
+		{
+			this->_releaseBlock();
+		}
+		if (this->block == NULL)
+		{
+			this->block = new ReceiveBuffer(sakit::getBufferSize());
+			this->blockSize = 0;
+		}
+		size = hmin(size, this->block->capacity - this->blockSize);
+		int read = 0;
+		bool result = this->socket->receive(this->block->data + this->blockSize, size, read);
+		if (read == 0)
+		{
+			// a socket without data doesn't hold on to the block, it goes back to the pool once its views are released
+			this->_releaseBlock();
+			return result;
+		}
+		this->buffer = new ReceiveBuffer(this->block, this->blockSize, read);
+		this->buffer->size = read;
+		this->blockSize += read;
+		if (this->maxValue > 0)
+		{
+			this->remaining -= read;
+		}
+		return result;
+	}
+
+	bool TcpReceiverThread::_pushBuffer()
+	{
+		if (!this->buffers.push(this->buffer))
+		{
+			hmutex::ScopeLock lock(&this->mutex);
+			// update() might have taken the queued data in the meantime, otherwise it has to resume the work
+			if (!this->buffers.push(this->buffer))
 			{
-				break;
+				this->paused = true;
+				return false;
 			}
-			hthread::sleep(*this->retryFrequency * 1000.0f);
 		}
-		lock.acquire(&this->mutex);
-		this->result = FINISHED;
+		this->buffer = NULL;
+		this->_queueUpdate();
+		return true;
+	}
+
+	void TcpReceiverThread::_releaseBlock()
+	{
+		if (this->block != NULL)
+		{
+			this->block->release();
+			this->block = NULL;
+		}
+		this->blockSize = 0;
 	}
 
 }
@@ -17,8 +17,10 @@
 #include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
 
-#include "Socket.h"
+#include "ReceiveBuffer.h"
 #include "ReceiverThread.h"
+#include "Socket.h"
+#include "SpscQueue.h"
 
 namespace sakit
 {
@@ -34,9 +36,29 @@ namespace sakit
 		~TcpReceiverThread();
 
 	protected:
-		hstream* stream;
+		/// @note Received data that is handed to update() without locking.
+		SpscQueue<ReceiveBuffer*> buffers;
+		/// @note Received data that didn't fit into the queue, only accessed by update() while the result isn't RUNNING.
+		ReceiveBuffer* buffer;
+		/// @brief Pooled buffer that data is received into, the queued buffers are views into it.
+		/// @note Only accessed by the thread.
+		ReceiveBuffer* block;
+		/// @brief Number of bytes at the start of the block that belong to views.
+		int blockSize;
+		int remaining;
+		/// @note Set while the queue is full, update() resumes the work after it has taken the queued data.
+		bool paused;
 
-		void _updateProcess();
+		bool _isReactive();
+		bool _startReady();
+		bool _updateReady();
+		void _finishReady();
+		bool _isPaused();
+		/// @brief Receives into the rest of the block and hands the received data out as a view into it.
+		bool _receiveBuffer();
+		void _releaseBlock();
+		/// @return False if the queue is full and the buffer has to be kept.
+		bool _pushBuffer();
 
 	};
 
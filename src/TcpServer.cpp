@@ -23,9 +23,9 @@ namespace sakit
 
 	TcpServer::TcpServer(TcpServerDelegate* tcpServerDelegate, TcpSocketDelegate* acceptedDelegate) : Server(dynamic_cast<ServerDelegate*>(tcpServerDelegate))
 	{
-		this->serverThread = this->tcpServerThread = new TcpServerThread(this->socket, this->acceptedDelegate, &this->timeout, &this->retryFrequency);
 		this->tcpServerDelegate = tcpServerDelegate;
 		this->acceptedDelegate = acceptedDelegate;
+		this->serverThread = this->tcpServerThread = new TcpServerThread(this->socket, this->acceptedDelegate, &this->timeout, &this->retryFrequency);
 		this->socket->setConnectionLess(false);
 		this->__register();
 	}
@@ -65,6 +65,7 @@ namespace sakit
 		lock.release();
 		foreach (TcpSocket*, it, sockets)
 		{
+			(*it)->server = this;
 			this->tcpServerDelegate->onAccepted(this, (*it));
 		}
 		Server::update(timeDelta);
@@ -85,7 +86,9 @@ namespace sakit
 		connections -= tcpSocket;
 		lock.release();
 		lockUpdate.release();
+		int64_t start = htickCount();
 		float time = 0.0f;
+		bool ready = false;
 		while (true)
 		{
 			if (!this->socket->listen())
@@ -96,17 +99,19 @@ namespace sakit
 			}
 			if (this->socket->accept(tcpSocket))
 			{
+				tcpSocket->server = this;
 				this->sockets += tcpSocket;
 				break;
 			}
-			time += this->retryFrequency;
+			time = (htickCount() - start) * 0.001f;
 			if (time >= this->timeout)
 			{
 				delete tcpSocket;
 				tcpSocket = NULL;
 				break;
 			}
-			hthread::sleep(this->retryFrequency * 1000.0f);
+			// a pending connection makes the listening socket readable
+			this->_waitReceive(ready, this->timeout - time);
 		}
 		lock.acquire(&this->mutexState);
 		this->state = BOUND;
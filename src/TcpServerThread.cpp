@@ -22,7 +22,7 @@ namespace sakit
 	extern hmutex connectionsMutex;
 	extern hmutex updateMutex;
 
-	TcpServerThread::TcpServerThread(PlatformSocket* socket, TcpSocketDelegate* acceptedDelegate, float* timeout, float* retryFrequency) : TimedThread(socket, timeout, retryFrequency)
+	TcpServerThread::TcpServerThread(PlatformSocket* socket, TcpSocketDelegate* acceptedDelegate, float* timeout, float* retryFrequency) : TimedThread(socket, timeout, retryFrequency), pendingSocket(NULL)
 	{
 		this->name = "SAKit TCP server";
 		this->acceptedDelegate = acceptedDelegate;
@@ -30,43 +30,67 @@ namespace sakit
 
 	TcpServerThread::~TcpServerThread()
 	{
+		if (this->pendingSocket != NULL)
+		{
+			delete this->pendingSocket;
+		}
 	}
 
-	void TcpServerThread::_updateProcess()
+	TcpSocket* TcpServerThread::_createSocket()
 	{
 		TcpSocket* tcpSocket = new TcpSocket(this->acceptedDelegate);
 		hmutex::ScopeLock lockUpdate(&updateMutex);
 		hmutex::ScopeLock lock(&connectionsMutex);
 		connections -= tcpSocket;
-		lock.release();
-		lockUpdate.release();
-		while (this->isRunning() && this->executing)
+		return tcpSocket;
+	}
+
+	bool TcpServerThread::_isReactive()
+	{
+		return true;
+	}
+
+	bool TcpServerThread::_startReady()
+	{
+		if (this->pendingSocket == NULL)
+		{
+			this->pendingSocket = this->_createSocket();
+		}
+		if (!this->socket->listen())
+		{
+			hmutex::ScopeLock lock(&this->mutex);
+			this->_setResult(FAILED);
+			lock.release();
+			delete this->pendingSocket;
+			this->pendingSocket = NULL;
+			return false;
+		}
+		return true;
+	}
+
+	bool TcpServerThread::_updateReady()
+	{
+		hmutex::ScopeLock lock;
+		// accepts all pending connections at once
+		while (this->socket->accept(this->pendingSocket))
+		{
+			lock.acquire(&this->mutex);
+			this->sockets += this->pendingSocket;
+			lock.release();
+			this->pendingSocket = this->_createSocket();
+			this->_queueUpdate();
+		}
+		return true;
+	}
+
+	void TcpServerThread::_finishReady()
+	{
+		if (this->pendingSocket != NULL)
 		{
-			if (!this->socket->listen())
-			{
-				lock.acquire(&this->mutex);
-				this->result = FAILED;
-				lock.release();
-				delete tcpSocket;
-				return;
-			}
-			if (this->socket->accept(tcpSocket))
-			{
-				lock.acquire(&this->mutex);
-				this->sockets += tcpSocket;
-				lock.release();
-				tcpSocket = new TcpSocket(this->acceptedDelegate);
-				lockUpdate.acquire(&updateMutex);
-				lock.acquire(&connectionsMutex);
-				connections -= tcpSocket;
-				lock.release();
-				lockUpdate.release();
-			}
-			hthread::sleep(*this->retryFrequency * 1000.0f);
+			delete this->pendingSocket;
+			this->pendingSocket = NULL;
 		}
-		delete tcpSocket;
-		lock.acquire(&this->mutex);
-		this->result = FINISHED;
+		TimedThread::_finishReady();
 	}
 
 }
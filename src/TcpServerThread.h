@@ -37,8 +37,14 @@ namespace sakit
 	protected:
 		TcpSocketDelegate* acceptedDelegate;
 		harray<TcpSocket*> sockets;
+		TcpSocket* pendingSocket;
 
-		void _updateProcess();
+		TcpSocket* _createSocket();
+
+		bool _isReactive();
+		bool _startReady();
+		bool _updateReady();
+		void _finishReady();
 
 	};
 
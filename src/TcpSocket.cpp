@@ -6,6 +6,7 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <hltypes/harray.h>
 #include <hltypes/hlog.h>
 #include <hltypes/hmutex.h>
 #include <hltypes/hstring.h>
@@ -13,17 +14,21 @@
 
 #include "ConnectorThread.h"
 #include "PlatformSocket.h"
+#include "ReceiveBuffer.h"
 #include "sakit.h"
 #include "sakitUtil.h"
 #include "SenderThread.h"
 #include "TcpReceiverThread.h"
+#include "TcpServer.h"
 #include "TcpSocket.h"
 #include "TcpSocketDelegate.h"
 
 namespace sakit
 {
+	void _queueUpdate(Base* connection);
+
 	TcpSocket::TcpSocket(TcpSocketDelegate* socketDelegate) : Socket(dynamic_cast<SocketDelegate*>(socketDelegate), CONNECTED),
-		Connector(this->socket, dynamic_cast<ConnectorDelegate*>(socketDelegate))
+		Connector(this->socket, dynamic_cast<ConnectorDelegate*>(socketDelegate)), server(NULL)
 	{
 		this->tcpSocketDelegate = socketDelegate;
 		this->socket->setConnectionLess(false);
@@ -46,40 +51,59 @@ namespace sakit
 	{
 		Socket::update(timeDelta);
 		Connector::_update(timeDelta);
+		// the server removes disconnected sockets in its own update, which only runs when it has been queued
+		if (this->server != NULL && !this->isConnected())
+		{
+			_queueUpdate(this->server);
+		}
 	}
 
 	void TcpSocket::_updateReceiving()
 	{
-		hstream* stream = NULL;
+		harray<ReceiveBuffer*> buffers;
+		this->_takeReceivedBuffers(buffers);
 		hmutex::ScopeLock lock(&this->mutexState);
 		hmutex::ScopeLock lockThread(&this->receiver->mutex);
-		if (this->tcpReceiver->stream->size() > 0)
-		{
-			stream = this->tcpReceiver->stream;
-			this->tcpReceiver->stream = new hstream();
-		}
 		State result = this->receiver->result;
 		if (result == RUNNING || result == IDLE)
 		{
-			if (stream != NULL)
+			// the queue has been emptied so the receiver can continue
+			bool paused = this->tcpReceiver->paused;
+			this->tcpReceiver->paused = false;
+			lockThread.release();
+			lock.release();
+			if (paused)
 			{
-				lockThread.release();
-				lock.release();
-				stream->rewind();
-				this->tcpSocketDelegate->onReceived(this, stream);
-				delete stream;
+				this->receiver->resumeWork();
+			}
+			if (buffers.size() > 0)
+			{
+				this->_deliverReceivedBuffers(buffers);
 			}
 			return;
 		}
+		// the receiver has stopped so data that was queued in the meantime or that didn't fit into the queue can be taken as well
+		this->_takeReceivedBuffers(buffers);
+		if (this->tcpReceiver->buffer != NULL)
+		{
+			if (this->tcpReceiver->buffer->size > 0)
+			{
+				buffers += this->tcpReceiver->buffer;
+			}
+			else
+			{
+				this->tcpReceiver->buffer->release();
+			}
+			this->tcpReceiver->buffer = NULL;
+		}
 		this->receiver->result = IDLE;
+		this->socket->releaseBuffer();
 		this->state = (this->state == SENDING_RECEIVING ? SENDING : this->idleState);
 		lockThread.release();
 		lock.release();
-		if (stream != NULL)
+		if (buffers.size() > 0)
 		{
-			stream->rewind();
-			this->tcpSocketDelegate->onReceived(this, stream);
-			delete stream;
+			this->_deliverReceivedBuffers(buffers);
 		}
 		// delegate calls
 		switch (result)
@@ -90,6 +114,34 @@ namespace sakit
 		}
 	}
 
+	void TcpSocket::_takeReceivedBuffers(harray<ReceiveBuffer*>& buffers)
+	{
+		ReceiveBuffer* buffer = NULL;
+		while (this->tcpReceiver->buffers.pop(buffer))
+		{
+			buffers += buffer;
+		}
+	}
+
+	void TcpSocket::_deliverReceivedBuffers(harray<ReceiveBuffer*>& buffers)
+	{
+		// all buffers are delivered together so the delegate is still called only once per update
+		this->tcpSocketDelegate->onReceivedBuffers(this, buffers);
+		foreach (ReceiveBuffer*, it, buffers)
+		{
+			(*it)->release();
+		}
+	}
+
+	int TcpSocket::receive(unsigned char* data, int size)
+	{
+		if (!this->_prepareReceive(data, size))
+		{
+			return 0;
+		}
+		return this->_finishReceive(this->_receiveDirect(data, size));
+	}
+
 	int TcpSocket::receive(hstream* stream, int maxBytes)
 	{
 		if (!this->_prepareReceive(stream))
@@ -113,6 +165,16 @@ namespace sakit
 		return this->_startReceiveAsync(maxBytes);
 	}
 
+	int64_t TcpSocket::sendFile(chstr filename, int64_t offset, int64_t length)
+	{
+		return this->_sendFile(filename, offset, length);
+	}
+
+	bool TcpSocket::sendFileAsync(chstr filename, int64_t offset, int64_t length)
+	{
+		return this->_sendFileAsync(filename, offset, length);
+	}
+
 	void TcpSocket::_activateConnection(Host remoteHost, unsigned short remotePort, Host localHost, unsigned short localPort)
 	{
 		SocketBase::_activateConnection(remoteHost, remotePort, localHost, localPort);
@@ -6,6 +6,10 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <hltypes/harray.h>
+#include <hltypes/hstream.h>
+
+#include "ReceiveBuffer.h"
 #include "TcpSocketDelegate.h"
 
 namespace sakit
@@ -22,6 +26,17 @@ namespace sakit
 	{
 	}
 
+	void TcpSocketDelegate::onReceivedBuffers(TcpSocket* socket, harray<ReceiveBuffer*> buffers)
+	{
+		hstream stream;
+		foreach (ReceiveBuffer*, it, buffers)
+		{
+			stream.writeRaw((*it)->getData(), (*it)->getSize());
+		}
+		stream.rewind();
+		this->onReceived(socket, &stream);
+	}
+
 	void TcpSocketDelegate::onReceiveFailed(TcpSocket* socket)
 	{
 	}
@@ -6,6 +6,8 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <hltypes/hthread.h>
+
 #include "PlatformSocket.h"
 #include "TimedThread.h"
 
@@ -22,4 +24,47 @@ namespace sakit
 	{
 	}
 
+	void TimedThread::_updateProcess()
+	{
+		if (!this->_startReady())
+		{
+			return;
+		}
+		while (this->_isActive())
+		{
+			if (!this->_updateReady())
+			{
+				return;
+			}
+			hthread::sleep(*this->retryFrequency * 1000.0f);
+		}
+		this->_finishReady();
+	}
+
+	float TimedThread::_updatePooled()
+	{
+		if (!this->_isReactive())
+		{
+			return WorkerThread::_updatePooled();
+		}
+		if (!this->poolStarted)
+		{
+			this->poolStarted = true;
+			if (!this->_startReady())
+			{
+				return -1.0f;
+			}
+		}
+		if (!this->executing)
+		{
+			this->_finishReady();
+			return -1.0f;
+		}
+		if (!this->_updateReady())
+		{
+			return -1.0f;
+		}
+		return (*this->retryFrequency * 1000.0f);
+	}
+
 }
@@ -33,6 +33,11 @@ namespace sakit
 		float* timeout;
 		float* retryFrequency;
 
+		/// @note Polls the ready-based work when no reactor is used.
+		void _updateProcess();
+		/// @note Polls the ready-based work in steps so it doesn't occupy a pool thread between attempts.
+		float _updatePooled();
+
 	};
 
 }
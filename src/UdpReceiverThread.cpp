@@ -9,61 +9,140 @@
 #include <hltypes/hstream.h>
 #include <hltypes/hthread.h>
 
+#include "DatagramBatch.h"
+#include "Endpoint.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "SocketDelegate.h"
 #include "UdpReceiverThread.h"
 
+#define QUEUE_CAPACITY 256
+
 namespace sakit
 {
-	UdpReceiverThread::UdpReceiverThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : ReceiverThread(socket, timeout, retryFrequency)
+	UdpReceiverThread::UdpReceiverThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : ReceiverThread(socket, timeout, retryFrequency),
+		datagrams(QUEUE_CAPACITY), batchSize(0), batchDatagramSize(0), batches(QUEUE_CAPACITY), batch(NULL), remaining(0)
 	{
 		this->name = "SAKit UDP receiver";
+		this->stream = new hstream();
 	}
 
 	UdpReceiverThread::~UdpReceiverThread()
 	{
-		hmutex::ScopeLock lock(&this->mutex);
-		foreach (hstream*, it, this->streams)
+		Datagram datagram;
+		while (this->datagrams.pop(datagram))
+		{
+			delete datagram.stream;
+		}
+		foreach (Datagram, it, this->overflow)
+		{
+			delete (*it).stream;
+		}
+		this->overflow.clear();
+		delete this->stream;
+		DatagramBatch* batch = NULL;
+		while (this->batches.pop(batch))
 		{
-			delete (*it);
+			batch->release();
 		}
-		this->remoteHosts.clear();
-		this->remotePorts.clear();
-		this->streams.clear();
+		foreach (DatagramBatch*, it, this->batchOverflow)
+		{
+			(*it)->release();
+		}
+		this->batchOverflow.clear();
+		if (this->batch != NULL)
+		{
+			this->batch->release();
+		}
+	}
+
+	bool UdpReceiverThread::_isReactive()
+	{
+		return true;
+	}
+
+	bool UdpReceiverThread::_startReady()
+	{
+		this->remaining = this->maxValue;
+		return true;
 	}
 
-	void UdpReceiverThread::_updateProcess()
+	bool UdpReceiverThread::_updateReady()
 	{
-		Host host;
-		unsigned short port = 0;
-		hstream* stream = new hstream();
-		int count = this->maxValue;
-		hmutex::ScopeLock lock;
-		while (this->isRunning() && this->executing)
+		if (this->batchSize > 0)
 		{
-			if (this->socket->receiveFrom(stream, host, port) && stream->size() > 0)
+			return this->_updateBatchReady();
+		}
+		Endpoint remoteEndpoint;
+		this->_queueDatagrams();
+		if (this->socket->receiveFrom(this->stream, remoteEndpoint) && this->stream->size() > 0)
+		{
+			this->stream->rewind();
+			this->overflow += Datagram(remoteEndpoint, this->stream);
+			this->stream = new hstream();
+			this->_queueDatagrams();
+			this->_queueUpdate();
+			--this->remaining;
+			if (this->maxValue > 0 && this->remaining == 0)
 			{
-				stream->rewind();
-				lock.acquire(&this->mutex);
-				this->remoteHosts += host;
-				this->remotePorts += port;
-				this->streams += stream;
-				lock.release();
-				host = Host();
-				port = 0;
-				stream = new hstream();
+				hmutex::ScopeLock lock(&this->mutex);
+				this->_setResult(FINISHED);
+				return false;
 			}
-			--count;
-			if (this->maxValue > 0 && count == 0)
+		}
+		return true;
+	}
+
+	bool UdpReceiverThread::_updateBatchReady()
+	{
+		this->_queueBatches();
+		if (this->batch == NULL)
+		{
+			this->batch = new DatagramBatch(this->batchSize, this->batchDatagramSize);
+		}
+		if (this->socket->receiveBatch(this->batch, (this->maxValue > 0 ? this->remaining : 0)) && this->batch->size() > 0)
+		{
+			this->remaining -= this->batch->size();
+			this->batchOverflow += this->batch;
+			this->batch = NULL;
+			this->_queueBatches();
+			this->_queueUpdate();
+			if (this->maxValue > 0 && this->remaining <= 0)
 			{
-				break;
+				hmutex::ScopeLock lock(&this->mutex);
+				this->_setResult(FINISHED);
+				return false;
 			}
-			hthread::sleep(*this->retryFrequency * 1000.0f);
 		}
-		delete stream;
-		lock.acquire(&this->mutex);
-		this->result = FINISHED;
+		return true;
+	}
+
+	void UdpReceiverThread::_queueDatagrams()
+	{
+		// keeps the order of datagrams that had to wait until update() caught up
+		while (this->overflow.size() > 0 && this->datagrams.push(this->overflow.first()))
+		{
+			this->overflow.removeFirst();
+		}
+	}
+
+	void UdpReceiverThread::_queueBatches()
+	{
+		while (this->batchOverflow.size() > 0 && this->batches.push(this->batchOverflow.first()))
+		{
+			this->batchOverflow.removeFirst();
+		}
+	}
+
+	void UdpReceiverThread::_setBatchSize(int count, int datagramSize)
+	{
+		if (this->batch != NULL && (this->batchSize != count || this->batchDatagramSize != datagramSize))
+		{
+			this->batch->release();
+			this->batch = NULL;
+		}
+		this->batchSize = count;
+		this->batchDatagramSize = datagramSize;
 	}
 
 }
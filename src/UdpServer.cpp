@@ -11,6 +11,9 @@
 #include <hltypes/hstream.h>
 #include <hltypes/hstring.h>
 
+#include "Datagram.h"
+#include "DatagramBatch.h"
+#include "Endpoint.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "SenderThread.h"
@@ -22,7 +25,7 @@
 
 namespace sakit
 {
-	UdpServer::UdpServer(UdpServerDelegate* udpServerDelegate) : Server(dynamic_cast<ServerDelegate*>(udpServerDelegate))
+	UdpServer::UdpServer(UdpServerDelegate* udpServerDelegate) : Server(dynamic_cast<ServerDelegate*>(udpServerDelegate)), receiveBatchSize(0)
 	{
 		this->socket->setConnectionLess(true);
 		this->udpServerDelegate = udpServerDelegate;
@@ -37,31 +40,83 @@ namespace sakit
 	
 	void UdpServer::update(float timeDelta)
 	{
-		harray<Host> hosts;
-		harray<unsigned short> ports;
-		harray<hstream*> streams;
+		harray<Datagram> datagrams;
+		Datagram datagram;
+		while (this->udpServerThread->datagrams.pop(datagram))
+		{
+			datagrams += datagram;
+		}
+		harray<DatagramBatch*> batches;
+		DatagramBatch* batch = NULL;
+		while (this->udpServerThread->batches.pop(batch))
+		{
+			batches += batch;
+		}
 		hmutex::ScopeLock lock(&this->mutexState);
 		hmutex::ScopeLock lockThread(&this->udpServerThread->mutex);
-		if (this->udpServerThread->streams.size() > 0)
+		// the server has stopped so datagrams that didn't fit into the queue can be taken as well
+		if (this->udpServerThread->result != RUNNING && this->udpServerThread->overflow.size() > 0)
+		{
+			while (this->udpServerThread->datagrams.pop(datagram))
+			{
+				datagrams += datagram;
+			}
+			datagrams += this->udpServerThread->overflow;
+			this->udpServerThread->overflow.clear();
+		}
+		if (this->udpServerThread->result != RUNNING && this->udpServerThread->batchOverflow.size() > 0)
 		{
-			hosts = this->udpServerThread->remoteHosts;
-			ports = this->udpServerThread->remotePorts;
-			streams = this->udpServerThread->streams;
-			this->udpServerThread->remoteHosts.clear();
-			this->udpServerThread->remotePorts.clear();
-			this->udpServerThread->streams.clear();
+			while (this->udpServerThread->batches.pop(batch))
+			{
+				batches += batch;
+			}
+			batches += this->udpServerThread->batchOverflow;
+			this->udpServerThread->batchOverflow.clear();
 		}
 		lockThread.release();
 		lock.release();
-		for_iter (i, 0, streams.size())
+		foreach (Datagram, it, datagrams)
 		{
-			this->udpServerDelegate->onReceived(this, hosts[i], ports[i], streams[i]);
-			delete streams[i];
+			this->udpServerDelegate->onReceived(this, (*it).endpoint, (*it).stream);
+			delete (*it).stream;
+		}
+		foreach (DatagramBatch*, it, batches)
+		{
+			this->udpServerDelegate->onReceivedBatch(this, (*it));
+			(*it)->release();
 		}
 		Server::update(timeDelta);
 	}
 
+	bool UdpServer::setReceiveBatchSize(int count, int datagramSize)
+	{
+		if (datagramSize <= 0)
+		{
+			hlog::warn(logTag, "Cannot set receive batch size, datagram size has to be larger than 0!");
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (this->state == RUNNING)
+		{
+			hlog::warn(logTag, "Cannot set receive batch size while receiving!");
+			return false;
+		}
+		hmutex::ScopeLock lockThread(&this->udpServerThread->mutex);
+		this->receiveBatchSize = hmax(count, 0);
+		this->udpServerThread->_setBatchSize(this->receiveBatchSize, datagramSize);
+		return true;
+	}
+
 	bool UdpServer::receive(hstream* stream, Host& host, unsigned short& port)
+	{
+		Endpoint remoteEndpoint;
+		bool result = this->receive(stream, remoteEndpoint);
+		host = remoteEndpoint.getHost();
+		port = remoteEndpoint.getPort();
+		return result;
+	}
+
+	bool UdpServer::receive(hstream* stream, Endpoint& remoteEndpoint)
 	{
 		hmutex::ScopeLock lock(&this->mutexState);
 		if (!this->_canStart(this->state))
@@ -74,7 +129,7 @@ namespace sakit
 		bool result = false;
 		while (true)
 		{
-			if (this->socket->receiveFrom(stream, host, port))
+			if (this->socket->receiveFrom(stream, remoteEndpoint))
 			{
 				if (stream->size() > 0)
 				{
@@ -89,6 +144,7 @@ namespace sakit
 			}
 			hthread::sleep(this->retryFrequency * 1000.0f);
 		}
+		this->socket->releaseBuffer();
 		lock.acquire(&this->mutexState);
 		this->state = BOUND;
 		return result;
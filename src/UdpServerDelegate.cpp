@@ -6,6 +6,12 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+
+#include "DatagramBatch.h"
+#include "Endpoint.h"
+#include "Host.h"
 #include "UdpServerDelegate.h"
 
 namespace sakit
@@ -22,4 +28,21 @@ namespace sakit
 	{
 	}
 
+	void UdpServerDelegate::onReceived(UdpServer* server, const Endpoint& remoteEndpoint, hstream* stream)
+	{
+		this->onReceived(server, remoteEndpoint.getHost(), remoteEndpoint.getPort(), stream);
+	}
+
+	void UdpServerDelegate::onReceivedBatch(UdpServer* server, DatagramBatch* batch)
+	{
+		hstream stream;
+		for_iter (i, 0, batch->size())
+		{
+			stream.clear();
+			stream.writeRaw(batch->getData(i), batch->getSize(i));
+			stream.rewind();
+			this->onReceived(server, batch->getRemoteEndpoint(i), &stream);
+		}
+	}
+
 }
@@ -9,6 +9,8 @@
 #include <hltypes/hstream.h>
 #include <hltypes/hthread.h>
 
+#include "DatagramBatch.h"
+#include "Endpoint.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "Socket.h"
@@ -16,53 +18,113 @@
 #include "UdpServerThread.h"
 #include "UdpSocket.h"
 
+#define QUEUE_CAPACITY 256
+
 namespace sakit
 {
-	UdpServerThread::UdpServerThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : TimedThread(socket, timeout, retryFrequency)
+	UdpServerThread::UdpServerThread(PlatformSocket* socket, float* timeout, float* retryFrequency) : TimedThread(socket, timeout, retryFrequency), datagrams(QUEUE_CAPACITY),
+		batchSize(0), batchDatagramSize(0), batches(QUEUE_CAPACITY), batch(NULL)
 	{
 		this->name = "SAKit UDP server";
+		this->stream = new hstream();
 	}
 
 	UdpServerThread::~UdpServerThread()
 	{
-		hmutex::ScopeLock lock(&this->mutex);
-		foreach (hstream*, it, this->streams)
+		Datagram datagram;
+		while (this->datagrams.pop(datagram))
+		{
+			delete datagram.stream;
+		}
+		foreach (Datagram, it, this->overflow)
+		{
+			delete (*it).stream;
+		}
+		this->overflow.clear();
+		delete this->stream;
+		DatagramBatch* batch = NULL;
+		while (this->batches.pop(batch))
+		{
+			batch->release();
+		}
+		foreach (DatagramBatch*, it, this->batchOverflow)
+		{
+			(*it)->release();
+		}
+		this->batchOverflow.clear();
+		if (this->batch != NULL)
+		{
+			this->batch->release();
+		}
+	}
+
+	bool UdpServerThread::_isReactive()
+	{
+		return true;
+	}
+
+	bool UdpServerThread::_updateReady()
+	{
+		if (this->batchSize > 0)
+		{
+			return this->_updateBatchReady();
+		}
+		Endpoint remoteEndpoint;
+		this->_queueDatagrams();
+		if (this->socket->receiveFrom(this->stream, remoteEndpoint) && this->stream->size() > 0)
+		{
+			this->stream->rewind();
+			this->overflow += Datagram(remoteEndpoint, this->stream);
+			this->stream = new hstream();
+			this->_queueDatagrams();
+			this->_queueUpdate();
+		}
+		return true;
+	}
+
+	bool UdpServerThread::_updateBatchReady()
+	{
+		this->_queueBatches();
+		if (this->batch == NULL)
+		{
+			this->batch = new DatagramBatch(this->batchSize, this->batchDatagramSize);
+		}
+		if (this->socket->receiveBatch(this->batch, 0) && this->batch->size() > 0)
+		{
+			this->batchOverflow += this->batch;
+			this->batch = NULL;
+			this->_queueBatches();
+			this->_queueUpdate();
+		}
+		return true;
+	}
+
+	void UdpServerThread::_queueDatagrams()
+	{
+		// keeps the order of datagrams that had to wait until update() caught up
+		while (this->overflow.size() > 0 && this->datagrams.push(this->overflow.first()))
+		{
+			this->overflow.removeFirst();
+		}
+	}
+
+	void UdpServerThread::_queueBatches()
+	{
+		while (this->batchOverflow.size() > 0 && this->batches.push(this->batchOverflow.first()))
 		{
-			delete (*it);
+			this->batchOverflow.removeFirst();
 		}
-		this->remoteHosts.clear();
-		this->remotePorts.clear();
-		this->streams.clear();
 	}
 
-	void UdpServerThread::_updateProcess()
+	void UdpServerThread::_setBatchSize(int count, int datagramSize)
 	{
-		Host remoteHost;
-		unsigned short remotePort = 0;
-		hstream* stream = new hstream();
-		hmutex::ScopeLock lock;
-		while (this->isRunning() && this->executing)
+		if (this->batch != NULL && (this->batchSize != count || this->batchDatagramSize != datagramSize))
 		{
-			if (this->socket->receiveFrom(stream, remoteHost, remotePort))
-			{
-				if (stream->size() > 0)
-				{
-					stream->rewind();
-					lock.acquire(&this->mutex);
-					this->remoteHosts += remoteHost;
-					this->remotePorts += remotePort;
-					this->streams += stream;
-					lock.release();
-					remoteHost = Host();
-					remotePort = 0;
-					stream = new hstream();
-				}
-			}
-			hthread::sleep(*this->retryFrequency * 1000.0f);
+			this->batch->release();
+			this->batch = NULL;
 		}
-		delete stream;
-		lock.acquire(&this->mutex);
-		this->result = FINISHED;
+		this->batchSize = count;
+		this->batchDatagramSize = datagramSize;
 	}
 
 }
@@ -16,7 +16,10 @@
 #include <hltypes/harray.h>
 #include <hltypes/hltypesUtil.h>
 
+#include "Datagram.h"
+#include "DatagramBatch.h"
 #include "Server.h"
+#include "SpscQueue.h"
 #include "TimedThread.h"
 
 namespace sakit
@@ -33,11 +36,29 @@ namespace sakit
 		~UdpServerThread();
 
 	protected:
-		harray<Host> remoteHosts;
-		harray<unsigned short> remotePorts;
-		harray<hstream*> streams;
+		/// @note Received datagrams that are handed to update() without locking.
+		SpscQueue<Datagram> datagrams;
+		/// @note Datagrams that didn't fit into the queue, only accessed by update() while the result isn't RUNNING.
+		harray<Datagram> overflow;
+		hstream* stream;
+		/// @note Batched receiving is used if larger than 0.
+		int batchSize;
+		int batchDatagramSize;
+		/// @note Received batches that are handed to update() without locking.
+		SpscQueue<DatagramBatch*> batches;
+		/// @note Batches that didn't fit into the queue, only accessed by update() while the result isn't RUNNING.
+		harray<DatagramBatch*> batchOverflow;
+		/// @note Reused by the next receive call while nothing was received into it.
+		DatagramBatch* batch;
 
-		void _updateProcess();
+		bool _isReactive();
+		bool _updateReady();
+		bool _updateBatchReady();
+
+		void _queueDatagrams();
+		void _queueBatches();
+		/// @note Only to be called while the thread isn't running.
+		void _setBatchSize(int count, int datagramSize);
 
 	};
 
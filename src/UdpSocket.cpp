@@ -11,6 +11,8 @@
 #include <hltypes/hstream.h>
 
 #include "BroadcasterThread.h"
+#include "Datagram.h"
+#include "DatagramBatch.h"
 #include "PlatformSocket.h"
 #include "sakit.h"
 #include "sakitUtil.h"
@@ -20,10 +22,13 @@
 #include "UdpSocket.h"
 #include "UdpSocketDelegate.h"
 
+// largest payload of an IPv4 UDP datagram
+#define MAX_DATAGRAM_SIZE 65507
+
 namespace sakit
 {
 	UdpSocket::UdpSocket(UdpSocketDelegate* socketDelegate) : Socket(dynamic_cast<SocketDelegate*>(socketDelegate), BOUND),
-		Binder(this->socket, dynamic_cast<BinderDelegate*>(socketDelegate))
+		Binder(this->socket, dynamic_cast<BinderDelegate*>(socketDelegate)), receiveBatchSize(0)
 	{
 		this->socket->setConnectionLess(true);
 		this->udpSocketDelegate = socketDelegate;
@@ -36,7 +41,7 @@ namespace sakit
 	UdpSocket::~UdpSocket()
 	{
 		this->__unregister();
-		this->broadcaster->join();
+		this->broadcaster->joinWork();
 		delete this->broadcaster;
 	}
 
@@ -160,41 +165,47 @@ namespace sakit
 
 	void UdpSocket::_updateReceiving()
 	{
-		harray<Host> remoteHosts;
-		harray<unsigned short> remotePorts;
-		harray<hstream*> streams;
-		hmutex::ScopeLock lock(&this->mutexState);
-		hmutex::ScopeLock lockThread(&this->receiver->mutex);
-		if (this->udpReceiver->streams.size() > 0)
+		harray<Datagram> datagrams;
+		Datagram datagram;
+		while (this->udpReceiver->datagrams.pop(datagram))
 		{
-			remoteHosts = this->udpReceiver->remoteHosts;
-			remotePorts = this->udpReceiver->remotePorts;
-			streams = this->udpReceiver->streams;
-			this->udpReceiver->remoteHosts.clear();
-			this->udpReceiver->remotePorts.clear();
-			this->udpReceiver->streams.clear();
+			datagrams += datagram;
 		}
+		harray<DatagramBatch*> batches;
+		DatagramBatch* batch = NULL;
+		while (this->udpReceiver->batches.pop(batch))
+		{
+			batches += batch;
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		hmutex::ScopeLock lockThread(&this->receiver->mutex);
 		State result = this->receiver->result;
 		if (result == RUNNING || result == IDLE)
 		{
 			lockThread.release();
 			lock.release();
-			for_iter (i, 0, streams.size())
-			{
-				this->udpSocketDelegate->onReceived(this, remoteHosts[i], remotePorts[i], streams[i]);
-				delete streams[i];
-			}
+			this->_deliverReceived(datagrams, batches);
 			return;
 		}
+		// the receiver has stopped so datagrams that were queued in the meantime or that didn't fit into the queue can be taken as well
+		while (this->udpReceiver->datagrams.pop(datagram))
+		{
+			datagrams += datagram;
+		}
+		datagrams += this->udpReceiver->overflow;
+		this->udpReceiver->overflow.clear();
+		while (this->udpReceiver->batches.pop(batch))
+		{
+			batches += batch;
+		}
+		batches += this->udpReceiver->batchOverflow;
+		this->udpReceiver->batchOverflow.clear();
 		this->receiver->result = IDLE;
+		this->socket->releaseBuffer();
 		this->state = (this->state == SENDING_RECEIVING ? SENDING : this->idleState);
 		lockThread.release();
 		lock.release();
-		for_iter (i, 0, streams.size())
-		{
-			this->udpSocketDelegate->onReceived(this, remoteHosts[i], remotePorts[i], streams[i]);
-			delete streams[i];
-		}
+		this->_deliverReceived(datagrams, batches);
 		// delegate calls
 		if (result == FINISHED)
 		{
@@ -202,13 +213,82 @@ namespace sakit
 		}
 	}
 
+	void UdpSocket::_deliverReceived(harray<Datagram>& datagrams, harray<DatagramBatch*>& batches)
+	{
+		foreach (Datagram, it, datagrams)
+		{
+			this->udpSocketDelegate->onReceived(this, (*it).endpoint, (*it).stream);
+			delete (*it).stream;
+		}
+		foreach (DatagramBatch*, it, batches)
+		{
+			this->udpSocketDelegate->onReceivedBatch(this, (*it));
+			(*it)->release();
+		}
+	}
+
+	int UdpSocket::sendBatch(harray<OutgoingDatagram> datagrams)
+	{
+		if (!this->_checkBatchParameters(datagrams))
+		{
+			return 0;
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (!this->_canSend(this->state))
+		{
+			return 0;
+		}
+		this->state = (this->state == RECEIVING ? SENDING_RECEIVING : SENDING);
+		lock.release();
+		int sent = 0;
+		this->socket->sendBatch(datagrams, sent);
+		lock.acquire(&this->mutexState);
+		this->state = (this->state == SENDING_RECEIVING ? RECEIVING : this->idleState);
+		return sent;
+	}
+
+	int UdpSocket::sendSegmented(const void* data, int size, int segmentSize)
+	{
+		if (data == NULL || size <= 0)
+		{
+			hlog::warn(logTag, "Cannot send, no data to send!");
+			return 0;
+		}
+		if (segmentSize <= 0 || segmentSize > MAX_DATAGRAM_SIZE)
+		{
+			hlog::warnf(logTag, "Cannot send, segment size must be between 1 and %d!", MAX_DATAGRAM_SIZE);
+			return 0;
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (!this->_canSend(this->state))
+		{
+			return 0;
+		}
+		this->state = (this->state == RECEIVING ? SENDING_RECEIVING : SENDING);
+		lock.release();
+		int sent = 0;
+		this->socket->sendSegmented((const unsigned char*)data, size, segmentSize, sent);
+		lock.acquire(&this->mutexState);
+		this->state = (this->state == SENDING_RECEIVING ? RECEIVING : this->idleState);
+		return sent;
+	}
+
 	int UdpSocket::receive(hstream* stream, Host& remoteHost, unsigned short& remotePort)
+	{
+		Endpoint remoteEndpoint;
+		int result = this->receive(stream, remoteEndpoint);
+		remoteHost = remoteEndpoint.getHost();
+		remotePort = remoteEndpoint.getPort();
+		return result;
+	}
+
+	int UdpSocket::receive(hstream* stream, Endpoint& remoteEndpoint)
 	{
 		if (!this->_prepareReceive(stream))
 		{
 			return 0;
 		}
-		return this->_finishReceive(this->_receiveFromDirect(stream, remoteHost, remotePort));
+		return this->_finishReceive(this->_receiveFromDirect(stream, remoteEndpoint));
 	}
 	
 	hstr UdpSocket::receive(Host& remoteHost, unsigned short& remotePort)
@@ -229,6 +309,25 @@ namespace sakit
 		return this->_startReceiveAsync(maxPackages);
 	}
 
+	bool UdpSocket::setReceiveBatchSize(int count, int datagramSize)
+	{
+		if (datagramSize <= 0)
+		{
+			hlog::warn(logTag, "Cannot set receive batch size, datagram size has to be larger than 0!");
+			return false;
+		}
+		hmutex::ScopeLock lock(&this->mutexState);
+		if (this->state == RECEIVING || this->state == SENDING_RECEIVING)
+		{
+			hlog::warn(logTag, "Cannot set receive batch size while receiving!");
+			return false;
+		}
+		hmutex::ScopeLock lockThread(&this->udpReceiver->mutex);
+		this->receiveBatchSize = hmax(count, 0);
+		this->udpReceiver->_setBatchSize(this->receiveBatchSize, datagramSize);
+		return true;
+	}
+
 	void UdpSocket::_activateConnection(Host remoteHost, unsigned short remotePort, Host localHost, unsigned short localPort)
 	{
 		SocketBase::_activateConnection(remoteHost, remotePort, localHost, localPort);
@@ -294,7 +393,7 @@ namespace sakit
 		this->broadcaster->stream->rewind();
 		this->broadcaster->adapters = adapters;
 		this->broadcaster->remotePort = remotePort;
-		this->broadcaster->start();
+		this->broadcaster->startWork();
 		return true;
 	}
 
@@ -326,6 +425,29 @@ namespace sakit
 		return _checkState(state, allowed, "set destination");
 	}
 
+	bool UdpSocket::_checkBatchParameters(harray<OutgoingDatagram>& datagrams)
+	{
+		if (datagrams.size() == 0)
+		{
+			hlog::warn(logTag, "Cannot send, no datagrams to send!");
+			return false;
+		}
+		foreach (OutgoingDatagram, it, datagrams)
+		{
+			if ((*it).getData() == NULL && (*it).getSize() > 0)
+			{
+				hlog::warn(logTag, "Cannot send, datagram data is NULL!");
+				return false;
+			}
+			if (!(*it).hasRemoteHost() && !this->hasDestination())
+			{
+				hlog::warn(logTag, "Cannot send, datagram has no remote host and no destination is set!");
+				return false;
+			}
+		}
+		return true;
+	}
+
 	bool UdpSocket::_canJoinMulticastGroup(State state)
 	{
 		harray<State> allowed;
@@ -6,6 +6,12 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hstream.h>
+
+#include "DatagramBatch.h"
+#include "Endpoint.h"
+#include "Host.h"
 #include "UdpSocketDelegate.h"
 
 namespace sakit
@@ -22,6 +28,23 @@ namespace sakit
 	{
 	}
 
+	void UdpSocketDelegate::onReceived(UdpSocket* socket, const Endpoint& remoteEndpoint, hstream* stream)
+	{
+		this->onReceived(socket, remoteEndpoint.getHost(), remoteEndpoint.getPort(), stream);
+	}
+
+	void UdpSocketDelegate::onReceivedBatch(UdpSocket* socket, DatagramBatch* batch)
+	{
+		hstream stream;
+		for_iter (i, 0, batch->size())
+		{
+			stream.clear();
+			stream.writeRaw(batch->getData(i), batch->getSize(i));
+			stream.rewind();
+			this->onReceived(socket, batch->getRemoteEndpoint(i), &stream);
+		}
+	}
+
 	void UdpSocketDelegate::onBroadcastFinished(UdpSocket* socket)
 	{
 	}
@@ -106,7 +106,31 @@ namespace sakit
 
 	void Url::_checkValues(chstr query)
 	{
-		int index = this->host.indexOf(':');
+		// an IPv6 address without brackets can't have a port
+		bool ipv6 = Host(this->host).isIpv6();
+		int index = (!ipv6 ? this->host.indexOf(':') : -1);
+		if (this->host.startsWith("["))
+		{
+			ipv6 = true;
+			// IPv6 addresses are in brackets so the port can be told apart
+			int end = this->host.indexOf(']');
+			hstr remaining = (end >= 0 ? this->host(end + 1, -1) : hstr(""));
+			if (end < 0 || (remaining != "" && !remaining.startsWith(":")))
+			{
+				hlog::warn(logTag, "Malformed URL host: " + this->host);
+				return;
+			}
+			// the scope ID delimiter is encoded as "%25"
+			this->host = this->host(1, end - 1).replaced("%25", "%");
+			if (!Host(this->host).isIpv6())
+			{
+				hlog::warn(logTag, "Malformed URL host: " + this->host);
+				return;
+			}
+			// the port is parsed below the same way as with other hosts
+			index = (remaining != "" ? this->host.size() : -1);
+			this->host += remaining;
+		}
 		if (index >= 0)
 		{
 			hstr port = this->host(index + 1, -1);
@@ -124,12 +148,15 @@ namespace sakit
 			}
 			this->port = (unsigned short)portValue;
 		}
-		if (!Url::_checkCharset(this->host, HOST_ALLOWED))
+		if (!ipv6)
 		{
-			hlog::warn(logTag, "Malformed URL host: " + this->host);
-			return;
+			if (!Url::_checkCharset(this->host, HOST_ALLOWED))
+			{
+				hlog::warn(logTag, "Malformed URL host: " + this->host);
+				return;
+			}
+			this->host = Url::_decodeWwwFormComponent(this->host);
 		}
-		this->host = Url::_decodeWwwFormComponent(this->host);
 		harray<hstr> paths = this->path.split('/', -1, true);
 		this->path = "";
 		foreach (hstr, it, paths)
@@ -184,7 +211,7 @@ namespace sakit
 
 	hstr Url::getAbsolutePath(bool withPort) const
 	{
-		hstr result = HTTP_SCHEME + this->_encodeWwwFormComponent(this->host, HOST_ALLOWED);
+		hstr result = HTTP_SCHEME + Url::_encodeHost(this->host);
 		if (withPort && this->port > 0)
 		{
 			result += ":" + hstr(this->port);
@@ -261,6 +288,15 @@ namespace sakit
 		return false;
 	}
 
+	hstr Url::_encodeHost(chstr host)
+	{
+		if (Host(host).isIpv6())
+		{
+			return "[" + host.replaced("%", "%25") + "]";
+		}
+		return Url::_encodeWwwFormComponent(host, HOST_ALLOWED);
+	}
+
 	hstr Url::_encodeWwwFormComponent(chstr string, chstr allowed)
 	{
 		hstr result;
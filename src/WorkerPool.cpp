@@ -0,0 +1,402 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#define __HL_INCLUDE_PLATFORM_HEADERS
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hplatform.h>
+#include <hltypes/hthread.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "WorkerPool.h"
+#include "WorkerThread.h"
+
+#define IDLE_TIMEOUT 1000.0f
+
+namespace sakit
+{
+	PoolThread::PoolThread(WorkerPool* pool) : hthread(&process, "SAKit pool worker"), current(NULL), restart(false), waiting(0)
+	{
+		this->pool = pool;
+	}
+
+	PoolThread::~PoolThread()
+	{
+	}
+
+	void PoolThread::shutdown()
+	{
+		this->executing = false;
+	}
+
+	void PoolThread::_finishCurrent()
+	{
+		this->current = NULL;
+		for_iter (i, 0, this->waiting)
+		{
+			this->finished.post();
+		}
+		this->waiting = 0;
+	}
+
+	void PoolThread::_addDelayed(WorkerThread* worker, int64_t time)
+	{
+		DelayedWork work;
+		work.worker = worker;
+		work.time = time;
+		this->delayed += work;
+		this->_siftDelayedUp(this->delayed.size() - 1);
+	}
+
+	WorkerThread* PoolThread::_takeDelayed(int64_t time, float& timeout)
+	{
+		if (this->delayed.size() == 0)
+		{
+			return NULL;
+		}
+		if (this->delayed.first().time > time)
+		{
+			timeout = hmin(timeout, (float)(this->delayed.first().time - time));
+			return NULL;
+		}
+		WorkerThread* worker = this->delayed.first().worker;
+		this->delayed[0] = this->delayed.last();
+		this->delayed.removeLast();
+		this->_siftDelayedDown(0);
+		return worker;
+	}
+
+	void PoolThread::_removeDelayed(WorkerThread* worker)
+	{
+		for_iter (i, 0, this->delayed.size())
+		{
+			if (this->delayed[i].worker == worker)
+			{
+				this->delayed[i] = this->delayed.last();
+				this->delayed.removeLast();
+				if (i < this->delayed.size())
+				{
+					this->_siftDelayedDown(i);
+					this->_siftDelayedUp(i);
+				}
+				return;
+			}
+		}
+	}
+
+	void PoolThread::_siftDelayedUp(int index)
+	{
+		DelayedWork work = this->delayed[index];
+		int parent = 0;
+		while (index > 0)
+		{
+			parent = (index - 1) / 2;
+			if (this->delayed[parent].time <= work.time)
+			{
+				break;
+			}
+			this->delayed[index] = this->delayed[parent];
+			index = parent;
+		}
+		this->delayed[index] = work;
+	}
+
+	void PoolThread::_siftDelayedDown(int index)
+	{
+		int size = this->delayed.size();
+		if (index >= size)
+		{
+			return;
+		}
+		DelayedWork work = this->delayed[index];
+		int child = 0;
+		while (true)
+		{
+			child = index * 2 + 1;
+			if (child >= size)
+			{
+				break;
+			}
+			if (child + 1 < size && this->delayed[child + 1].time < this->delayed[child].time)
+			{
+				++child;
+			}
+			if (work.time <= this->delayed[child].time)
+			{
+				break;
+			}
+			this->delayed[index] = this->delayed[child];
+			index = child;
+		}
+		this->delayed[index] = work;
+	}
+
+	void PoolThread::process(hthread* thread)
+	{
+		PoolThread* poolThread = (PoolThread*)thread;
+		WorkerPool* pool = poolThread->pool;
+		WorkerThread* worker = NULL;
+		float timeout = 0.0f;
+		float delay = 0.0f;
+		while (poolThread->isRunning() && poolThread->executing)
+		{
+			worker = pool->_take(poolThread, timeout);
+			if (worker != NULL)
+			{
+				delay = worker->_updatePooled();
+				if (delay < 0.0f)
+				{
+					worker->_queueUpdate();
+				}
+				pool->_finish(poolThread, worker, delay);
+			}
+			else
+			{
+				pool->semaphore.wait(timeout);
+			}
+		}
+	}
+
+	WorkerPool::WorkerPool(int threadCount) : nextIndex(0)
+	{
+		PoolThread* thread = NULL;
+		for_iter (i, 0, threadCount)
+		{
+			thread = new PoolThread(this);
+			thread->start();
+			this->threads += thread;
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		foreach (PoolThread*, it, this->threads)
+		{
+			(*it)->shutdown();
+		}
+		// all threads have to be flagged first, otherwise a signal could wake up a thread that keeps running
+		for_iter (i, 0, this->threads.size())
+		{
+			this->semaphore.post();
+		}
+		foreach (PoolThread*, it, this->threads)
+		{
+			(*it)->join();
+			delete (*it);
+		}
+		this->threads.clear();
+	}
+
+	int WorkerPool::getThreadCount()
+	{
+		return this->threads.size();
+	}
+
+	int WorkerPool::getProcessorCount()
+	{
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetNativeSystemInfo(&info);
+		return hmax((int)info.dwNumberOfProcessors, 1);
+#else
+		return hmax((int)sysconf(_SC_NPROCESSORS_ONLN), 1);
+#endif
+	}
+
+	void WorkerPool::add(WorkerThread* worker)
+	{
+		hmutex::ScopeLock lock;
+		hmutex::ScopeLock lockWorker;
+		PoolThread* thread = this->_lockWorker(worker, lock, lockWorker);
+		if (worker->poolThread != NULL)
+		{
+			// work that is already queued isn't queued twice, work that is being executed is executed again afterwards
+			if (thread->current == worker)
+			{
+				thread->restart = true;
+			}
+			return;
+		}
+		worker->poolThread = thread;
+		worker->poolDelayed = false;
+		thread->tasks += worker;
+		lockWorker.release();
+		lock.release();
+		this->semaphore.post();
+	}
+
+	bool WorkerPool::remove(WorkerThread* worker)
+	{
+		hmutex::ScopeLock lock;
+		hmutex::ScopeLock lockWorker;
+		PoolThread* thread = NULL;
+		while (true)
+		{
+			thread = this->_lockWorker(worker, lock, lockWorker);
+			if (worker->poolThread == NULL)
+			{
+				return false;
+			}
+			if (thread->current != worker)
+			{
+				break;
+			}
+			thread->restart = false;
+			++thread->waiting;
+			lockWorker.release();
+			lock.release();
+			thread->finished.wait();
+		}
+		if (worker->poolDelayed)
+		{
+			thread->_removeDelayed(worker);
+		}
+		else
+		{
+			thread->tasks -= worker;
+		}
+		worker->poolThread = NULL;
+		worker->poolDelayed = false;
+		return true;
+	}
+
+	PoolThread* WorkerPool::_lockWorker(WorkerThread* worker, hmutex::ScopeLock& lock, hmutex::ScopeLock& lockWorker)
+	{
+		PoolThread* thread = NULL;
+		int index = 0;
+		while (true)
+		{
+			lockWorker.acquire(&worker->poolMutex);
+			thread = worker->poolThread;
+			lockWorker.release();
+			if (thread == NULL)
+			{
+#if defined(__ATOMIC_ACQ_REL)
+				index = __atomic_add_fetch(&this->nextIndex, 1, __ATOMIC_RELAXED);
+#elif defined(_MSC_VER)
+				index = (int)_InterlockedIncrement((volatile long*)&this->nextIndex);
+#else
+				index = __sync_add_and_fetch(&this->nextIndex, 1);
+#endif
+				thread = this->threads[(unsigned int)index % (unsigned int)this->threads.size()];
+			}
+			lock.acquire(&thread->mutex);
+			lockWorker.acquire(&worker->poolMutex);
+			// the worker could have been queued or stolen in the meantime
+			if (worker->poolThread == thread || worker->poolThread == NULL)
+			{
+				return thread;
+			}
+			lockWorker.release();
+			lock.release();
+		}
+	}
+
+	WorkerThread* WorkerPool::_take(PoolThread* thread, float& timeout)
+	{
+		WorkerThread* worker = NULL;
+		timeout = IDLE_TIMEOUT;
+		hmutex::ScopeLock lock(&thread->mutex);
+		// delayed work is taken first so polling workers don't starve when there is a lot of other work
+		worker = thread->_takeDelayed(htickCount(), timeout);
+		if (worker == NULL && thread->tasks.size() > 0)
+		{
+			worker = thread->tasks.removeLast();
+		}
+		if (worker != NULL)
+		{
+			hmutex::ScopeLock lockWorker(&worker->poolMutex);
+			worker->poolDelayed = false;
+			thread->current = worker;
+			return worker;
+		}
+		lock.release();
+		return this->_steal(thread);
+	}
+
+	WorkerThread* WorkerPool::_steal(PoolThread* thread)
+	{
+		int size = this->threads.size();
+		int index = this->threads.indexOf(thread);
+		int otherIndex = 0;
+		int64_t time = htickCount();
+		float timeout = 0.0f;
+		PoolThread* other = NULL;
+		WorkerThread* worker = NULL;
+		hmutex::ScopeLock lock;
+		hmutex::ScopeLock lockOther;
+		for_iter (i, 1, size)
+		{
+			otherIndex = (index + i) % size;
+			other = this->threads[otherIndex];
+			// both threads have to be locked so the worker can't be seen as neither queued nor executed
+			if (index < otherIndex)
+			{
+				lock.acquire(&thread->mutex);
+				lockOther.acquire(&other->mutex);
+			}
+			else
+			{
+				lockOther.acquire(&other->mutex);
+				lock.acquire(&thread->mutex);
+			}
+			// due delayed work of a busy thread would otherwise wait until that thread is done
+			worker = other->_takeDelayed(time, timeout);
+			if (worker == NULL && other->tasks.size() > 0)
+			{
+				worker = other->tasks.removeFirst();
+			}
+			if (worker != NULL)
+			{
+				hmutex::ScopeLock lockWorker(&worker->poolMutex);
+				worker->poolThread = thread;
+				worker->poolDelayed = false;
+				thread->current = worker;
+				return worker;
+			}
+			lockOther.release();
+			lock.release();
+		}
+		return NULL;
+	}
+
+	void WorkerPool::_finish(PoolThread* thread, WorkerThread* worker, float delay)
+	{
+		hmutex::ScopeLock lock(&thread->mutex);
+		hmutex::ScopeLock lockWorker(&worker->poolMutex);
+		thread->_finishCurrent();
+		if (thread->restart)
+		{
+			thread->restart = false;
+			thread->tasks += worker;
+		}
+		else if (delay >= 0.0f)
+		{
+			// the thread takes its delayed work itself once it's due so nobody has to be woken up
+			worker->poolDelayed = true;
+			thread->_addDelayed(worker, htickCount() + (int64_t)delay);
+			return;
+		}
+		else
+		{
+			worker->poolThread = NULL;
+			return;
+		}
+		lockWorker.release();
+		lock.release();
+		this->semaphore.post();
+	}
+
+}
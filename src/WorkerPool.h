@@ -0,0 +1,119 @@
+/// @file
+/// @version 1.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a shared pool of threads that execute async socket work instead of one thread per operation.
+
+#ifndef SAKIT_WORKER_POOL_H
+#define SAKIT_WORKER_POOL_H
+
+#include <stdint.h>
+
+#include <hltypes/harray.h>
+#include <hltypes/hltypesUtil.h>
+#include <hltypes/hmutex.h>
+#include <hltypes/hthread.h>
+
+#include "Semaphore.h"
+
+namespace sakit
+{
+	class WorkerPool;
+	class WorkerThread;
+
+	class PoolThread : public hthread
+	{
+	public:
+		friend class WorkerPool;
+
+		PoolThread(WorkerPool* pool);
+		~PoolThread();
+
+		void shutdown();
+
+	protected:
+		/// @brief Work that continues after a delay, e.g. polling receivers.
+		struct DelayedWork
+		{
+			WorkerThread* worker;
+			int64_t time;
+		};
+
+		WorkerPool* pool;
+		/// @note The owner takes work from the back while other threads steal from the front.
+		harray<WorkerThread*> tasks;
+		/// @brief Min-heap of the delayed work, ordered by the time it's due.
+		harray<DelayedWork> delayed;
+		WorkerThread* current;
+		/// @note The current worker has been added again while it was executed.
+		bool restart;
+		/// @note Number of threads in WorkerPool::remove() that wait for the current worker to be finished.
+		int waiting;
+		Semaphore finished;
+		/// @note Protects the tasks, the delayed work and the current worker, multiple threads' mutexes are always locked in the order of the threads.
+		hmutex mutex;
+
+		/// @note Has to be called while the mutex is locked.
+		void _finishCurrent();
+		/// @note Has to be called while the mutex is locked.
+		void _addDelayed(WorkerThread* worker, int64_t time);
+		/// @brief Takes the delayed work that is due first if it's due at the given time.
+		/// @param[out] timeout Is lowered to the time in milliseconds until the next delayed work is due.
+		/// @note Has to be called while the mutex is locked.
+		WorkerThread* _takeDelayed(int64_t time, float& timeout);
+		/// @note Has to be called while the mutex is locked.
+		void _removeDelayed(WorkerThread* worker);
+		void _siftDelayedUp(int index);
+		void _siftDelayedDown(int index);
+
+		static void process(hthread* thread);
+
+	private:
+		PoolThread(const PoolThread& other); // prevents copying
+
+	};
+
+	class WorkerPool
+	{
+	public:
+		friend class PoolThread;
+
+		WorkerPool(int threadCount);
+		~WorkerPool();
+
+		int getThreadCount();
+
+		/// @brief Queues a worker to be executed, a worker that is being executed at the moment will be executed again afterwards.
+		void add(WorkerThread* worker);
+		/// @brief Removes a worker from the queues, waits if the worker is being executed at the moment.
+		/// @return True if the worker was still queued.
+		bool remove(WorkerThread* worker);
+
+		static int getProcessorCount();
+
+	protected:
+		harray<PoolThread*> threads;
+		volatile int nextIndex;
+		Semaphore semaphore;
+
+		/// @brief Locks the pool thread that has queued or executes the worker, or a new one if the worker isn't in the pool.
+		/// @note The worker's poolMutex is locked as well, a worker can only change its pool thread while both are locked.
+		PoolThread* _lockWorker(WorkerThread* worker, hmutex::ScopeLock& lock, hmutex::ScopeLock& lockWorker);
+		WorkerThread* _take(PoolThread* thread, float& timeout);
+		/// @brief Takes queued work or due delayed work from another thread.
+		WorkerThread* _steal(PoolThread* thread);
+		void _finish(PoolThread* thread, WorkerThread* worker, float delay);
+
+	private:
+		WorkerPool(const WorkerPool& other); // prevents copying
+
+	};
+
+}
+#endif
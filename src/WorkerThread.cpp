@@ -6,26 +6,190 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <hltypes/harray.h>
+#include <hltypes/hmutex.h>
 #include <hltypes/hstream.h>
 #include <hltypes/hthread.h>
 
 #include "PlatformSocket.h"
+#include "ReactorThread.h"
+#include "WorkerPool.h"
 #include "WorkerThread.h"
 
 namespace sakit
 {
-	WorkerThread::WorkerThread(PlatformSocket* socket) : hthread(&process, "SAKit worker"), result(IDLE), port(0)
+	extern harray<ReactorThread*> reactors;
+	extern hmutex reactorsMutex;
+	extern WorkerPool* workerPool;
+	static int reactorIndex = 0;
+	static harray<WorkerThread*> workers;
+	static hmutex workersMutex;
+
+	void _queueUpdate(Base* connection);
+
+	WorkerThread::WorkerThread(PlatformSocket* socket) : hthread(&process, "SAKit worker"), result(IDLE), port(0), reactor(NULL), pool(NULL), poolStarted(false), poolThread(NULL), poolDelayed(false)
 	{
 		this->socket = socket;
+		hmutex::ScopeLock lock(&workersMutex);
+		workers += this;
 	}
 
 	WorkerThread::~WorkerThread()
 	{
+		hmutex::ScopeLock lock(&workersMutex);
+		workers.tryRemove(this);
+	}
+
+	void WorkerThread::detachAll()
+	{
+		hmutex::ScopeLock lock(&workersMutex);
+		foreach (WorkerThread*, it, workers)
+		{
+			(*it)->reactor = NULL;
+			(*it)->pool = NULL;
+		}
+	}
+
+	void WorkerThread::startWork()
+	{
+		if (this->_isReactive())
+		{
+			// a worker always stays on the same reactor so its registrations can't overlap
+			if (this->reactor == NULL)
+			{
+				hmutex::ScopeLock lock(&reactorsMutex);
+				if (reactors.size() > 0)
+				{
+					reactorIndex = (reactorIndex + 1) % reactors.size();
+					this->reactor = reactors[reactorIndex];
+				}
+			}
+			if (this->reactor != NULL)
+			{
+				this->reactor->add(this);
+				return;
+			}
+		}
+		if (this->pool == NULL && this->_isPoolable())
+		{
+			this->pool = workerPool;
+		}
+		if (this->pool != NULL)
+		{
+			this->executing = true;
+			this->poolStarted = false;
+			this->pool->add(this);
+			return;
+		}
+		this->start();
+	}
+
+	void WorkerThread::stopWork()
+	{
+		if (this->reactor != NULL)
+		{
+			this->reactor->cancel(this);
+			return;
+		}
+		this->executing = false;
+	}
+
+	void WorkerThread::joinWork()
+	{
+		if (this->reactor != NULL)
+		{
+			if (this->reactor->remove(this))
+			{
+				this->_finishReady();
+				this->_queueUpdate();
+			}
+			return;
+		}
+		if (this->pool != NULL)
+		{
+			// same as joining a thread, the work is told to stop
+			this->executing = false;
+			if (this->pool->remove(this) && this->poolStarted)
+			{
+				this->_finishReady();
+				this->_queueUpdate();
+			}
+			return;
+		}
+		this->join();
+	}
+
+	void WorkerThread::resumeWork()
+	{
+		// polling threads and pool threads keep trying on their own
+		if (this->reactor != NULL)
+		{
+			this->reactor->resume(this);
+		}
+	}
+
+	bool WorkerThread::_isActive()
+	{
+		return ((this->pool != NULL || this->isRunning()) && this->executing);
+	}
+
+	void WorkerThread::_queueUpdate()
+	{
+		Base* owner = this->socket->getOwner();
+		if (owner != NULL)
+		{
+			sakit::_queueUpdate(owner);
+		}
+	}
+
+	void WorkerThread::_setResult(State result)
+	{
+		this->result = result;
+		this->_queueUpdate();
+	}
+
+	bool WorkerThread::_isPoolable()
+	{
+		return true;
+	}
+
+	float WorkerThread::_updatePooled()
+	{
+		this->_updateProcess();
+		return -1.0f;
+	}
+
+	bool WorkerThread::_isReactive()
+	{
+		return false;
+	}
+
+	bool WorkerThread::_startReady()
+	{
+		return true;
+	}
+
+	bool WorkerThread::_updateReady()
+	{
+		return false;
+	}
+
+	void WorkerThread::_finishReady()
+	{
+		hmutex::ScopeLock lock(&this->mutex);
+		this->_setResult(FINISHED);
+	}
+
+	bool WorkerThread::_isPaused()
+	{
+		return false;
 	}
 
 	void WorkerThread::process(hthread* thread)
 	{
-		((WorkerThread*)thread)->_updateProcess();
+		WorkerThread* worker = (WorkerThread*)thread;
+		worker->_updateProcess();
+		worker->_queueUpdate();
 	}
 
 }
@@ -25,30 +25,82 @@
 namespace sakit
 {
 	class PlatformSocket;
+	class PoolThread;
+	class ReactorThread;
 	class Server;
 	class Socket;
 	class TcpSocket;
 	class UdpSocket;
+	class WorkerPool;
 	
 	class WorkerThread : public hthread
 	{
 	public:
+		friend class PoolThread;
+		friend class ReactorThread;
 		friend class Server;
 		friend class Socket;
 		friend class TcpSocket;
 		friend class UdpSocket;
+		friend class WorkerPool;
 
 		WorkerThread(PlatformSocket* socket);
 		~WorkerThread();
 
+		/// @brief Starts the work either on a reactor, in the worker pool or on this thread.
+		void startWork();
+		/// @brief Signals the work to stop, doesn't wait for it.
+		void stopWork();
+		/// @brief Waits for the work to stop.
+		void joinWork();
+		/// @brief Continues work that has been paused because its results couldn't be handed over.
+		void resumeWork();
+
+		/// @brief Detaches all existing workers from reactors and the worker pool before these are deleted.
+		/// @note Reactors and the worker pool have to be stopped already.
+		static void detachAll();
+
 	protected:
 		State result;
 		PlatformSocket* socket;
 		Host host;
 		unsigned short port;
 		hmutex mutex;
+		ReactorThread* reactor;
+		WorkerPool* pool;
+		bool poolStarted;
+		/// @brief The pool thread that has queued or executes the work, NULL if it's not in the pool.
+		/// @note Only changed while the mutexes of the involved pool threads and poolMutex are locked.
+		PoolThread* poolThread;
+		/// @brief Whether the work waits in the delayed work of poolThread instead of its tasks.
+		bool poolDelayed;
+		/// @note Locked after the mutexes of pool threads.
+		hmutex poolMutex;
+
+		/// @return True while the work has not been stopped, regardless of whether it runs on this thread or in the worker pool.
+		bool _isActive();
+		/// @brief Queues the socket's owner so its next update delivers the new results.
+		void _queueUpdate();
+		/// @brief Sets the result and queues the socket's owner so its next update delivers it.
+		/// @note The mutex has to be locked.
+		void _setResult(State result);
 
 		virtual void _updateProcess() = 0;
+		/// @return True if the work may be executed in the worker pool.
+		virtual bool _isPoolable();
+		/// @brief Executes the work in a pool thread.
+		/// @return Delay in milliseconds after which the work has to be continued or a negative value if it has finished.
+		virtual float _updatePooled();
+
+		/// @return True if the work can be driven by readiness notifications of the socket.
+		virtual bool _isReactive();
+		/// @note Returning false means that the work has finished and that the result has been set.
+		virtual bool _startReady();
+		/// @note Called whenever the socket is ready. Returning false means that the work has finished and that the result has been set.
+		virtual bool _updateReady();
+		virtual void _finishReady();
+		/// @return True if readiness notifications have to be ignored until resumeWork() is called.
+		virtual bool _isPaused();
 
 		static void process(hthread* thread);
 
@@ -8,27 +8,52 @@
 
 #define __HL_INCLUDE_PLATFORM_HEADERS
 #include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
 #include <hltypes/hmap.h>
 #include <hltypes/hplatform.h>
 #include <hltypes/hstring.h>
 
+#include "BufferPool.h"
+#include "ByteScanner.h"
+#include "DnsCache.h"
+#include "DnsResolver.h"
+#include "IoUring.h"
 #include "PlatformSocket.h"
+#include "ReactorThread.h"
+#include "ResolverDelegate.h"
 #include "sakit.h"
+#include "Semaphore.h"
 #include "Socket.h"
+#include "WorkerPool.h"
+#include "WorkerThread.h"
 
 #ifndef _WIN32
 #include <unistd.h>
 #endif
 
+#define UPDATE_WAIT_TIMEOUT 100.0f
+
 namespace sakit
 {
 	hstr logTag = "sakit";
 	float timeout = 10.00f;
 	float retryFrequency = 0.01f;
 	int bufferSize = 65536;
+	BufferPool bufferPool;
+	DnsCache dnsCache;
+	DnsResolver* dnsResolver = NULL;
 	harray<Base*> connections;
 	hmutex connectionsMutex;
 	hmutex updateMutex;
+	/// @note Connections with pending worker results, only these are updated.
+	harray<Base*> queuedConnections;
+	harray<Base*> updatingConnections;
+	hmutex queuedConnectionsMutex;
+	Semaphore queuedConnectionsSemaphore;
+	harray<ReactorThread*> reactors;
+	hmutex reactorsMutex;
+	IoBackend ioBackend = IO_BACKEND_SOCKETS;
+	WorkerPool* workerPool = NULL;
 	hmap<unsigned int, hstr> mapping;
 	/// @note Used for optimization to avoid hstr::fromUnicode() calls.
 	hmap<hstr, hstr> reverseMapping;
@@ -36,17 +61,20 @@ namespace sakit
 
 	void _asyncUpdate(hthread* thread);
 	void _internalUpdate(float timeDelta);
+	void _queueUpdate(Base* connection);
+	void _wakeUpdate();
 
 	bool isInitialized()
 	{
 		return mapping.size() > 0;
 	}
 	
-	void init(bool threadedUpdate)
+	void init(bool threadedUpdate, int reactorCount, IoBackend backend, int poolThreadCount)
 	{
 		bufferSize = 65536;
 		hlog::write(logTag, "Initializing Socket Abstraction Kit.");
 		PlatformSocket::platformInit();
+		hlog::debugf(logTag, "Scanning HTTP responses with %s.", _getByteScannerName().cStr());
 		// all 254 HTML entities as per HTML 4.0 specification
 		mapping[0x22u] = "quot";
 		mapping[0x26u] = "amp";
@@ -311,6 +339,60 @@ namespace sakit
 			_updateThread = new hthread(&_asyncUpdate, "SAKit async update");
 			_updateThread->start();
 		}
+		// reactors create their shared rings depending on the backend
+		ioBackend = IO_BACKEND_SOCKETS;
+		if (backend == IO_BACKEND_IO_URING)
+		{
+#ifdef _SAKIT_IO_URING
+			if (IoUring::isSupported())
+			{
+				ioBackend = backend;
+			}
+			else
+			{
+				hlog::warn(logTag, "io_uring is not supported by this kernel, using sockets instead.");
+			}
+#else
+			hlog::warn(logTag, "io_uring is not supported on this platform, using sockets instead.");
+#endif
+		}
+		if (reactorCount > 0)
+		{
+			if (ReactorThread::isSupported())
+			{
+				hmutex::ScopeLock lock(&reactorsMutex);
+				ReactorThread* reactor = NULL;
+				for_iter (i, 0, reactorCount)
+				{
+					reactor = new ReactorThread();
+					if (!reactor->isValid())
+					{
+						delete reactor;
+						break;
+					}
+					reactor->start();
+					reactors += reactor;
+				}
+				if (reactors.size() < reactorCount)
+				{
+					hlog::warnf(logTag, "Only %d of %d reactors could be created.", reactors.size(), reactorCount);
+				}
+			}
+			else
+			{
+				hlog::warn(logTag, "Reactors are not supported on this platform, using polling threads instead.");
+			}
+		}
+		if (poolThreadCount < 0)
+		{
+			poolThreadCount = WorkerPool::getProcessorCount();
+		}
+		if (poolThreadCount > 0)
+		{
+			workerPool = new WorkerPool(poolThreadCount);
+		}
+		dnsResolver = new DnsResolver();
+		dnsResolver->start();
 	}
 	
 	hstr getHostName()
@@ -346,6 +428,30 @@ namespace sakit
 			delete _updateThread;
 			_updateThread = NULL;
 		}
+		hmutex::ScopeLock lock(&reactorsMutex);
+		foreach (ReactorThread*, it, reactors)
+		{
+			(*it)->shutdown();
+		}
+		if (workerPool != NULL)
+		{
+			delete workerPool;
+			workerPool = NULL;
+		}
+		// sockets that haven't been destroyed yet must not access deleted reactors or the deleted pool later on
+		WorkerThread::detachAll();
+		foreach (ReactorThread*, it, reactors)
+		{
+			delete (*it);
+		}
+		reactors.clear();
+		lock.release();
+		if (dnsResolver != NULL)
+		{
+			dnsResolver->shutdown();
+			delete dnsResolver;
+			dnsResolver = NULL;
+		}
 		PlatformSocket::platformDestroy();
 		if (connections.size() > 0)
 		{
@@ -353,15 +459,58 @@ namespace sakit
 		}
 	}
 
+	void _queueUpdate(Base* connection)
+	{
+		hmutex::ScopeLock lock(&queuedConnectionsMutex);
+		if (connection->updateQueued || !connection->updateRegistered)
+		{
+			return;
+		}
+		connection->updateQueued = true;
+		queuedConnections += connection;
+		bool wake = (queuedConnections.size() == 1);
+		lock.release();
+		if (wake)
+		{
+			queuedConnectionsSemaphore.post();
+		}
+	}
+
+	void _wakeUpdate()
+	{
+		queuedConnectionsSemaphore.post();
+	}
+
 	void _internalUpdate(float timeDelta)
 	{
 		hmutex::ScopeLock lockUpdate(&updateMutex);
-		hmutex::ScopeLock lock(&connectionsMutex);
-		harray<Base*> _connections = sakit::connections;
+		// every result is queued when it's set so only the connections that have something to deliver are updated
+		hmutex::ScopeLock lock(&queuedConnectionsMutex);
+		updatingConnections = queuedConnections;
+		queuedConnections.clear();
+		foreach (Base*, it, updatingConnections)
+		{
+			(*it)->updateQueued = false;
+		}
+		lock.release();
+		Base* connection = NULL;
+		// connections destroyed during the update are set to NULL in this array so it has to be accessed by index
+		for_iter (i, 0, updatingConnections.size())
+		{
+			lock.acquire(&queuedConnectionsMutex);
+			connection = updatingConnections[i];
+			lock.release();
+			if (connection != NULL)
+			{
+				connection->update(timeDelta);
+			}
+		}
+		lock.acquire(&queuedConnectionsMutex);
+		updatingConnections.clear();
 		lock.release();
-		foreach (Base*, it, _connections)
+		if (dnsResolver != NULL)
 		{
-			(*it)->update(timeDelta);
+			dnsResolver->update();
 		}
 	}
 
@@ -377,13 +526,34 @@ namespace sakit
 
 	void _asyncUpdate(hthread* thread)
 	{
+		int64_t time = htickCount();
+		int64_t lastTime = time;
 		while (thread->isRunning())
 		{
-			_internalUpdate(0.001f);
-			hthread::sleep(1.0f);
+			time = htickCount();
+			_internalUpdate((time - lastTime) * 0.001f);
+			lastTime = time;
+			// wakes up as soon as a worker queues a connection
+			queuedConnectionsSemaphore.wait(UPDATE_WAIT_TIMEOUT);
 		}
 	}
 
+	int getReactorCount()
+	{
+		hmutex::ScopeLock lock(&reactorsMutex);
+		return reactors.size();
+	}
+
+	IoBackend getIoBackend()
+	{
+		return ioBackend;
+	}
+
+	int getPoolThreadCount()
+	{
+		return (workerPool != NULL ? workerPool->getThreadCount() : 0);
+	}
+
 	int getBufferSize()
 	{
 		return bufferSize;
@@ -394,6 +564,21 @@ namespace sakit
 		bufferSize = value;
 	}
 
+	int getUsedBufferCount()
+	{
+		return bufferPool.getUsedCount();
+	}
+
+	int getFreeBufferCount()
+	{
+		return bufferPool.getFreeCount();
+	}
+
+	int64_t getAllocatedBufferSize()
+	{
+		return bufferPool.getAllocatedSize();
+	}
+
 	float getGlobalTimeout()
 	{
 		return timeout;
@@ -415,9 +600,109 @@ namespace sakit
 		return PlatformSocket::getNetworkAdapters();
 	}
 
+	float getDnsCacheTtl()
+	{
+		return dnsCache.getTtl();
+	}
+
+	float getDnsCacheNegativeTtl()
+	{
+		return dnsCache.getNegativeTtl();
+	}
+
+	void setDnsCacheTtl(float ttl, float negativeTtl)
+	{
+		dnsCache.setTtl(ttl, negativeTtl);
+	}
+
+	int getDnsCacheMaxSize()
+	{
+		return dnsCache.getMaxSize();
+	}
+
+	void setDnsCacheMaxSize(int value)
+	{
+		dnsCache.setMaxSize(value);
+	}
+
+	int getDnsCacheSize()
+	{
+		return dnsCache.getSize();
+	}
+
+	int64_t getDnsCacheHitCount()
+	{
+		return dnsCache.getHitCount();
+	}
+
+	int64_t getDnsCacheMissCount()
+	{
+		return dnsCache.getMissCount();
+	}
+
+	void clearDnsCache()
+	{
+		dnsCache.clear();
+	}
+
 	Host resolveHost(Host domain)
 	{
-		return PlatformSocket::resolveHost(domain);
+		harray<Host> ips = resolveHosts(domain);
+		return (ips.size() > 0 ? ips.first() : Host());
+	}
+
+	harray<Host> resolveHosts(Host domain)
+	{
+		harray<Host> ips;
+		if (domain.isIp())
+		{
+			ips += domain;
+			return ips;
+		}
+		DnsCache::Result result = dnsCache.get(domain, ips);
+		if (result == DnsCache::FOUND)
+		{
+			return ips;
+		}
+		if (result == DnsCache::FAILED)
+		{
+			return harray<Host>();
+		}
+		ips = PlatformSocket::resolveHosts(domain);
+		if (ips.size() == 0)
+		{
+			dnsCache.addFailed(domain);
+			return ips;
+		}
+		dnsCache.add(domain, ips);
+		return ips;
+	}
+
+	bool resolveHostAsync(Host domain, ResolverDelegate* resolverDelegate)
+	{
+		if (dnsResolver == NULL)
+		{
+			hlog::warn(logTag, "Cannot resolve asynchronously, SAKit is not initialized!");
+			return false;
+		}
+		dnsResolver->query(domain, resolverDelegate);
+		return true;
+	}
+
+	void cancelResolveHostAsync(ResolverDelegate* resolverDelegate)
+	{
+		if (dnsResolver != NULL)
+		{
+			dnsResolver->cancel(resolverDelegate);
+		}
+	}
+
+	void setDnsServers(const harray<Host>& servers, unsigned short port)
+	{
+		if (dnsResolver != NULL)
+		{
+			dnsResolver->setServers(servers, port);
+		}
 	}
 
 	Host resolveIp(Host ip)
@@ -8,6 +8,7 @@
 
 #include <hltypes/harray.h>
 #include <hltypes/hlog.h>
+#include <hltypes/hltypesUtil.h>
 #include <hltypes/hstring.h>
 
 #include "sakit.h"
@@ -53,4 +54,23 @@ namespace sakit
 
 	}
 
+	bool _parseSize(chstr string, int64_t& value)
+	{
+		if (string.size() == 0 || string.size() > 18) // more digits could overflow
+		{
+			return false;
+		}
+		const char* data = string.cStr();
+		value = 0;
+		for_iter (i, 0, string.size())
+		{
+			if (data[i] < '0' || data[i] > '9')
+			{
+				return false;
+			}
+			value = value * 10 + (data[i] - '0');
+		}
+		return true;
+	}
+
 }
@@ -13,6 +13,8 @@
 #ifndef SAKIT_UTIL_H
 #define SAKIT_UTIL_H
 
+#include <stdint.h>
+
 #include <hltypes/harray.h>
 #include <hltypes/hstring.h>
 
@@ -22,6 +24,8 @@ namespace sakit
 {
 	hstr _getText(State state);
 	bool _checkState(State current, harray<State> allowed, chstr action);
+	/// @return False if the string isn't a non-negative decimal number that fits into 63 bits.
+	bool _parseSize(chstr string, int64_t& value);
 
 }
 #endif